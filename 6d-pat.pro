@@ -1,9 +1,10 @@
 TEMPLATE = subdirs
 CONFIG += ordered
-SUBDIRS = src app tests
+SUBDIRS = src app tests benchmarks tools
 
 app.depends = src
 tests.depends = src
+benchmarks.depends = src
 
 OTHER_FILES += \
     defaults.pri
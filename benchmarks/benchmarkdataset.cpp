@@ -0,0 +1,96 @@
+#include "benchmarkdataset.hpp"
+
+#include <datasetgenerator.hpp>
+
+#include <QFile>
+#include <QtTest/QtTest>
+
+BenchmarkDataset::BenchmarkDataset(int numberOfImages,
+                                   int numberOfObjectModels,
+                                   int posesPerImage,
+                                   const QSize &imageSize)
+    : m_numberOfImages(numberOfImages)
+    , m_numberOfObjectModels(numberOfObjectModels)
+    , m_posesPerImage(posesPerImage) {
+    if (!m_dir.isValid()) {
+        return;
+    }
+    DatasetGenerator::Parameters parameters;
+    parameters.numberOfImages = numberOfImages;
+    parameters.numberOfObjectModels = numberOfObjectModels;
+    parameters.numberOfPoses = numberOfPoses();
+    parameters.imageSize = imageSize;
+    // The benchmarks are about the number of entities and not about what the images show
+    parameters.sharedImage = true;
+    DatasetGenerator generator(parameters);
+    if (!generator.generate(m_dir.path())) {
+        qWarning() << "Failed to write the benchmark dataset:" << generator.errorString();
+        return;
+    }
+    QFile posesFile(posesFilePath());
+    if (posesFile.open(QFile::ReadOnly)) {
+        m_posesFileContent = posesFile.readAll();
+        m_valid = true;
+    }
+}
+
+QMap<QString, QSharedPointer<BenchmarkDataset>> BenchmarkDataset::standardDatasets() {
+    static QMap<QString, QSharedPointer<BenchmarkDataset>> datasets;
+    if (datasets.isEmpty()) {
+        datasets["100 images"] = QSharedPointer<BenchmarkDataset>(new BenchmarkDataset(100, 10, 10));
+        datasets["1000 images"] = QSharedPointer<BenchmarkDataset>(new BenchmarkDataset(1000, 50, 10));
+        datasets["10000 images"] = QSharedPointer<BenchmarkDataset>(new BenchmarkDataset(10000, 100, 10));
+    }
+    return datasets;
+}
+
+void BenchmarkDataset::addRows() {
+    QTest::addColumn<QString>("dataset");
+    for (const QString &name : standardDatasets().keys()) {
+        QTest::newRow(name.toUtf8().constData()) << name;
+    }
+}
+
+BenchmarkDataset *BenchmarkDataset::fromRow() {
+    QFETCH(QString, dataset);
+    return standardDatasets().value(dataset).data();
+}
+
+bool BenchmarkDataset::isValid() const {
+    return m_valid;
+}
+
+QString BenchmarkDataset::imagesPath() const {
+    return m_dir.filePath("images");
+}
+
+QString BenchmarkDataset::objectModelsPath() const {
+    return m_dir.filePath("models");
+}
+
+QString BenchmarkDataset::posesFilePath() const {
+    return m_dir.filePath("poses.json");
+}
+
+QString BenchmarkDataset::path() const {
+    return m_dir.path();
+}
+
+int BenchmarkDataset::numberOfImages() const {
+    return m_numberOfImages;
+}
+
+int BenchmarkDataset::numberOfObjectModels() const {
+    return m_numberOfObjectModels;
+}
+
+int BenchmarkDataset::numberOfPoses() const {
+    return m_numberOfObjectModels > 0 ? m_numberOfImages * m_posesPerImage : 0;
+}
+
+void BenchmarkDataset::resetPosesFile() {
+    QFile file(posesFilePath());
+    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+        file.write(m_posesFileContent);
+    }
+}
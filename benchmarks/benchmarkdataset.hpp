@@ -0,0 +1,62 @@
+#ifndef BENCHMARKDATASET_H
+#define BENCHMARKDATASET_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QSharedPointer>
+#include <QSize>
+#include <QString>
+#include <QTemporaryDir>
+
+/*!
+ * \brief The BenchmarkDataset class writes a dataset with the DatasetGenerator to a
+ * temporary folder: the images with their camera info file, the object models and a poses
+ * file. The contents only depend on the sizes, i.e. two runs of a benchmark always work
+ * on the same data.
+ */
+class BenchmarkDataset {
+
+public:
+    BenchmarkDataset(int numberOfImages,
+                     int numberOfObjectModels,
+                     int posesPerImage,
+                     const QSize &imageSize = QSize(64, 48));
+
+    /*!
+     * \brief standardDatasets returns the datasets all benchmarks run on, like a small, a
+     * medium and a production sized project. They are written on the first call.
+     */
+    static QMap<QString, QSharedPointer<BenchmarkDataset>> standardDatasets();
+    //! Adds the column "dataset" to a data function, with one row per standard dataset
+    static void addRows();
+    //! The standard dataset of the current row
+    static BenchmarkDataset *fromRow();
+
+    //! False if the files could not be written
+    bool isValid() const;
+
+    QString imagesPath() const;
+    QString objectModelsPath() const;
+    QString posesFilePath() const;
+    QString path() const;
+
+    int numberOfImages() const;
+    int numberOfObjectModels() const;
+    int numberOfPoses() const;
+
+    /*!
+     * \brief resetPosesFile writes the original poses file again, e.g. after a benchmark
+     * saved poses to it.
+     */
+    void resetPosesFile();
+
+private:
+    QTemporaryDir m_dir;
+    int m_numberOfImages;
+    int m_numberOfObjectModels;
+    int m_posesPerImage;
+    QByteArray m_posesFileContent;
+    bool m_valid = false;
+};
+
+#endif // BENCHMARKDATASET_H
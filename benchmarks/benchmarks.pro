@@ -0,0 +1,43 @@
+TEMPLATE = app
+TARGET = benchmarks
+QT += core gui widgets concurrent testlib 3dcore 3dextras 3drender 3dinput
+CONFIG += c++11 no_keywords
+
+include(../defaults.pri)
+include(../tools/datasetgenerator/datasetgenerator.pri)
+include(model/model.pri)
+include(view/view.pri)
+
+LIBS += -L../src -l6dpat
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/benchmarkdataset.hpp
+
+SOURCES += \
+    $$PWD/benchmarkdataset.cpp \
+    $$PWD/main.cpp
+
+RESOURCES += \
+    resources.qrc
+
+unix: QT_CONFIG -= no-pkg-config
+unix: CONFIG += link_pkgconfig
+
+packagesExist(opencv) {
+    unix: PKGCONFIG += opencv
+} else {
+    packagesExist(opencv4) {
+        unix: PKGCONFIG += opencv4
+    } else {
+        error(OpenCV not found!)
+    }
+}
+
+DEFINES += QT_DEPRECATED_WARNINGS PYBIND11_PYTHON_VERSION="3.8"
+
+INCLUDEPATH += /usr/include/python3.8 \
+               /usr/include/pybind11
+
+LIBS += -lpython3.8
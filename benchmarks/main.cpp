@@ -0,0 +1,75 @@
+#include "model/cachingmodelmanagerbenchmark.hpp"
+#include "model/loadandstorestrategybenchmark.hpp"
+#include "view/gallerybenchmark.hpp"
+
+#include <QApplication>
+#include <QFileInfo>
+#include <QSharedPointer>
+#include <QStandardPaths>
+#include <QSurfaceFormat>
+#include <QtTest/QtTest>
+
+/*!
+ * \brief argumentsForBenchmark returns the arguments for the benchmark with the given name.
+ * QtTest overwrites the files given with -o for every test object, that's why the name
+ * of the benchmark is inserted into them, e.g. -o results.xml,xml writes
+ * results-GalleryBenchmark.xml.
+ */
+static QStringList argumentsForBenchmark(const QStringList &arguments, const QString &name) {
+    QStringList result = arguments;
+    for (int i = 1; i < result.size() - 1; i++) {
+        if (result[i] != "-o") {
+            continue;
+        }
+        QString &output = result[++i];
+        const int formatSeparator = output.lastIndexOf(',');
+        QString fileName = formatSeparator >= 0 ? output.left(formatSeparator) : output;
+        if (fileName == "-") {
+            // Standard output
+            continue;
+        }
+        QFileInfo fileInfo(fileName);
+        fileName = fileInfo.dir().filePath(fileInfo.completeBaseName() + "-" + name
+                                           + (fileInfo.suffix().isEmpty() ? "" : "." + fileInfo.suffix()));
+        output = formatSeparator >= 0 ? fileName + output.mid(formatSeparator) : fileName;
+    }
+    return result;
+}
+
+/*!
+ * Runs all benchmarks, the arguments are the ones of QtTest. Results can be written in a
+ * machine readable format to track them over time, e.g.
+ *
+ *     ./benchmarks -o results.xml,xml
+ *     ./benchmarks -o results.csv,csv
+ *
+ * Both formats contain the measurements of every data row. -callgrind, -tickcounter or
+ * -eventcounter switch from wall time to other measurements.
+ */
+int main(int argc, char *argv[]) {
+    // Like the application, the offscreen renderer needs a shared OpenGL context
+    QSurfaceFormat format;
+    format.setDepthBufferSize(24);
+    format.setStencilBufferSize(0);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setVersion(3, 0);
+    QSurfaceFormat::setDefaultFormat(format);
+    QApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+
+    QApplication application(argc, argv);
+    // Keeps the dataset manifests out of the cache of the application
+    QStandardPaths::setTestModeEnabled(true);
+
+    QList<QSharedPointer<QObject>> benchmarks;
+    benchmarks << QSharedPointer<QObject>(new LoadAndStoreStrategyBenchmark)
+               << QSharedPointer<QObject>(new CachingModelManagerBenchmark)
+               << QSharedPointer<QObject>(new GalleryBenchmark);
+
+    int status = 0;
+    const QStringList arguments = application.arguments();
+    for (const QSharedPointer<QObject> &benchmark : benchmarks) {
+        status |= QTest::qExec(benchmark.data(),
+                               argumentsForBenchmark(arguments, benchmark->metaObject()->className()));
+    }
+    return status;
+}
@@ -0,0 +1,177 @@
+#include "cachingmodelmanagerbenchmark.hpp"
+
+#include <misc/memoryaccounting.hpp>
+#include <model/jsonloadandstorestrategy.hpp>
+
+namespace {
+
+//! Reads the files on every reload instead of the manifest of the previous one
+class ManifestlessJsonLoadAndStoreStrategy : public JsonLoadAndStoreStrategy {
+
+public:
+    bool supportsManifest() const override {
+        return false;
+    }
+};
+
+}
+
+QSharedPointer<CachingModelManager> CachingModelManagerBenchmark::createManager(bool useManifest) {
+    BenchmarkDataset *dataset = BenchmarkDataset::fromRow();
+    LoadAndStoreStrategyPtr strategy(useManifest ? new JsonLoadAndStoreStrategy
+                                                 : new ManifestlessJsonLoadAndStoreStrategy);
+    strategy->setImagesPath(dataset->imagesPath());
+    strategy->setObjectModelsPath(dataset->objectModelsPath());
+    strategy->setPosesFilePath(dataset->posesFilePath());
+    QSharedPointer<CachingModelManager> manager(new CachingModelManager(strategy));
+    manager->reload();
+    return manager;
+}
+
+void CachingModelManagerBenchmark::reload_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::reload() {
+    QSharedPointer<CachingModelManager> manager = createManager();
+    QBENCHMARK {
+        manager->reload();
+    }
+    QCOMPARE(manager->poses().size(), BenchmarkDataset::fromRow()->numberOfPoses());
+}
+
+void CachingModelManagerBenchmark::reloadFromManifest_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::reloadFromManifest() {
+    // The first reload writes the manifest
+    QSharedPointer<CachingModelManager> manager = createManager(true);
+    QBENCHMARK {
+        manager->reload();
+    }
+    QCOMPARE(manager->poses().size(), BenchmarkDataset::fromRow()->numberOfPoses());
+}
+
+void CachingModelManagerBenchmark::snapshot_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::snapshot() {
+    QSharedPointer<CachingModelManager> manager = createManager();
+    ModelSnapshotPtr snapshot;
+    QBENCHMARK {
+        snapshot = manager->snapshot();
+    }
+    QCOMPARE(snapshot->images().size(), BenchmarkDataset::fromRow()->numberOfImages());
+}
+
+void CachingModelManagerBenchmark::posesForImage_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::posesForImage() {
+    QSharedPointer<CachingModelManager> manager = createManager();
+    QList<ImagePtr> images = manager->images();
+    QVERIFY(!images.isEmpty());
+    int i = 0;
+    int numberOfPoses = 0;
+    QBENCHMARK {
+        // Like switching through the images, the poses of each have to be materialized
+        numberOfPoses += manager->posesForImage(*images[i]).size();
+        i = (i + 1) % images.size();
+    }
+    QVERIFY(numberOfPoses > 0);
+}
+
+void CachingModelManagerBenchmark::posesForObjectModel_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::posesForObjectModel() {
+    QSharedPointer<CachingModelManager> manager = createManager();
+    QList<ObjectModelPtr> objectModels = manager->objectModels();
+    QVERIFY(!objectModels.isEmpty());
+    int i = 0;
+    int numberOfPoses = 0;
+    QBENCHMARK {
+        numberOfPoses += manager->posesForObjectModel(*objectModels[i]).size();
+        i = (i + 1) % objectModels.size();
+    }
+    QVERIFY(numberOfPoses > 0);
+}
+
+void CachingModelManagerBenchmark::poseById_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::poseById() {
+    QSharedPointer<CachingModelManager> manager = createManager();
+    const QString id = manager->posesForImage(*manager->images().last()).first()->id();
+    PosePtr pose;
+    QBENCHMARK {
+        pose = manager->poseById(id);
+    }
+    QVERIFY(pose);
+}
+
+void CachingModelManagerBenchmark::updatePose_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::updatePose() {
+    QSharedPointer<CachingModelManager> manager = createManager();
+    PosePtr pose = manager->posesForImage(*manager->images().first()).first();
+    QVector3D position = pose->position();
+    const QMatrix3x3 rotation = pose->rotation().toRotationMatrix();
+    bool updated = true;
+    QBENCHMARK {
+        position += QVector3D(1, 0, 0);
+        updated &= manager->updatePose(pose->id(), position, rotation);
+    }
+    BenchmarkDataset::fromRow()->resetPosesFile();
+    QVERIFY(updated);
+}
+
+void CachingModelManagerBenchmark::addAndRemovePose_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::addAndRemovePose() {
+    QSharedPointer<CachingModelManager> manager = createManager();
+    ImagePtr image = manager->images().first();
+    ObjectModelPtr objectModel = manager->objectModels().first();
+    bool removed = true;
+    QBENCHMARK {
+        // Removed again to keep the size of the dataset
+        PosePtr pose = manager->addPose(image, objectModel, QVector3D(0, 0, 500), QMatrix3x3());
+        removed &= pose && manager->removePose(pose->id());
+    }
+    BenchmarkDataset::fromRow()->resetPosesFile();
+    QVERIFY(removed);
+}
+
+void CachingModelManagerBenchmark::memoryPerPose_data() {
+    BenchmarkDataset::addRows();
+}
+
+void CachingModelManagerBenchmark::memoryPerPose() {
+    const qint64 residentBefore = MemoryAccounting::processMemory();
+    QSharedPointer<CachingModelManager> manager = createManager();
+    const qint64 residentAfter = MemoryAccounting::processMemory();
+    // Taken from the dataset, asking the manager would materialize all poses
+    const int numberOfPoses = BenchmarkDataset::fromRow()->numberOfPoses();
+    QVERIFY(numberOfPoses > 0);
+    qint64 usage = -1;
+    for (const MemoryAccounting::Account &account : MemoryAccounting::instance()->accounts()) {
+        if (account.subsystem == MemoryAccounting::ENTITIES) {
+            usage = account.usage;
+        }
+    }
+    QVERIFY(usage > 0);
+    if (residentBefore >= 0 && residentAfter >= 0) {
+        qDebug() << "Resident memory grew by" << MemoryAccounting::formatBytes(residentAfter - residentBefore)
+                 << "for" << numberOfPoses << "poses.";
+    }
+    QTest::setBenchmarkResult(double(usage) / numberOfPoses, QTest::BytesAllocated);
+}
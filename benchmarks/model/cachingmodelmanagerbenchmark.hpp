@@ -0,0 +1,55 @@
+#ifndef CACHINGMODELMANAGERBENCHMARK_H
+#define CACHINGMODELMANAGERBENCHMARK_H
+
+#include "benchmarkdataset.hpp"
+
+#include <model/cachingmodelmanager.hpp>
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+/*!
+ * \brief The CachingModelManagerBenchmark class measures loading the datasets into the
+ * manager, the queries the views issue when the user switches images, the mutations
+ * of poses including persisting them and the memory the poses take.
+ */
+class CachingModelManagerBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void reload_data();
+    void reload();
+    //! Like restarting the program with an unchanged dataset
+    void reloadFromManifest_data();
+    void reloadFromManifest();
+
+    void snapshot_data();
+    void snapshot();
+    void posesForImage_data();
+    void posesForImage();
+    void posesForObjectModel_data();
+    void posesForObjectModel();
+    void poseById_data();
+    void poseById();
+
+    void updatePose_data();
+    void updatePose();
+    void addAndRemovePose_data();
+    void addAndRemovePose();
+
+    /*!
+     * \brief memoryPerPose reports the estimated bytes of the entities per pose after
+     * loading, the growth of the resident memory is logged for comparison.
+     */
+    void memoryPerPose_data();
+    void memoryPerPose();
+
+private:
+    /*!
+     * \brief createManager returns a manager that has loaded the dataset of the current row.
+     * Without the manifest every reload reads the files again.
+     */
+    QSharedPointer<CachingModelManager> createManager(bool useManifest = false);
+};
+
+#endif // CACHINGMODELMANAGERBENCHMARK_H
@@ -0,0 +1,185 @@
+#include "loadandstorestrategybenchmark.hpp"
+
+#include <settings/settings.hpp>
+
+#include <QFile>
+
+void LoadAndStoreStrategyBenchmark::initTestCase() {
+    for (const QSharedPointer<BenchmarkDataset> &dataset : BenchmarkDataset::standardDatasets()) {
+        QVERIFY(dataset->isValid());
+    }
+    m_jsonStrategy = new JsonLoadAndStoreStrategy;
+
+    QVERIFY(m_scriptDir.isValid());
+    QVERIFY(QFile::copy(":/python/benchmark_loader.py", m_scriptDir.filePath("benchmark_loader.py")));
+}
+
+void LoadAndStoreStrategyBenchmark::usePaths(LoadAndStoreStrategy *strategy,
+                                             BenchmarkDataset *dataset) {
+    strategy->setImagesPath(dataset->imagesPath());
+    strategy->setObjectModelsPath(dataset->objectModelsPath());
+    strategy->setPosesFilePath(dataset->posesFilePath());
+}
+
+bool LoadAndStoreStrategyBenchmark::initPythonStrategy() {
+    if (!m_pythonStrategy) {
+        m_pythonStrategy = new PythonLoadAndStoreStrategy;
+        SettingsPtr settings(new Settings("benchmark"));
+        settings->setLoadSaveScriptPath(m_scriptDir.filePath("benchmark_loader.py"));
+        m_pythonStrategy->applySettings(settings);
+        // Starting the interpreter is not what we want to measure
+        m_pythonStrategy->warmUp();
+    }
+    QSignalSpy errorSpy(m_pythonStrategy, &LoadAndStoreStrategy::error);
+    usePaths(m_pythonStrategy, BenchmarkDataset::fromRow());
+    return m_pythonStrategy->loadObjectModels().size() > 0 && errorSpy.isEmpty();
+}
+
+void LoadAndStoreStrategyBenchmark::loadImagesJson_data() {
+    BenchmarkDataset::addRows();
+}
+
+void LoadAndStoreStrategyBenchmark::loadImagesJson() {
+    BenchmarkDataset *dataset = BenchmarkDataset::fromRow();
+    usePaths(m_jsonStrategy, dataset);
+    QList<ImagePtr> images;
+    QBENCHMARK {
+        images = m_jsonStrategy->loadImages();
+    }
+    QCOMPARE(images.size(), dataset->numberOfImages());
+}
+
+void LoadAndStoreStrategyBenchmark::loadObjectModelsJson_data() {
+    BenchmarkDataset::addRows();
+}
+
+void LoadAndStoreStrategyBenchmark::loadObjectModelsJson() {
+    BenchmarkDataset *dataset = BenchmarkDataset::fromRow();
+    usePaths(m_jsonStrategy, dataset);
+    QList<ObjectModelPtr> objectModels;
+    QBENCHMARK {
+        objectModels = m_jsonStrategy->loadObjectModels();
+    }
+    QCOMPARE(objectModels.size(), dataset->numberOfObjectModels());
+}
+
+void LoadAndStoreStrategyBenchmark::loadPosesJson_data() {
+    BenchmarkDataset::addRows();
+}
+
+void LoadAndStoreStrategyBenchmark::loadPosesJson() {
+    BenchmarkDataset *dataset = BenchmarkDataset::fromRow();
+    usePaths(m_jsonStrategy, dataset);
+    QList<ImagePtr> images = m_jsonStrategy->loadImages();
+    QList<ObjectModelPtr> objectModels = m_jsonStrategy->loadObjectModels();
+    QList<PosePtr> poses;
+    QBENCHMARK {
+        poses = m_jsonStrategy->loadPoses(images, objectModels);
+    }
+    QCOMPARE(poses.size(), dataset->numberOfPoses());
+}
+
+void LoadAndStoreStrategyBenchmark::loadImagesPython_data() {
+    BenchmarkDataset::addRows();
+}
+
+void LoadAndStoreStrategyBenchmark::loadImagesPython() {
+    if (!initPythonStrategy()) {
+        QSKIP("The Python strategy could not load the benchmark script.");
+    }
+    QList<ImagePtr> images;
+    QBENCHMARK {
+        images = m_pythonStrategy->loadImages();
+    }
+    QCOMPARE(images.size(), BenchmarkDataset::fromRow()->numberOfImages());
+}
+
+void LoadAndStoreStrategyBenchmark::loadPosesPython_data() {
+    BenchmarkDataset::addRows();
+}
+
+void LoadAndStoreStrategyBenchmark::loadPosesPython() {
+    if (!initPythonStrategy()) {
+        QSKIP("The Python strategy could not load the benchmark script.");
+    }
+    QList<ImagePtr> images = m_pythonStrategy->loadImages();
+    QList<ObjectModelPtr> objectModels = m_pythonStrategy->loadObjectModels();
+    QList<PosePtr> poses;
+    QBENCHMARK {
+        poses = m_pythonStrategy->loadPoses(images, objectModels);
+    }
+    QCOMPARE(poses.size(), BenchmarkDataset::fromRow()->numberOfPoses());
+}
+
+void LoadAndStoreStrategyBenchmark::persistPoseJson_data() {
+    BenchmarkDataset::addRows();
+}
+
+void LoadAndStoreStrategyBenchmark::persistPoseJson() {
+    BenchmarkDataset *dataset = BenchmarkDataset::fromRow();
+    usePaths(m_jsonStrategy, dataset);
+    QList<PosePtr> poses = m_jsonStrategy->loadPoses(m_jsonStrategy->loadImages(),
+                                                     m_jsonStrategy->loadObjectModels());
+    QVERIFY(!poses.isEmpty());
+    PosePtr pose = poses.first();
+    bool persisted = true;
+    QBENCHMARK {
+        pose->setPosition(pose->position() + QVector3D(1, 0, 0));
+        persisted &= m_jsonStrategy->persistPose(*pose, false);
+    }
+    dataset->resetPosesFile();
+    QVERIFY(persisted);
+}
+
+void LoadAndStoreStrategyBenchmark::persistPosesOfImageJson_data() {
+    BenchmarkDataset::addRows();
+}
+
+void LoadAndStoreStrategyBenchmark::persistPosesOfImageJson() {
+    BenchmarkDataset *dataset = BenchmarkDataset::fromRow();
+    usePaths(m_jsonStrategy, dataset);
+    QList<ImagePtr> images = m_jsonStrategy->loadImages();
+    QList<PosePtr> poses = m_jsonStrategy->loadPoses(images, m_jsonStrategy->loadObjectModels());
+    QList<PosePtr> posesOfImage;
+    for (const PosePtr &pose : poses) {
+        if (pose->image() == images.first()) {
+            posesOfImage.append(pose);
+        }
+    }
+    QVERIFY(!posesOfImage.isEmpty());
+    bool persisted = true;
+    QBENCHMARK {
+        for (const PosePtr &pose : posesOfImage) {
+            pose->setPosition(pose->position() + QVector3D(1, 0, 0));
+            persisted &= m_jsonStrategy->persistPose(*pose, false);
+        }
+    }
+    dataset->resetPosesFile();
+    QVERIFY(persisted);
+}
+
+void LoadAndStoreStrategyBenchmark::persistPosePython_data() {
+    BenchmarkDataset::addRows();
+}
+
+void LoadAndStoreStrategyBenchmark::persistPosePython() {
+    if (!initPythonStrategy()) {
+        QSKIP("The Python strategy could not load the benchmark script.");
+    }
+    QList<PosePtr> poses = m_pythonStrategy->loadPoses(m_pythonStrategy->loadImages(),
+                                                       m_pythonStrategy->loadObjectModels());
+    QVERIFY(!poses.isEmpty());
+    PosePtr pose = poses.first();
+    bool persisted = true;
+    QBENCHMARK {
+        pose->setPosition(pose->position() + QVector3D(1, 0, 0));
+        persisted &= m_pythonStrategy->persistPose(*pose, false);
+    }
+    BenchmarkDataset::fromRow()->resetPosesFile();
+    QVERIFY(persisted);
+}
+
+void LoadAndStoreStrategyBenchmark::cleanupTestCase() {
+    delete m_jsonStrategy;
+    delete m_pythonStrategy;
+}
@@ -0,0 +1,59 @@
+#ifndef LOADANDSTORESTRATEGYBENCHMARK_H
+#define LOADANDSTORESTRATEGYBENCHMARK_H
+
+#include "benchmarkdataset.hpp"
+
+#include <model/jsonloadandstorestrategy.hpp>
+#include <model/pythonloadandstorestrategy.hpp>
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+/*!
+ * \brief The LoadAndStoreStrategyBenchmark class measures loading and persisting through
+ * the JSON and the Python strategy at several dataset sizes. Both strategies read the
+ * same files, the Python one through benchmark_loader.py.
+ */
+class LoadAndStoreStrategyBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void loadImagesJson_data();
+    void loadImagesJson();
+    void loadObjectModelsJson_data();
+    void loadObjectModelsJson();
+    void loadPosesJson_data();
+    void loadPosesJson();
+
+    void loadImagesPython_data();
+    void loadImagesPython();
+    void loadPosesPython_data();
+    void loadPosesPython();
+
+    //! Persisting rewrites the poses file, i.e. it depends on the size of the dataset
+    void persistPoseJson_data();
+    void persistPoseJson();
+    //! Persists all poses of an image like saving after editing them
+    void persistPosesOfImageJson_data();
+    void persistPosesOfImageJson();
+    void persistPosePython_data();
+    void persistPosePython();
+
+    void cleanupTestCase();
+
+private:
+    void usePaths(LoadAndStoreStrategy *strategy, BenchmarkDataset *dataset);
+    bool initPythonStrategy();
+
+private:
+    JsonLoadAndStoreStrategy *m_jsonStrategy = Q_NULLPTR;
+    //! The interpreter can't be started again once it's finalized, all Python
+    //! benchmarks share this strategy
+    PythonLoadAndStoreStrategy *m_pythonStrategy = Q_NULLPTR;
+    QTemporaryDir m_scriptDir;
+};
+
+#endif // LOADANDSTORESTRATEGYBENCHMARK_H
@@ -0,0 +1,9 @@
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/cachingmodelmanagerbenchmark.hpp \
+    $$PWD/loadandstorestrategybenchmark.hpp
+
+SOURCES += \
+    $$PWD/cachingmodelmanagerbenchmark.cpp \
+    $$PWD/loadandstorestrategybenchmark.cpp
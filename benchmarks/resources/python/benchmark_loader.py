@@ -0,0 +1,66 @@
+"""Reads the datasets of the benchmarks, which are in the format of the JSON strategy,
+through the Python strategy.
+"""
+
+import json
+import os
+
+
+def _read_json(path):
+    with open(path, 'r') as json_file:
+        return json.load(json_file)
+
+
+def _floats(values):
+    # Integral values are read as ints but the strategy expects floats
+    return [float(value) for value in values]
+
+
+def load_images(images_path, segmentation_images_path):
+    camera_info = _read_json(os.path.join(images_path, 'info.json'))
+    filenames = sorted(filename for filename in os.listdir(images_path)
+                       if filename.endswith('.png'))
+    images = []
+    for index, filename in enumerate(filenames):
+        images.append({'img_id': index,
+                       'img_path': filename,
+                       'base_path': images_path,
+                       'K': _floats(camera_info[filename]['K'])})
+    return images
+
+
+def load_object_models(object_models_path):
+    filenames = sorted(filename for filename in os.listdir(object_models_path)
+                       if filename.endswith('.obj'))
+    return [{'obj_id': index,
+             'obj_model_path': filename,
+             'base_path': object_models_path}
+            for index, filename in enumerate(filenames)]
+
+
+def load_poses(poses_file_path):
+    poses = _read_json(poses_file_path)
+    result = []
+    for image_path, entries in poses.items():
+        result.append([{'pose_id': entry['id'],
+                        'img_path': image_path,
+                        'obj_model_path': entry['obj'],
+                        'R': _floats(entry['R']),
+                        't': _floats(entry['t'])}
+                       for entry in entries])
+    return result
+
+
+def persist_pose(poses_file_path, pose_id, image_id, image_path, obj_id,
+                 obj_model_path, rotation, translation, delete):
+    poses = _read_json(poses_file_path)
+    entries = [entry for entry in poses.get(image_path, []) if entry['id'] != pose_id]
+    if not delete:
+        entries.append({'id': pose_id,
+                        'obj': obj_model_path,
+                        'R': list(rotation),
+                        't': list(translation)})
+    poses[image_path] = entries
+    with open(poses_file_path, 'w') as json_file:
+        json.dump(poses, json_file)
+    return True
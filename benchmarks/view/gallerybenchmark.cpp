@@ -0,0 +1,66 @@
+#include "gallerybenchmark.hpp"
+#include "benchmarkdataset.hpp"
+
+#include <model/jsonloadandstorestrategy.hpp>
+#include <view/gallery/resizeimagesrunnable.hpp>
+#include <view/rendering/offscreenengine.hpp>
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+
+void GalleryBenchmark::resizeImages_data() {
+    QTest::addColumn<QSize>("imageSize");
+    QTest::newRow("640x480") << QSize(640, 480);
+    QTest::newRow("1920x1080") << QSize(1920, 1080);
+    QTest::newRow("4096x3072") << QSize(4096, 3072);
+}
+
+void GalleryBenchmark::resizeImages() {
+    QFETCH(QSize, imageSize);
+    BenchmarkDataset dataset(20, 1, 0, imageSize);
+    QVERIFY(dataset.isValid());
+    JsonLoadAndStoreStrategy strategy;
+    strategy.setImagesPath(dataset.imagesPath());
+    QList<ImagePtr> images = strategy.loadImages();
+    QCOMPARE(images.size(), dataset.numberOfImages());
+
+    int resizedImages = 0;
+    QBENCHMARK {
+        // Runs on this thread instead of the thread pool of the gallery
+        ResizeImagesRunnable runnable(images);
+        connect(&runnable, &ResizeImagesRunnable::imageResized,
+                [&resizedImages](int, const QString &, const QImage &image) {
+            resizedImages += image.isNull() ? 0 : 1;
+        });
+        runnable.run();
+    }
+    QVERIFY(resizedImages >= images.size());
+}
+
+void GalleryBenchmark::renderObjectModelPreview() {
+    QOffscreenSurface surface;
+    surface.create();
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        QSKIP("No OpenGL context available for offscreen rendering.");
+    }
+    context.doneCurrent();
+
+    BenchmarkDataset dataset(1, 1, 0);
+    QVERIFY(dataset.isValid());
+    JsonLoadAndStoreStrategy strategy;
+    strategy.setObjectModelsPath(dataset.objectModelsPath());
+    QList<ObjectModelPtr> objectModels = strategy.loadObjectModels();
+    QCOMPARE(objectModels.size(), 1);
+
+    OffscreenEngine engine(QSize(300, 300));
+    QSignalSpy imageReadySpy(&engine, &OffscreenEngine::imageReady);
+    engine.setObjectModel(*objectModels.first());
+    // Loading the mesh is not part of rendering the preview
+    engine.requestImage();
+    QVERIFY(imageReadySpy.wait(10000));
+    QBENCHMARK {
+        engine.requestImage();
+        QVERIFY(imageReadySpy.wait(10000));
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef GALLERYBENCHMARK_H
+#define GALLERYBENCHMARK_H
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+/*!
+ * \brief The GalleryBenchmark class measures what the galleries spend their time on,
+ * i.e. creating the thumbnails of the images and rendering the previews of the object
+ * models offscreen.
+ */
+class GalleryBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void resizeImages_data();
+    void resizeImages();
+    //! Skipped if there is no OpenGL context to render with
+    void renderObjectModelPreview();
+};
+
+#endif // GALLERYBENCHMARK_H
@@ -0,0 +1,7 @@
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/gallerybenchmark.hpp
+
+SOURCES += \
+    $$PWD/gallerybenchmark.cpp
@@ -1,2 +1,5 @@
 INCLUDEPATH += $$PWD/src
-SRC_DIR = $$PWD
\ No newline at end of file
+SRC_DIR = $$PWD
+
+# Build with CONFIG+=tracing to record the TRACE_* spans, see misc/tracing.hpp
+tracing: DEFINES += ENABLE_TRACING
@@ -2,8 +2,12 @@ INCLUDEPATH += $$PWD
 
 HEADERS  += \
     $$PWD/poseseditingcontroller.hpp \
+    $$PWD/poseedithistory.hpp \
+    $$PWD/posesavequeue.hpp \
     $$PWD/maincontroller.hpp
 
 SOURCES += \
     $$PWD/poseseditingcontroller.cpp \
+    $$PWD/poseedithistory.cpp \
+    $$PWD/posesavequeue.cpp \
     $$PWD/maincontroller.cpp
@@ -2,14 +2,22 @@
 #include "view/gallery/galleryimagemodel.hpp"
 #include "model/jsonloadandstorestrategy.hpp"
 #include "model/pythonloadandstorestrategy.hpp"
+#include "model/pythonprocessloadandstorestrategy.hpp"
+#include "misc/tracing.hpp"
+#include "misc/memoryaccounting.hpp"
 
 #include <QSplashScreen>
 #include <QFile>
 #include <QApplication>
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
 
 MainController::MainController(int &argc, char **argv, int)
     : QApplication(argc, argv)
     , m_modelManagerThread(new QThread) {
+    // Shows up in traces
+    m_modelManagerThread->setObjectName("Model manager thread");
 }
 
 MainController::~MainController() {
@@ -24,14 +32,35 @@ int MainController::exec() {
 
     initialize();
 
+#ifdef ENABLE_TRACING
+    connect(this, &QCoreApplication::aboutToQuit, this, &MainController::writeTrace);
+#endif
+
     return QApplication::exec();
 }
 
+void MainController::writeTrace() {
+    QString traceFilePath = qEnvironmentVariable("SIXDPAT_TRACE_FILE");
+    if (traceFilePath.isEmpty()) {
+        traceFilePath = QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation))
+                .filePath("6dpat-trace.json");
+    }
+    if (Tracer::instance()->writeChromeTrace(traceFilePath)) {
+        qDebug() << "Wrote trace to " + traceFilePath;
+    } else {
+        qWarning() << "Failed to write trace to " + traceFilePath;
+    }
+}
+
 void MainController::initialize() {
     m_settingsStore.reset(new SettingsStore(m_settingsIdentifier));
     Settings tmp(*m_settingsStore->currentSettings());
     m_currentSettings.reset(new Settings(tmp));
 
+    // Checks every 5 seconds whether the system runs low on memory and logs the usage of
+    // the caches every minute
+    MemoryAccounting::instance()->startMonitoring(5000, 60000);
+
     initializeStrategies();
     selectCurrentStrategy();
 
@@ -42,9 +71,10 @@ void MainController::initialize() {
             m_modelManager.get(), &ModelManager::reload);
     m_modelManager->moveToThread(m_modelManagerThread);
     m_modelManagerThread->start();
+    m_asyncModelManager.reset(new AsyncModelManager(m_modelManager.get()));
     connect(m_settingsStore.data(), &SettingsStore::currentSettingsChanged,
             this, &MainController::onSettingsChanged);
-    m_mainWindow.reset(new MainWindow(0, m_modelManager.get(), m_settingsStore.get()));
+    m_mainWindow.reset(new MainWindow(0, m_asyncModelManager.get(), m_settingsStore.get()));
     connect(m_mainWindow.get(), &MainWindow::reloadViewsRequested,
             this, &MainController::onReloadViewsRequested);
     connect(m_modelManager.get(), &ModelManager::stateChanged,
@@ -54,6 +84,7 @@ void MainController::initialize() {
     m_mainWindow->poseEditor()->setSettingsStore(m_settingsStore.get());
 
     showView();
+    warmUpCurrentStrategy();
 
     m_splashScreen = new SplashScreen();
     // Make it an infinite progress bar
@@ -65,7 +96,8 @@ void MainController::initialize() {
     });
 
     // Call here since we need the model manager and the main window
-    m_poseEditingController.reset(new PosesEditingController(Q_NULLPTR, m_modelManager.get(), m_mainWindow.get()));
+    m_poseEditingController.reset(new PosesEditingController(Q_NULLPTR, m_asyncModelManager.get(), m_mainWindow.get()));
+    m_poseEditingController->setSettingsStore(m_settingsStore.get());
 
     // This makes the ModelManager load data - don't call it before creating the MainWindow as we
     // want to show the progress loading view in the ModelManager state change callback
@@ -80,8 +112,13 @@ void MainController::initializeStrategies() {
     // Python doesn't like to be destroyed...
     m_strategies[Settings::UsedLoadAndStoreStrategy::Default]
             = JsonLoadAndStoreStrategyPtr(new JsonLoadAndStoreStrategy);
+    // Constructing the Python strategy is cheap, the interpreter is only
+    // started when the strategy is used
     m_strategies[Settings::UsedLoadAndStoreStrategy::Python]
             = PythonLoadAndStoreStrategyPtr(new PythonLoadAndStoreStrategy);
+    // Starts its worker processes on first use as well
+    m_strategies[Settings::UsedLoadAndStoreStrategy::PythonProcesses]
+            = PythonProcessLoadAndStoreStrategyPtr(new PythonProcessLoadAndStoreStrategy);
 
     // Move the strategies to a new thread to allow threadded data loading
     // This also means that we have to call the strategy's methods
@@ -98,6 +135,17 @@ void MainController::selectCurrentStrategy() {
     m_currentStrategy->applySettings(m_currentSettings);
 }
 
+void MainController::warmUpCurrentStrategy() {
+    PythonLoadAndStoreStrategy *pythonStrategy =
+            qobject_cast<PythonLoadAndStoreStrategy*>(m_currentStrategy.data());
+    if (pythonStrategy) {
+        // Start the interpreter on the model manager thread while the UI is
+        // already visible instead of blocking the startup
+        QMetaObject::invokeMethod(pythonStrategy, &PythonLoadAndStoreStrategy::warmUp,
+                                  Qt::QueuedConnection);
+    }
+}
+
 void MainController::showView() {
     m_mainWindow->show();
     m_mainWindow->raise();
@@ -2,6 +2,7 @@
 #define MAINCONTROLLER_H
 
 #include "model/cachingmodelmanager.hpp"
+#include "model/asyncmodelmanager.hpp"
 #include "model/loadandstorestrategy.hpp"
 #include "settings/settingsstore.hpp"
 #include "view/mainwindow.hpp"
@@ -43,6 +44,12 @@ private Q_SLOTS:
     void onReloadViewsRequested();
     void onModelManagerStateChanged(ModelManager::State state,
                                     const QString &error);
+    /*!
+     * \brief writeTrace writes the recorded trace when the program quits, to the file in
+     * the environment variable SIXDPAT_TRACE_FILE or 6dpat-trace.json in the temporary
+     * folder. Only connected in builds with CONFIG+=tracing.
+     */
+    void writeTrace();
 
 private:
     /*!
@@ -51,6 +58,7 @@ private:
     void initialize();
     void initializeStrategies();
     void selectCurrentStrategy();
+    void warmUpCurrentStrategy();
 
     /*!
      * \brief showView shows the view of this controller.
@@ -73,6 +81,8 @@ private:
     LoadAndStoreStrategyPtr m_currentStrategy;
     QScopedPointer<CachingModelManager> m_modelManager;
     QThread *m_modelManagerThread;
+    //! Everything outside of the model manager's thread talks to the manager through this
+    QScopedPointer<AsyncModelManager> m_asyncModelManager;
     QScopedPointer<PosesEditingController> m_poseEditingController;
 
     QScopedPointer<MainWindow> m_mainWindow;
@@ -0,0 +1,214 @@
+#include "poseedithistory.hpp"
+
+#include <algorithm>
+
+PoseEditHistory::PoseEditHistory(int memoryBudget, int coalesceInterval)
+    : m_memoryBudget(memoryBudget)
+    , m_coalesceInterval(coalesceInterval) {
+}
+
+void PoseEditHistory::setMemoryBudget(int memoryBudget) {
+    m_memoryBudget = memoryBudget;
+    dropRedoSteps();
+    const int capacity = qMax(1, m_memoryBudget / int(sizeof(PoseEdit)));
+    while (m_count > 0 && (m_count > capacity || m_memoryUsage > m_memoryBudget)) {
+        dropOldestStep();
+    }
+    // Give back the slots that the smaller budget doesn't allow anymore
+    if (m_edits.size() > capacity) {
+        QVector<PoseEdit> edits;
+        edits.reserve(m_count);
+        for (int i = 0; i < m_count; i++) {
+            edits.append(at(i));
+        }
+        m_edits = edits;
+        m_first = 0;
+    }
+}
+
+int PoseEditHistory::memoryBudget() const {
+    return m_memoryBudget;
+}
+
+int PoseEditHistory::memoryUsage() const {
+    return m_memoryUsage;
+}
+
+void PoseEditHistory::setCoalesceInterval(int coalesceInterval) {
+    m_coalesceInterval = coalesceInterval;
+}
+
+int PoseEditHistory::coalesceInterval() const {
+    return m_coalesceInterval;
+}
+
+void PoseEditHistory::recordModified(const PosePtr &pose,
+                                     const QVector3D &positionBefore,
+                                     const QQuaternion &rotationBefore,
+                                     const QVector3D &positionAfter,
+                                     const QQuaternion &rotationAfter) {
+    if (positionBefore == positionAfter && rotationBefore == rotationAfter) {
+        return;
+    }
+    if (m_coalescing && m_cursor > 0 && m_cursor == m_count
+            && m_lastModification.elapsed() < m_coalesceInterval) {
+        PoseEdit &last = at(m_cursor - 1);
+        if (last.type == PoseEdit::Modified && last.pose == pose) {
+            // Still the same drag, only the final values matter
+            last.positionAfter = positionAfter;
+            last.rotationAfter = rotationAfter;
+            m_lastModification.restart();
+            return;
+        }
+    }
+    PoseEdit edit;
+    edit.pose = pose;
+    edit.positionBefore = positionBefore;
+    edit.positionAfter = positionAfter;
+    edit.rotationBefore = rotationBefore;
+    edit.rotationAfter = rotationAfter;
+    edit.step = m_nextStep++;
+    edit.type = PoseEdit::Modified;
+    push(edit);
+    m_coalescing = true;
+    m_lastModification.restart();
+}
+
+void PoseEditHistory::recordAdded(const QList<PosePtr> &poses) {
+    seal();
+    if (poses.isEmpty()) {
+        return;
+    }
+    PoseEdit edit;
+    edit.type = PoseEdit::Added;
+    if (poses.size() * costOf(edit) > m_memoryBudget) {
+        // The step alone doesn't fit, keeping the older ones would allow to undo them
+        // without undoing this one first
+        clear();
+        return;
+    }
+    edit.step = m_nextStep++;
+    for (const PosePtr &pose : poses) {
+        edit.pose = pose;
+        push(edit);
+    }
+}
+
+void PoseEditHistory::recordRemoved(const PosePtr &pose) {
+    seal();
+    PoseEdit edit;
+    edit.pose = pose;
+    edit.step = m_nextStep++;
+    edit.type = PoseEdit::Removed;
+    push(edit);
+}
+
+void PoseEditHistory::seal() {
+    m_coalescing = false;
+}
+
+bool PoseEditHistory::canUndo() const {
+    return m_cursor > 0;
+}
+
+bool PoseEditHistory::canRedo() const {
+    return m_cursor < m_count;
+}
+
+QVector<PoseEdit> PoseEditHistory::undo() {
+    QVector<PoseEdit> edits;
+    seal();
+    if (!canUndo()) {
+        return edits;
+    }
+    const quint32 step = at(m_cursor - 1).step;
+    while (m_cursor > 0 && at(m_cursor - 1).step == step) {
+        edits.append(at(m_cursor - 1));
+        m_cursor--;
+    }
+    return edits;
+}
+
+QVector<PoseEdit> PoseEditHistory::redo() {
+    QVector<PoseEdit> edits;
+    seal();
+    if (!canRedo()) {
+        return edits;
+    }
+    const quint32 step = at(m_cursor).step;
+    while (m_cursor < m_count && at(m_cursor).step == step) {
+        edits.append(at(m_cursor));
+        m_cursor++;
+    }
+    return edits;
+}
+
+void PoseEditHistory::clear() {
+    m_edits.clear();
+    m_first = 0;
+    m_count = 0;
+    m_cursor = 0;
+    m_memoryUsage = 0;
+    m_coalescing = false;
+}
+
+void PoseEditHistory::push(const PoseEdit &edit) {
+    dropRedoSteps();
+    const int cost = costOf(edit);
+    const int capacity = qMax(1, m_memoryBudget / int(sizeof(PoseEdit)));
+    while (m_count > 0 && (m_count >= capacity || m_memoryUsage + cost > m_memoryBudget)) {
+        dropOldestStep();
+    }
+    if (m_count < m_edits.size()) {
+        at(m_count) = edit;
+    } else {
+        // The ring is full but the budget allows more slots, e.g. because it was raised
+        std::rotate(m_edits.begin(), m_edits.begin() + m_first, m_edits.end());
+        m_first = 0;
+        m_edits.append(edit);
+    }
+    m_count++;
+    m_cursor++;
+    m_memoryUsage += cost;
+}
+
+void PoseEditHistory::dropOldestStep() {
+    const quint32 step = at(0).step;
+    while (m_count > 0 && at(0).step == step) {
+        m_memoryUsage -= costOf(at(0));
+        // Releases the pose
+        at(0) = PoseEdit();
+        m_first = (m_first + 1) % m_edits.size();
+        m_count--;
+        m_cursor = qMax(0, m_cursor - 1);
+    }
+    if (m_count == 0) {
+        m_first = 0;
+        m_coalescing = false;
+    }
+}
+
+void PoseEditHistory::dropRedoSteps() {
+    while (m_count > m_cursor) {
+        m_count--;
+        m_memoryUsage -= costOf(at(m_count));
+        at(m_count) = PoseEdit();
+    }
+}
+
+PoseEdit &PoseEditHistory::at(int index) {
+    return m_edits[(m_first + index) % m_edits.size()];
+}
+
+const PoseEdit &PoseEditHistory::at(int index) const {
+    return m_edits[(m_first + index) % m_edits.size()];
+}
+
+int PoseEditHistory::costOf(const PoseEdit &edit) {
+    int cost = int(sizeof(PoseEdit));
+    if (edit.type != PoseEdit::Modified) {
+        // The history might be the only one left holding on to an added or removed pose
+        cost += int(sizeof(Pose));
+    }
+    return cost;
+}
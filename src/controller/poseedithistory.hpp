@@ -0,0 +1,122 @@
+#ifndef POSEEDITHISTORY_H
+#define POSEEDITHISTORY_H
+
+#include "model/pose.hpp"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QQuaternion>
+#include <QVector>
+#include <QVector3D>
+
+/*!
+ * \brief The PoseEdit struct is one change of one pose in the edit history. Modifications
+ * store the values before and after the change, additions and removals only the pose.
+ */
+struct PoseEdit {
+    enum Type : quint8 {
+        Modified,
+        Added,
+        Removed
+    };
+
+    PosePtr pose;
+    QVector3D positionBefore;
+    QVector3D positionAfter;
+    QQuaternion rotationBefore;
+    QQuaternion rotationAfter;
+    //! All edits of one step share the step, e.g. the poses copied from another image
+    quint32 step = 0;
+    Type type = Modified;
+};
+
+/*!
+ * \brief The PoseEditHistory class records the edits of the poses of the current image so
+ * that they can be undone and redone. Edits are kept in a ring buffer of fixed size slots,
+ * when the memory budget is used up the oldest steps are dropped. Undoing or redoing a
+ * step only moves the cursor, i.e. it doesn't depend on the length of the history.
+ *
+ * Dragging a pose changes it on every mouse move. Modifications of the same pose that
+ * follow each other within the coalesce interval are merged into one step, so that
+ * undoing reverts the whole drag.
+ */
+class PoseEditHistory {
+
+public:
+    explicit PoseEditHistory(int memoryBudget = 4 * 1024 * 1024, int coalesceInterval = 500);
+
+    /*!
+     * \brief setMemoryBudget sets the number of bytes the history may use, the oldest steps
+     * are dropped if it is exceeded.
+     */
+    void setMemoryBudget(int memoryBudget);
+    int memoryBudget() const;
+    //! The estimated number of bytes used by the recorded edits
+    int memoryUsage() const;
+
+    /*!
+     * \brief setCoalesceInterval sets the time in milliseconds after which a modification of
+     * the same pose starts a new step.
+     */
+    void setCoalesceInterval(int coalesceInterval);
+    int coalesceInterval() const;
+
+    //! Records a modification, merging it with the previous one if they belong to one drag
+    void recordModified(const PosePtr &pose,
+                        const QVector3D &positionBefore,
+                        const QQuaternion &rotationBefore,
+                        const QVector3D &positionAfter,
+                        const QQuaternion &rotationAfter);
+    //! Records the addition of the poses as one step
+    void recordAdded(const QList<PosePtr> &poses);
+    void recordRemoved(const PosePtr &pose);
+    /*!
+     * \brief seal ends the current drag, the next modification starts a new step even if it
+     * changes the same pose.
+     */
+    void seal();
+
+    bool canUndo() const;
+    bool canRedo() const;
+    /*!
+     * \brief undo moves the cursor back by one step.
+     * \return the edits of the step, the most recent one first
+     */
+    QVector<PoseEdit> undo();
+    /*!
+     * \brief redo moves the cursor forward by one step.
+     * \return the edits of the step in the order they were recorded
+     */
+    QVector<PoseEdit> redo();
+    void clear();
+
+private:
+    //! Appends the edit to the current step, everything that could be redone is dropped
+    void push(const PoseEdit &edit);
+    //! Drops all edits of the oldest step
+    void dropOldestStep();
+    //! Drops all edits after the cursor
+    void dropRedoSteps();
+    //! The edit at the given position, counted from the oldest one
+    PoseEdit &at(int index);
+    const PoseEdit &at(int index) const;
+    static int costOf(const PoseEdit &edit);
+
+private:
+    //! Grows until it holds as many edits as the budget allows, is used as a ring afterwards
+    QVector<PoseEdit> m_edits;
+    //! The slot of the oldest edit
+    int m_first = 0;
+    //! The number of recorded edits, the ones before the cursor can be undone
+    int m_count = 0;
+    int m_cursor = 0;
+    int m_memoryBudget;
+    int m_memoryUsage = 0;
+    quint32 m_nextStep = 1;
+    int m_coalesceInterval;
+    //! Set while the last step is a modification that further ones can be merged into
+    bool m_coalescing = false;
+    QElapsedTimer m_lastModification;
+};
+
+#endif // POSEEDITHISTORY_H
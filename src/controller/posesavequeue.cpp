@@ -0,0 +1,75 @@
+#include "posesavequeue.hpp"
+
+#include <QCoreApplication>
+#include <QSet>
+
+bool PoseSaveJob::isEmpty() const {
+    return posesToAdd.isEmpty() && posesToUpdate.isEmpty() && poseIdsToRemove.isEmpty();
+}
+
+bool PoseSaveResult::success() const {
+    return failedAdds.isEmpty() && failedUpdates.isEmpty() && failedRemoves.isEmpty();
+}
+
+PoseSaveQueue::PoseSaveQueue(AsyncModelManager *modelManager, QObject *parent)
+    : QObject(parent)
+    , m_modelManager(modelManager) {
+    // Nothing the user saved may get lost when the program is closed
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &PoseSaveQueue::flush);
+}
+
+PoseSaveQueue::~PoseSaveQueue() {
+    flush();
+}
+
+void PoseSaveQueue::submit(const PoseSaveJob &job,
+                           std::function<void()> completed,
+                           std::function<void(const PoseSaveResult &)> failed) {
+    m_pendingJobs++;
+    m_lastJob = m_modelManager->run<void>([this, job, completed, failed](ModelManager *modelManager) {
+        const PoseSaveResult result = execute(modelManager, job);
+        QMetaObject::invokeMethod(this, [this, result, completed, failed]() {
+            m_pendingJobs--;
+            if (result.success()) {
+                if (completed) {
+                    completed();
+                }
+            } else if (failed) {
+                failed(result);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+PoseSaveResult PoseSaveQueue::execute(ModelManager *modelManager, const PoseSaveJob &job) {
+    // One call so that the job is persisted as a whole, whatever is missing in the
+    // returned IDs failed
+    const QSet<QString> savedIds = QSet<QString>::fromList(
+                modelManager->savePoses(job.posesToAdd, job.posesToUpdate, job.poseIdsToRemove));
+    PoseSaveResult result;
+    for (const PosePtr &pose : job.posesToAdd) {
+        if (!savedIds.contains(pose->id())) {
+            result.failedAdds.append(pose->id());
+        }
+    }
+    for (const PosePtr &pose : job.posesToUpdate) {
+        if (!savedIds.contains(pose->id())) {
+            result.failedUpdates.append(pose->id());
+        }
+    }
+    for (const QString &id : job.poseIdsToRemove) {
+        if (!savedIds.contains(id)) {
+            result.failedRemoves.append(id);
+        }
+    }
+    return result;
+}
+
+void PoseSaveQueue::flush() {
+    if (m_pendingJobs == 0) {
+        return;
+    }
+    m_lastJob.waitForFinished();
+    // Deliver the callbacks of the executed jobs right away
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
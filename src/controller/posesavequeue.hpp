@@ -0,0 +1,86 @@
+#ifndef POSESAVEQUEUE_H
+#define POSESAVEQUEUE_H
+
+#include "model/pose.hpp"
+#include "model/asyncmodelmanager.hpp"
+
+#include <QObject>
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+/*!
+ * \brief The PoseSaveJob struct holds the changes to the poses of one image that are to
+ * be persisted together. The poses are copies, i.e. the views can keep on modifying the
+ * original ones while the job is waiting or running.
+ */
+struct PoseSaveJob {
+    //! The image whose poses are saved
+    QString imagePath;
+    QList<PosePtr> posesToAdd;
+    //! Poses with the values they are to be updated to
+    QList<PosePtr> posesToUpdate;
+    QStringList poseIdsToRemove;
+
+    bool isEmpty() const;
+};
+
+/*!
+ * \brief The PoseSaveResult struct lists the changes of a job that could not be persisted.
+ * The model manager has already reported the actual errors when the callback is called.
+ */
+struct PoseSaveResult {
+    QStringList failedAdds;
+    QStringList failedUpdates;
+    QStringList failedRemoves;
+
+    bool success() const;
+};
+
+/*!
+ * \brief The PoseSaveQueue class persists poses through the model manager on the model
+ * manager's thread, so that the GUI never waits for the strategy to rewrite files or to
+ * call Python. Every job is one command of the AsyncModelManager, i.e. jobs are executed
+ * strictly in the order they were submitted. Their callbacks are called on the thread of
+ * the queue.
+ */
+class PoseSaveQueue : public QObject {
+
+    Q_OBJECT
+
+public:
+    PoseSaveQueue(AsyncModelManager *modelManager, QObject *parent = Q_NULLPTR);
+    ~PoseSaveQueue();
+
+    /*!
+     * \brief submit queues the job for execution on the model manager's thread.
+     * \param completed called when all changes of the job have been persisted
+     * \param failed called with the changes that couldn't be persisted otherwise
+     */
+    void submit(const PoseSaveJob &job,
+                std::function<void()> completed,
+                std::function<void(const PoseSaveResult &)> failed);
+
+public Q_SLOTS:
+    /*!
+     * \brief flush blocks until all submitted jobs have been executed and calls their
+     * callbacks. It is called automatically before the application quits.
+     */
+    void flush();
+
+private:
+    //! Executed on the model manager's thread
+    static PoseSaveResult execute(ModelManager *modelManager, const PoseSaveJob &job);
+
+private:
+    AsyncModelManager *m_modelManager;
+    //! Commands are executed in order, once this one has finished all jobs have
+    QFuture<void> m_lastJob;
+    //! The number of jobs whose callbacks haven't been called yet
+    int m_pendingJobs = 0;
+};
+
+#endif // POSESAVEQUEUE_H
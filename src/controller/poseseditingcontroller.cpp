@@ -3,23 +3,35 @@
 #include "view/poseviewer/poseviewer.hpp"
 #include "view/gallery/galleryobjectmodels.hpp"
 #include "misc/generalhelper.hpp"
+#include "misc/tracing.hpp"
 
-#include <iostream>
 #include <QList>
-#include <opencv2/calib3d/calib3d.hpp>
-#include <opencv2/core/core.hpp>
-#include <opencv2/imgproc/imgproc.hpp>
+#include <QSet>
+#include <algorithm>
+#include <type_traits>
 
-PosesEditingController::PosesEditingController(QObject *parent, ModelManager *modelManager, MainWindow *mainWindow)
+PosesEditingController::PosesEditingController(QObject *parent, AsyncModelManager *modelManager, MainWindow *mainWindow)
     : QObject(parent)
     , m_modelManager(modelManager)
-    , m_mainWindow(mainWindow) {
+    , m_mainWindow(mainWindow)
+    , m_poseSaveQueue(modelManager) {
 
     // Check whether we have poses to save before the manager reloads
-    connect(modelManager, &ModelManager::stateChanged,
+    connect(modelManager, &AsyncModelManager::stateChanged,
             this, &PosesEditingController::modelManagerStateChanged);
-    connect(modelManager, &ModelManager::dataChanged,
+    connect(modelManager, &AsyncModelManager::dataChanged,
             this, &PosesEditingController::onDataChanged);
+    // Partial reloads, only the affected images are reset
+    connect(modelManager, &AsyncModelManager::imagesChanged,
+            this, &PosesEditingController::onImagesChanged);
+    connect(modelManager, &AsyncModelManager::objectModelsChanged,
+            this, &PosesEditingController::onObjectModelsChanged);
+    connect(modelManager, &AsyncModelManager::posesReloaded,
+            this, &PosesEditingController::onPosesReloaded);
+    connect(&m_posesForImageWatcher, &QFutureWatcher<QList<PosePtr>>::finished,
+            this, &PosesEditingController::onPosesForImageLoaded);
+    connect(&m_posesToCopyWatcher, &QFutureWatcher<QList<PosePtr>>::finished,
+            this, &PosesEditingController::onPosesToCopyLoaded);
 
     // Connect the PoseEditor and PoseViewer to the PoseEditingController
     connect(this, &PosesEditingController::selectedPoseChanged,
@@ -58,6 +70,36 @@ PosesEditingController::PosesEditingController(QObject *parent, ModelManager *mo
             this, &PosesEditingController::createPose);
     connect(mainWindow->poseViewer(), &PoseViewer::imageClicked,
             this, &PosesEditingController::add2DPoint);
+    connect(&m_poseRecoveringWatcher, &QFutureWatcher<PoseRecoveringResult>::finished,
+            this, &PosesEditingController::onPoseRecoveringFinished);
+
+    // React to pose refining
+    connect(mainWindow->poseEditor(), &PoseEditor::buttonRefineClicked,
+            this, &PosesEditingController::refineSelectedPose);
+    connect(mainWindow, &MainWindow::refineAllPosesRequested,
+            this, &PosesEditingController::refineAllPoses);
+    connect(&m_poseRefinementTasksWatcher, &QFutureWatcher<QList<PoseRefinementTask>>::finished,
+            this, &PosesEditingController::onPoseRefinementTasksCreated);
+    connect(&m_poseRefiningWatcher, &QFutureWatcher<PoseRefinementResult>::finished,
+            this, &PosesEditingController::onPoseRefiningFinished);
+    connect(&m_posesRefiningWatcher, &QFutureWatcher<PoseRefinementResult>::progressValueChanged,
+            this, &PosesEditingController::onPosesRefiningProgressChanged);
+    connect(&m_posesRefiningWatcher, &QFutureWatcher<PoseRefinementResult>::finished,
+            this, &PosesEditingController::onPosesRefiningFinished);
+    connect(&m_refinedPosesUpdatingWatcher, &QFutureWatcher<QStringList>::finished,
+            this, &PosesEditingController::onRefinedPosesUpdated);
+
+    // React to pose propagating
+    connect(mainWindow, &MainWindow::propagatePosesToSceneRequested,
+            this, &PosesEditingController::propagatePosesToScene);
+    connect(&m_posesToPropagateWatcher, &QFutureWatcher<QPair<QList<PosePtr>, QList<PosePtr>>>::finished,
+            this, &PosesEditingController::onPosesToPropagateLoaded);
+    connect(&m_posesPropagatingWatcher, &QFutureWatcher<QList<PropagatedPose>>::progressValueChanged,
+            this, &PosesEditingController::onPosesPropagatingProgressChanged);
+    connect(&m_posesPropagatingWatcher, &QFutureWatcher<QList<PropagatedPose>>::finished,
+            this, &PosesEditingController::onPosesPropagatingFinished);
+    connect(&m_propagatedPosesAddingWatcher, &QFutureWatcher<QList<PosePtr>>::finished,
+            this, &PosesEditingController::onPropagatedPosesAdded);
 
     // React to mainwindow signals
     connect(mainWindow, &MainWindow::closingProgram,
@@ -66,6 +108,10 @@ PosesEditingController::PosesEditingController(QObject *parent, ModelManager *mo
             this, &PosesEditingController::abortPoseCreation);
     connect(mainWindow, &MainWindow::resetRequested,
             this, &PosesEditingController::reset);
+    connect(mainWindow, &MainWindow::undoRequested,
+            this, &PosesEditingController::undo);
+    connect(mainWindow, &MainWindow::redoRequested,
+            this, &PosesEditingController::redo);
 
     connect(mainWindow->galleryImages(), &Gallery::selectedItemChanged,
             this, &PosesEditingController::onSelectedImageChanged);
@@ -73,13 +119,12 @@ PosesEditingController::PosesEditingController(QObject *parent, ModelManager *mo
             this, &PosesEditingController::onSelectedObjectModelChanged);
 }
 
+void PosesEditingController::setSettingsStore(SettingsStore *settingsStore) {
+    m_settingsStore = settingsStore;
+}
+
 void PosesEditingController::selectPose(PosePtr pose) {
-    if (!m_selectedPose.isNull()) {
-        disconnect(m_selectedPose.get(), &Pose::positionChanged,
-                   this, &PosesEditingController::onPosePositionChanged);
-        disconnect(m_selectedPose.get(), &Pose::rotationChanged,
-                   this, &PosesEditingController::onPoseRotationChanged);
-    }
+    disconnectSelectedPose();
     if (pose == m_selectedPose || pose.isNull()) {
         // When starting the program sometimes the gallery hasn't been initialized yet
         // m_mainWindow->galleryObjectModels()->clearSelection(false);
@@ -90,10 +135,7 @@ void PosesEditingController::selectPose(PosePtr pose) {
     } else {
         PosePtr oldPose = m_selectedPose;
         m_selectedPose = pose;
-        connect(m_selectedPose.get(), &Pose::positionChanged,
-                this, &PosesEditingController::onPosePositionChanged);
-        connect(m_selectedPose.get(), &Pose::rotationChanged,
-                this, &PosesEditingController::onPoseRotationChanged);
+        connectSelectedPose();
         m_mainWindow->galleryObjectModels()->selectObjectModelByID(*pose->objectModel(), false);
         Q_EMIT selectedPoseChanged(m_selectedPose, oldPose);
     }
@@ -108,42 +150,35 @@ void PosesEditingController::addPose(PosePtr pose) {
     // the pose doesn't exist in the model manager yet
     // -> actual persisting happens when saving everything
     Q_ASSERT(pose);
-    m_posesToAdd.append(pose);
-    m_posesForImage.append(pose);
+    attachPose(pose);
+    m_editHistory.recordAdded({pose});
     m_mainWindow->poseEditor()->addPose(pose);
     m_mainWindow->poseViewer()->addPose(pose);
     enableSaveButtonOnPoseEditor();
     // No need to actual emit the selected pose changed signal
     // here because PoseViewer and PoseEditor already
     // select the new pose interally
+    disconnectSelectedPose();
     m_selectedPose = pose;
+    connectSelectedPose();
     abortPoseCreation();
+    enableUndoRedoActions();
 }
 
 void PosesEditingController::removePose() {
-    for (int i = 0; i < m_posesForImage.size(); i++) {
-        if (m_posesForImage[i] == m_selectedPose) {
-            m_posesForImage.removeAt(i);
-            break;
-        }
-    }
-    // Check if the pose has only been added
-    bool poseHasJustBeenAdded = false;
-    for (int i = 0; i < m_posesToAdd.size(); i++) {
-        if (m_posesToAdd[i] == m_selectedPose) {
-            m_posesToAdd.removeAt(i);
-            poseHasJustBeenAdded = true;
-            break;
-        }
-    }
-    if (!poseHasJustBeenAdded) {
-        m_posesToRemove.append(m_selectedPose);
+    if (m_selectedPose.isNull()) {
+        return;
     }
-    m_mainWindow->poseViewer()->removePose(m_selectedPose);
-    m_mainWindow->poseEditor()->removePose(m_selectedPose);
+    PosePtr pose = m_selectedPose;
+    disconnectSelectedPose();
+    detachPose(pose);
+    m_editHistory.recordRemoved(pose);
+    m_mainWindow->poseViewer()->removePose(pose);
+    m_mainWindow->poseEditor()->removePose(pose);
     abortPoseCreation();
     m_selectedPose.reset();
     enableSaveButtonOnPoseEditor();
+    enableUndoRedoActions();
     // Save button of PoseEditor gets enabled or disabled
     // by receiving the signal of pose selected
     Q_EMIT selectedPoseChanged(PosePtr(), PosePtr());
@@ -155,15 +190,92 @@ void PosesEditingController::duplicatePose() {
 
 void PosesEditingController::copyPosesFromImage(ImagePtr image) {
     abortPoseCreation();
-    QList<PosePtr> poses = m_modelManager->posesForImage(*image);
+    if (m_currentImage.isNull()) {
+        return;
+    }
+    m_imageToCopyPosesFrom = image;
+    m_imageToCopyPosesTo = m_currentImage;
+    // Commands are executed in order, i.e. poses that are still being saved are included
+    m_posesToCopyWatcher.setFuture(m_modelManager->posesForImage(image));
+}
+
+void PosesEditingController::onPosesToCopyLoaded() {
+    const QList<PosePtr> poses = m_posesToCopyWatcher.result();
+    ImagePtr image = m_imageToCopyPosesFrom;
+    ImagePtr currentImage = m_imageToCopyPosesTo;
+    m_imageToCopyPosesFrom.reset();
+    m_imageToCopyPosesTo.reset();
+    if (currentImage.isNull() || currentImage != m_currentImage) {
+        // The user selected a different image in the meantime
+        return;
+    }
+    QList<PosePtr> newPoses;
     for (const PosePtr &pose : poses) {
         PosePtr newPose = createNewPoseFromPose(pose);
-        m_posesToAdd.append(newPose);
-        m_posesForImage.append(newPose);
+        // Poses are relative to the camera, if it moved between the images (and we know
+        // how) the pose has to be transformed to stay at the same place in the world
+        QVector3D position;
+        QMatrix3x3 rotation;
+        if (PosePropagator::transformPose(pose->position(), pose->rotation().toRotationMatrix(),
+                                          *image, *m_currentImage, position, rotation)) {
+            newPose->setPosition(position);
+            newPose->setRotation(rotation);
+        }
+        attachPose(newPose);
+        newPoses.append(newPose);
     }
+    // Undoing the copy removes all copied poses at once
+    m_editHistory.recordAdded(newPoses);
     m_mainWindow->poseEditor()->setPoses(m_posesForImage);
     m_mainWindow->poseEditor()->setEnabledButtonSave(true);
     m_mainWindow->poseViewer()->setPoses(m_posesForImage);
+    enableUndoRedoActions();
+}
+
+void PosesEditingController::undo() {
+    applyEdits(m_editHistory.undo(), true);
+}
+
+void PosesEditingController::redo() {
+    applyEdits(m_editHistory.redo(), false);
+}
+
+void PosesEditingController::applyEdits(const QVector<PoseEdit> &edits, bool undo) {
+    if (edits.isEmpty()) {
+        return;
+    }
+    m_applyingEdits = true;
+    bool posesAddedOrRemoved = false;
+    for (const PoseEdit &edit : edits) {
+        if (edit.type == PoseEdit::Modified) {
+            edit.pose->setPosition(undo ? edit.positionBefore : edit.positionAfter);
+            edit.pose->setRotation(undo ? edit.rotationBefore : edit.rotationAfter);
+            updateDirtyState(edit.pose);
+        } else {
+            // Undoing an addition removes the pose and vice versa
+            if ((edit.type == PoseEdit::Added) != undo) {
+                attachPose(edit.pose);
+            } else {
+                detachPose(edit.pose);
+            }
+            posesAddedOrRemoved = true;
+        }
+    }
+    m_applyingEdits = false;
+
+    if (posesAddedOrRemoved) {
+        // The selected pose might be gone, set up the views like after copying poses
+        if (!m_selectedPose.isNull()) {
+            selectPose(PosePtr());
+        }
+        m_mainWindow->poseEditor()->setPoses(m_posesForImage);
+        m_mainWindow->poseViewer()->setPoses(m_posesForImage);
+    } else if (!m_selectedPose.isNull()) {
+        // The viewer follows the poses by itself, the editor only shows the selected one
+        Q_EMIT poseValuesChanged(m_selectedPose);
+    }
+    enableSaveButtonOnPoseEditor();
+    enableUndoRedoActions();
 }
 
 // Called from the setters of the pose
@@ -174,16 +286,24 @@ void PosesEditingController::onPoseChanged() {
     if (m_selectedPose.isNull()) {
         return;
     }
+    if (!m_applyingEdits) {
+        // Consecutive changes while dragging the pose become one step
+        m_editHistory.recordModified(m_selectedPose,
+                                     m_selectedPoseValues.position,
+                                     m_selectedPoseValues.rotation,
+                                     m_selectedPose->position(),
+                                     m_selectedPose->rotation());
+        enableUndoRedoActions();
+    }
+    m_selectedPoseValues = {.position = m_selectedPose->position(),
+                            .rotation = m_selectedPose->rotation()};
     if (m_posesToAdd.contains(m_selectedPose)) {
         // If the pose has just been added we do not need to store
         // its modified values, it will get saved anyways (or not
         // added when the user doesn't want it)
         return;
     }
-    // Only assign true when actually changed
-    PoseValues poseValues = m_unmodifiedPoses[m_selectedPose->id()];
-    m_dirtyPoses[m_selectedPose] = poseValues.position != m_selectedPose->position()
-                                    || poseValues.rotation != m_selectedPose->rotation();
+    updateDirtyState(m_selectedPose);
     enableSaveButtonOnPoseEditor();
     Q_EMIT poseValuesChanged(m_selectedPose);
 }
@@ -213,17 +333,64 @@ void PosesEditingController::onDataChanged(int /*data*/) {
     abortPoseCreation();
 
     // No matter what changed we need to reset the controller's state
+    disconnectSelectedPose();
     m_selectedPose.reset();
     // Disconnect from pose and fire signals
     selectPose(PosePtr());
     m_posesForImage.clear();
     m_dirtyPoses.clear();
     m_unmodifiedPoses.clear();
-    m_images = m_modelManager->images();
-    m_objectModels = m_modelManager->objectModels();
+    m_imageOfPosesLoading.reset();
+    clearEditHistory();
+    const ModelSnapshotPtr snapshot = m_modelManager->snapshot();
+    m_images = snapshot->images();
+    m_objectModels = snapshot->objectModels();
     m_mainWindow->poseEditor()->reset();
     m_mainWindow->poseEditor()->setImages(m_images);
     m_mainWindow->poseViewer()->reset();
+    // The kept renderables might show meshes that aren't part of the dataset anymore
+    m_mainWindow->poseViewer()->releaseUnusedObjectModels();
+}
+
+void PosesEditingController::onImagesChanged(const QList<ImagePtr> &images) {
+    m_images = images;
+    m_mainWindow->poseEditor()->setImages(m_images);
+}
+
+void PosesEditingController::onObjectModelsChanged(const QList<ObjectModelPtr> &objectModels) {
+    m_objectModels = objectModels;
+    // Reloaded object models might have different meshes than the kept renderables
+    m_mainWindow->poseViewer()->releaseUnusedObjectModels();
+}
+
+void PosesEditingController::onPosesReloaded(const QList<ImagePtr> &images) {
+    if (m_currentImage.isNull()) {
+        return;
+    }
+    const QString currentImagePath = m_currentImage->absoluteImagePath();
+    bool currentImageAffected = std::any_of(images.begin(), images.end(),
+                                            [&currentImagePath](const ImagePtr &image) {
+        return image->absoluteImagePath() == currentImagePath;
+    });
+    if (!currentImageAffected) {
+        return;
+    }
+    // The image might have been replaced by a reloaded one with a different row
+    int index = -1;
+    for (int i = 0; i < m_images.size(); i++) {
+        if (m_images[i]->absoluteImagePath() == currentImagePath) {
+            index = i;
+            break;
+        }
+    }
+    if (index == -1) {
+        // The current image has been removed
+        m_currentImage.reset();
+        onDataChanged(Data::Images);
+    } else {
+        // Selecting the image again saves or restores modified poses and shows the new ones
+        onSelectedImageChanged(index);
+    }
 }
 
 void PosesEditingController::saveUnsavedChanges() {
@@ -235,6 +402,9 @@ void PosesEditingController::savePoses() {
 }
 
 void PosesEditingController::savePosesOrRestoreState() {
+    // Saving clears them but we need them to restore the poses of the image
+    const QList<PosePtr> posesToAdd = m_posesToAdd;
+    const QList<PosePtr> posesToRemove = m_posesToRemove;
     bool result = showDialogAndSavePoses(true);
     // Result is true if poses have been saved
     if (!result) {
@@ -246,17 +416,25 @@ void PosesEditingController::savePosesOrRestoreState() {
             pose->setRotation(poseValues.rotation);
             m_dirtyPoses[pose] = false;
         }
-        // Set the original poses again
-        m_posesForImage = m_modelManager->posesForImage(*m_currentImage);
+        // Set the original poses again, i.e. without the added and with the removed ones
+        for (const PosePtr &pose : posesToAdd) {
+            m_posesForImage.removeOne(pose);
+        }
+        for (const PosePtr &pose : posesToRemove) {
+            if (isOfCurrentImage(pose) && !m_posesForImage.contains(pose)) {
+                m_posesForImage.append(pose);
+            }
+        }
         m_mainWindow->poseEditor()->setPoses(m_posesForImage);
         m_mainWindow->poseViewer()->setPoses(m_posesForImage);
+        // The history refers to the discarded changes
+        clearEditHistory();
     }
 }
 
 bool PosesEditingController::showDialogAndSavePoses(bool showDialog) {
     QList<PosePtr> posesToSave = m_dirtyPoses.keys(true);
     m_mainWindow->poseEditor()->setEnabledButtonSave(false);
-    bool noErrorSavingPoses = true;
     if (posesToSave.size() || m_posesToAdd.size() || m_posesToRemove.size()) {
         int posesToSaveCount = posesToSave.size() + m_posesToAdd.size() + m_posesToRemove.size();
         for (int i = 0; i < posesToSave.size(); i++) {
@@ -275,30 +453,61 @@ bool PosesEditingController::showDialogAndSavePoses(bool showDialog) {
         // If show dialog, check result (which is the result from showing the dialog)
         // else result will be true because result = !showDialog (the latter is false in this case)
         if (!showDialog || result) {
-            qDebug() << "Adding " << m_posesToAdd.size() << " poses.";
+            PoseSaveJob job;
+            job.imagePath = m_currentImage->absoluteImagePath();
+            // The job gets copies so that the user can continue editing the poses
+            // while they are being saved
             for (const PosePtr &pose : m_posesToAdd) {
-                PosePtr newPose = m_modelManager->addPose(*pose);
-                // If there was an error saving the pose, the returned pointer will be null
-                noErrorSavingPoses &= !newPose.isNull();
+                job.posesToAdd.append(PosePtr(new Pose(*pose)));
+                m_unmodifiedPoses[pose->id()] = {.position = pose->position(),
+                                                 .rotation = pose->rotation()};
             }
-            qDebug() << "Saving " << posesToSave.size() << " poses.";
+            QMap<QString, PoseValues> previousValues;
             for (const PosePtr &pose : posesToSave) {
-                // No need to display a warning here because if something goes wrong
-                // the LoadAndStoreStrategy already notifies the MainWindow
-                bool updatedPoseSuccessfully = m_modelManager->updatePose(pose->id(),
-                                                                          pose->position(),
-                                                                          pose->rotation().toRotationMatrix());
-                noErrorSavingPoses &= updatedPoseSuccessfully;
-                if (updatedPoseSuccessfully) {
-                    m_dirtyPoses[pose] = false;
-                    m_unmodifiedPoses[pose->id()] = {.position = pose->position(),
-                                                     .rotation = pose->rotation()};
-                }
+                job.posesToUpdate.append(PosePtr(new Pose(*pose)));
+                previousValues[pose->id()] = m_unmodifiedPoses[pose->id()];
+                // The poses count as saved unless the job reports an error
+                m_dirtyPoses[pose] = false;
+                m_unmodifiedPoses[pose->id()] = {.position = pose->position(),
+                                                 .rotation = pose->rotation()};
             }
-            qDebug() << "Removing " << m_posesToRemove.size() << " poses.";
             for (const PosePtr &pose : m_posesToRemove) {
-                noErrorSavingPoses  &= m_modelManager->removePose(pose->id());
+                job.poseIdsToRemove.append(pose->id());
             }
+            const QList<PosePtr> addedPoses = m_posesToAdd;
+            const QList<PosePtr> removedPoses = m_posesToRemove;
+            m_poseSaveQueue.submit(job, Q_NULLPTR,
+                                   [this, job, addedPoses, posesToSave, removedPoses, previousValues]
+                                   (const PoseSaveResult &saveResult) {
+                if (m_currentImage.isNull() || m_currentImage->absoluteImagePath() != job.imagePath) {
+                    // The user has moved on to another image, the model manager has already
+                    // shown the error
+                    return;
+                }
+                // Restore the state of the failed changes so that the user can try and
+                // save them again
+                for (const PosePtr &pose : addedPoses) {
+                    if (saveResult.failedAdds.contains(pose->id())
+                            && m_posesForImage.contains(pose) && !m_posesToAdd.contains(pose)) {
+                        m_posesToAdd.append(pose);
+                    }
+                }
+                for (const PosePtr &pose : posesToSave) {
+                    if (saveResult.failedUpdates.contains(pose->id())
+                            && m_posesForImage.contains(pose)) {
+                        m_unmodifiedPoses[pose->id()] = previousValues[pose->id()];
+                        m_dirtyPoses[pose] = true;
+                    }
+                }
+                for (const PosePtr &pose : removedPoses) {
+                    if (saveResult.failedRemoves.contains(pose->id()) && !m_posesToRemove.contains(pose)) {
+                        m_posesToRemove.append(pose);
+                    }
+                }
+                // We don't need a message here since saving already emits errors in the
+                // model manager
+                m_mainWindow->poseEditor()->setEnabledButtonSave(true);
+            });
         } else if (showDialog && !result) {
             qDebug() << "Not saving poses as requested.";
             // Need to clean up in case the user pressed only the reset button
@@ -309,16 +518,9 @@ bool PosesEditingController::showDialogAndSavePoses(bool showDialog) {
                 }
             }
         }
-        if (noErrorSavingPoses) {
-            m_posesToAdd.clear();
-            m_posesToRemove.clear();
-        } else {
-            qDebug() << "There was an error saving the poses.";
-            // There was an error so we allow the option to try and save
-            // the poses again. We don't need a message here since saving
-            // already emits errors in the model manager.
-            m_mainWindow->poseEditor()->setEnabledButtonSave(true);
-        }
+        // Saving happens asynchronously, errors are handled in the callback of the job
+        m_posesToAdd.clear();
+        m_posesToRemove.clear();
         // Result is either true if the user was shown the save dialog and clicked yes,
         // false if the user clicked no or true if there was no dialog to be shown but
         // the saving executed directly
@@ -328,6 +530,7 @@ bool PosesEditingController::showDialogAndSavePoses(bool showDialog) {
 }
 
 void PosesEditingController::onSelectedImageChanged(int index) {
+    TRACE_SCOPE("viewer", "PosesEditingController::onSelectedImageChanged");
     // Only after resetting the selected pose so that singals are disconnected
     savePosesOrRestoreState();
     m_points2D.clear();
@@ -338,6 +541,8 @@ void PosesEditingController::onSelectedImageChanged(int index) {
     m_posesToRemove.clear();
     m_dirtyPoses.clear();
     m_unmodifiedPoses.clear();
+    // The history only covers the poses of one image
+    clearEditHistory();
     // So that the object model doesn't get reset by selecting a new image
     m_mainWindow->poseEditor()->reset3DViewOnPoseSelectionChange(false);
     // Do not reset the editor because then we reset the object model that
@@ -350,20 +555,38 @@ void PosesEditingController::onSelectedImageChanged(int index) {
     m_mainWindow->poseViewer()->reset();
 
     // Index can be -1 when the views are reset
+    m_posesForImage.clear();
+    m_imageOfPosesLoading.reset();
     if (index >= 0 && index < m_images.size()) {
         m_currentImage = m_images[index];
-        m_posesForImage = m_modelManager->posesForImage(*m_currentImage);
-        for (const PosePtr &pose: m_posesForImage) {
-            m_dirtyPoses[pose] = false;
-            // Need to fully copy to keep unmodified pose
-            m_unmodifiedPoses[pose->id()] = {.position = pose->position(),
-                                             .rotation = pose->rotation()};
-        }
         m_mainWindow->poseEditor()->setCurrentImage(m_currentImage);
-        m_mainWindow->poseEditor()->setPoses(m_posesForImage);
         m_mainWindow->poseViewer()->setImage(m_currentImage);
-        m_mainWindow->poseViewer()->setPoses(m_posesForImage);
+        // The query runs after the saving above, onPosesForImageLoaded shows the poses
+        m_imageOfPosesLoading = m_currentImage;
+        m_posesForImageWatcher.setFuture(m_modelManager->posesForImage(m_currentImage));
+    }
+    m_mainWindow->poseEditor()->reset3DViewOnPoseSelectionChange(true);
+}
+
+void PosesEditingController::onPosesForImageLoaded() {
+    const QList<PosePtr> poses = m_posesForImageWatcher.result();
+    ImagePtr image = m_imageOfPosesLoading;
+    m_imageOfPosesLoading.reset();
+    if (image.isNull() || image != m_currentImage) {
+        // Another image has been selected or the views have been reset in the meantime
+        return;
     }
+    for (const PosePtr &pose: poses) {
+        m_dirtyPoses[pose] = false;
+        // Need to fully copy to keep unmodified pose
+        m_unmodifiedPoses[pose->id()] = {.position = pose->position(),
+                                         .rotation = pose->rotation()};
+    }
+    // Poses that have been added while loading, e.g. by copying them, stay
+    m_posesForImage = poses + m_posesForImage;
+    m_mainWindow->poseEditor()->reset3DViewOnPoseSelectionChange(false);
+    m_mainWindow->poseEditor()->setPoses(m_posesForImage);
+    m_mainWindow->poseViewer()->setPoses(m_posesForImage);
     m_mainWindow->poseEditor()->reset3DViewOnPoseSelectionChange(true);
 }
 
@@ -378,14 +601,20 @@ void PosesEditingController::onSelectedObjectModelChanged(int index) {
 }
 
 PosePtr PosesEditingController::createNewPoseFromPose(PosePtr pose) {
-    return PosePtr(new Pose(GeneralHelper::createPoseId(*m_currentImage,
-                                                         *pose->objectModel()),
+    return PosePtr(new Pose(GeneralHelper::createPoseId(),
                              pose->position(),
                              pose->rotation(),
                              m_currentImage,
                              pose->objectModel()));
 }
 
+QMap<QString, QString> PosesEditingController::segmentationCodes() const {
+    if (m_settingsStore) {
+        return m_settingsStore->currentSettings()->segmentationCodes();
+    }
+    return QMap<QString, QString>();
+}
+
 void PosesEditingController::enableSaveButtonOnPoseEditor() {
     QList<PosePtr> dirtyPoses = m_dirtyPoses.keys(true);
     m_mainWindow->poseEditor()->setEnabledButtonSave(m_posesToAdd.size() ||
@@ -393,6 +622,69 @@ void PosesEditingController::enableSaveButtonOnPoseEditor() {
                                                      dirtyPoses.size());
 }
 
+void PosesEditingController::connectSelectedPose() {
+    connect(m_selectedPose.get(), &Pose::positionChanged,
+            this, &PosesEditingController::onPosePositionChanged);
+    connect(m_selectedPose.get(), &Pose::rotationChanged,
+            this, &PosesEditingController::onPoseRotationChanged);
+    m_selectedPoseValues = {.position = m_selectedPose->position(),
+                            .rotation = m_selectedPose->rotation()};
+    // Changes of another pose are never part of the previous drag
+    m_editHistory.seal();
+}
+
+void PosesEditingController::disconnectSelectedPose() {
+    if (!m_selectedPose.isNull()) {
+        disconnect(m_selectedPose.get(), &Pose::positionChanged,
+                   this, &PosesEditingController::onPosePositionChanged);
+        disconnect(m_selectedPose.get(), &Pose::rotationChanged,
+                   this, &PosesEditingController::onPoseRotationChanged);
+    }
+    m_editHistory.seal();
+}
+
+void PosesEditingController::updateDirtyState(const PosePtr &pose) {
+    if (m_posesToAdd.contains(pose)) {
+        return;
+    }
+    // Only assign true when actually changed
+    PoseValues poseValues = m_unmodifiedPoses[pose->id()];
+    m_dirtyPoses[pose] = poseValues.position != pose->position()
+                         || poseValues.rotation != pose->rotation();
+}
+
+void PosesEditingController::attachPose(const PosePtr &pose) {
+    // A pose whose removal hasn't been saved yet is still persisted
+    if (!m_posesToRemove.removeOne(pose)) {
+        m_posesToAdd.append(pose);
+    }
+    if (isOfCurrentImage(pose)) {
+        m_posesForImage.append(pose);
+    }
+}
+
+void PosesEditingController::detachPose(const PosePtr &pose) {
+    m_posesForImage.removeOne(pose);
+    // A pose that has only been added doesn't have to be removed from the model manager
+    if (!m_posesToAdd.removeOne(pose)) {
+        m_posesToRemove.append(pose);
+    }
+}
+
+bool PosesEditingController::isOfCurrentImage(const PosePtr &pose) const {
+    return !m_currentImage.isNull() && pose->image()->id() == m_currentImage->id();
+}
+
+void PosesEditingController::clearEditHistory() {
+    m_editHistory.clear();
+    enableUndoRedoActions();
+}
+
+void PosesEditingController::enableUndoRedoActions() {
+    m_mainWindow->setEnabledActionUndo(m_editHistory.canUndo());
+    m_mainWindow->setEnabledActionRedo(m_editHistory.canRedo());
+}
+
 template<class A, class B>
 void PosesEditingController::addPoint(A point,
                                       QList<A> &listToAddTo,
@@ -436,97 +728,287 @@ void PosesEditingController::add3DPoint(QVector3D objectModelPoint) {
     addPoint<QVector3D, QPoint>(objectModelPoint, m_points3D, m_points2D);
 }
 
-QString correspondenceToString(QPoint point2D, QVector3D point3D) {
-    return "("
-            + QString::number(point2D.x()) + ", "
-            + QString::number(point2D.y())
-            + ") - ("
-            + QString::number(point3D.x()) + ", "
-            + QString::number(point3D.y()) + ", "
-            + QString::number(point3D.z()) + ")";
+void PosesEditingController::createPose() {
+    if (m_state != ReadyForPoseCreation) {
+        qWarning() << "Illegal state for pose recovering. This should never happen.";
+        return;
+    }
+    if (m_poseRecoveringWatcher.isRunning()) {
+        // Button is disabled while recovering but clicks might still be queued
+        return;
+    }
+
+    m_imageOfPoseRecovering = m_currentImage;
+    m_objectModelOfPoseRecovering = m_currentObjectModel;
+    m_mainWindow->poseEditor()->setEnabledButtonRecoverPose(false);
+    m_mainWindow->setStatusBarTextRecoveringPose();
+    // Runs on the thread pool, onPoseRecoveringFinished gets called through the watcher
+    m_poseRecoveringWatcher.setFuture(m_poseRecoverer.recoverPose(m_points2D,
+                                                                  m_points3D,
+                                                                  m_currentImage->getCameraMatrix()));
 }
 
-void PosesEditingController::createPose() {
-    // TODO show warnings in mainwindow
-    switch (m_state) {
-        case ReadyForPoseCreation:
-            break;
-        case Empty:
-        case NotEnoughCorrespondences:
-        case Missing2DPoint:
-        case Missing3DPoint:
-        default:
-            qWarning() << "Illegal state for pose recovering. This should never happen.";
-            break;
+void PosesEditingController::onPoseRecoveringFinished() {
+    PoseRecoveringResult result = m_poseRecoveringWatcher.result();
+    ImagePtr image = m_imageOfPoseRecovering;
+    ObjectModelPtr objectModel = m_objectModelOfPoseRecovering;
+    m_imageOfPoseRecovering.reset();
+    m_objectModelOfPoseRecovering.reset();
+
+    if (image.isNull() || image != m_currentImage) {
+        // The user aborted or selected a different image in the meantime, the
+        // correspondences have already been discarded
+        return;
+    }
+
+    if (!result.success) {
+        m_mainWindow->setStatusBarTextPoseRecoveringFailed(result.errorMessage);
+        m_mainWindow->poseEditor()->setEnabledButtonRecoverPose(m_state == ReadyForPoseCreation);
+        return;
     }
 
-    m_mainWindow->showPoseRecoveringProgressView(true);
+    PosePtr newPose(new Pose(GeneralHelper::createPoseId(),
+                             result.position,
+                             QQuaternion::fromRotationMatrix(result.rotation),
+                             image,
+                             objectModel));
+
+    // Also clears the correspondences and the click visualizations
+    addPose(newPose);
+    m_mainWindow->setStatusBarTextPoseRecovered(result.residuals,
+                                                result.inliers,
+                                                result.inlierRMS);
+}
 
-    std::vector<cv::Point2f> imagePoints;
-    std::vector<cv::Point3f> objectPoints;
+void PosesEditingController::refineSelectedPose() {
+    if (m_selectedPose.isNull() || m_poseRefiningWatcher.isRunning()) {
+        return;
+    }
+    QList<PoseRefinementTask> tasks = PoseRefiner::tasksForPoses({m_selectedPose},
+                                                                 segmentationCodes());
+    if (tasks.isEmpty()) {
+        m_mainWindow->setStatusBarTextPoseRefiningFailed(
+                    tr("the image needs a depth image, or a segmentation image and the object model a segmentation code"));
+        return;
+    }
+    m_mainWindow->setStatusBarTextRefiningPoses(0, 1);
+    m_poseRefiningWatcher.setFuture(m_poseRefiner.refinePose(tasks.first()));
+}
 
-    for (int i = 0; i < m_points2D.size(); i ++) {
-        QVector3D point3D = m_points3D[i];
-        QPoint point2D = m_points2D[i];
-        objectPoints.push_back(cv::Point3f(point3D.x(), point3D.y(), point3D.z()));
-        imagePoints.push_back(cv::Point2f(point2D.x(), point2D.y()));
-        qDebug() << correspondenceToString(point2D, point3D);
+void PosesEditingController::refineAllPoses() {
+    if (m_poseRefinementTasksWatcher.isRunning() || m_posesRefiningWatcher.isRunning()
+            || m_refinedPosesUpdatingWatcher.isRunning()) {
+        return;
     }
+    // Refining works on the persisted poses, i.e. unsaved modifications have to
+    // be saved or discarded first to not get overwritten
+    savePosesOrRestoreState();
+    // The tasks are created after the changes above have been saved
+    const QMap<QString, QString> codes = segmentationCodes();
+    m_poseRefinementTasksWatcher.setFuture(m_modelManager->run<QList<PoseRefinementTask>>(
+                                               [codes](ModelManager *modelManager) {
+        return PoseRefiner::tasksForPoses(modelManager->storedPoses(), codes);
+    }));
+}
 
-    // Setup camera matrix
-    float values[9] = {m_currentImage->getCameraMatrix()(0, 0), 0, m_currentImage->getCameraMatrix()(0, 2),
-                       0 , m_currentImage->getCameraMatrix()(1, 1), m_currentImage->getCameraMatrix()(1, 2),
-                       0, 0, 1};
-    cv::Mat cameraMatrix = cv::Mat(3, 3, CV_32F, values);
+void PosesEditingController::onPoseRefinementTasksCreated() {
+    const QList<PoseRefinementTask> tasks = m_poseRefinementTasksWatcher.result();
+    if (tasks.isEmpty()) {
+        m_mainWindow->setStatusBarTextPoseRefiningFailed(tr("no pose has a depth image or a segmentation image and code"));
+        return;
+    }
+    m_mainWindow->setStatusBarTextRefiningPoses(0, tasks.size());
+    m_posesRefiningWatcher.setFuture(m_poseRefiner.refinePoses(tasks));
+}
 
-    // Setup coefficient matrix
-    cv::Mat distCoeffs(4,1,cv::DataType<float>::type);
-    distCoeffs.at<float>(0) = 0;
-    distCoeffs.at<float>(1) = 0;
-    distCoeffs.at<float>(2) = 0;
-    distCoeffs.at<float>(3) = 0;
+void PosesEditingController::onPoseRefiningFinished() {
+    PoseRefinementResult result = m_poseRefiningWatcher.result();
+    if (!result.success) {
+        m_mainWindow->setStatusBarTextPoseRefiningFailed(result.errorMessage);
+        return;
+    }
+    // The user might have selected a different image in the meantime
+    for (const PosePtr &pose : m_posesForImage) {
+        if (pose->id() == result.poseId) {
+            // Applied like an edit of the user so that it can be undone
+            PoseEdit edit;
+            edit.pose = pose;
+            edit.positionBefore = pose->position();
+            edit.rotationBefore = pose->rotation();
+            edit.positionAfter = result.position;
+            edit.rotationAfter = QQuaternion::fromRotationMatrix(result.rotation);
+            // Not merged with a drag of the same pose that happened right before
+            m_editHistory.seal();
+            m_editHistory.recordModified(pose, edit.positionBefore, edit.rotationBefore,
+                                         edit.positionAfter, edit.rotationAfter);
+            m_editHistory.seal();
+            applyEdits({edit}, false);
+            m_mainWindow->setStatusBarTextPoseRefined(result.initialScore, result.finalScore);
+            return;
+        }
+    }
+}
 
-    cv::Mat rvec(3,1,cv::DataType<float>::type);
-    cv::Mat tvec(3,1,cv::DataType<float>::type);
+void PosesEditingController::onPosesRefiningProgressChanged(int progress) {
+    m_mainWindow->setStatusBarTextRefiningPoses(progress, m_posesRefiningWatcher.progressMaximum());
+}
 
-    cv::solvePnP(objectPoints, imagePoints, cameraMatrix, distCoeffs, rvec, tvec);
+void PosesEditingController::onPosesRefiningFinished() {
+    QList<PoseRefinementResult> results = m_posesRefiningWatcher.future().results();
+    m_numberOfPosesToRefine = results.size();
+    m_improvedPoses.clear();
+    QList<PosePtr> posesToUpdate;
+    for (const PoseRefinementResult &result : results) {
+        if (result.success && result.finalScore > result.initialScore) {
+            m_improvedPoses[result.poseId] = result;
+            // Only carries the values, the model manager looks up the rest
+            posesToUpdate.append(PosePtr(new Pose(result.poseId, result.position, result.rotation,
+                                                  ImagePtr(), ObjectModelPtr())));
+        }
+    }
+    // All poses are persisted at once, the displayed ones are updated when it's done
+    m_refinedPosesUpdatingWatcher.setFuture(m_modelManager->updatePoses(posesToUpdate));
+}
 
-    qDebug() << "Result translation: " << tvec.at<float>(0, 0) << ", "
-                                       << tvec.at<float>(1, 0) << ", "
-                                       << tvec.at<float>(2, 0);
+void PosesEditingController::onRefinedPosesUpdated() {
+    const QStringList updatedIds = m_refinedPosesUpdatingWatcher.result();
+    // The model manager only updates the stored poses, the displayed ones are updated here.
+    // The user might have selected a different image in the meantime, those poses are
+    // loaded with the new values once their image is selected again.
+    m_applyingEdits = true;
+    for (const PosePtr &pose : m_posesForImage) {
+        if (!updatedIds.contains(pose->id()) || m_posesToAdd.contains(pose)) {
+            continue;
+        }
+        const PoseRefinementResult &result = m_improvedPoses[pose->id()];
+        // Changes the user made while refining are kept and stay unsaved
+        const bool modifiedByUser = m_dirtyPoses.value(pose, false);
+        m_unmodifiedPoses[pose->id()] = {.position = result.position,
+                                         .rotation = QQuaternion::fromRotationMatrix(result.rotation)};
+        if (!modifiedByUser) {
+            pose->setPosition(result.position);
+            pose->setRotation(result.rotation);
+        }
+        updateDirtyState(pose);
+        if (pose == m_selectedPose) {
+            Q_EMIT poseValuesChanged(pose);
+        }
+    }
+    m_applyingEdits = false;
+    m_improvedPoses.clear();
+    enableSaveButtonOnPoseEditor();
+    // Includes the poses of other images
+    m_mainWindow->setStatusBarTextPosesRefined(updatedIds.size(), m_numberOfPosesToRefine);
+}
 
-    qDebug() << "Result rotation: " << rvec.at<float>(0, 0) << ", "
-                                    << rvec.at<float>(1, 0) << ", "
-                                    << rvec.at<float>(2, 0);
+void PosesEditingController::propagatePosesToScene() {
+    if (m_currentImage.isNull() || m_posesToPropagateWatcher.isRunning()
+            || m_posesPropagatingWatcher.isRunning()) {
+        return;
+    }
+    if (!m_currentImage->hasCameraExtrinsics()) {
+        m_mainWindow->setStatusBarTextPosePropagationFailed(tr("the image has no camera extrinsics"));
+        return;
+    }
+    if (m_currentImage->sceneId().isEmpty()) {
+        // Without the dataset naming the scene we can't know which images share the world
+        m_mainWindow->setStatusBarTextPosePropagationFailed(tr("the image doesn't belong to a scene"));
+        return;
+    }
+    // Like refining, propagating works on the persisted poses
+    savePosesOrRestoreState();
+    m_imageOfPosesToPropagate = m_currentImage;
+    const ImagePtr image = m_currentImage;
+    m_posesToPropagateWatcher.setFuture(m_modelManager->run<QPair<QList<PosePtr>, QList<PosePtr>>>(
+                                            [image](ModelManager *modelManager) {
+        // Copies, the views edit the poses handed out by the model manager
+        const QList<PosePtr> poses = modelManager->storedPoses();
+        QList<PosePtr> posesOfImage;
+        for (const PosePtr &pose : poses) {
+            if (pose->image()->id() == image->id()) {
+                posesOfImage.append(pose);
+            }
+        }
+        return qMakePair(posesOfImage, poses);
+    }));
+}
 
-    cv::Mat rotMatrix;
-    cv::Rodrigues(rvec, rotMatrix);
+void PosesEditingController::onPosesToPropagateLoaded() {
+    const QPair<QList<PosePtr>, QList<PosePtr>> loadedPoses = m_posesToPropagateWatcher.result();
+    ImagePtr image = m_imageOfPosesToPropagate;
+    m_imageOfPosesToPropagate.reset();
+    if (image.isNull() || image != m_currentImage) {
+        // The user selected a different image in the meantime
+        return;
+    }
+    const QList<PosePtr> &poses = loadedPoses.first;
+    if (poses.isEmpty()) {
+        m_mainWindow->setStatusBarTextPosePropagationFailed(tr("the image has no poses"));
+        return;
+    }
+    QList<ImagePtr> images = m_modelManager->snapshot()->images();
+    if (PosePropagator::sceneImages(*m_currentImage, images).isEmpty()) {
+        m_mainWindow->setStatusBarTextPosePropagationFailed(
+                    tr("no other image of the scene has camera extrinsics"));
+        return;
+    }
+    m_imageOfPropagatedPoses = image;
+    m_posesPropagatingWatcher.setFuture(
+                m_posePropagator.propagatePoses(poses, images, loadedPoses.second));
+}
 
-    QVector3D position(tvec.at<float>(0, 0),
-                       tvec.at<float>(1, 0),
-                       tvec.at<float>(2, 0));
-    QMatrix3x3 rotationMatrix(new float[9] {
-        rotMatrix.at<float>(0, 0), rotMatrix.at<float>(0, 1), rotMatrix.at<float>(0, 2),
-        rotMatrix.at<float>(1, 0), rotMatrix.at<float>(1, 1), rotMatrix.at<float>(1, 2),
-        rotMatrix.at<float>(2, 0), rotMatrix.at<float>(2, 1), rotMatrix.at<float>(2, 2)
-    });
+void PosesEditingController::onPosesPropagatingProgressChanged(int progress) {
+    m_mainWindow->setStatusBarTextPropagatingPoses(progress, m_posesPropagatingWatcher.progressMaximum());
+}
 
-    PosePtr newPose(new Pose(GeneralHelper::createPoseId(*m_currentImage, *m_currentObjectModel),
-                             position,
-                             QQuaternion::fromRotationMatrix(rotationMatrix),
-                             m_currentImage,
-                             m_currentObjectModel));
+void PosesEditingController::onPosesPropagatingFinished() {
+    QList<QList<PropagatedPose>> results = m_posesPropagatingWatcher.future().results();
+    // Adding the poses doesn't block the GUI, the status bar is updated once they are added
+    auto addPoses = [results](ModelManager *modelManager) {
+        QList<PosePtr> posesToAdd;
+        for (const QList<PropagatedPose> &propagatedPoses : results) {
+            for (const PropagatedPose &propagatedPose : propagatedPoses) {
+                posesToAdd.append(PosePtr(new Pose(GeneralHelper::createPoseId(),
+                                                   propagatedPose.position,
+                                                   propagatedPose.rotation,
+                                                   propagatedPose.image,
+                                                   propagatedPose.objectModel)));
+            }
+        }
+        // All images at once, i.e. the poses file is written only once
+        const QStringList addedIds = modelManager->savePoses(posesToAdd, {}, {});
+        QList<PosePtr> addedPoses;
+        for (const QString &id : addedIds) {
+            addedPoses.append(modelManager->poseById(id));
+        }
+        return addedPoses;
+    };
+    m_propagatedPosesAddingWatcher.setFuture(m_modelManager->run<QList<PosePtr>>(addPoses));
+}
 
-    addPose(newPose);
-    m_mainWindow->setStatusBarTextStartAddingCorrespondences();
-    m_points2D.clear();
-    m_mainWindow->poseViewer()->onPoseCreationAborted();
-    m_points3D.clear();
-    m_mainWindow->poseEditor()->onPoseCreationAborted();
-    m_mainWindow->showPoseRecoveringProgressView(false);
+void PosesEditingController::onPropagatedPosesAdded() {
+    const QList<PosePtr> addedPoses = m_propagatedPosesAddingWatcher.result();
+    const ImagePtr image = m_imageOfPropagatedPoses;
+    m_imageOfPropagatedPoses.reset();
+    QSet<QString> imageIds;
+    for (const PosePtr &pose : addedPoses) {
+        imageIds.insert(pose->image()->id());
+    }
+    // The history only covers the current image, after selecting a different one in the
+    // meantime the propagation can't be undone anymore like any other change
+    if (!addedPoses.isEmpty() && !image.isNull() && image == m_currentImage) {
+        // Undoing removes the propagated poses from the other images again once the
+        // changes are saved
+        m_editHistory.recordAdded(addedPoses);
+        enableUndoRedoActions();
+    }
+    m_mainWindow->setStatusBarTextPosesPropagated(addedPoses.size(), imageIds.size());
 }
 
 void PosesEditingController::abortPoseCreation() {
+    // A recovery that is still running gets discarded when it finishes
+    m_imageOfPoseRecovering.reset();
+    m_objectModelOfPoseRecovering.reset();
     m_state = Empty;
     m_points2D.clear();
     m_points3D.clear();
@@ -542,4 +1024,6 @@ void PosesEditingController::reset() {
 
 void PosesEditingController::onProgramClose() {
     showDialogAndSavePoses(true);
+    // Wait for the saving to finish before the window closes
+    m_poseSaveQueue.flush();
 }
@@ -3,13 +3,21 @@
 
 #include "model/pose.hpp"
 #include "model/image.hpp"
-#include "model/modelmanager.hpp"
+#include "model/asyncmodelmanager.hpp"
+#include "controller/poseedithistory.hpp"
+#include "controller/posesavequeue.hpp"
+#include "posecomputation/posepropagator.hpp"
+#include "posecomputation/poserecoverer.hpp"
+#include "posecomputation/poserefiner.hpp"
+#include "settings/settingsstore.hpp"
 
 #include "view/mainwindow.hpp"
 
 #include <QObject>
 #include <QMap>
 #include <QList>
+#include <QFutureWatcher>
+#include <QPair>
 
 class PosesEditingController : public QObject
 {
@@ -17,8 +25,9 @@ class PosesEditingController : public QObject
 
 public:
     explicit PosesEditingController(QObject *parent,
-                                    ModelManager *modelManager,
+                                    AsyncModelManager *modelManager,
                                     MainWindow *mainWindow);
+    void setSettingsStore(SettingsStore *settingsStore);
 
 Q_SIGNALS:
     void selectedPoseChanged(PosePtr selected, PosePtr deselected);
@@ -32,17 +41,42 @@ private Q_SLOTS:
     void removePose();
     void duplicatePose();
     void copyPosesFromImage(ImagePtr image);
+    void undo();
+    void redo();
     void onPoseChanged();
     void onPosePositionChanged(QVector3D position);
     void onPoseRotationChanged(QQuaternion rotation);
     void modelManagerStateChanged(ModelManager::State state);
     void onDataChanged(int data);
+    void onImagesChanged(const QList<ImagePtr> &images);
+    void onObjectModelsChanged(const QList<ObjectModelPtr> &objectModels);
+    void onPosesReloaded(const QList<ImagePtr> &images);
+    void onPosesForImageLoaded();
+    void onPosesToCopyLoaded();
 
     // Pose Recovering
     void add2DPoint(QPoint imagePoint);
     void add3DPoint(QVector3D objectModelPoint);
     void createPose();
+    void onPoseRecoveringFinished();
     void abortPoseCreation();
+
+    // Pose Refining
+    void refineSelectedPose();
+    void refineAllPoses();
+    void onPoseRefinementTasksCreated();
+    void onPoseRefiningFinished();
+    void onPosesRefiningProgressChanged(int progress);
+    void onPosesRefiningFinished();
+    void onRefinedPosesUpdated();
+
+    // Pose Propagating
+    void propagatePosesToScene();
+    void onPosesToPropagateLoaded();
+    void onPosesPropagatingProgressChanged(int progress);
+    void onPosesPropagatingFinished();
+    void onPropagatedPosesAdded();
+
     // Resets the current modifications so that the user doesn't have to
     // select a new image to reset the current view
     void reset();
@@ -64,7 +98,22 @@ private:
     template<class A, class B>
     void addPoint(A point, QList<A> &listToAddTo, QList<B> &listToCompareTo);
     PosePtr createNewPoseFromPose(PosePtr pose);
+    QMap<QString, QString> segmentationCodes() const;
     void enableSaveButtonOnPoseEditor();
+    //! Connects to the pose signals of m_selectedPose and remembers its values
+    void connectSelectedPose();
+    void disconnectSelectedPose();
+    //! Compares the pose to its unmodified values, poses that are to be added are never dirty
+    void updateDirtyState(const PosePtr &pose);
+    //! Adds the pose to the current image without recording it in the edit history
+    void attachPose(const PosePtr &pose);
+    //! Removes the pose from the current image without recording it in the edit history
+    void detachPose(const PosePtr &pose);
+    //! False for the poses propagated to other images, which are in the history too
+    bool isOfCurrentImage(const PosePtr &pose) const;
+    void applyEdits(const QVector<PoseEdit> &edits, bool undo);
+    void clearEditHistory();
+    void enableUndoRedoActions();
 
 private:
     struct PoseValues {
@@ -81,7 +130,8 @@ private:
     };
 
     PosePtr m_selectedPose;
-    ModelManager *m_modelManager;
+    AsyncModelManager *m_modelManager;
+    SettingsStore *m_settingsStore = Q_NULLPTR;
     MainWindow *m_mainWindow;
 
     ImagePtr m_currentImage;
@@ -89,18 +139,66 @@ private:
     ObjectModelPtr m_currentObjectModel;
     QList<ObjectModelPtr> m_objectModels;
     QList<PosePtr> m_posesForImage;
+    // The poses of the current image are loaded on the model manager's thread after the
+    // changes of the previous image have been saved, the GUI doesn't wait for them
+    QFutureWatcher<QList<PosePtr>> m_posesForImageWatcher;
+    ImagePtr m_imageOfPosesLoading;
+    // Copying poses from another image, the poses of that image are loaded first
+    QFutureWatcher<QList<PosePtr>> m_posesToCopyWatcher;
+    ImagePtr m_imageToCopyPosesFrom;
+    ImagePtr m_imageToCopyPosesTo;
     QList<PosePtr> m_posesToAdd;
     QList<PosePtr> m_posesToRemove;
     QMap<QString, PoseValues> m_unmodifiedPoses;
     // Needs to be <PosePtr, Bool> to be able to retrieve a list of
     // PosePtr by bool value
     QMap<PosePtr, bool> m_dirtyPoses;
+    // The values of the selected pose before its last change, the signals of the pose
+    // only carry the new ones
+    PoseValues m_selectedPoseValues;
+    // Edits of the poses of the current image
+    PoseEditHistory m_editHistory;
+    // Set while undoing or redoing so that the changes aren't recorded again
+    bool m_applyingEdits = false;
 
     // Pose Recovering
     int m_minimumNumberOfPoints = 6;
     PoseRecoveringState m_state = Empty;
     QList<QPoint> m_points2D;
     QList<QVector3D> m_points3D;
+    PoseRecoverer m_poseRecoverer;
+    QFutureWatcher<PoseRecoveringResult> m_poseRecoveringWatcher;
+    // The image and object model the currently running recovery was started for,
+    // the user might select different ones while the recovery is running
+    ImagePtr m_imageOfPoseRecovering;
+    ObjectModelPtr m_objectModelOfPoseRecovering;
+
+    // Pose Refining
+    PoseRefiner m_poseRefiner;
+    // The tasks for refining all poses are created from the persisted poses on the model
+    // manager's thread
+    QFutureWatcher<QList<PoseRefinementTask>> m_poseRefinementTasksWatcher;
+    // One watcher for refining the selected pose and one for refining all poses
+    QFutureWatcher<PoseRefinementResult> m_poseRefiningWatcher;
+    QFutureWatcher<PoseRefinementResult> m_posesRefiningWatcher;
+    //! Persisting the improved poses, the model manager returns the IDs of the updated ones
+    QFutureWatcher<QStringList> m_refinedPosesUpdatingWatcher;
+    QMap<QString, PoseRefinementResult> m_improvedPoses;
+    int m_numberOfPosesToRefine = 0;
+
+    // Pose Propagating
+    PosePropagator m_posePropagator;
+    //! The persisted poses of the image to propagate and all poses of the dataset
+    QFutureWatcher<QPair<QList<PosePtr>, QList<PosePtr>>> m_posesToPropagateWatcher;
+    ImagePtr m_imageOfPosesToPropagate;
+    QFutureWatcher<QList<PropagatedPose>> m_posesPropagatingWatcher;
+    //! The image whose poses are being propagated, to record them in its edit history
+    ImagePtr m_imageOfPropagatedPoses;
+    //! Adding the propagated poses to the model manager, the poses that were added
+    QFutureWatcher<QList<PosePtr>> m_propagatedPosesAddingWatcher;
+
+    // Saving poses on the model manager's thread
+    PoseSaveQueue m_poseSaveQueue;
 };
 
 #endif // POSEEDITINGMODEL_H
@@ -3,6 +3,7 @@
 
 #include "model/image.hpp"
 #include "model/objectmodel.hpp"
+#include "model/poseid.hpp"
 
 #include <math.h>
 #include <QColor>
@@ -11,7 +12,6 @@
 #include <QMap>
 #include <QFileInfo>
 #include <QStringList>
-#include <QDateTime>
 
 static const QString colorCodeDelimiter = ".";
 
@@ -38,18 +38,14 @@ inline QColor colorFromSegmentationCode(const QString &segmentationCode) {
     return QColor(splitCode.at(0).toInt(), splitCode.at(1).toInt(), splitCode.at(2).toInt());
 }
 
-inline QString createPoseId(const Image &image, const ObjectModel &objectModel){
-    QDateTime date = QDateTime::currentDateTime();;
-    //! We include the date as part of the identifier - this actually makes
-    //! the ID quite long but still better readable than a UUID
-    QString id = QFileInfo(image.imagePath()).completeBaseName()
-               + "_"
-               + QFileInfo(objectModel.path()).completeBaseName()
-               + "_"
-               + date.toString("d.M.yy_HH:mm:ss");
-    return id;
+/*!
+ * \brief createPoseId returns a new unique pose id, see PoseId for its format. Creating
+ * many poses at once, e.g. when copying them from another image, never yields the same id
+ * twice.
+ */
+inline QString createPoseId() {
+    return PoseId::generate().toString();
 }
-
 }
 
 #endif // GENERALHELPER_HPP
@@ -0,0 +1,214 @@
+#include "memoryaccounting.hpp"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutexLocker>
+#include <QtDebug>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+const QString MemoryAccounting::GALLERY_THUMBNAILS = "Gallery thumbnails";
+const QString MemoryAccounting::OBJECT_MODEL_PREVIEWS = "Object model previews";
+const QString MemoryAccounting::ENTITIES = "Images, object models and poses";
+const QString MemoryAccounting::RENDERING_RESOURCES = "Meshes and textures";
+const QString MemoryAccounting::PYTHON_HEAP = "Python workers";
+
+const double MemoryAccounting::LOW_MEMORY_FRACTION = 0.05;
+
+static const qint64 MB = 1024 * 1024;
+
+/*!
+ * \brief readMemInfo returns the value of the field of /proc/meminfo in bytes, -1 if
+ * there is no such file or field.
+ */
+static qint64 readMemInfo(const QByteArray &field) {
+    QFile file("/proc/meminfo");
+    if (!file.open(QFile::ReadOnly)) {
+        return -1;
+    }
+    // The file reports a size of 0, i.e. readAll doesn't work
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.startsWith(field + ":")) {
+            // E.g. "MemAvailable:    1234567 kB"
+            const QList<QByteArray> parts = line.simplified().split(' ');
+            if (parts.size() >= 2) {
+                return parts[1].toLongLong() * 1024;
+            }
+        }
+    }
+    return -1;
+}
+
+MemoryAccounting::MemoryAccounting()
+    : m_checkTimer(this)
+    , m_logTimer(this) {
+    // Defaults for a laptop with 16 GB, entities and rendering resources can only be
+    // evicted in parts, that's why their budgets are larger
+    m_accounts[GALLERY_THUMBNAILS].budget = 512 * MB;
+    m_accounts[OBJECT_MODEL_PREVIEWS].budget = 128 * MB;
+    m_accounts[ENTITIES].budget = 2048 * MB;
+    m_accounts[RENDERING_RESOURCES].budget = 1024 * MB;
+    m_accounts[PYTHON_HEAP].budget = 2048 * MB;
+    for (auto account = m_accounts.begin(); account != m_accounts.end(); account++) {
+        account->subsystem = account.key();
+    }
+    connect(&m_checkTimer, &QTimer::timeout, this, &MemoryAccounting::checkSystemMemory);
+    connect(&m_logTimer, &QTimer::timeout, this, &MemoryAccounting::logUsage);
+}
+
+MemoryAccounting *MemoryAccounting::instance() {
+    static MemoryAccounting *accounting = []() {
+        MemoryAccounting *accounting = new MemoryAccounting;
+        // The first report might come from a worker thread, the timers belong to the GUI thread
+        if (QCoreApplication::instance()) {
+            accounting->moveToThread(QCoreApplication::instance()->thread());
+        }
+        return accounting;
+    }();
+    return accounting;
+}
+
+void MemoryAccounting::reportUsage(const QString &subsystem, qint64 bytes) {
+    qint64 bytesToFree = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        Account &account = m_accounts[subsystem];
+        account.subsystem = subsystem;
+        account.usage = bytes;
+        if (account.evicting) {
+            // The first report after being asked to evict is the result of evicting,
+            // subsystems that can't evict enough would be asked again and again otherwise.
+            // Receivers might be queued, that's why it isn't reset right after emitting.
+            account.evicting = false;
+        } else if (account.budget > 0 && account.usage > account.budget) {
+            bytesToFree = account.usage - account.budget;
+            account.evictions++;
+            account.evicting = true;
+        }
+    }
+    Q_EMIT usageChanged();
+    if (bytesToFree > 0) {
+        Q_EMIT budgetExceeded(subsystem, bytesToFree);
+    }
+}
+
+void MemoryAccounting::setBudget(const QString &subsystem, qint64 bytes) {
+    qint64 usage;
+    {
+        QMutexLocker locker(&m_mutex);
+        Account &account = m_accounts[subsystem];
+        account.subsystem = subsystem;
+        account.budget = bytes;
+        usage = account.usage;
+    }
+    // Enforces the new budget right away
+    reportUsage(subsystem, usage);
+}
+
+qint64 MemoryAccounting::budget(const QString &subsystem) const {
+    QMutexLocker locker(&m_mutex);
+    return m_accounts.value(subsystem).budget;
+}
+
+QList<MemoryAccounting::Account> MemoryAccounting::accounts() const {
+    QMutexLocker locker(&m_mutex);
+    return m_accounts.values();
+}
+
+qint64 MemoryAccounting::totalUsage() const {
+    QMutexLocker locker(&m_mutex);
+    qint64 total = 0;
+    for (const Account &account : m_accounts) {
+        total += account.usage;
+    }
+    return total;
+}
+
+/*!
+ * \brief readResidentMemory returns the resident memory in the statm file of the process
+ * in bytes, -1 if there is no such file.
+ */
+static qint64 readResidentMemory(const QString &process) {
+#ifdef Q_OS_UNIX
+    QFile file("/proc/" + process + "/statm");
+    if (file.open(QFile::ReadOnly)) {
+        // Total program size followed by the resident pages
+        const QList<QByteArray> pages = file.readLine().simplified().split(' ');
+        if (pages.size() >= 2) {
+            return pages[1].toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+#else
+    Q_UNUSED(process)
+#endif
+    return -1;
+}
+
+qint64 MemoryAccounting::processMemory() {
+    return readResidentMemory("self");
+}
+
+qint64 MemoryAccounting::processMemory(qint64 processId) {
+    return readResidentMemory(QString::number(processId));
+}
+
+qint64 MemoryAccounting::availableSystemMemory() {
+    return readMemInfo("MemAvailable");
+}
+
+qint64 MemoryAccounting::totalSystemMemory() {
+    return readMemInfo("MemTotal");
+}
+
+void MemoryAccounting::startMonitoring(int checkInterval, int logInterval) {
+    m_checkTimer.start(checkInterval);
+    if (logInterval > 0) {
+        m_logTimer.start(logInterval);
+    } else {
+        m_logTimer.stop();
+    }
+}
+
+void MemoryAccounting::logUsage() const {
+    qInfo().noquote() << "Memory of the process: " + formatBytes(processMemory());
+    for (const Account &account : accounts()) {
+        qInfo().noquote() << QString("    %1: %2 of %3, evicted %4 times")
+                             .arg(account.subsystem)
+                             .arg(formatBytes(account.usage))
+                             .arg(account.budget > 0 ? formatBytes(account.budget) : "unlimited")
+                             .arg(account.evictions);
+    }
+}
+
+QString MemoryAccounting::formatBytes(qint64 bytes) {
+    if (bytes < 0) {
+        return tr("unknown");
+    }
+    return QString::number(bytes / double(MB), 'f', 1) + " MB";
+}
+
+void MemoryAccounting::checkSystemMemory() {
+    const qint64 available = availableSystemMemory();
+    const qint64 total = totalSystemMemory();
+    if (available < 0 || total <= 0 || available >= total * LOW_MEMORY_FRACTION) {
+        return;
+    }
+    qWarning() << "Low on memory, only" << formatBytes(available) << "available. Evicting caches.";
+    QList<Account> accountsToTrim;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (Account &account : m_accounts) {
+            if (account.usage > 0) {
+                account.evictions++;
+                account.evicting = true;
+                accountsToTrim.append(account);
+            }
+        }
+    }
+    for (const Account &account : accountsToTrim) {
+        Q_EMIT budgetExceeded(account.subsystem, account.usage / 2);
+    }
+}
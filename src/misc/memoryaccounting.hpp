@@ -0,0 +1,100 @@
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+/*!
+ * \brief The MemoryAccounting class keeps track of how much memory the caches of the
+ * program use, e.g. the thumbnails of the gallery or the Qt3D resources of the pose viewer.
+ * Every subsystem reports its usage through reportUsage and has a budget. When the usage
+ * exceeds the budget or the system runs low on memory, budgetExceeded asks the subsystem to
+ * evict entries it can recreate later.
+ *
+ * The usages are estimates of the large allocations of a subsystem and don't have to add
+ * up to the memory of the process, which is shown separately.
+ */
+class MemoryAccounting : public QObject {
+
+    Q_OBJECT
+
+public:
+    struct Account {
+        QString subsystem;
+        qint64 usage = 0;
+        //! 0 means unlimited
+        qint64 budget = 0;
+        //! The number of times the subsystem was asked to evict entries
+        int evictions = 0;
+        //! Set from asking the subsystem to evict until it reports its usage the next time
+        bool evicting = false;
+    };
+
+    static MemoryAccounting *instance();
+
+    /*!
+     * \brief reportUsage sets the current usage of the subsystem in bytes. Can be called
+     * from any thread. If the usage exceeds the budget budgetExceeded is emitted right away.
+     */
+    void reportUsage(const QString &subsystem, qint64 bytes);
+    void setBudget(const QString &subsystem, qint64 bytes);
+    qint64 budget(const QString &subsystem) const;
+    QList<Account> accounts() const;
+    qint64 totalUsage() const;
+
+    //! The resident memory of this process in bytes, -1 if unknown on this platform
+    static qint64 processMemory();
+    //! The resident memory of another process, e.g. a Python worker
+    static qint64 processMemory(qint64 processId);
+    //! The memory the system can still hand out without swapping, -1 if unknown
+    static qint64 availableSystemMemory();
+    static qint64 totalSystemMemory();
+
+    /*!
+     * \brief startMonitoring checks the available memory of the system in the interval
+     * and logs the usage of all subsystems every logInterval milliseconds, 0 disables logging.
+     */
+    void startMonitoring(int checkInterval, int logInterval);
+    //! Writes the usage of all subsystems to the log
+    void logUsage() const;
+    //! E.g. 12.3 MB
+    static QString formatBytes(qint64 bytes);
+
+    static const QString GALLERY_THUMBNAILS;
+    static const QString OBJECT_MODEL_PREVIEWS;
+    static const QString ENTITIES;
+    static const QString RENDERING_RESOURCES;
+    static const QString PYTHON_HEAP;
+
+    /*!
+     * \brief LOW_MEMORY_FRACTION the fraction of the system memory below which the
+     * available memory counts as low and all subsystems have to evict half their entries.
+     */
+    static const double LOW_MEMORY_FRACTION;
+
+Q_SIGNALS:
+    /*!
+     * \brief budgetExceeded asks the subsystem to free at least the given number of bytes.
+     * Receivers only react to their own subsystem and report their new usage afterwards.
+     */
+    void budgetExceeded(const QString &subsystem, qint64 bytesToFree);
+    void usageChanged();
+
+private Q_SLOTS:
+    void checkSystemMemory();
+
+private:
+    MemoryAccounting();
+
+private:
+    mutable QMutex m_mutex;
+    QMap<QString, Account> m_accounts;
+    QTimer m_checkTimer;
+    QTimer m_logTimer;
+};
+
+#endif // MEMORYACCOUNTING_H
@@ -2,6 +2,10 @@ INCLUDEPATH += $$PWD
 
 HEADERS += \
     $$PWD/generalhelper.hpp \
-    $$PWD/global.hpp
+    $$PWD/global.hpp \
+    $$PWD/memoryaccounting.hpp \
+    $$PWD/tracing.hpp
 
-SOURCES +=
+SOURCES += \
+    $$PWD/memoryaccounting.cpp \
+    $$PWD/tracing.cpp
@@ -0,0 +1,145 @@
+#include "tracing.hpp"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+
+const int Tracer::MAX_EVENTS = 1000000;
+
+Tracer::Tracer() {
+    m_timer.start();
+}
+
+Tracer *Tracer::instance() {
+    static Tracer tracer;
+    return &tracer;
+}
+
+double Tracer::now() const {
+    return m_timer.nsecsElapsed() / 1000.0;
+}
+
+void Tracer::addCompleteEvent(const char *category, const char *name,
+                              double start, double duration, const QString &detail) {
+    Event event = {category, name, 'X', start, duration, 0, 0, detail};
+    QMutexLocker locker(&m_mutex);
+    addEvent(event);
+}
+
+void Tracer::addCounterEvent(const char *category, const char *name, double value) {
+    Event event = {category, name, 'C', now(), value, 0, 0, QString()};
+    QMutexLocker locker(&m_mutex);
+    addEvent(event);
+}
+
+void Tracer::addInstantEvent(const char *category, const char *name, const QString &detail) {
+    Event event = {category, name, 'i', now(), 0, 0, 0, detail};
+    QMutexLocker locker(&m_mutex);
+    addEvent(event);
+}
+
+void Tracer::addAsyncEvent(const char *category, const char *name, quintptr id, bool begin) {
+    Event event = {category, name, begin ? 'b' : 'e', now(), 0, id, 0, QString()};
+    QMutexLocker locker(&m_mutex);
+    addEvent(event);
+}
+
+void Tracer::addEvent(Event &event) {
+    const Qt::HANDLE threadHandle = QThread::currentThreadId();
+    auto thread = m_threads.constFind(threadHandle);
+    if (thread == m_threads.constEnd()) {
+        QThread *currentThread = QThread::currentThread();
+        QString threadName = currentThread->objectName();
+        if (QCoreApplication::instance() && currentThread == QCoreApplication::instance()->thread()) {
+            threadName = "Main thread";
+        } else if (threadName.isEmpty()) {
+            threadName = "Thread " + QString::number(m_threadNames.size());
+        }
+        thread = m_threads.insert(threadHandle, m_threadNames.size());
+        m_threadNames.append(threadName);
+    }
+    event.thread = thread.value();
+
+    if (m_events.size() < MAX_EVENTS) {
+        m_events.append(event);
+    } else {
+        // Overwrite the oldest event
+        m_events[m_firstEvent] = event;
+        m_firstEvent = (m_firstEvent + 1) % MAX_EVENTS;
+    }
+}
+
+bool Tracer::writeChromeTrace(const QString &filePath) const {
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    const qint64 processId = QCoreApplication::applicationPid();
+    file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    auto writeEvent = [&file, &first](const QJsonObject &event) {
+        if (!first) {
+            file.write(",\n");
+        }
+        first = false;
+        file.write(QJsonDocument(event).toJson(QJsonDocument::Compact));
+    };
+
+    for (int i = 0; i < m_threadNames.size(); i++) {
+        writeEvent({{"ph", "M"}, {"name", "thread_name"}, {"pid", processId}, {"tid", i},
+                    {"args", QJsonObject{{"name", m_threadNames[i]}}}});
+    }
+    for (int i = 0; i < m_events.size(); i++) {
+        const Event &event = m_events[(m_firstEvent + i) % m_events.size()];
+        QJsonObject object{{"ph", QString(QLatin1Char(event.phase))},
+                           {"cat", event.category},
+                           {"name", event.name},
+                           {"ts", event.timestamp},
+                           {"pid", processId},
+                           {"tid", event.thread}};
+        switch (event.phase) {
+        case 'X':
+            object["dur"] = event.value;
+            break;
+        case 'C':
+            object["args"] = QJsonObject{{"value", event.value}};
+            break;
+        case 'i':
+            // Only mark the thread instead of drawing a line through the whole trace
+            object["s"] = "t";
+            break;
+        case 'b':
+        case 'e':
+            object["id"] = QString::number(event.id, 16);
+            break;
+        }
+        if (!event.detail.isEmpty()) {
+            object["args"] = QJsonObject{{"detail", event.detail}};
+        }
+        writeEvent(object);
+    }
+    file.write("\n]}\n");
+    return file.error() == QFile::NoError;
+}
+
+void Tracer::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+    m_firstEvent = 0;
+}
+
+TraceSpan::TraceSpan(const char *category, const char *name, const QString &detail)
+    : m_category(category)
+    , m_name(name)
+    , m_detail(detail)
+    , m_start(Tracer::instance()->now()) {
+}
+
+TraceSpan::~TraceSpan() {
+    Tracer *tracer = Tracer::instance();
+    tracer->addCompleteEvent(m_category, m_name, m_start, tracer->now() - m_start, m_detail);
+}
@@ -0,0 +1,133 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/*!
+ * \brief The Tracer class records spans, counters and instants of the running program and
+ * writes them in the Chrome trace format, which chrome://tracing and Perfetto open. This
+ * shows on which thread the time of a slow operation went to, e.g. loading, the gallery
+ * previews or switching images.
+ *
+ * Don't use the class directly but the TRACE_* macros below. They only record anything if
+ * the program was built with
+ *
+ *     qmake CONFIG+=tracing
+ *
+ * and expand to nothing otherwise, not even their arguments are evaluated. Categories and
+ * names have to be string literals since only their pointers are stored.
+ */
+class Tracer {
+
+public:
+    static Tracer *instance();
+
+    //! Microseconds since the tracer was created, the time base of all events
+    double now() const;
+
+    void addCompleteEvent(const char *category, const char *name,
+                          double start, double duration, const QString &detail = QString());
+    void addCounterEvent(const char *category, const char *name, double value);
+    void addInstantEvent(const char *category, const char *name, const QString &detail = QString());
+    //! Spans that end on another thread or in a different call than they began, e.g. renderings
+    void addAsyncEvent(const char *category, const char *name, quintptr id, bool begin);
+
+    /*!
+     * \brief writeChromeTrace writes all recorded events to the file.
+     * \return false if the file could not be written
+     */
+    bool writeChromeTrace(const QString &filePath) const;
+    //! Removes all recorded events, e.g. to only trace a single operation
+    void clear();
+
+    /*!
+     * \brief MAX_EVENTS the events that are kept at most, older ones are dropped so that a
+     * long session can't use up the memory.
+     */
+    static const int MAX_EVENTS;
+
+private:
+    Tracer();
+
+    struct Event {
+        const char *category;
+        const char *name;
+        char phase;
+        double timestamp;
+        //! The duration of complete events, the value of counters
+        double value;
+        quintptr id;
+        int thread;
+        QString detail;
+    };
+
+    //! Needs the mutex to be locked
+    void addEvent(Event &event);
+
+private:
+    QElapsedTimer m_timer;
+    mutable QMutex m_mutex;
+    //! A ring buffer of at most MAX_EVENTS events starting at m_firstEvent
+    QVector<Event> m_events;
+    int m_firstEvent = 0;
+    //! Small numbers instead of the thread handles to make the trace readable
+    QHash<Qt::HANDLE, int> m_threads;
+    QVector<QString> m_threadNames;
+};
+
+/*!
+ * \brief The TraceSpan class records the time from its construction to its destruction as a
+ * span on the current thread, see TRACE_SCOPE.
+ */
+class TraceSpan {
+
+public:
+    TraceSpan(const char *category, const char *name, const QString &detail = QString());
+    ~TraceSpan();
+
+private:
+    const char *m_category;
+    const char *m_name;
+    QString m_detail;
+    double m_start;
+};
+
+#ifdef ENABLE_TRACING
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+//! Records a span from here to the end of the enclosing scope
+#define TRACE_SCOPE(category, name) \
+    TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(category, name)
+//! Like TRACE_SCOPE with a string that is shown with the span, e.g. the path of a file
+#define TRACE_SCOPE_DETAIL(category, name, detail) \
+    TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(category, name, detail)
+//! Records the value of a counter, counters of the same name are drawn as a graph
+#define TRACE_COUNTER(category, name, value) \
+    Tracer::instance()->addCounterEvent(category, name, value)
+//! Records a single point in time
+#define TRACE_INSTANT(category, name, detail) \
+    Tracer::instance()->addInstantEvent(category, name, detail)
+//! Begins a span that TRACE_ASYNC_END with the same name and id ends
+#define TRACE_ASYNC_BEGIN(category, name, id) \
+    Tracer::instance()->addAsyncEvent(category, name, quintptr(id), true)
+#define TRACE_ASYNC_END(category, name, id) \
+    Tracer::instance()->addAsyncEvent(category, name, quintptr(id), false)
+
+#else
+
+#define TRACE_SCOPE(category, name) ((void) 0)
+#define TRACE_SCOPE_DETAIL(category, name, detail) ((void) 0)
+#define TRACE_COUNTER(category, name, value) ((void) 0)
+#define TRACE_INSTANT(category, name, detail) ((void) 0)
+#define TRACE_ASYNC_BEGIN(category, name, id) ((void) 0)
+#define TRACE_ASYNC_END(category, name, id) ((void) 0)
+
+#endif
+
+#endif // TRACING_H
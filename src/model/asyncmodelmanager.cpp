@@ -0,0 +1,106 @@
+#include "asyncmodelmanager.hpp"
+
+AsyncModelManager::AsyncModelManager(ModelManager *modelManager, QObject *parent)
+    : QObject(parent)
+    , m_modelManager(modelManager) {
+    Q_ASSERT(modelManager != Q_NULLPTR);
+    connect(modelManager, &ModelManager::dataChanged,
+            this, &AsyncModelManager::dataChanged);
+    connect(modelManager, &ModelManager::imagesChanged,
+            this, &AsyncModelManager::imagesChanged);
+    connect(modelManager, &ModelManager::objectModelsChanged,
+            this, &AsyncModelManager::objectModelsChanged);
+    connect(modelManager, &ModelManager::posesReloaded,
+            this, &AsyncModelManager::posesReloaded);
+    connect(modelManager, &ModelManager::poseAdded,
+            this, &AsyncModelManager::poseAdded);
+    connect(modelManager, &ModelManager::poseUpdated,
+            this, &AsyncModelManager::poseUpdated);
+    connect(modelManager, &ModelManager::poseDeleted,
+            this, &AsyncModelManager::poseDeleted);
+    connect(modelManager, &ModelManager::stateChanged,
+            this, &AsyncModelManager::stateChanged);
+}
+
+QFuture<QList<ImagePtr>> AsyncModelManager::images() const {
+    return run<QList<ImagePtr>>([](ModelManager *modelManager) {
+        return modelManager->images();
+    });
+}
+
+QFuture<QList<ObjectModelPtr>> AsyncModelManager::objectModels() const {
+    return run<QList<ObjectModelPtr>>([](ModelManager *modelManager) {
+        return modelManager->objectModels();
+    });
+}
+
+QFuture<QList<PosePtr>> AsyncModelManager::poses() const {
+    return run<QList<PosePtr>>([](ModelManager *modelManager) {
+        return modelManager->poses();
+    });
+}
+
+QFuture<QList<PosePtr>> AsyncModelManager::posesForImage(const ImagePtr &image) const {
+    return run<QList<PosePtr>>([image](ModelManager *modelManager) {
+        return modelManager->posesForImage(*image);
+    });
+}
+
+QFuture<QList<PosePtr>> AsyncModelManager::posesForObjectModel(const ObjectModelPtr &objectModel) const {
+    return run<QList<PosePtr>>([objectModel](ModelManager *modelManager) {
+        return modelManager->posesForObjectModel(*objectModel);
+    });
+}
+
+QFuture<PosePtr> AsyncModelManager::poseById(const QString &id) const {
+    return run<PosePtr>([id](ModelManager *modelManager) {
+        return modelManager->poseById(id);
+    });
+}
+
+ModelSnapshotPtr AsyncModelManager::snapshot() const {
+    return m_modelManager->snapshot();
+}
+
+QFuture<PosePtr> AsyncModelManager::addPose(const Pose &pose) {
+    PosePtr copy(new Pose(pose));
+    return run<PosePtr>([copy](ModelManager *modelManager) {
+        return modelManager->addPose(*copy);
+    });
+}
+
+QFuture<PosePtr> AsyncModelManager::addPose(ImagePtr image,
+                                            ObjectModelPtr objectModel,
+                                            const QVector3D &position,
+                                            const QMatrix3x3 &rotation) {
+    return run<PosePtr>([image, objectModel, position, rotation](ModelManager *modelManager) {
+        return modelManager->addPose(image, objectModel, position, rotation);
+    });
+}
+
+QFuture<bool> AsyncModelManager::updatePose(const QString &id,
+                                            const QVector3D &position,
+                                            const QMatrix3x3 &rotation) {
+    return run<bool>([id, position, rotation](ModelManager *modelManager) {
+        return modelManager->updatePose(id, position, rotation);
+    });
+}
+
+QFuture<QStringList> AsyncModelManager::updatePoses(const QList<PosePtr> &poses) {
+    return run<QStringList>([poses](ModelManager *modelManager) {
+        return modelManager->updatePoses(poses);
+    });
+}
+
+QFuture<bool> AsyncModelManager::removePose(const QString &id) {
+    return run<bool>([id](ModelManager *modelManager) {
+        return modelManager->removePose(id);
+    });
+}
+
+void AsyncModelManager::execute(QFutureInterface<void> &future,
+                                const std::function<void(ModelManager *)> &command,
+                                ModelManager *modelManager) {
+    command(modelManager);
+    future.reportFinished();
+}
@@ -0,0 +1,122 @@
+#ifndef ASYNCMODELMANAGER_H
+#define ASYNCMODELMANAGER_H
+
+#include "modelmanager.hpp"
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QMetaObject>
+#include <QThread>
+
+#include <functional>
+
+/*!
+ * \brief The AsyncModelManager class is the interface through which the GUI thread talks to
+ * the model manager living on its own thread. Every query and every modification is sent
+ * to the manager's thread as a command and executed there one after the other, in the order
+ * the commands were issued. The results are returned as futures.
+ *
+ * Since the manager only ever runs one command or one of its own slots (e.g. applying loaded
+ * data) at a time, every query sees a consistent state and no command can observe a half
+ * finished reload. The GUI thread must not wait on the futures, it watches them with a
+ * QFutureWatcher instead. Data that is needed right away is read from the snapshot.
+ *
+ * The signals of the model manager are forwarded, i.e. emitted on the thread of this object.
+ * The manager publishes its snapshot before it emits a signal, i.e. the snapshot a slot
+ * reads is at least as new as the change that is being handled.
+ */
+class AsyncModelManager : public QObject {
+
+    Q_OBJECT
+
+public:
+    explicit AsyncModelManager(ModelManager *modelManager, QObject *parent = Q_NULLPTR);
+
+    QFuture<QList<ImagePtr>> images() const;
+    QFuture<QList<ObjectModelPtr>> objectModels() const;
+    QFuture<QList<PosePtr>> poses() const;
+    QFuture<QList<PosePtr>> posesForImage(const ImagePtr &image) const;
+    QFuture<QList<PosePtr>> posesForObjectModel(const ObjectModelPtr &objectModel) const;
+    QFuture<PosePtr> poseById(const QString &id) const;
+    /*!
+     * \brief snapshot is not a command, it returns the latest snapshot of the manager right
+     * away. Use it instead of images() and objectModels() wherever a consistent list is
+     * enough, e.g. to display them.
+     */
+    ModelSnapshotPtr snapshot() const;
+
+    //! The pose is copied, i.e. the caller can keep on modifying it
+    QFuture<PosePtr> addPose(const Pose &pose);
+    QFuture<PosePtr> addPose(ImagePtr image,
+                             ObjectModelPtr objectModel,
+                             const QVector3D &position,
+                             const QMatrix3x3 &rotation);
+    QFuture<bool> updatePose(const QString &id,
+                             const QVector3D &position,
+                             const QMatrix3x3 &rotation);
+    QFuture<QStringList> updatePoses(const QList<PosePtr> &poses);
+    QFuture<bool> removePose(const QString &id);
+
+    /*!
+     * \brief run executes the given command on the model manager's thread, in order with
+     * all other commands. This allows to run several calls to the manager as one command.
+     */
+    template<typename T>
+    QFuture<T> run(const std::function<T(ModelManager *)> &command) const;
+
+Q_SIGNALS:
+    void dataChanged(int data);
+    void imagesChanged(const QList<ImagePtr> &images, const DataDelta &delta);
+    void objectModelsChanged(const QList<ObjectModelPtr> &objectModels, const DataDelta &delta);
+    void posesReloaded(const QList<ImagePtr> &images);
+    void poseAdded(PosePtr pose);
+    void poseUpdated(PosePtr pose);
+    void poseDeleted(PosePtr pose);
+    void stateChanged(ModelManager::State state, const QString &error);
+
+private:
+    template<typename T>
+    static void execute(QFutureInterface<T> &future,
+                        const std::function<T(ModelManager *)> &command,
+                        ModelManager *modelManager);
+    static void execute(QFutureInterface<void> &future,
+                        const std::function<void(ModelManager *)> &command,
+                        ModelManager *modelManager);
+
+private:
+    ModelManager *m_modelManager;
+};
+
+template<typename T>
+QFuture<T> AsyncModelManager::run(const std::function<T(ModelManager *)> &command) const {
+    QFutureInterface<T> future;
+    future.reportStarted();
+    ModelManager *modelManager = m_modelManager;
+    auto task = [future, command, modelManager]() mutable {
+        execute(future, command, modelManager);
+    };
+    QThread *managerThread = m_modelManager->thread();
+    if (managerThread == QThread::currentThread()) {
+        // A command issued by the manager itself would otherwise wait for itself
+        task();
+    } else {
+        // Running the command here would race with the manager's thread as soon as it is
+        // started, a command issued before is delivered once the event loop runs
+        Q_ASSERT_X(managerThread->isRunning(), "AsyncModelManager::run",
+                   "The thread of the model manager is not running.");
+        // Queued calls to the same receiver are delivered in the order they were posted
+        QMetaObject::invokeMethod(m_modelManager, task, Qt::QueuedConnection);
+    }
+    return future.future();
+}
+
+template<typename T>
+void AsyncModelManager::execute(QFutureInterface<T> &future,
+                                const std::function<T(ModelManager *)> &command,
+                                ModelManager *modelManager) {
+    future.reportResult(command(modelManager));
+    future.reportFinished();
+}
+
+#endif // ASYNCMODELMANAGER_H
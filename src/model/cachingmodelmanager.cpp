@@ -1,74 +1,506 @@
 #include "cachingmodelmanager.hpp"
+#include "internpool.hpp"
 #include "misc/generalhelper.hpp"
+#include "misc/memoryaccounting.hpp"
+#include "misc/tracing.hpp"
 
 #include <QApplication>
+#include <QCollator>
+#include <QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSet>
+#include <QtConcurrent>
 
-CachingModelManager::CachingModelManager(LoadAndStoreStrategyPtr loadAndStoreStrategy) : ModelManager(loadAndStoreStrategy) {
-    connect(loadAndStoreStrategy.get(), &LoadAndStoreStrategy::dataChanged,
-            this, &CachingModelManager::dataChanged);
-    connect(loadAndStoreStrategy.get(), &LoadAndStoreStrategy::error,
-            this, &CachingModelManager::onLoadAndStoreStrategyError);
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+QString normalizedPath(const QString &path) {
+    return QFileInfo(path).absoluteFilePath();
+}
+
+//! Compares the poses of one image as they are stored, i.e. ignoring their order
+bool samePoses(const PoseStore &store1, QVector<int> rows1,
+               const PoseStore &store2, QVector<int> rows2) {
+    if (rows1.size() != rows2.size()) {
+        return false;
+    }
+    std::sort(rows1.begin(), rows1.end(), [&store1](int r1, int r2) {
+        return store1.id(r1) < store1.id(r2);
+    });
+    std::sort(rows2.begin(), rows2.end(), [&store2](int r1, int r2) {
+        return store2.id(r1) < store2.id(r2);
+    });
+    for (int i = 0; i < rows1.size(); i++) {
+        const int row1 = rows1[i];
+        const int row2 = rows2[i];
+        // Both stores index the same list of object models
+        if (store1.id(row1) != store2.id(row2)
+                || store1.position(row1) != store2.position(row2)
+                || store1.rotation(row1) != store2.rotation(row2)
+                || store1.objectModelIndex(row1) != store2.objectModelIndex(row2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! Compares the entities by their values, reloaded entities are new objects
+template<typename T>
+bool sameEntities(const QList<QSharedPointer<T>> &list1, const QList<QSharedPointer<T>> &list2) {
+    if (list1.size() != list2.size()) {
+        return false;
+    }
+    for (int i = 0; i < list1.size(); i++) {
+        if (list1[i] != list2[i] && !(*list1[i] == *list2[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+CachingModelManager::CachingModelManager(LoadAndStoreStrategyPtr loadAndStoreStrategy)
+    : ModelManager(loadAndStoreStrategy)
+    , m_snapshot(new ModelSnapshot) {
+    connectLoadAndStoreStrategy();
+    connect(&m_manifestVerifyWatcher, &QFutureWatcherBase::finished,
+            this, &CachingModelManager::onManifestVerified);
+    connect(MemoryAccounting::instance(), &MemoryAccounting::budgetExceeded,
+            this, &CachingModelManager::onMemoryBudgetExceeded);
 }
 
 CachingModelManager::~CachingModelManager() {
+    m_manifestVerifyWatcher.waitForFinished();
+    if (!m_manifestOutdated || m_loadingFailed || !m_loadAndStoreStrategy->supportsManifest()) {
+        return;
+    }
+    // Poses have been edited, without storing them the next start could not use the manifest.
+    // The stamps must only be renewed if we know that the files still contain what we hold
+    // in memory, i.e. nobody else touched them since loading them or writing the poses.
+    bool dependenciesUnchanged = m_dependenciesVerified;
+    for (const DatasetManifest::Dependency &dependency : m_loadedDependencies) {
+        if (!dependenciesUnchanged) {
+            break;
+        }
+        dependenciesUnchanged = LoadAndStoreStrategy::stampFile(dependency.first) == dependency.second;
+    }
+    if (dependenciesUnchanged) {
+        DatasetManifest manifest;
+        manifest.setDependencies(m_loadedDependencies);
+        saveManifest(manifest);
+    } else {
+        // The outdated manifest would be found up to date if the files got their old stamps
+        // back, we can't tell what it's missing
+        DatasetManifest::remove(manifestKey());
+    }
 }
 
 void CachingModelManager::setLoadAndStoreStrategy(LoadAndStoreStrategyPtr strategy) {
-    disconnect(m_loadAndStoreStrategy.get(), &LoadAndStoreStrategy::dataChanged,
-            this, &CachingModelManager::dataChanged);
-    disconnect(m_loadAndStoreStrategy.get(), &LoadAndStoreStrategy::error,
-            this, &CachingModelManager::onLoadAndStoreStrategyError);
+    disconnectLoadAndStoreStrategy();
     m_loadAndStoreStrategy = strategy;
+    connectLoadAndStoreStrategy();
+}
+
+void CachingModelManager::connectLoadAndStoreStrategy() {
     connect(m_loadAndStoreStrategy.get(), &LoadAndStoreStrategy::dataChanged,
-            this, &CachingModelManager::dataChanged);
+            this, &CachingModelManager::onDataChanged);
+    connect(m_loadAndStoreStrategy.get(), &LoadAndStoreStrategy::filesChanged,
+            this, &CachingModelManager::onFilesChanged);
     connect(m_loadAndStoreStrategy.get(), &LoadAndStoreStrategy::error,
             this, &CachingModelManager::onLoadAndStoreStrategyError);
 }
 
+void CachingModelManager::disconnectLoadAndStoreStrategy() {
+    disconnect(m_loadAndStoreStrategy.get(), &LoadAndStoreStrategy::dataChanged,
+            this, &CachingModelManager::onDataChanged);
+    disconnect(m_loadAndStoreStrategy.get(), &LoadAndStoreStrategy::filesChanged,
+            this, &CachingModelManager::onFilesChanged);
+    disconnect(m_loadAndStoreStrategy.get(), &LoadAndStoreStrategy::error,
+            this, &CachingModelManager::onLoadAndStoreStrategyError);
+}
+
 void CachingModelManager::createConditionalCache() {
-    m_posesForImages.clear();
-    m_posesForObjectModels.clear();
-    for (int i = 0; i < m_poses.size(); i++) {
-        PosePtr pose = m_poses[i];
+    TRACE_SCOPE("model", "CachingModelManager::createConditionalCache");
+    m_poseRowForId.clear();
+    m_poseRowForId.reserve(m_poses.size());
+    m_poseRowsForImages = QVector<QVector<int>>(m_images.size());
+    m_poseRowsForObjectModels = QVector<QVector<int>>(m_objectModels.size());
+    PoseId greatestId;
+    QSet<PoseId> legacyIds;
+    for (int row = 0; row < m_poses.size(); row++) {
+        const PoseId id = m_poses.id(row);
+        m_poseRowForId.insert(id, row);
+        if (id.isLegacy()) {
+            legacyIds.insert(id);
+        } else if (greatestId < id) {
+            greatestId = id;
+        }
 
         //! Setup cache of poses that can be retrieved via an image
-        QList<PosePtr> &posesForImage =
-                m_posesForImages[pose->image()->imagePath()];
-        posesForImage.append(pose);
+        m_poseRowsForImages[m_poses.imageIndex(row)].append(row);
 
         //! Setup cache of poses that can be retrieved via an object model
-        QList<PosePtr> &posesForObjectModel =
-                m_posesForObjectModels[pose->objectModel()->path()];
-        posesForObjectModel.append(pose);
+        m_poseRowsForObjectModels[m_poses.objectModelIndex(row)].append(row);
+    }
+    // New poses must not get the id of a loaded one, even if it was created on a clock
+    // that was ahead of ours
+    PoseId::advancePast(greatestId);
+    // The ids of poses that are gone can't be looked up anymore anyway, the manager is the
+    // only one registering legacy ids
+    PoseId::releaseLegacyIds(legacyIds);
+
+    // Get rid of the entries of poses that nobody references anymore
+    QMutexLocker locker(&m_materializedPosesMutex);
+    for (auto it = m_materializedPoses.begin(); it != m_materializedPoses.end();) {
+        if (it->isNull()) {
+            it = m_materializedPoses.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CachingModelManager::indexEntities() {
+    m_imageIndexForPath.clear();
+    m_imageIndexForPath.reserve(m_images.size());
+    for (int i = 0; i < m_images.size(); i++) {
+        m_imageIndexForPath.insert(m_images[i]->imagePath(), i);
+    }
+    m_objectModelIndexForPath.clear();
+    m_objectModelIndexForPath.reserve(m_objectModels.size());
+    for (int i = 0; i < m_objectModels.size(); i++) {
+        m_objectModelIndexForPath.insert(m_objectModels[i]->path(), i);
+    }
+}
+
+PoseStore CachingModelManager::poseStoreFromPoses(const QList<PosePtr> &poses) const {
+    PoseStore store;
+    store.reserve(poses.size());
+    for (const PosePtr &pose : poses) {
+        const int imageIndex = m_imageIndexForPath.value(pose->image()->imagePath(), -1);
+        const int objectModelIndex = m_objectModelIndexForPath.value(pose->objectModel()->path(), -1);
+        if (imageIndex == -1 || objectModelIndex == -1) {
+            continue;
+        }
+        store.append(PoseId::fromString(pose->id()), pose->position(), pose->rotation(),
+                     imageIndex, objectModelIndex);
+    }
+    return store;
+}
+
+PosePtr CachingModelManager::materializePose(int row) const {
+    const PoseId id = m_poses.id(row);
+    QMutexLocker locker(&m_materializedPosesMutex);
+    PosePtr pose = m_materializedPoses.value(id).toStrongRef();
+    if (pose.isNull()) {
+        pose.reset(new Pose(id.toString(),
+                            m_poses.position(row),
+                            m_poses.rotation(row),
+                            m_images[m_poses.imageIndex(row)],
+                            m_objectModels[m_poses.objectModelIndex(row)]));
+        m_materializedPoses.insert(id, pose);
+    }
+    return pose;
+}
+
+QList<PosePtr> CachingModelManager::materializePoses(const QVector<int> &rows) const {
+    QList<PosePtr> poses;
+    poses.reserve(rows.size());
+    for (int row : rows) {
+        poses.append(materializePose(row));
+    }
+    return poses;
+}
+
+QSet<int> CachingModelManager::imageIndicesOf(const QList<ImagePtr> &images) const {
+    QSet<int> imageIndices;
+    for (const ImagePtr &image : images) {
+        const int imageIndex = m_imageIndexForPath.value(image->imagePath(), -1);
+        if (imageIndex != -1) {
+            imageIndices.insert(imageIndex);
+        }
+    }
+    return imageIndices;
+}
+
+void CachingModelManager::forgetMaterializedPoses() {
+    QMutexLocker locker(&m_materializedPosesMutex);
+    m_materializedPoses.clear();
+}
+
+void CachingModelManager::forgetMaterializedPosesOfImages(const QSet<int> &imageIndices) {
+    QMutexLocker locker(&m_materializedPosesMutex);
+    for (int imageIndex : imageIndices) {
+        for (int row : m_poseRowsForImages.value(imageIndex)) {
+            m_materializedPoses.remove(m_poses.id(row));
+        }
     }
 }
 
 void CachingModelManager::onDataChanged(int data) {
+    // Further changes might still be on their way, the files can't be trusted anymore
+    m_dependenciesVerified = false;
+    if (data == Data::Poses) {
+        // Only the poses file changed, no need to reset the whole program
+        PoseStore loadedPoses = poseStoreFromPoses(
+                    m_loadAndStoreStrategy->loadPoses(m_images, m_objectModels));
+        QVector<QVector<int>> loadedRowsForImages(m_images.size());
+        for (int row = 0; row < loadedPoses.size(); row++) {
+            loadedRowsForImages[loadedPoses.imageIndex(row)].append(row);
+        }
+        QList<ImagePtr> changedImages;
+        QSet<int> changedImageIndices;
+        for (int i = 0; i < m_images.size(); i++) {
+            if (!samePoses(m_poses, m_poseRowsForImages[i], loadedPoses, loadedRowsForImages[i])) {
+                changedImages.append(m_images[i]);
+                changedImageIndices.insert(i);
+            }
+        }
+        // Pose objects of unchanged images stay valid since views might still reference them
+        forgetMaterializedPosesOfImages(changedImageIndices);
+        m_poses = loadedPoses;
+        m_posesSqueezed = false;
+        createConditionalCache();
+        m_manifestOutdated = true;
+        publishSnapshot();
+        if (!changedImages.isEmpty()) {
+            Q_EMIT posesReloaded(changedImages);
+        }
+        return;
+    }
+
     Q_EMIT stateChanged(State::Loading, QString());
-    if (data == Images) {
+    if (data & Data::Images) {
         m_images = m_loadAndStoreStrategy->loadImages();
         // Add to flag that poses have been changed too
         data |= Data::Poses;
     }
-    if (data == ObjectModels) {
+    if (data & Data::ObjectModels) {
         m_objectModels = m_loadAndStoreStrategy->loadObjectModels();
         // Add to flag that poses have been changed too
         data |= Data::Poses;
     }
+    indexEntities();
     // We need to load poses no matter what
-    m_poses = m_loadAndStoreStrategy->loadPoses(m_images, m_objectModels);
+    forgetMaterializedPoses();
+    m_poses = poseStoreFromPoses(m_loadAndStoreStrategy->loadPoses(m_images, m_objectModels));
+    m_posesSqueezed = false;
     createConditionalCache();
+    m_loadAndStoreStrategy->updateFileSnapshots();
+    m_manifestOutdated = true;
+    publishSnapshot();
     Q_EMIT stateChanged(ModelManager::State::Ready, QString());
     Q_EMIT dataChanged(data);
 }
 
+void CachingModelManager::onFilesChanged(int data, const QStringList &absolutePaths) {
+    m_dependenciesVerified = false;
+    if (data == Data::Images) {
+        applyImagesDelta(absolutePaths);
+    } else if (data == Data::ObjectModels) {
+        applyObjectModelsDelta(absolutePaths);
+    }
+}
+
+void CachingModelManager::applyImagesDelta(const QStringList &absolutePaths) {
+    TRACE_SCOPE("model", "CachingModelManager::applyImagesDelta");
+    QSet<QString> touchedPaths;
+    for (const QString &path : absolutePaths) {
+        touchedPaths.insert(normalizedPath(path));
+    }
+
+    QHash<QString, ImagePtr> reloadedImagesForPath;
+    for (const ImagePtr &image : m_loadAndStoreStrategy->loadImagesDelta(absolutePaths)) {
+        reloadedImagesForPath.insert(normalizedPath(image->absoluteImagePath()), image);
+    }
+
+    DataDelta delta;
+    QList<ImagePtr> images;
+    QList<ImagePtr> removedImages;
+    QSet<int> removedImageIndices;
+    QSet<QString> changedPaths;
+    for (int i = 0; i < m_images.size(); i++) {
+        const ImagePtr &image = m_images[i];
+        const QString path = normalizedPath(image->absoluteImagePath());
+        if (!touchedPaths.contains(path)) {
+            images.append(image);
+            continue;
+        }
+        auto reloadedImage = reloadedImagesForPath.find(path);
+        // Changed images are replaced and their poses reloaded
+        removedImages.append(image);
+        removedImageIndices.insert(i);
+        if (reloadedImage == reloadedImagesForPath.end()) {
+            delta.removedRows.append(i);
+        } else {
+            images.append(*reloadedImage);
+            changedPaths.insert(path);
+            reloadedImagesForPath.erase(reloadedImage);
+        }
+    }
+
+    // What's left are new images, insert them where a full reload would put them
+    QCollator collator;
+    collator.setNumericMode(true);
+    auto lessThan = [&collator](const ImagePtr &i1, const ImagePtr &i2) {
+        return collator.compare(i1->imagePath(), i2->imagePath()) < 0;
+    };
+    QSet<QString> insertedPaths;
+    for (const ImagePtr &image : reloadedImagesForPath) {
+        images.insert(std::upper_bound(images.begin(), images.end(), image, lessThan), image);
+        insertedPaths.insert(normalizedPath(image->absoluteImagePath()));
+    }
+
+    QList<ImagePtr> reloadedImages;
+    for (int i = 0; i < images.size(); i++) {
+        const QString path = normalizedPath(images[i]->absoluteImagePath());
+        if (insertedPaths.contains(path)) {
+            delta.insertedRows.append(i);
+            reloadedImages.append(images[i]);
+        } else if (changedPaths.contains(path)) {
+            delta.changedRows.append(i);
+            reloadedImages.append(images[i]);
+        }
+    }
+
+    if (delta.isEmpty()) {
+        return;
+    }
+
+    // Drop the poses of the replaced images and move the ones of all other images to the
+    // new indices before loading the poses of the new images
+    QVector<int> imageMapping = delta.rowMapping(m_images.size());
+    for (int i : removedImageIndices) {
+        imageMapping[i] = -1;
+    }
+    forgetMaterializedPosesOfImages(removedImageIndices);
+    m_poses.remapImageIndices(imageMapping);
+    m_images = images;
+    indexEntities();
+    m_poses.append(poseStoreFromPoses(
+                       m_loadAndStoreStrategy->loadPosesDelta(m_images, m_objectModels, reloadedImages)));
+    createConditionalCache();
+
+    m_manifestOutdated = true;
+    publishSnapshot();
+
+    Q_EMIT imagesChanged(m_images, delta);
+    Q_EMIT posesReloaded(removedImages + reloadedImages);
+}
+
+void CachingModelManager::applyObjectModelsDelta(const QStringList &absolutePaths) {
+    TRACE_SCOPE("model", "CachingModelManager::applyObjectModelsDelta");
+    QSet<QString> touchedPaths;
+    for (const QString &path : absolutePaths) {
+        touchedPaths.insert(normalizedPath(path));
+    }
+
+    QHash<QString, int> oldRowForPath;
+    for (int i = 0; i < m_objectModels.size(); i++) {
+        oldRowForPath.insert(normalizedPath(m_objectModels[i]->absolutePath()), i);
+    }
+
+    // Listing the object models is cheap, their geometry is only loaded when they are
+    // rendered, which is why we can simply compare the new list to the old one
+    DataDelta delta;
+    QList<ObjectModelPtr> objectModels;
+    QSet<int> affectedRows;
+    QSet<int> keptRows;
+    QVector<int> objectModelMapping(m_objectModels.size(), -1);
+    for (const ObjectModelPtr &objectModel : m_loadAndStoreStrategy->loadObjectModels()) {
+        const QString path = normalizedPath(objectModel->absolutePath());
+        auto oldRow = oldRowForPath.constFind(path);
+        if (oldRow == oldRowForPath.constEnd()) {
+            delta.insertedRows.append(objectModels.size());
+            objectModels.append(objectModel);
+        } else if (touchedPaths.contains(path)) {
+            delta.changedRows.append(objectModels.size());
+            affectedRows.insert(*oldRow);
+            objectModelMapping[*oldRow] = objectModels.size();
+            objectModels.append(objectModel);
+            keptRows.insert(*oldRow);
+        } else {
+            objectModelMapping[*oldRow] = objectModels.size();
+            objectModels.append(m_objectModels[*oldRow]);
+            keptRows.insert(*oldRow);
+        }
+    }
+    for (int i = 0; i < m_objectModels.size(); i++) {
+        if (!keptRows.contains(i)) {
+            delta.removedRows.append(i);
+            affectedRows.insert(i);
+        }
+    }
+
+    if (delta.isEmpty()) {
+        return;
+    }
+
+    QList<ImagePtr> affectedImages;
+    if (!delta.insertedRows.isEmpty()) {
+        // Poses that referenced a previously missing object model can be loaded now,
+        // we can't know which images they belong to without reading all poses
+        m_objectModels = objectModels;
+        indexEntities();
+        forgetMaterializedPoses();
+        m_poses = poseStoreFromPoses(m_loadAndStoreStrategy->loadPoses(m_images, m_objectModels));
+        m_posesSqueezed = false;
+        createConditionalCache();
+        affectedImages = m_images;
+    } else {
+        for (int i = 0; i < m_images.size(); i++) {
+            for (int row : m_poseRowsForImages[i]) {
+                if (affectedRows.contains(m_poses.objectModelIndex(row))) {
+                    affectedImages.append(m_images[i]);
+                    break;
+                }
+            }
+        }
+        // Poses of removed object models are dropped here, the ones of changed object
+        // models are replaced when reloading the affected images
+        forgetMaterializedPosesOfImages(imageIndicesOf(affectedImages));
+        m_poses.remapObjectModelIndices(objectModelMapping);
+        m_objectModels = objectModels;
+        indexEntities();
+        createConditionalCache();
+        reloadPosesOfImages(affectedImages);
+    }
+
+    m_manifestOutdated = true;
+    publishSnapshot();
+    Q_EMIT objectModelsChanged(m_objectModels, delta);
+    if (!affectedImages.isEmpty()) {
+        Q_EMIT posesReloaded(affectedImages);
+    }
+}
+
+void CachingModelManager::reloadPosesOfImages(const QList<ImagePtr> &images) {
+    TRACE_SCOPE("model", "CachingModelManager::reloadPosesOfImages");
+    if (images.isEmpty()) {
+        return;
+    }
+    const QSet<int> imageIndices = imageIndicesOf(images);
+    forgetMaterializedPosesOfImages(imageIndices);
+    m_poses.removeRowsOfImages(imageIndices);
+    m_poses.append(poseStoreFromPoses(
+                       m_loadAndStoreStrategy->loadPosesDelta(m_images, m_objectModels, images)));
+    createConditionalCache();
+}
+
 QList<ImagePtr> CachingModelManager::images() const {
     return m_images;
 }
 
 QList<PosePtr> CachingModelManager::posesForImage(const Image &image) const  {
-    if (m_posesForImages.find(image.imagePath()) != m_posesForImages.end()) {
-        return m_posesForImages[image.imagePath()];
+    TRACE_SCOPE("model", "CachingModelManager::posesForImage");
+    const int imageIndex = m_imageIndexForPath.value(image.imagePath(), -1);
+    if (imageIndex != -1) {
+        return materializePoses(m_poseRowsForImages[imageIndex]);
     }
 
     return QList<PosePtr>();
@@ -79,34 +511,138 @@ QList<ObjectModelPtr> CachingModelManager::objectModels() const {
 }
 
 QList<PosePtr> CachingModelManager::posesForObjectModel(const ObjectModel &objectModel) const {
-    if (m_posesForObjectModels.find(objectModel.path()) != m_posesForObjectModels.end()) {
-        return m_posesForObjectModels[objectModel.path()];
+    TRACE_SCOPE("model", "CachingModelManager::posesForObjectModel");
+    const int objectModelIndex = m_objectModelIndexForPath.value(objectModel.path(), -1);
+    if (objectModelIndex != -1) {
+        return materializePoses(m_poseRowsForObjectModels[objectModelIndex]);
     }
 
     return QList<PosePtr>();
 }
 
 QList<PosePtr> CachingModelManager::poses() const {
-    return m_poses;
+    QList<PosePtr> poses;
+    poses.reserve(m_poses.size());
+    for (int row = 0; row < m_poses.size(); row++) {
+        poses.append(materializePose(row));
+    }
+    return poses;
+}
+
+QList<PosePtr> CachingModelManager::storedPoses() const {
+    QList<PosePtr> poses;
+    poses.reserve(m_poses.size());
+    for (int row = 0; row < m_poses.size(); row++) {
+        poses.append(PosePtr(new Pose(m_poses.id(row).toString(),
+                                      m_poses.position(row),
+                                      m_poses.rotation(row),
+                                      m_images[m_poses.imageIndex(row)],
+                                      m_objectModels[m_poses.objectModelIndex(row)])));
+    }
+    return poses;
 }
 
 PosePtr CachingModelManager::poseById(const QString &id) const {
-    PosePtr result;
-    auto itObj = std::find_if(
-        m_poses.begin(), m_poses.end(),
-        [id](PosePtr o) { return o->id() == id; }
-    );
-    if (itObj != m_poses.end()) {
-        result = *itObj;
+    const int row = m_poseRowForId.value(PoseId::find(id), -1);
+    if (row == -1) {
+        return PosePtr();
+    }
+    return materializePose(row);
+}
+
+ModelSnapshotPtr CachingModelManager::snapshot() const {
+    QMutexLocker locker(&m_snapshotMutex);
+    return m_snapshot;
+}
+
+void CachingModelManager::publishSnapshot() {
+    TRACE_SCOPE("model", "CachingModelManager::publishSnapshot");
+    // Only this thread publishes, i.e. the current snapshot can't change in between
+    const ModelSnapshotPtr current = snapshot();
+    const bool imagesChanged = !sameEntities(current->images(), m_images);
+    const bool objectModelsChanged = !sameEntities(current->objectModels(), m_objectModels);
+    // The lists are implicitly shared, the snapshot doesn't copy them until we modify ours
+    ModelSnapshotPtr next(new ModelSnapshot(
+                              current->version() + 1,
+                              current->imagesVersion() + (imagesChanged ? 1 : 0),
+                              current->objectModelsVersion() + (objectModelsChanged ? 1 : 0),
+                              m_images,
+                              m_objectModels));
+    {
+        QMutexLocker locker(&m_snapshotMutex);
+        m_snapshot = next;
+    }
+    if (imagesChanged) {
+        m_imagesMemoryUsage = 0;
+        for (const ImagePtr &image : m_images) {
+            m_imagesMemoryUsage += sizeof(Image) + 2 * (image->id().size() + image->imagePath().size()
+                                                        + image->segmentationImagePath().size()
+                                                        + image->getBasePath().size());
+        }
+    }
+    if (objectModelsChanged) {
+        m_objectModelsMemoryUsage = 0;
+        for (const ObjectModelPtr &objectModel : m_objectModels) {
+            m_objectModelsMemoryUsage += sizeof(ObjectModel) + 2 * (objectModel->id().size()
+                                                                    + objectModel->path().size()
+                                                                    + objectModel->basePath().size());
+        }
+    }
+    if (imagesChanged || objectModelsChanged) {
+        // Entities of the previous snapshot that are still referenced keep their values,
+        // they are dropped on one of the next changes
+        InternPool::purge();
     }
-    return result;
+    MemoryAccounting::instance()->reportUsage(MemoryAccounting::ENTITIES, memoryUsage());
+}
+
+qint64 CachingModelManager::memoryUsage() const {
+    // Strings are counted for every entity, even if the intern pool shares them
+    qint64 bytes = m_imagesMemoryUsage + m_objectModelsMemoryUsage;
+    bytes += m_poses.memoryUsage();
+    // The rows of every pose are stored once per image and once per object model, plus
+    // a hash entry per id
+    bytes += qint64(m_poses.size()) * (2 * sizeof(int) + sizeof(PoseId) + sizeof(int) + sizeof(void*));
+    QMutexLocker locker(&m_materializedPosesMutex);
+    bytes += qint64(m_materializedPoses.size()) * (sizeof(Pose) + sizeof(QWeakPointer<Pose>));
+    return bytes;
+}
+
+void CachingModelManager::onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree) {
+    Q_UNUSED(bytesToFree)
+    if (subsystem != MemoryAccounting::ENTITIES) {
+        return;
+    }
+    if (m_posesSqueezed) {
+        // Nothing more to free until the poses are loaded again
+        return;
+    }
+    m_posesSqueezed = true;
+    {
+        QMutexLocker locker(&m_materializedPosesMutex);
+        for (auto pose = m_materializedPoses.begin(); pose != m_materializedPoses.end();) {
+            if (pose->isNull()) {
+                pose = m_materializedPoses.erase(pose);
+            } else {
+                pose++;
+            }
+        }
+        m_materializedPoses.squeeze();
+    }
+    m_poses.squeeze();
+    MemoryAccounting::instance()->reportUsage(MemoryAccounting::ENTITIES, memoryUsage());
 }
 
 QList<PosePtr> CachingModelManager::posesForImageAndObjectModel(const Image &image, const ObjectModel &objectModel) {
     QList<PosePtr> posesForImageAndObjectModel;
-    for (PosePtr &pose : m_posesForImages[image.imagePath()]) {
-        if (pose->objectModel()->path().compare(objectModel.path()) == 0) {
-           posesForImageAndObjectModel.append(pose);
+    const int imageIndex = m_imageIndexForPath.value(image.imagePath(), -1);
+    const int objectModelIndex = m_objectModelIndexForPath.value(objectModel.path(), -1);
+    if (imageIndex == -1 || objectModelIndex == -1) {
+        return posesForImageAndObjectModel;
+    }
+    for (int row : m_poseRowsForImages[imageIndex]) {
+        if (m_poses.objectModelIndex(row) == objectModelIndex) {
+           posesForImageAndObjectModel.append(materializePose(row));
         }
     }
     return posesForImageAndObjectModel;
@@ -118,7 +654,7 @@ PosePtr CachingModelManager::addPose(ImagePtr image,
                                      const QMatrix3x3 &rotation) {
     Q_ASSERT(image);
     Q_ASSERT(objectModel);
-    return this->addPose(Pose(GeneralHelper::createPoseId(*image, *objectModel),
+    return this->addPose(Pose(GeneralHelper::createPoseId(),
                               position,
                               rotation,
                               image,
@@ -126,103 +662,285 @@ PosePtr CachingModelManager::addPose(ImagePtr image,
 }
 
 PosePtr CachingModelManager::addPose(const Pose &pose) {
-    // Persist the pose
-    if (!m_loadAndStoreStrategy->persistPose(pose, false)) {
+    TRACE_SCOPE("model", "CachingModelManager::addPose");
+    if (savePoses({PosePtr(new Pose(pose))}, {}, {}).isEmpty()) {
         //! if there is an error persisting the pose for any reason we should not add the pose to this manager
         return PosePtr();
     }
-
-    //! pose has not yet been added
-    PosePtr newPose(new Pose(pose));
-    m_poses.push_back(newPose);
-
-    createConditionalCache();
-
-    Q_EMIT poseAdded(newPose);
-
-    return newPose;
+    return materializePose(m_poseRowForId.value(PoseId::find(pose.id())));
 }
 
 bool CachingModelManager::updatePose(const QString &id,
                                      const QVector3D &position,
                                      const QMatrix3x3 &rotation) {
-    PosePtr pose;
-    for (int i = 0; i < m_poses.size(); i++) {
-        if (m_poses[i]->id() == id) {
-            pose = m_poses[i];
-            break;
+    TRACE_SCOPE("model", "CachingModelManager::updatePose");
+    // Only carries the values, the image and object model are the stored ones
+    const PosePtr updatedPose(new Pose(id, position, rotation, ImagePtr(), ObjectModelPtr()));
+    return !savePoses({}, {updatedPose}, {}).isEmpty();
+}
+
+QStringList CachingModelManager::updatePoses(const QList<PosePtr> &poses) {
+    TRACE_SCOPE("model", "CachingModelManager::updatePoses");
+    return savePoses({}, poses, {});
+}
+
+bool CachingModelManager::removePose(const QString &id) {
+    TRACE_SCOPE("model", "CachingModelManager::removePose");
+    return !savePoses({}, {}, {id}).isEmpty();
+}
+
+QStringList CachingModelManager::savePoses(const QList<PosePtr> &posesToAdd,
+                                           const QList<PosePtr> &posesToUpdate,
+                                           const QStringList &poseIdsToRemove) {
+    TRACE_SCOPE_DETAIL("model", "CachingModelManager::savePoses",
+                       QString::number(posesToAdd.size() + posesToUpdate.size() + poseIdsToRemove.size()));
+    // The strategy gets the poses with the images and object models of this manager
+    QList<PosePtr> addedPoses;
+    QVector<int> addedImageIndices;
+    QVector<int> addedObjectModelIndices;
+    for (const PosePtr &pose : posesToAdd) {
+        const int imageIndex = m_imageIndexForPath.value(pose->image()->imagePath(), -1);
+        const int objectModelIndex = m_objectModelIndexForPath.value(pose->objectModel()->path(), -1);
+        if (imageIndex == -1 || objectModelIndex == -1) {
+            //! this manager does not manage the image or object model of the pose
+            continue;
         }
+        addedPoses.append(PosePtr(new Pose(pose->id(), pose->position(), pose->rotation(),
+                                           m_images[imageIndex], m_objectModels[objectModelIndex])));
+        addedImageIndices.append(imageIndex);
+        addedObjectModelIndices.append(objectModelIndex);
     }
-
-    if (pose.isNull()) {
-        //! this manager does not manage the given pose
-        return false;
+    QVector<int> updatedRows;
+    QList<PosePtr> updatedPoses;
+    for (const PosePtr &pose : posesToUpdate) {
+        const int row = m_poseRowForId.value(PoseId::find(pose->id()), -1);
+        if (row == -1) {
+            //! this manager does not manage the given pose
+            continue;
+        }
+        updatedRows.append(row);
+        updatedPoses.append(PosePtr(new Pose(pose->id(), pose->position(), pose->rotation(),
+                                             m_images[m_poses.imageIndex(row)],
+                                             m_objectModels[m_poses.objectModelIndex(row)])));
+    }
+    QVector<int> removedRows;
+    QList<PosePtr> removedPoses;
+    for (const QString &id : poseIdsToRemove) {
+        const int row = m_poseRowForId.value(PoseId::find(id), -1);
+        if (row == -1 || removedRows.contains(row)) {
+            continue;
+        }
+        removedRows.append(row);
+        removedPoses.append(materializePose(row));
+    }
+    if (addedPoses.isEmpty() && updatedPoses.isEmpty() && removedPoses.isEmpty()) {
+        return QStringList();
     }
 
-    QVector3D previousPosition = pose->position();
-    QMatrix3x3 previousRotation = pose->rotation().toRotationMatrix() ;
+    QStringList persistedIds;
+    writePosesFile([this, &addedPoses, &updatedPoses, &removedPoses, &persistedIds]() {
+        persistedIds = m_loadAndStoreStrategy->persistPoses(addedPoses + updatedPoses, removedPoses);
+        return !persistedIds.isEmpty();
+    });
+    if (persistedIds.isEmpty()) {
+        //! if there is an error persisting the poses for any reason we should not keep the changes
+        return persistedIds;
+    }
+    // Exactly the changes that made it to the poses file are applied, whatever the strategy
+    // couldn't persist stays as it was
+    const QSet<QString> persisted = QSet<QString>::fromList(persistedIds);
+
+    QList<PosePtr> changedPoses;
+    for (int i = 0; i < updatedRows.size(); i++) {
+        if (persisted.contains(updatedPoses[i]->id())) {
+            m_poses.setPose(updatedRows[i], updatedPoses[i]->position(), updatedPoses[i]->rotation());
+            changedPoses.append(materializePose(updatedRows[i]));
+        }
+    }
+    QList<PosePtr> newPoses;
+    for (int i = 0; i < addedPoses.size(); i++) {
+        if (!persisted.contains(addedPoses[i]->id())) {
+            continue;
+        }
+        //! new rows go to the end which keeps the caches valid
+        const PoseId id = PoseId::fromString(addedPoses[i]->id());
+        const int row = m_poses.append(id, addedPoses[i]->position(), addedPoses[i]->rotation(),
+                                       addedImageIndices[i], addedObjectModelIndices[i]);
+        m_poseRowForId.insert(id, row);
+        m_poseRowsForImages[addedImageIndices[i]].append(row);
+        m_poseRowsForObjectModels[addedObjectModelIndices[i]].append(row);
+        newPoses.append(materializePose(row));
+    }
+    QList<PosePtr> deletedPoses;
+    QVector<int> rowsToRemove;
+    for (int i = 0; i < removedRows.size(); i++) {
+        if (persisted.contains(removedPoses[i]->id())) {
+            rowsToRemove.append(removedRows[i]);
+            deletedPoses.append(removedPoses[i]);
+        }
+    }
+    if (!rowsToRemove.isEmpty()) {
+        // From the back, removing a row moves the following ones
+        std::sort(rowsToRemove.begin(), rowsToRemove.end(), std::greater<int>());
+        {
+            QMutexLocker locker(&m_materializedPosesMutex);
+            for (int row : rowsToRemove) {
+                m_materializedPoses.remove(m_poses.id(row));
+            }
+        }
+        for (int row : rowsToRemove) {
+            m_poses.removeAt(row);
+        }
+        createConditionalCache();
+    }
+    m_manifestOutdated = true;
+    // Only one snapshot for all changes
+    publishSnapshot();
 
-    pose->setPosition(position);
-    pose->setRotation(rotation);
+    for (const PosePtr &pose : changedPoses) {
+        Q_EMIT poseUpdated(pose);
+    }
+    for (const PosePtr &pose : newPoses) {
+        Q_EMIT poseAdded(pose);
+    }
+    for (const PosePtr &pose : deletedPoses) {
+        Q_EMIT poseDeleted(pose);
+    }
+    return persistedIds;
+}
 
-    if (!m_loadAndStoreStrategy->persistPose(*pose, false)) {
-        // if there is an error persisting the pose for any reason we should not keep the new values
-        pose->setPosition(previousPosition);
-        pose->setRotation(previousRotation);
-        return false;
+void CachingModelManager::reload() {
+    TRACE_SCOPE("model", "CachingModelManager::reload");
+    Q_EMIT stateChanged(CachingModelManager::State::Loading, QString());
+    if (loadFromManifest()) {
+        Q_EMIT dataReady();
+        return;
     }
 
+    // Stamped before loading so that changes while loading invalidate the manifest
+    DatasetManifest manifest;
+    const bool useManifest = m_loadAndStoreStrategy->supportsManifest();
+    if (useManifest) {
+        manifest.setDependencies(m_loadAndStoreStrategy->manifestDependencies());
+    }
+    m_loadingFailed = false;
+    m_images = m_loadAndStoreStrategy->loadImages();
+    m_objectModels = m_loadAndStoreStrategy->loadObjectModels();
+    indexEntities();
+    forgetMaterializedPoses();
+    m_poses = poseStoreFromPoses(m_loadAndStoreStrategy->loadPoses(m_images, m_objectModels));
+    m_posesSqueezed = false;
     createConditionalCache();
-
-    Q_EMIT poseUpdated(pose);
-
-    return true;
+    // Later changes on the filesystem are compared to the loaded state
+    m_loadAndStoreStrategy->updateFileSnapshots();
+    if (useManifest && !m_loadingFailed) {
+        saveManifest(manifest);
+    }
+    m_loadedDependencies = manifest.dependencies();
+    m_dependenciesVerified = useManifest;
+    Q_EMIT dataReady();
 }
 
-bool CachingModelManager::removePose(const QString &id) {
-    PosePtr pose;
-    for (int i = 0; i < m_poses.size(); i++) {
-        if (m_poses[i]->id() == id)
-            pose = m_poses[i];
-    }
+QString CachingModelManager::manifestKey() const {
+    return QStringList({m_loadAndStoreStrategy->metaObject()->className(),
+                        m_loadAndStoreStrategy->imagesPath(),
+                        m_loadAndStoreStrategy->segmentationImagesPath(),
+                        m_loadAndStoreStrategy->objectModelsPath(),
+                        m_loadAndStoreStrategy->posesFilePath()}).join('\n');
+}
 
-    if (!pose) {
-        //! this manager does not manager the given pose
+bool CachingModelManager::loadFromManifest() {
+    TRACE_SCOPE("model", "CachingModelManager::loadFromManifest");
+    if (!m_loadAndStoreStrategy->supportsManifest()) {
         return false;
     }
-
-    if (!m_loadAndStoreStrategy->persistPose(*pose, true)) {
-        //! there was an error persistently removing the corresopndence, maybe wrong folder, maybe the pose didn't exist
-        //! thus it doesn't make sense to remove the pose from this manager
+    DatasetManifest manifest;
+    if (!manifest.load(manifestKey()) || !manifest.isUpToDate()) {
         return false;
     }
-
-    for (int i = 0; i < m_poses.size(); i++) {
-        if (m_poses.at(i)->id() == id)
-            m_poses.removeAt(i);
-    }
-
+    m_loadingFailed = false;
+    m_images = manifest.images();
+    m_objectModels = manifest.objectModels();
+    m_poses = manifest.poses();
+    m_posesSqueezed = false;
+    indexEntities();
+    forgetMaterializedPoses();
     createConditionalCache();
+    m_manifestOutdated = false;
+    m_loadedDependencies = manifest.dependencies();
+    // Trusted once the background check below is done
+    m_dependenciesVerified = false;
+
+    // The cheap check only covers the folders and files the strategy named, to be sure
+    // we compare every image and object model file in the background
+    m_verifiedManifest = manifest;
+    const QString imagesPath = m_loadAndStoreStrategy->imagesPath();
+    const QString objectModelsPath = m_loadAndStoreStrategy->objectModelsPath();
+    m_manifestVerifyWatcher.setFuture(QtConcurrent::run([imagesPath, objectModelsPath]() {
+        return qMakePair(LoadAndStoreStrategy::snapshotFiles(imagesPath, false),
+                         LoadAndStoreStrategy::snapshotFiles(objectModelsPath, true));
+    }));
+    return true;
+}
 
-    Q_EMIT poseDeleted(pose);
+void CachingModelManager::onManifestVerified() {
+    auto snapshots = m_manifestVerifyWatcher.result();
+    DatasetManifest manifest = m_verifiedManifest;
+    m_verifiedManifest = DatasetManifest();
+    if (snapshots.first == manifest.imageFiles()
+            && snapshots.second == manifest.objectModelFiles()) {
+        // Saves listing the folders again
+        m_loadAndStoreStrategy->setFileSnapshots(snapshots.first, snapshots.second);
+        m_dependenciesVerified = true;
+    } else {
+        qDebug() << "Dataset manifest is outdated, reloading.";
+        DatasetManifest::remove(manifestKey());
+        reload();
+    }
+}
 
-    return true;
+bool CachingModelManager::writePosesFile(const std::function<bool()> &write) {
+    const QString posesFilePath = m_loadAndStoreStrategy->posesFilePath();
+    int dependencyIndex = -1;
+    for (int i = 0; i < m_loadedDependencies.size(); i++) {
+        if (m_loadedDependencies[i].first == posesFilePath) {
+            dependencyIndex = i;
+        }
+    }
+    if (dependencyIndex != -1
+            && LoadAndStoreStrategy::stampFile(posesFilePath) != m_loadedDependencies[dependencyIndex].second) {
+        // Someone else wrote the file, whatever they wrote isn't necessarily loaded yet
+        m_dependenciesVerified = false;
+    }
+    const bool written = write();
+    if (dependencyIndex != -1) {
+        // Our own changes are in memory already
+        m_loadedDependencies[dependencyIndex].second = LoadAndStoreStrategy::stampFile(posesFilePath);
+    }
+    return written;
 }
 
-void CachingModelManager::reload() {
-    Q_EMIT stateChanged(CachingModelManager::State::Loading, QString());
-    m_images = m_loadAndStoreStrategy->loadImages();
-    m_objectModels = m_loadAndStoreStrategy->loadObjectModels();
-    m_poses = m_loadAndStoreStrategy->loadPoses(m_images, m_objectModels);
-    createConditionalCache();
-    Q_EMIT dataReady();
+void CachingModelManager::saveManifest(const DatasetManifest &dependencies) {
+    TRACE_SCOPE("model", "CachingModelManager::saveManifest");
+    DatasetManifest manifest = dependencies;
+    manifest.setEntities(m_images, m_objectModels, m_poses);
+    manifest.setImageFiles(m_loadAndStoreStrategy->imageFilesSnapshot());
+    manifest.setObjectModelFiles(m_loadAndStoreStrategy->objectModelFilesSnapshot());
+    if (manifest.save(manifestKey())) {
+        m_manifestOutdated = false;
+    }
 }
 
 void CachingModelManager::onLoadAndStoreStrategyError(const QString &error) {
+    m_loadingFailed = true;
     Q_EMIT stateChanged(CachingModelManager::State::Error, error);
 }
 
 void CachingModelManager::dataReady() {
+    TRACE_COUNTER("model", "images", m_images.size());
+    TRACE_COUNTER("model", "object models", m_objectModels.size());
+    TRACE_COUNTER("model", "poses", m_poses.size());
+    publishSnapshot();
     Q_EMIT stateChanged(CachingModelManager::State::Ready, QString());
     Q_EMIT dataChanged(Data::Images | Data::ObjectModels | Data::Poses);
 }
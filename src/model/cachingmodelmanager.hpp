@@ -3,11 +3,21 @@
 
 #include "modelmanager.hpp"
 #include "loadandstorestrategy.hpp"
-#include <QMap>
+#include "datasetmanifest.hpp"
+#include "posestore.hpp"
+#include <QHash>
+#include <QMutex>
+#include <QSet>
 #include <QString>
 #include <QList>
+#include <QStringList>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QPair>
+#include <QVector>
+#include <QWeakPointer>
+
+#include <functional>
 
 /*!
  * \brief The CachingModelManager class implements the ModelManager interface. To improve the speed of the application
@@ -35,9 +45,12 @@ public:
     QList<PosePtr> posesForObjectModel(const ObjectModel &objectModel) const override;
 
     QList<PosePtr> poses() const override;
+    QList<PosePtr> storedPoses() const override;
 
     PosePtr poseById(const QString &id) const override;
 
+    ModelSnapshotPtr snapshot() const override;
+
     QList<PosePtr> posesForImageAndObjectModel(const Image &image,
                                                const ObjectModel &objectModel) override;
 
@@ -52,6 +65,12 @@ public:
                     const QVector3D &position,
                     const QMatrix3x3 &rotation) override;
 
+    QStringList updatePoses(const QList<PosePtr> &poses) override;
+
+    QStringList savePoses(const QList<PosePtr> &posesToAdd,
+                          const QList<PosePtr> &posesToUpdate,
+                          const QStringList &poseIdsToRemove) override;
+
     bool removePose(const QString &id) override;
 
 public Q_SLOTS:
@@ -61,7 +80,15 @@ private Q_SLOTS:
     // Callback for threadded data loading
     void dataReady();
     void onDataChanged(int data);
+    void onFilesChanged(int data, const QStringList &absolutePaths);
     void onLoadAndStoreStrategyError(const QString &error);
+    void onManifestVerified();
+    /*!
+     * \brief onMemoryBudgetExceeded drops the entries of materialized poses that are not
+     * used anymore and releases reserved memory, at most once per load of the poses. The
+     * entities themselves can't be evicted.
+     */
+    void onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree);
 
 private:
     /*!
@@ -69,20 +96,126 @@ private:
      * can be retrieved for an image or for an object model.
      */
     void createConditionalCache();
+    /*!
+     * \brief indexEntities maps the paths of the images and object models to their
+     * indices, it has to be called whenever one of the two lists changes.
+     */
+    void indexEntities();
+    /*!
+     * \brief poseStoreFromPoses converts the poses a strategy loaded into rows of a store,
+     * poses of images or object models that this manager doesn't know are dropped.
+     */
+    PoseStore poseStoreFromPoses(const QList<PosePtr> &poses) const;
+    //! The indices of the given images in m_images
+    QSet<int> imageIndicesOf(const QList<ImagePtr> &images) const;
+    /*!
+     * \brief materializePose returns the Pose object of the given row. As long as someone
+     * holds on to it, the same object is returned for the row's pose.
+     */
+    PosePtr materializePose(int row) const;
+    QList<PosePtr> materializePoses(const QVector<int> &rows) const;
+    //! Drops all materialized poses, e.g. because the poses have been reloaded
+    void forgetMaterializedPoses();
+    //! Drops the materialized poses of the images with the given indices
+    void forgetMaterializedPosesOfImages(const QSet<int> &imageIndices);
+    /*!
+     * \brief applyImagesDelta reloads only the images at the given paths and their poses,
+     * keeping all other images as they are.
+     */
+    void applyImagesDelta(const QStringList &absolutePaths);
+    /*!
+     * \brief applyObjectModelsDelta reloads only the object models at the given paths and
+     * the poses that reference them.
+     */
+    void applyObjectModelsDelta(const QStringList &absolutePaths);
+    /*!
+     * \brief reloadPosesOfImages replaces the poses of the given images by the ones the
+     * strategy loads for them.
+     */
+    void reloadPosesOfImages(const QList<ImagePtr> &images);
+    void connectLoadAndStoreStrategy();
+    /*!
+     * \brief manifestKey identifies the manifest of the current strategy and paths.
+     */
+    QString manifestKey() const;
+    /*!
+     * \brief loadFromManifest takes the entities from the manifest of the current dataset
+     * if it is still valid and starts verifying it thoroughly in the background.
+     * \return false if there is no valid manifest and the data has to be loaded normally
+     */
+    bool loadFromManifest();
+    /*!
+     * \brief saveManifest stores the current entities in the manifest.
+     * \param dependencies the dependencies stamped before the entities were loaded, so that
+     * changes during loading invalidate the manifest
+     */
+    void saveManifest(const DatasetManifest &dependencies);
+    //! Runs the given write of the poses file and keeps track of its stamp
+    bool writePosesFile(const std::function<bool()> &write);
+    void disconnectLoadAndStoreStrategy();
+    /*!
+     * \brief publishSnapshot replaces the snapshot readers get by one of the current state,
+     * it has to be called whenever the entities or poses changed.
+     */
+    void publishSnapshot();
+    /*!
+     * \brief memoryUsage estimates the bytes the entities, the pose store and the indices
+     * take, which is reported to the MemoryAccounting whenever a snapshot is published. Only
+     * the images and object models are counted one by one and only when they changed.
+     */
+    qint64 memoryUsage() const;
 
 private:
     //! The pattern that is used to load maybe existing segmentation images
     QString m_segmentationImagePattern;
     //! The list of the loaded images
     QList<ImagePtr> m_images;
-    //! Convenience map to store poses for images
-    QMap<QString, QList<PosePtr>> m_posesForImages;
+    //! Maps the image paths to their index in m_images
+    QHash<QString, int> m_imageIndexForPath;
     //! The list of the loaded object models
     QList<ObjectModelPtr> m_objectModels;
-    //! Convenience map to store poses for object models
-    QMap<QString, QList<PosePtr>> m_posesForObjectModels;
-    //! The list of the object image poses
-    QList<PosePtr> m_poses;
+    //! Maps the object model paths to their index in m_objectModels
+    QHash<QString, int> m_objectModelIndexForPath;
+    //! The values of all object image poses, Pose objects are only created when requested
+    PoseStore m_poses;
+    //! Convenience map to find the row of a pose
+    QHash<PoseId, int> m_poseRowForId;
+    //! The rows of the poses of every image, by image index
+    QVector<QVector<int>> m_poseRowsForImages;
+    //! The rows of the poses of every object model, by object model index
+    QVector<QVector<int>> m_poseRowsForObjectModels;
+    //! Pose objects that have been handed out, weak so that unused ones get freed
+    mutable QHash<PoseId, QWeakPointer<Pose>> m_materializedPoses;
+    //! The views request poses from the main thread
+    mutable QMutex m_materializedPosesMutex;
+    //! Lists the folders in the background to verify a manifest that has been used
+    QFutureWatcher<QPair<LoadAndStoreStrategy::FileSnapshot,
+                         LoadAndStoreStrategy::FileSnapshot>> m_manifestVerifyWatcher{this};
+    DatasetManifest m_verifiedManifest;
+    /*!
+     * The files and folders the entities were loaded from with their stamps at that time,
+     * the stamp of the poses file is renewed after writing poses
+     */
+    QList<DatasetManifest::Dependency> m_loadedDependencies;
+    //! Cleared as soon as the files might differ from the entities, e.g. when they changed
+    bool m_dependenciesVerified = false;
+    //! Never modified, only replaced as a whole by publishSnapshot
+    ModelSnapshotPtr m_snapshot;
+    //! Only held to copy or to replace the pointer, readers never wait for the manager
+    mutable QMutex m_snapshotMutex;
+    //! Set when the entities changed since the manifest was written
+    bool m_manifestOutdated = false;
+    //! Set when the strategy reported an error while loading, such a state is not cached
+    bool m_loadingFailed = false;
+    //! The estimated bytes of the images and object models, only updated when they change
+    qint64 m_imagesMemoryUsage = 0;
+    qint64 m_objectModelsMemoryUsage = 0;
+    /*!
+     * Set when the pose store has been squeezed to stay within the memory budget, cleared
+     * when the poses are loaded again. Appending grows the store again, squeezing on every
+     * publish would copy all poses for every edit.
+     */
+    bool m_posesSqueezed = false;
 
 };
 
@@ -1,6 +1,10 @@
 #ifndef DATA_HPP
 #define DATA_HPP
 
+#include <QList>
+#include <QVector>
+#include <QMetaType>
+
 enum Data {
     Images       = 1,
     ObjectModels = 2,
@@ -12,5 +16,72 @@ inline Data operator|(Data a, Data b)
     return static_cast<Data>(static_cast<int>(a) | static_cast<int>(b));
 }
 
+/*!
+ * \brief The DataDelta struct describes how a list of entities (e.g. the images) changed
+ * when only some of them were reloaded, so that views can update the affected rows only.
+ */
+struct DataDelta {
+    //! Rows in the old list of the entities that were removed, ascending
+    QList<int> removedRows;
+    //! Rows in the new list of the entities that were inserted, ascending
+    QList<int> insertedRows;
+    //! Rows in the new list of the entities that were reloaded but kept their row
+    QList<int> changedRows;
+
+    bool isEmpty() const {
+        return removedRows.isEmpty() && insertedRows.isEmpty() && changedRows.isEmpty();
+    }
+
+    /*!
+     * \brief mapRow maps a row of the old list to the row of the same entity in the new list.
+     * \return the new row or -1 if the entity was removed
+     */
+    int mapRow(int oldRow) const {
+        if (oldRow < 0 || removedRows.contains(oldRow)) {
+            return -1;
+        }
+        int newRow = oldRow;
+        for (int removedRow : removedRows) {
+            if (removedRow < oldRow) {
+                newRow--;
+            }
+        }
+        for (int insertedRow : insertedRows) {
+            if (insertedRow <= newRow) {
+                newRow++;
+            }
+        }
+        return newRow;
+    }
+
+    /*!
+     * \brief rowMapping maps all rows of the old list at once, which is a lot faster than
+     * calling mapRow for every row of a large list.
+     * \param oldRowCount the size of the old list
+     * \return the new row for each old row, -1 for removed ones
+     */
+    QVector<int> rowMapping(int oldRowCount) const {
+        QVector<int> mapping(oldRowCount, -1);
+        int removedIndex = 0;
+        int insertedIndex = 0;
+        int newRow = 0;
+        for (int oldRow = 0; oldRow < oldRowCount; oldRow++) {
+            if (removedIndex < removedRows.size() && removedRows[removedIndex] == oldRow) {
+                removedIndex++;
+                continue;
+            }
+            // Inserted rows are given in the new list, skip the ones before this row
+            while (insertedIndex < insertedRows.size() && insertedRows[insertedIndex] == newRow) {
+                insertedIndex++;
+                newRow++;
+            }
+            mapping[oldRow] = newRow;
+            newRow++;
+        }
+        return mapping;
+    }
+};
+
+Q_DECLARE_METATYPE(DataDelta)
 
 #endif // DATA_HPP
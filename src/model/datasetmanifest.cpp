@@ -0,0 +1,223 @@
+#include "datasetmanifest.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// "6DMF"
+const quint32 DatasetManifest::MAGIC = 0x36444D46;
+// Increase whenever the format or what the strategies load changes
+const quint32 DatasetManifest::VERSION = 3;
+
+// Not in an anonymous namespace, the stream operators of the Qt containers need to find
+// them through argument dependent lookup
+static QDataStream &operator<<(QDataStream &stream, const LoadAndStoreStrategy::FileStamp &stamp) {
+    return stream << stamp.size << stamp.lastModified;
+}
+
+static QDataStream &operator>>(QDataStream &stream, LoadAndStoreStrategy::FileStamp &stamp) {
+    return stream >> stamp.size >> stamp.lastModified;
+}
+
+DatasetManifest::DatasetManifest() {
+}
+
+QString DatasetManifest::manifestFilePath(const QString &key) {
+    QString hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    return cacheDir.filePath("manifests/" + hash + ".manifest");
+}
+
+bool DatasetManifest::load(const QString &key) {
+    QFile file(manifestFilePath(key));
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic, version;
+    QString storedKey;
+    stream >> magic >> version;
+    if (magic != MAGIC || version != VERSION) {
+        return false;
+    }
+    stream >> storedKey;
+    if (storedKey != key) {
+        // Extremely unlikely collision of the hashes
+        return false;
+    }
+
+    stream >> m_dependencies >> m_imageFiles >> m_objectModelFiles;
+
+    qint32 numberOfImages;
+    stream >> numberOfImages;
+    m_images.clear();
+    m_images.reserve(numberOfImages);
+    for (qint32 i = 0; i < numberOfImages && stream.status() == QDataStream::Ok; i++) {
+        QString id, imagePath, segmentationImagePath, basePath, depthImagePath, sceneId;
+        QMatrix3x3 cameraMatrix, cameraRotation;
+        QVector3D cameraTranslation;
+        float nearPlane, farPlane, depthScale;
+        bool hasCameraExtrinsics;
+        stream >> id >> imagePath >> segmentationImagePath >> basePath >> cameraMatrix
+               >> nearPlane >> farPlane >> depthImagePath >> depthScale
+               >> hasCameraExtrinsics >> cameraRotation >> cameraTranslation >> sceneId;
+        ImagePtr image(new Image(id, imagePath, segmentationImagePath, basePath,
+                                 cameraMatrix, nearPlane, farPlane));
+        if (!depthImagePath.isEmpty()) {
+            image->setDepthImage(depthImagePath, depthScale);
+        }
+        if (hasCameraExtrinsics) {
+            image->setCameraExtrinsics(cameraRotation, cameraTranslation);
+        }
+        if (!sceneId.isEmpty()) {
+            image->setSceneId(sceneId);
+        }
+        m_images.append(image);
+    }
+
+    qint32 numberOfObjectModels;
+    stream >> numberOfObjectModels;
+    m_objectModels.clear();
+    m_objectModels.reserve(numberOfObjectModels);
+    for (qint32 i = 0; i < numberOfObjectModels && stream.status() == QDataStream::Ok; i++) {
+        QString id, path, basePath;
+        stream >> id >> path >> basePath;
+        m_objectModels.append(ObjectModelPtr(new ObjectModel(id, path, basePath)));
+    }
+
+    qint32 numberOfPoses;
+    stream >> numberOfPoses;
+    m_poses.clear();
+    m_poses.reserve(numberOfPoses);
+    for (qint32 i = 0; i < numberOfPoses && stream.status() == QDataStream::Ok; i++) {
+        QString id;
+        QVector3D position;
+        QQuaternion rotation;
+        qint32 imageIndex, objectModelIndex;
+        stream >> id >> position >> rotation >> imageIndex >> objectModelIndex;
+        if (imageIndex < 0 || imageIndex >= m_images.size()
+                || objectModelIndex < 0 || objectModelIndex >= m_objectModels.size()) {
+            return false;
+        }
+        m_poses.append(PoseId::fromString(id), position, rotation, imageIndex, objectModelIndex);
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool DatasetManifest::save(const QString &key) const {
+    const QString filePath = manifestFilePath(key);
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    // Written to a temporary file first, a crash never leaves a half written manifest
+    QSaveFile file(filePath);
+    if (!file.open(QFile::WriteOnly)) {
+        qDebug() << "Could not write dataset manifest " + filePath;
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << MAGIC << VERSION << key;
+    stream << m_dependencies << m_imageFiles << m_objectModelFiles;
+
+    stream << qint32(m_images.size());
+    for (const ImagePtr &image : m_images) {
+        stream << image->id() << image->imagePath() << image->segmentationImagePath()
+               << image->getBasePath() << image->getCameraMatrix()
+               << image->nearPlane() << image->farPlane()
+               << image->depthImagePath() << image->depthScale()
+               << image->hasCameraExtrinsics() << image->cameraRotation()
+               << image->cameraTranslation() << image->sceneId();
+    }
+
+    stream << qint32(m_objectModels.size());
+    for (const ObjectModelPtr &objectModel : m_objectModels) {
+        stream << objectModel->id() << objectModel->path() << objectModel->basePath();
+    }
+
+    // Poses reference their image and object model by index
+    stream << qint32(m_poses.size());
+    for (int row = 0; row < m_poses.size(); row++) {
+        stream << m_poses.id(row).toString() << m_poses.position(row) << m_poses.rotation(row)
+               << qint32(m_poses.imageIndex(row)) << qint32(m_poses.objectModelIndex(row));
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+void DatasetManifest::remove(const QString &key) {
+    QFile::remove(manifestFilePath(key));
+}
+
+bool DatasetManifest::isUpToDate() const {
+    if (m_dependencies.isEmpty()) {
+        return false;
+    }
+    for (const Dependency &dependency : m_dependencies) {
+        if (LoadAndStoreStrategy::stampFile(dependency.first) != dependency.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DatasetManifest::setDependencies(const QStringList &dependencies) {
+    m_dependencies.clear();
+    for (const QString &dependency : dependencies) {
+        m_dependencies.append(Dependency(dependency, LoadAndStoreStrategy::stampFile(dependency)));
+    }
+}
+
+void DatasetManifest::setDependencies(const QList<Dependency> &dependencies) {
+    m_dependencies = dependencies;
+}
+
+QList<DatasetManifest::Dependency> DatasetManifest::dependencies() const {
+    return m_dependencies;
+}
+
+void DatasetManifest::setEntities(const QList<ImagePtr> &images,
+                                  const QList<ObjectModelPtr> &objectModels,
+                                  const PoseStore &poses) {
+    m_images = images;
+    m_objectModels = objectModels;
+    m_poses = poses;
+}
+
+QList<ImagePtr> DatasetManifest::images() const {
+    return m_images;
+}
+
+QList<ObjectModelPtr> DatasetManifest::objectModels() const {
+    return m_objectModels;
+}
+
+PoseStore DatasetManifest::poses() const {
+    return m_poses;
+}
+
+void DatasetManifest::setImageFiles(const LoadAndStoreStrategy::FileSnapshot &imageFiles) {
+    m_imageFiles = imageFiles;
+}
+
+LoadAndStoreStrategy::FileSnapshot DatasetManifest::imageFiles() const {
+    return m_imageFiles;
+}
+
+void DatasetManifest::setObjectModelFiles(const LoadAndStoreStrategy::FileSnapshot &objectModelFiles) {
+    m_objectModelFiles = objectModelFiles;
+}
+
+LoadAndStoreStrategy::FileSnapshot DatasetManifest::objectModelFiles() const {
+    return m_objectModelFiles;
+}
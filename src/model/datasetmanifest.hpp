@@ -0,0 +1,90 @@
+#ifndef DATASETMANIFEST_H
+#define DATASETMANIFEST_H
+
+#include "image.hpp"
+#include "objectmodel.hpp"
+#include "posestore.hpp"
+#include "loadandstorestrategy.hpp"
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+/*!
+ * \brief The DatasetManifest class stores the loaded images, object models and poses
+ * together with the state of the files they were loaded from in a compact binary file in
+ * the cache folder. On the next start the manifest only has to be checked against the size
+ * and modification time of a few files and folders instead of listing, sorting and parsing
+ * the whole dataset again.
+ *
+ * The files of the images and object models folders are stored as well, so that the
+ * manifest can be verified thoroughly in the background after it has been used.
+ */
+class DatasetManifest {
+
+public:
+    typedef QPair<QString, LoadAndStoreStrategy::FileStamp> Dependency;
+
+    DatasetManifest();
+
+    /*!
+     * \brief manifestFilePath returns the file in the cache folder that the manifest with
+     * the given key is stored in.
+     */
+    static QString manifestFilePath(const QString &key);
+
+    /*!
+     * \brief load reads the manifest with the given key.
+     * \return false if there is none or it was written by a different version
+     */
+    bool load(const QString &key);
+
+    /*!
+     * \brief save writes the manifest with the given key, replacing the old one atomically.
+     */
+    bool save(const QString &key) const;
+
+    //! Removes the manifest with the given key, e.g. because it turned out to be outdated
+    static void remove(const QString &key);
+
+    /*!
+     * \brief isUpToDate compares the dependencies with the filesystem, this only takes one
+     * stat call per dependency.
+     */
+    bool isUpToDate() const;
+
+    /*!
+     * \brief setDependencies stamps the given files and folders.
+     */
+    void setDependencies(const QStringList &dependencies);
+    //! Sets dependencies that have been stamped before
+    void setDependencies(const QList<Dependency> &dependencies);
+    QList<Dependency> dependencies() const;
+
+    void setEntities(const QList<ImagePtr> &images,
+                     const QList<ObjectModelPtr> &objectModels,
+                     const PoseStore &poses);
+    QList<ImagePtr> images() const;
+    QList<ObjectModelPtr> objectModels() const;
+    //! The image and object model indices of the poses refer to the two lists above
+    PoseStore poses() const;
+
+    void setImageFiles(const LoadAndStoreStrategy::FileSnapshot &imageFiles);
+    LoadAndStoreStrategy::FileSnapshot imageFiles() const;
+    void setObjectModelFiles(const LoadAndStoreStrategy::FileSnapshot &objectModelFiles);
+    LoadAndStoreStrategy::FileSnapshot objectModelFiles() const;
+
+private:
+    static const quint32 MAGIC;
+    static const quint32 VERSION;
+
+    QList<Dependency> m_dependencies;
+    QList<ImagePtr> m_images;
+    QList<ObjectModelPtr> m_objectModels;
+    PoseStore m_poses;
+    LoadAndStoreStrategy::FileSnapshot m_imageFiles;
+    LoadAndStoreStrategy::FileSnapshot m_objectModelFiles;
+};
+
+#endif // DATASETMANIFEST_H
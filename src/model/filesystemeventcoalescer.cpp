@@ -0,0 +1,73 @@
+#include "filesystemeventcoalescer.hpp"
+
+#include <QDir>
+
+namespace {
+
+// Names that copy tools, browsers, editors and office programs use for files that
+// are still being written or that are only kept until a save completes
+const QStringList TEMPORARY_FILE_PATTERNS = {
+    "*.tmp", "*.temp", "*.part", "*.partial", "*.crdownload", "*.download",
+    "*.swp", "*.swx", "*~", ".#*", "~$*", ".~*", ".goutputstream-*"
+};
+
+}
+
+FileSystemEventCoalescer::FileSystemEventCoalescer(QObject *parent) : QObject(parent) {
+    m_quietTimer.setSingleShot(true);
+    m_maximumLatencyTimer.setSingleShot(true);
+    connect(&m_quietTimer, &QTimer::timeout, this, &FileSystemEventCoalescer::flush);
+    connect(&m_maximumLatencyTimer, &QTimer::timeout, this, &FileSystemEventCoalescer::flush);
+}
+
+void FileSystemEventCoalescer::setQuietPeriod(int quietPeriod) {
+    m_quietPeriod = qMax(0, quietPeriod);
+}
+
+int FileSystemEventCoalescer::quietPeriod() const {
+    return m_quietPeriod;
+}
+
+void FileSystemEventCoalescer::setMaximumLatency(int maximumLatency) {
+    m_maximumLatency = qMax(0, maximumLatency);
+}
+
+int FileSystemEventCoalescer::maximumLatency() const {
+    return m_maximumLatency;
+}
+
+bool FileSystemEventCoalescer::isTemporaryFile(const QString &fileName) {
+    return QDir::match(TEMPORARY_FILE_PATTERNS, fileName);
+}
+
+void FileSystemEventCoalescer::addDirectory(const QString &path) {
+    m_directories.insert(path);
+    eventAdded();
+}
+
+void FileSystemEventCoalescer::addFile(const QString &path) {
+    m_files.insert(path);
+    eventAdded();
+}
+
+void FileSystemEventCoalescer::eventAdded() {
+    // Every event postpones the delivery until things calm down, but
+    // not longer than the maximum latency since the first event
+    m_quietTimer.start(m_quietPeriod);
+    if (!m_maximumLatencyTimer.isActive()) {
+        m_maximumLatencyTimer.start(m_maximumLatency);
+    }
+}
+
+void FileSystemEventCoalescer::flush() {
+    m_quietTimer.stop();
+    m_maximumLatencyTimer.stop();
+    if (m_directories.isEmpty() && m_files.isEmpty()) {
+        return;
+    }
+    const QStringList directories = m_directories.values();
+    const QStringList files = m_files.values();
+    m_directories.clear();
+    m_files.clear();
+    Q_EMIT eventsReady(directories, files);
+}
@@ -0,0 +1,70 @@
+#ifndef FILESYSTEMEVENTCOALESCER_H
+#define FILESYSTEMEVENTCOALESCER_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+/*!
+ * \brief The FileSystemEventCoalescer class merges bursts of file system events into one
+ * change set. Copying thousands of images into a folder makes the QFileSystemWatcher fire
+ * for nearly every file, with this class the receiver only reacts once the folder has been
+ * quiet for the quiet period, or at the latest after the maximum latency.
+ */
+class FileSystemEventCoalescer : public QObject {
+
+    Q_OBJECT
+
+public:
+    explicit FileSystemEventCoalescer(QObject *parent = Q_NULLPTR);
+
+    /*!
+     * \brief setQuietPeriod sets the time in milliseconds without new events after which
+     * the collected events are delivered.
+     */
+    void setQuietPeriod(int quietPeriod);
+    int quietPeriod() const;
+
+    /*!
+     * \brief setMaximumLatency sets the maximum time in milliseconds between the first
+     * event of a change set and its delivery, even if events keep coming in.
+     */
+    void setMaximumLatency(int maximumLatency);
+    int maximumLatency() const;
+
+    /*!
+     * \brief isTemporaryFile checks whether the file name looks like one of the files
+     * that copy tools, browsers and editors write before renaming them to their final
+     * name, e.g. image.png.part or .image.png.swp.
+     */
+    static bool isTemporaryFile(const QString &fileName);
+
+public Q_SLOTS:
+    void addDirectory(const QString &path);
+    void addFile(const QString &path);
+    //! Delivers the collected events right away
+    void flush();
+
+Q_SIGNALS:
+    /*!
+     * \brief eventsReady is emitted with every path that had at least one event since the
+     * last delivery, each path is contained only once.
+     */
+    void eventsReady(const QStringList &directories, const QStringList &files);
+
+private:
+    void eventAdded();
+
+private:
+    int m_quietPeriod = 500;
+    int m_maximumLatency = 5000;
+    // Children so that they move along when the coalescer is moved to another thread
+    QTimer m_quietTimer{this};
+    QTimer m_maximumLatencyTimer{this};
+    QSet<QString> m_directories;
+    QSet<QString> m_files;
+};
+
+#endif // FILESYSTEMEVENTCOALESCER_H
@@ -1,5 +1,6 @@
 #include "image.hpp"
 #include "misc/global.hpp"
+#include "internpool.hpp"
 
 #include <QDir>
 
@@ -7,7 +8,7 @@ Image::Image()
     : m_imagePath(Global::NO_PATH),
       m_segmentationImagePath(Global::NO_PATH),
       m_basePath(Global::NO_PATH),
-      m_cameraMatrix() {
+      m_cameraMatrix(InternPool::cameraMatrix(QMatrix3x3())) {
 
 }
 
@@ -17,8 +18,8 @@ Image::Image(const QString &id, const QString& imagePath,
     : m_id(id),
       m_imagePath(imagePath),
       m_segmentationImagePath(Global::NO_PATH),
-      m_basePath(basePath),
-      m_cameraMatrix(cameraMatrix),
+      m_basePath(InternPool::string(basePath)),
+      m_cameraMatrix(InternPool::cameraMatrix(cameraMatrix)),
       m_nearPlane(nearPlane),
       m_farPlane(farPlane) {
 }
@@ -29,8 +30,8 @@ Image::Image(const QString &id, const QString& imagePath, const QString& segment
     : m_id(id),
       m_imagePath(imagePath),
       m_segmentationImagePath(segmentationImagePath),
-      m_basePath(basePath),
-      m_cameraMatrix(cameraMatrix),
+      m_basePath(InternPool::string(basePath)),
+      m_cameraMatrix(InternPool::cameraMatrix(cameraMatrix)),
       m_nearPlane(nearPlane),
       m_farPlane(farPlane) {
 }
@@ -41,6 +42,14 @@ Image::Image(const Image &other) {
     m_segmentationImagePath = other.m_segmentationImagePath;
     m_basePath = other.m_basePath;
     m_cameraMatrix = other.m_cameraMatrix;
+    m_nearPlane = other.m_nearPlane;
+    m_farPlane = other.m_farPlane;
+    m_depthImagePath = other.m_depthImagePath;
+    m_depthScale = other.m_depthScale;
+    m_hasCameraExtrinsics = other.m_hasCameraExtrinsics;
+    m_cameraRotation = other.m_cameraRotation;
+    m_cameraTranslation = other.m_cameraTranslation;
+    m_sceneId = other.m_sceneId;
 }
 
 QString Image::imagePath() const {
@@ -65,7 +74,7 @@ QString Image::getBasePath() const {
 }
 
 QMatrix3x3 Image::getCameraMatrix() const {
-    return m_cameraMatrix;
+    return *m_cameraMatrix;
 }
 
 bool Image::operator==(const Image &other) {
@@ -73,7 +82,8 @@ bool Image::operator==(const Image &other) {
     return m_basePath == other.m_basePath &&
             m_imagePath == other.m_imagePath &&
             m_segmentationImagePath == other.m_segmentationImagePath &&
-            m_cameraMatrix == other.m_cameraMatrix;
+            // The values, equal matrices don't have to be the same interned instance
+            *m_cameraMatrix == *other.m_cameraMatrix;
 }
 
 Image& Image::operator=(const Image &other) {
@@ -81,6 +91,14 @@ Image& Image::operator=(const Image &other) {
     m_imagePath = other.m_imagePath;
     m_segmentationImagePath = other.m_segmentationImagePath;
     m_cameraMatrix = other.m_cameraMatrix;
+    m_nearPlane = other.m_nearPlane;
+    m_farPlane = other.m_farPlane;
+    m_depthImagePath = other.m_depthImagePath;
+    m_depthScale = other.m_depthScale;
+    m_hasCameraExtrinsics = other.m_hasCameraExtrinsics;
+    m_cameraRotation = other.m_cameraRotation;
+    m_cameraTranslation = other.m_cameraTranslation;
+    m_sceneId = other.m_sceneId;
     return *this;
 }
 
@@ -96,3 +114,46 @@ QString Image::id() const
 float Image::nearPlane() const {
     return m_nearPlane;
 }
+
+void Image::setDepthImage(const QString &depthImagePath, float depthScale) {
+    m_depthImagePath = depthImagePath;
+    m_depthScale = depthScale;
+}
+
+QString Image::depthImagePath() const {
+    return m_depthImagePath;
+}
+
+bool Image::hasDepthImage() const {
+    return !m_depthImagePath.isEmpty();
+}
+
+float Image::depthScale() const {
+    return m_depthScale;
+}
+
+void Image::setCameraExtrinsics(const QMatrix3x3 &rotation, const QVector3D &translation) {
+    m_cameraRotation = rotation;
+    m_cameraTranslation = translation;
+    m_hasCameraExtrinsics = true;
+}
+
+bool Image::hasCameraExtrinsics() const {
+    return m_hasCameraExtrinsics;
+}
+
+QMatrix3x3 Image::cameraRotation() const {
+    return m_cameraRotation;
+}
+
+QVector3D Image::cameraTranslation() const {
+    return m_cameraTranslation;
+}
+
+void Image::setSceneId(const QString &sceneId) {
+    m_sceneId = InternPool::string(sceneId);
+}
+
+QString Image::sceneId() const {
+    return m_sceneId;
+}
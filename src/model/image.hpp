@@ -3,6 +3,7 @@
 
 #include <QString>
 #include <QMatrix3x3>
+#include <QVector3D>
 #include <QSharedPointer>
 
 /*!
@@ -86,14 +87,66 @@ public:
 
     float farPlane() const;
 
+    /*!
+     * \brief setDepthImage sets the depth map that is aligned with this image.
+     * \param depthImagePath the absolute path to the depth map
+     * \param depthScale the factor that converts the stored depth values to the
+     * units of the object models (usually millimeters)
+     */
+    void setDepthImage(const QString &depthImagePath, float depthScale);
+
+    /*!
+     * \brief depthImagePath Returns the absolute path to the depth map of this image
+     * or an empty string if there is none. The depth map itself is only loaded when
+     * it is needed.
+     */
+    QString depthImagePath() const;
+
+    bool hasDepthImage() const;
+
+    float depthScale() const;
+
+    /*!
+     * \brief setCameraExtrinsics sets the pose of the camera that took this image, i.e.
+     * the transformation from world (scene) coordinates to camera coordinates. Images
+     * with the same scene ID are expected to share the world coordinate system.
+     * \param rotation the rotation from world to camera coordinates
+     * \param translation the translation from world to camera coordinates
+     */
+    void setCameraExtrinsics(const QMatrix3x3 &rotation, const QVector3D &translation);
+
+    bool hasCameraExtrinsics() const;
+
+    QMatrix3x3 cameraRotation() const;
+
+    QVector3D cameraTranslation() const;
+
+    /*!
+     * \brief setSceneId sets the scene this image was taken in. Images of the same scene
+     * show the same static objects, i.e. poses can be transferred between them using the
+     * camera extrinsics. Images without scene ID don't belong to any scene.
+     */
+    void setSceneId(const QString &sceneId);
+
+    QString sceneId() const;
+
 private:
     QString m_id;
     QString m_imagePath;
     QString m_segmentationImagePath;
+    //! Interned, all images of a folder share the string
     QString m_basePath;
-    QMatrix3x3 m_cameraMatrix;
+    //! Interned, usually all images of a dataset share the camera matrix
+    QSharedPointer<const QMatrix3x3> m_cameraMatrix;
     float m_nearPlane;
     float m_farPlane;
+    QString m_depthImagePath;
+    float m_depthScale = 1.f;
+    bool m_hasCameraExtrinsics = false;
+    QMatrix3x3 m_cameraRotation;
+    QVector3D m_cameraTranslation;
+    //! Interned, all images of a scene share the string
+    QString m_sceneId;
 
 };
 
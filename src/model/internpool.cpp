@@ -0,0 +1,80 @@
+#include "internpool.hpp"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QWeakPointer>
+
+namespace {
+
+QMutex stringsMutex;
+QSet<QString> strings;
+
+QMutex cameraMatricesMutex;
+// Keyed by the raw bytes of the matrix, the matrices belong to the images
+QHash<QByteArray, QWeakPointer<const QMatrix3x3>> cameraMatrices;
+
+}
+
+QString InternPool::string(const QString &value) {
+    if (value.isEmpty()) {
+        return value;
+    }
+    QMutexLocker locker(&stringsMutex);
+    auto it = strings.constFind(value);
+    if (it != strings.constEnd()) {
+        return *it;
+    }
+    strings.insert(value);
+    return value;
+}
+
+QSharedPointer<const QMatrix3x3> InternPool::cameraMatrix(const QMatrix3x3 &value) {
+    float values[9];
+    for (int i = 0; i < 9; i++) {
+        // -0 and 0 have different bytes but are the same value
+        values[i] = value.constData()[i] + 0.f;
+    }
+    const QByteArray key(reinterpret_cast<const char*>(values), sizeof(values));
+    QMutexLocker locker(&cameraMatricesMutex);
+    QSharedPointer<const QMatrix3x3> matrix = cameraMatrices.value(key).toStrongRef();
+    if (matrix.isNull()) {
+        matrix.reset(new QMatrix3x3(value));
+        cameraMatrices.insert(key, matrix);
+    }
+    return matrix;
+}
+
+void InternPool::purge() {
+    {
+        QMutexLocker locker(&stringsMutex);
+        for (auto it = strings.begin(); it != strings.end();) {
+            // Nobody can get another reference to the string without the lock
+            if (it->isDetached()) {
+                it = strings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    QMutexLocker locker(&cameraMatricesMutex);
+    for (auto it = cameraMatrices.begin(); it != cameraMatrices.end();) {
+        if (it->isNull()) {
+            it = cameraMatrices.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int InternPool::stringCount() {
+    QMutexLocker locker(&stringsMutex);
+    return strings.size();
+}
+
+int InternPool::cameraMatrixCount() {
+    QMutexLocker locker(&cameraMatricesMutex);
+    return cameraMatrices.size();
+}
@@ -0,0 +1,45 @@
+#ifndef INTERNPOOL_H
+#define INTERNPOOL_H
+
+#include <QMatrix3x3>
+#include <QSharedPointer>
+#include <QString>
+
+/*!
+ * \brief The InternPool class deduplicates values that thousands of entities share, e.g.
+ * the base path of the images or the camera matrix of a dataset recorded with a single
+ * camera. Equal values are stored only once. Values nobody uses anymore are dropped by
+ * purge, e.g. after loading another dataset.
+ *
+ * All methods are thread-safe, strategies create entities on the model manager thread
+ * and in the background.
+ */
+class InternPool {
+
+public:
+    /*!
+     * \brief string returns the pooled instance of the string, it shares its data with all
+     * other strings interned with the same value.
+     */
+    static QString string(const QString &value);
+
+    /*!
+     * \brief cameraMatrix returns the pooled camera matrix equal to the given one. The pool
+     * only holds it weakly, i.e. it is freed with the last entity using it.
+     */
+    static QSharedPointer<const QMatrix3x3> cameraMatrix(const QMatrix3x3 &value);
+
+    /*!
+     * \brief purge drops the strings only the pool still references and the entries of
+     * freed camera matrices.
+     */
+    static void purge();
+
+    //! The number of distinct strings, e.g. for diagnostics
+    static int stringCount();
+
+    //! The number of distinct camera matrices, e.g. for diagnostics
+    static int cameraMatrixCount();
+};
+
+#endif // INTERNPOOL_H
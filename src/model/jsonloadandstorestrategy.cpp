@@ -1,6 +1,7 @@
 #include "jsonloadandstorestrategy.hpp"
 #include "misc/generalhelper.hpp"
 #include "misc/global.hpp"
+#include "misc/tracing.hpp"
 
 #include <opencv2/core/mat.hpp>
 
@@ -12,8 +13,10 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QHash>
 #include <QMap>
 #include <QDir>
+#include <QSet>
 #include <QThread>
 
 JsonLoadAndStoreStrategy::JsonLoadAndStoreStrategy()  {
@@ -22,32 +25,8 @@ JsonLoadAndStoreStrategy::JsonLoadAndStoreStrategy()  {
 JsonLoadAndStoreStrategy::~JsonLoadAndStoreStrategy() {
 }
 
-bool JsonLoadAndStoreStrategy::persistPose(const Pose &objectImagePose, bool deletePose) {
-
-    // Read in the camera parameters from the JSON file
-    QFileInfo info(m_posesFilePath);
-    QFile jsonFile(m_posesFilePath);
-
-    if (!info.isFile()) {
-        Q_EMIT error(tr("Failed to persist pose. Poses file is not a file."));
-        return false;
-    }
-
-    if (!jsonFile.open(QFile::ReadWrite)) {
-        Q_EMIT error(tr("Failed to persist pose. Poses file could not be read."));
-        return false;
-    }
-
-    QByteArray data = jsonFile.readAll();
-    QJsonDocument jsonDocument(QJsonDocument::fromJson(data));
-
-    if (jsonDocument.isNull()) {
-        // JSON Document is null, an nerror occured, we cannot persist the pose
-        return false;
-    }
-
-    QJsonObject jsonObject = jsonDocument.object();
-
+//! Applies the given change of one pose to the entries of the poses file
+static void writePoseToJson(QJsonObject &jsonObject, const Pose &objectImagePose, bool deletePose) {
     QString imagePath = objectImagePose.image()->imagePath();
     QJsonArray entriesForImage;
 
@@ -112,14 +91,85 @@ bool JsonLoadAndStoreStrategy::persistPose(const Pose &objectImagePose, bool del
             entriesForImage << newEntry;
         }
     }
-    m_ignorePosesFileChanged = true;
     jsonObject[imagePath] = entriesForImage;
+}
+
+bool JsonLoadAndStoreStrategy::modifyPosesFile(const QList<const Pose *> &poses,
+                                               const QList<const Pose *> &removedPoses) {
+    // Read in the camera parameters from the JSON file
+    QFileInfo info(m_posesFilePath);
+    QFile jsonFile(m_posesFilePath);
+
+    if (!info.isFile()) {
+        Q_EMIT error(tr("Failed to persist pose. Poses file is not a file."));
+        return false;
+    }
+
+    if (!jsonFile.open(QFile::ReadWrite)) {
+        Q_EMIT error(tr("Failed to persist pose. Poses file could not be read."));
+        return false;
+    }
+
+    QByteArray data = jsonFile.readAll();
+    QJsonDocument jsonDocument(QJsonDocument::fromJson(data));
+
+    if (jsonDocument.isNull()) {
+        // JSON Document is null, an nerror occured, we cannot persist the pose
+        return false;
+    }
+
+    QJsonObject jsonObject = jsonDocument.object();
+    for (const Pose *pose : poses) {
+        writePoseToJson(jsonObject, *pose, false);
+    }
+    for (const Pose *pose : removedPoses) {
+        writePoseToJson(jsonObject, *pose, true);
+    }
+
+    m_ignorePosesFileChanged = true;
     jsonFile.resize(0);
-    jsonFile.write(QJsonDocument(jsonObject).toJson());
+    const QByteArray json = QJsonDocument(jsonObject).toJson();
+    if (jsonFile.write(json) != json.size()) {
+        Q_EMIT error(tr("Failed to persist pose. Poses file could not be written."));
+        return false;
+    }
 
     return true;
 }
 
+bool JsonLoadAndStoreStrategy::persistPose(const Pose &objectImagePose, bool deletePose) {
+    TRACE_SCOPE_DETAIL("save", "JsonLoadAndStoreStrategy::persistPose", objectImagePose.id());
+    if (deletePose) {
+        return modifyPosesFile({}, {&objectImagePose});
+    }
+    return modifyPosesFile({&objectImagePose}, {});
+}
+
+QStringList JsonLoadAndStoreStrategy::persistPoses(const QList<PosePtr> &poses,
+                                                   const QList<PosePtr> &removedPoses) {
+    TRACE_SCOPE_DETAIL("save", "JsonLoadAndStoreStrategy::persistPoses",
+                       QString::number(poses.size() + removedPoses.size()));
+    QStringList ids;
+    QList<const Pose *> posesToWrite;
+    for (const PosePtr &pose : poses) {
+        posesToWrite.append(pose.data());
+        ids.append(pose->id());
+    }
+    QList<const Pose *> posesToDelete;
+    for (const PosePtr &pose : removedPoses) {
+        posesToDelete.append(pose.data());
+        ids.append(pose->id());
+    }
+    if (ids.isEmpty()) {
+        return ids;
+    }
+    // Reading and writing the whole file once instead of once per pose
+    if (!modifyPosesFile(posesToWrite, posesToDelete)) {
+        return QStringList();
+    }
+    return ids;
+}
+
 static QMatrix3x3 rotVectorFromJsonRotMatrix(QJsonArray &jsonRotationMatrix) {
     float values[9] = {
         (float) jsonRotationMatrix[0].toDouble(),
@@ -135,12 +185,30 @@ static QMatrix3x3 rotVectorFromJsonRotMatrix(QJsonArray &jsonRotationMatrix) {
     return rotationMatrix;
 }
 
+static QStringList sortedImageFiles(const QString &path, const QStringList &extensions) {
+    if (path.isEmpty()) {
+        return QStringList();
+    }
+    QStringList files = QDir(path).entryList(extensions, QDir::Files, QDir::Name);
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(
+        files.begin(),
+        files.end(),
+        [&collator](const QString &s1, const QString &s2)
+        {
+            return collator.compare(s1, s2) < 0;
+        });
+    return files;
+}
+
 static ImagePtr createImageWithJsonParams(const QString &id,
                                           const QString& filename,
                                           const QString &segmentationFilename,
                                           const QString &imagesPath,
                                           float defaultNearPlane,
                                           float defaultFarPlane,
+                                          float defaultDepthScale,
                                           QJsonObject &json) {
     QJsonObject parameters = json[filename].toObject();
     if (!parameters.contains("K")) {
@@ -166,11 +234,45 @@ static ImagePtr createImageWithJsonParams(const QString &id,
     if (parameters.contains("farPlane")) {
         farPlane = (float) parameters["farPlane"].toDouble();
     }
-    return ImagePtr(new Image(id, filename, segmentationFilename, imagesPath, qtCameraMatrix,
-                              nearPlane, farPlane));
+    ImagePtr image(new Image(id, filename, segmentationFilename, imagesPath, qtCameraMatrix,
+                             nearPlane, farPlane));
+    // The depth map is optional and only loaded when it is needed, the path
+    // can be absolute or relative to the images path
+    if (parameters.contains("depth")) {
+        float depthScale = defaultDepthScale;
+        if (parameters.contains("depthScale")) {
+            depthScale = (float) parameters["depthScale"].toDouble();
+        }
+        image->setDepthImage(QDir(imagesPath).absoluteFilePath(parameters["depth"].toString()),
+                             depthScale);
+    }
+    // Camera extrinsics are optional as well, together with the scene they are
+    // needed to transfer poses between images of the same scene
+    if (parameters.contains("cam_R_w2c") && parameters.contains("cam_t_w2c")) {
+        QJsonArray cameraRotation = parameters["cam_R_w2c"].toArray();
+        QJsonArray cameraTranslation = parameters["cam_t_w2c"].toArray();
+        if (cameraRotation.size() == 9 && cameraTranslation.size() == 3) {
+            float rotationValues[9];
+            for (int i = 0; i < 9; i++) {
+                rotationValues[i] = (float) cameraRotation[i].toDouble();
+            }
+            image->setCameraExtrinsics(QMatrix3x3(rotationValues),
+                                       QVector3D((float) cameraTranslation[0].toDouble(),
+                                                 (float) cameraTranslation[1].toDouble(),
+                                                 (float) cameraTranslation[2].toDouble()));
+        }
+    }
+    // All images of a folder could be from different scenes, only the ones that name
+    // the same scene share the world coordinate system
+    if (parameters.contains("scene")) {
+        QJsonValue scene = parameters["scene"];
+        image->setSceneId(scene.isDouble() ? QString::number(scene.toInt()) : scene.toString());
+    }
+    return image;
 }
 
 QList<ImagePtr> JsonLoadAndStoreStrategy::loadImages() {
+    TRACE_SCOPE("load", "JsonLoadAndStoreStrategy::loadImages");
     QList<ImagePtr> images;
     m_imagesWithInvalidData.clear();
 
@@ -196,68 +298,27 @@ QList<ImagePtr> JsonLoadAndStoreStrategy::loadImages() {
         return images;
     }
 
-    QStringList imageFiles = QDir(m_imagesPath).entryList(IMAGE_FILES_EXTENSIONS, QDir::Files, QDir::Name);
-    QStringList segmentationImageFiles =
-            QDir(m_segmentationImagesPath).entryList(IMAGE_FILES_EXTENSIONS, QDir::Files, QDir::Name);
+    // Sorted to have the corresponding image and segmentation image at the same position
+    QStringList imageFiles = sortedImageFiles(m_imagesPath, IMAGE_FILES_EXTENSIONS);
+    QStringList segmentationImageFiles = sortedImageFiles(m_segmentationImagesPath, IMAGE_FILES_EXTENSIONS);
     // Also ensure that the number of elements is the same
     bool segmentationImagesPathSet = m_segmentationImagesPath != ""
             && imageFiles.size() == segmentationImageFiles.size();
 
-    // Sort both list the have the corresponding image and segmentation image at the
-    // same position
-    QCollator collator;
-    collator.setNumericMode(true);
-
-    std::sort(
-        imageFiles.begin(),
-        imageFiles.end(),
-        [&collator](const QString &s1, const QString &s2)
-        {
-            return collator.compare(s1, s2) < 0;
-        });
-    std::sort(
-        segmentationImageFiles.begin(),
-        segmentationImageFiles.end(),
-        [&collator](const QString &s1, const QString &s2)
-        {
-            return collator.compare(s1, s2) < 0;
-        });
-
-    // Read in the camera parameters from the JSON file
-    QFile jsonFile(QDir(m_imagesPath).filePath("info.json"));
-
     bool foundImageWithInvalidCameraMatrix = false;
 
     if (imageFiles.size() == 0) {
         Q_EMIT error(tr("No images found at images dir."));
         return images;
-    } else if (!jsonFile.exists()) {
-        Q_EMIT error(tr("Failed to load images. Camera info file info.json does not exist."));
-        return images;
-    } else if (!jsonFile.open(QFile::ReadOnly)) {
-        Q_EMIT error(tr("Failed to load images. Camera info file info.json is not readable."));
-        return images;
     }
 
-    QByteArray data = jsonFile.readAll();
-    QJsonDocument jsonDocument(QJsonDocument::fromJson(data));
-    if (jsonDocument.isNull()) {
-        Q_EMIT error(tr("Failed to load images. Camera info file info.json is not a JSON file."));
+    QJsonObject jsonObject;
+    float nearPlane, farPlane, depthScale;
+    if (!readCameraInfo(jsonObject, nearPlane, farPlane, depthScale)) {
         return images;
     }
-
-    QJsonObject jsonObject = jsonDocument.object();
-    // The user can define the near and far plane per image or
-    // on a global level which will be used in case no individual
-    // near and far plane are set on the image
-    float nearPlane = NEAR_PLANE;
-    if (jsonObject.contains("nearPlane")) {
-        nearPlane = (float) jsonObject["nearPlane"].toDouble();
-    }
-    float farPlane = FAR_PLANE;
-    if (jsonObject.contains("farPlane")) {
-        farPlane = (float) jsonObject["farPlane"].toDouble();
-    }
+    // The file name is the ID, unlike the position in the folder it stays the same when
+    // other images are added or removed and loadImagesDelta can assign it as well
     for (int i = 0; i < imageFiles.size(); i ++) {
         QString image = imageFiles[i];
         QString imageFilename = QFileInfo(image).fileName();
@@ -271,20 +332,22 @@ QList<ImagePtr> JsonLoadAndStoreStrategy::loadImages() {
             QString segmentationImageFile = segmentationImageFiles[i];
             QString segmentationImageFilePath =
                     QDir(m_segmentationImagesPath).absoluteFilePath(segmentationImageFile);
-            newImage = createImageWithJsonParams(QString::number(i),
+            newImage = createImageWithJsonParams(imageFilename,
                                                  imageFilename,
                                                  segmentationImageFilePath,
                                                  m_imagesPath,
                                                  nearPlane,
                                                  farPlane,
+                                                 depthScale,
                                                  jsonObject);
         } else {
-            newImage = createImageWithJsonParams(QString::number(i),
+            newImage = createImageWithJsonParams(imageFilename,
                                                  imageFilename,
                                                  "",
                                                  m_imagesPath,
                                                  nearPlane,
                                                  farPlane,
+                                                 depthScale,
                                                  jsonObject);
         }
         if (!newImage) {
@@ -305,11 +368,118 @@ QList<ImagePtr> JsonLoadAndStoreStrategy::loadImages() {
                         "camera matrix contains only invalid entries."));
         return images;
     }
-    jsonFile.close();
     return images;
 }
 
+QList<ImagePtr> JsonLoadAndStoreStrategy::loadImagesDelta(const QStringList &absoluteImagePaths) {
+    TRACE_SCOPE("load", "JsonLoadAndStoreStrategy::loadImagesDelta");
+    QList<ImagePtr> images;
+    m_imagesWithInvalidData.clear();
+
+    QJsonObject jsonObject;
+    float nearPlane, farPlane, depthScale;
+    if (!readCameraInfo(jsonObject, nearPlane, farPlane, depthScale)) {
+        return images;
+    }
+
+    // Listing the folders is cheap compared to loading all images, we need them to match
+    // the segmentation images like loadImages does. Adding or removing images shifts this
+    // pairing, the strategy requests a full reload then instead of a delta.
+    QStringList imageFiles = sortedImageFiles(m_imagesPath, IMAGE_FILES_EXTENSIONS);
+    QStringList segmentationImageFiles = sortedImageFiles(m_segmentationImagesPath, IMAGE_FILES_EXTENSIONS);
+    bool segmentationImagesPathSet = m_segmentationImagesPath != ""
+            && imageFiles.size() == segmentationImageFiles.size();
+    QHash<QString, int> indexForFile;
+    for (int i = 0; i < imageFiles.size(); i++) {
+        indexForFile[imageFiles[i]] = i;
+    }
+
+    const QString imagesPath = QFileInfo(m_imagesPath).absoluteFilePath();
+    for (const QString &path : absoluteImagePaths) {
+        QFileInfo fileInfo(path);
+        auto index = indexForFile.constFind(fileInfo.fileName());
+        if (fileInfo.absolutePath() != imagesPath || index == indexForFile.constEnd()) {
+            // Removed or not one of our images
+            continue;
+        }
+        QString segmentationImageFilePath;
+        if (segmentationImagesPathSet) {
+            segmentationImageFilePath =
+                    QDir(m_segmentationImagesPath).absoluteFilePath(segmentationImageFiles[*index]);
+        }
+        ImagePtr newImage = createImageWithJsonParams(fileInfo.fileName(),
+                                                      fileInfo.fileName(),
+                                                      segmentationImageFilePath,
+                                                      m_imagesPath,
+                                                      nearPlane,
+                                                      farPlane,
+                                                      depthScale,
+                                                      jsonObject);
+        if (!newImage) {
+            m_imagesWithInvalidData.append(fileInfo.fileName());
+        } else {
+            images.append(newImage);
+        }
+    }
+
+    if (m_imagesWithInvalidData.size() > 0) {
+        Q_EMIT error(tr("There were images with invalid camera matrices."));
+    }
+    return images;
+}
+
+bool JsonLoadAndStoreStrategy::supportsManifest() const {
+    return true;
+}
+
+QStringList JsonLoadAndStoreStrategy::manifestDependencies() const {
+    QStringList dependencies = LoadAndStoreStrategy::manifestDependencies();
+    if (m_imagesPath != Global::NO_PATH) {
+        dependencies.append(QDir(m_imagesPath).filePath("info.json"));
+    }
+    return dependencies;
+}
+
+bool JsonLoadAndStoreStrategy::readCameraInfo(QJsonObject &jsonObject, float &nearPlane,
+                                              float &farPlane, float &depthScale) {
+    // Read in the camera parameters from the JSON file
+    QFile jsonFile(QDir(m_imagesPath).filePath("info.json"));
+    if (!jsonFile.exists()) {
+        Q_EMIT error(tr("Failed to load images. Camera info file info.json does not exist."));
+        return false;
+    } else if (!jsonFile.open(QFile::ReadOnly)) {
+        Q_EMIT error(tr("Failed to load images. Camera info file info.json is not readable."));
+        return false;
+    }
+
+    QByteArray data = jsonFile.readAll();
+    QJsonDocument jsonDocument(QJsonDocument::fromJson(data));
+    if (jsonDocument.isNull()) {
+        Q_EMIT error(tr("Failed to load images. Camera info file info.json is not a JSON file."));
+        return false;
+    }
+
+    jsonObject = jsonDocument.object();
+    // The user can define the near and far plane per image or
+    // on a global level which will be used in case no individual
+    // near and far plane are set on the image
+    nearPlane = NEAR_PLANE;
+    if (jsonObject.contains("nearPlane")) {
+        nearPlane = (float) jsonObject["nearPlane"].toDouble();
+    }
+    farPlane = FAR_PLANE;
+    if (jsonObject.contains("farPlane")) {
+        farPlane = (float) jsonObject["farPlane"].toDouble();
+    }
+    depthScale = 1.f;
+    if (jsonObject.contains("depthScale")) {
+        depthScale = (float) jsonObject["depthScale"].toDouble();
+    }
+    return true;
+}
+
 QList<ObjectModelPtr> JsonLoadAndStoreStrategy::loadObjectModels() {
+    TRACE_SCOPE("load", "JsonLoadAndStoreStrategy::loadObjectModels");
     QList<ObjectModelPtr> objectModels;
 
     if (m_objectModelsPath == Global::NO_PATH) {
@@ -382,6 +552,26 @@ QMap<QString, ObjectModelPtr> createObjectModelMap(const QList<ObjectModelPtr> &
 
 QList<PosePtr> JsonLoadAndStoreStrategy::loadPoses(const QList<ImagePtr> &images,
                                                      const QList<ObjectModelPtr> &objectModels) {
+    return readPoses(images, objectModels, QSet<QString>());
+}
+
+QList<PosePtr> JsonLoadAndStoreStrategy::loadPosesDelta(const QList<ImagePtr> &images,
+                                                        const QList<ObjectModelPtr> &objectModels,
+                                                        const QList<ImagePtr> &imagesToLoad) {
+    QSet<QString> imagePaths;
+    for (const ImagePtr &image : imagesToLoad) {
+        imagePaths.insert(image->imagePath());
+    }
+    if (imagePaths.isEmpty()) {
+        return QList<PosePtr>();
+    }
+    return readPoses(images, objectModels, imagePaths);
+}
+
+QList<PosePtr> JsonLoadAndStoreStrategy::readPoses(const QList<ImagePtr> &images,
+                                                   const QList<ObjectModelPtr> &objectModels,
+                                                   const QSet<QString> &imagePaths) {
+    TRACE_SCOPE("load", "JsonLoadAndStoreStrategy::readPoses");
     QList<PosePtr> poses;
     m_posesWithInvalidData.clear();
 
@@ -421,6 +611,10 @@ QList<PosePtr> JsonLoadAndStoreStrategy::loadPoses(const QList<ImagePtr> &images
     //! If we need to update missing IDs we have to write back the document
     bool documentDirty = false;
     for(const QString& imagePath : jsonObject.keys()) {
+        if (!imagePaths.isEmpty() && !imagePaths.contains(imagePath)) {
+            // Only the poses of some images were requested, the others are left untouched
+            continue;
+        }
         if (!jsonObject[imagePath].isArray()) {
             Q_EMIT error(tr("The JSON poses file does not contain an array of image entries."));
             return poses;
@@ -485,7 +679,7 @@ QList<PosePtr> JsonLoadAndStoreStrategy::loadPoses(const QList<ImagePtr> &images
                 if (poseEntry.contains("id")) {
                     id = poseEntry["id"].toString();
                 } else {
-                    id = GeneralHelper::createPoseId(*image, *objectModel);
+                    id = GeneralHelper::createPoseId();
                     //! No ID attatched to the entry yet -> write it to the file
                     //! to be able to identify the poses later
                     QJsonObject modifiedEntry(poseEntry);
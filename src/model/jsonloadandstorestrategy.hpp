@@ -5,6 +5,8 @@
 #include <QString>
 #include <QStringList>
 #include <QList>
+#include <QSet>
+#include <QJsonObject>
 #include <QFileSystemWatcher>
 
 /*!
@@ -28,8 +30,18 @@ public:
 
     bool persistPose(const Pose &pose, bool deletePose) override;
 
+    //! Writes the poses file only once for all poses, i.e. persists all of them or none
+    QStringList persistPoses(const QList<PosePtr> &poses,
+                             const QList<PosePtr> &removedPoses = QList<PosePtr>()) override;
+
     QList<ImagePtr> loadImages() override;
 
+    /*!
+     * \brief loadImagesDelta creates only the images at the given paths from the camera info
+     * file. The images get the same IDs as when loading all images, i.e. their file names.
+     */
+    QList<ImagePtr> loadImagesDelta(const QStringList &absoluteImagePaths) override;
+
     QList<ObjectModelPtr> loadObjectModels() override;
 
     /*!
@@ -47,6 +59,32 @@ public:
      */
     QList<PosePtr> loadPoses(const QList<ImagePtr> &images,
                                const QList<ObjectModelPtr> &objectModels) override;
+
+    /*!
+     * \brief loadPosesDelta only reads the entries of the given images from the poses file.
+     */
+    QList<PosePtr> loadPosesDelta(const QList<ImagePtr> &images,
+                                  const QList<ObjectModelPtr> &objectModels,
+                                  const QList<ImagePtr> &imagesToLoad) override;
+
+    bool supportsManifest() const override;
+
+    //! Additionally the camera info file
+    QStringList manifestDependencies() const override;
+
+private:
+    //! Reads the poses file, writes the given poses, deletes the removed ones and writes the file again
+    bool modifyPosesFile(const QList<const Pose *> &poses, const QList<const Pose *> &removedPoses);
+    /*!
+     * \brief readCameraInfo reads the camera info file info.json in the images folder.
+     * \return false if the file does not exist or is invalid, an error has been emitted then
+     */
+    bool readCameraInfo(QJsonObject &jsonObject, float &nearPlane,
+                        float &farPlane, float &depthScale);
+    //! Reads the poses of the images with the given paths, all if the set is empty
+    QList<PosePtr> readPoses(const QList<ImagePtr> &images,
+                             const QList<ObjectModelPtr> &objectModels,
+                             const QSet<QString> &imagePaths);
 };
 
 typedef QSharedPointer<JsonLoadAndStoreStrategy> JsonLoadAndStoreStrategyPtr;
@@ -3,7 +3,11 @@
 #include "misc/global.hpp"
 
 #include <QCollator>
+#include <QDateTime>
 #include <QDirIterator>
+#include <QFileInfo>
+#include <QPair>
+#include <QSet>
 
 // Overwriteable by subclasses
 const QStringList LoadAndStoreStrategy::OBJECT_MODEL_FILES_EXTENSIONS =
@@ -24,9 +28,15 @@ void LoadAndStoreStrategy::applySettings(SettingsPtr settings) {
     setObjectModelsPath(settings->objectModelsPath());
     setPosesFilePath(settings->posesFilePath());
     setSegmentationImagesPath(settings->segmentationImagesPath());
+    m_eventCoalescer.setQuietPeriod(settings->fileSystemEventsQuietPeriod());
+    m_eventCoalescer.setMaximumLatency(settings->fileSystemEventsMaximumLatency());
 }
 
 void LoadAndStoreStrategy::setImagesPath(const QString &imagesPath) {
+    if (imagesPath != m_imagesPath) {
+        // The snapshot of the old folder is worthless
+        m_hasImageFilesSnapshot = false;
+    }
     setPath(imagesPath, this->m_imagesPath);
 }
 
@@ -34,11 +44,46 @@ void LoadAndStoreStrategy::setSegmentationImagesPath(const QString &path) {
     setPath(path, this->m_segmentationImagesPath);
 }
 
+QStringList LoadAndStoreStrategy::persistPoses(const QList<PosePtr> &poses,
+                                               const QList<PosePtr> &removedPoses) {
+    // Poses that have been persisted before a failing one can't be taken back, the caller
+    // applies exactly the ones that made it
+    QStringList persistedIds;
+    for (const PosePtr &pose : poses) {
+        if (persistPose(*pose, false)) {
+            persistedIds.append(pose->id());
+        }
+    }
+    for (const PosePtr &pose : removedPoses) {
+        if (persistPose(*pose, true)) {
+            persistedIds.append(pose->id());
+        }
+    }
+    return persistedIds;
+}
+
+QList<ImagePtr> LoadAndStoreStrategy::loadImagesDelta(const QStringList &absoluteImagePaths) {
+    QSet<QString> requestedPaths;
+    for (const QString &path : absoluteImagePaths) {
+        requestedPaths.insert(QFileInfo(path).absoluteFilePath());
+    }
+    QList<ImagePtr> images;
+    for (const ImagePtr &image : loadImages()) {
+        if (requestedPaths.contains(QFileInfo(image->absoluteImagePath()).absoluteFilePath())) {
+            images.append(image);
+        }
+    }
+    return images;
+}
+
 QList<QString> LoadAndStoreStrategy::imagesWithInvalidData() const {
     return m_imagesWithInvalidData;
 }
 
 void LoadAndStoreStrategy::setObjectModelsPath(const QString &objectModelsPath) {
+    if (objectModelsPath != m_objectModelsPath) {
+        m_hasObjectModelFilesSnapshot = false;
+    }
     setPath(objectModelsPath, this->m_objectModelsPath);
 }
 
@@ -46,10 +91,221 @@ void LoadAndStoreStrategy::setPosesFilePath(const QString &posesFilePath) {
     setPath(posesFilePath, this->m_posesFilePath);
 }
 
+QList<PosePtr> LoadAndStoreStrategy::loadPosesDelta(const QList<ImagePtr> &images,
+                                                    const QList<ObjectModelPtr> &objectModels,
+                                                    const QList<ImagePtr> &imagesToLoad) {
+    QSet<QString> imagePaths;
+    for (const ImagePtr &image : imagesToLoad) {
+        imagePaths.insert(image->imagePath());
+    }
+    QList<PosePtr> poses;
+    for (const PosePtr &pose : loadPoses(images, objectModels)) {
+        if (imagePaths.contains(pose->image()->imagePath())) {
+            poses.append(pose);
+        }
+    }
+    return poses;
+}
+
 QList<QString> LoadAndStoreStrategy::posesWithInvalidData() const {
     return m_posesWithInvalidData;
 }
 
+void LoadAndStoreStrategy::updateFileSnapshots() {
+    m_imageFiles = snapshotFiles(m_imagesPath, false);
+    m_hasImageFilesSnapshot = true;
+    // Object models are also loaded from subfolders
+    m_objectModelFiles = snapshotFiles(m_objectModelsPath, true);
+    m_hasObjectModelFilesSnapshot = true;
+}
+
+LoadAndStoreStrategy::FileStamp LoadAndStoreStrategy::stampFile(const QString &path) {
+    QFileInfo fileInfo(path);
+    if (!fileInfo.exists()) {
+        return FileStamp{-1, -1};
+    }
+    return FileStamp{fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch()};
+}
+
+void LoadAndStoreStrategy::setFileSnapshots(const FileSnapshot &imageFiles,
+                                            const FileSnapshot &objectModelFiles) {
+    m_imageFiles = imageFiles;
+    m_hasImageFilesSnapshot = true;
+    m_objectModelFiles = objectModelFiles;
+    m_hasObjectModelFilesSnapshot = true;
+}
+
+LoadAndStoreStrategy::FileSnapshot LoadAndStoreStrategy::imageFilesSnapshot() const {
+    return m_imageFiles;
+}
+
+LoadAndStoreStrategy::FileSnapshot LoadAndStoreStrategy::objectModelFilesSnapshot() const {
+    return m_objectModelFiles;
+}
+
+QString LoadAndStoreStrategy::imagesPath() const {
+    return m_imagesPath;
+}
+
+QString LoadAndStoreStrategy::segmentationImagesPath() const {
+    return m_segmentationImagesPath;
+}
+
+QString LoadAndStoreStrategy::objectModelsPath() const {
+    return m_objectModelsPath;
+}
+
+QString LoadAndStoreStrategy::posesFilePath() const {
+    return m_posesFilePath;
+}
+
+bool LoadAndStoreStrategy::supportsManifest() const {
+    return false;
+}
+
+QStringList LoadAndStoreStrategy::manifestDependencies() const {
+    QStringList dependencies;
+    for (const QString &path : {m_imagesPath, m_segmentationImagesPath, m_posesFilePath}) {
+        if (!path.isEmpty() && path != Global::NO_PATH) {
+            dependencies.append(path);
+        }
+    }
+    if (!m_objectModelsPath.isEmpty() && m_objectModelsPath != Global::NO_PATH) {
+        // Object models are loaded from subfolders as well
+        dependencies.append(m_objectModelsPath);
+        QDirIterator it(m_objectModelsPath, QDir::Dirs | QDir::NoDotAndDotDot,
+                        QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            dependencies.append(it.next());
+        }
+    }
+    return dependencies;
+}
+
+LoadAndStoreStrategy::FileSnapshot LoadAndStoreStrategy::snapshotFiles(const QString &path, bool recursive) {
+    FileSnapshot snapshot;
+    if (path.isEmpty() || path == Global::NO_PATH) {
+        return snapshot;
+    }
+    QDirIterator it(path, QDir::Files,
+                    recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo fileInfo = it.fileInfo();
+        snapshot.insert(fileInfo.absoluteFilePath(),
+                        FileStamp{fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch()});
+    }
+    return snapshot;
+}
+
+QStringList LoadAndStoreStrategy::changedFiles(const FileSnapshot &before, const FileSnapshot &after) {
+    QStringList changed;
+    for (auto it = before.constBegin(); it != before.constEnd(); it++) {
+        auto afterIt = after.constFind(it.key());
+        if (afterIt == after.constEnd()
+                || afterIt->size != it->size
+                || afterIt->lastModified != it->lastModified) {
+            changed.append(it.key());
+        }
+    }
+    for (auto it = after.constBegin(); it != after.constEnd(); it++) {
+        if (!before.contains(it.key())) {
+            changed.append(it.key());
+        }
+    }
+    return changed;
+}
+
+void LoadAndStoreStrategy::updateFileStamp(const QString &filePath, FileSnapshot &snapshot,
+                                           bool hasSnapshot) {
+    if (!hasSnapshot) {
+        return;
+    }
+    // Otherwise the next change of the folder would report the file again
+    QFileInfo fileInfo(filePath);
+    if (fileInfo.exists()) {
+        snapshot.insert(fileInfo.absoluteFilePath(),
+                        FileStamp{fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch()});
+    } else {
+        snapshot.remove(fileInfo.absoluteFilePath());
+    }
+}
+
+void LoadAndStoreStrategy::handleFolderChanged(const QString &path, int data, const QStringList &filters,
+                                               bool recursive, FileSnapshot &snapshot, bool &hasSnapshot) {
+    if (!hasSnapshot) {
+        // Nothing to compare to, the model manager takes a snapshot after reloading
+        Q_EMIT dataChanged(data);
+        return;
+    }
+    FileSnapshot currentSnapshot = snapshotFiles(path, recursive);
+    const QStringList changed = changedFiles(snapshot, currentSnapshot);
+
+    // Copy tools often write to a temporary name and rename the file when it is
+    // complete, the renamed file keeps size and modification time of the temporary one
+    QSet<QPair<qint64, qint64>> vanishedTemporaryFiles;
+    for (const QString &file : changed) {
+        auto oldStamp = snapshot.constFind(file);
+        if (oldStamp != snapshot.constEnd() && !currentSnapshot.contains(file)
+                && FileSystemEventCoalescer::isTemporaryFile(QFileInfo(file).fileName())) {
+            vanishedTemporaryFiles.insert(qMakePair(oldStamp->size, oldStamp->lastModified));
+        }
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList reportedFiles;
+    bool otherFilesChanged = false;
+    // Segmentation images are matched to images by their position in the sorted folders
+    const bool pairedBySegmentationImages = data == Data::Images
+            && !m_segmentationImagesPath.isEmpty() && m_segmentationImagesPath != Global::NO_PATH;
+    bool filesBeingWritten = false;
+    for (const QString &file : changed) {
+        const QString fileName = QFileInfo(file).fileName();
+        if (FileSystemEventCoalescer::isTemporaryFile(fileName)) {
+            continue;
+        }
+        auto currentStamp = currentSnapshot.constFind(file);
+        if (currentStamp != currentSnapshot.constEnd()) {
+            bool renamedFromTemporaryFile = vanishedTemporaryFiles.contains(
+                        qMakePair(currentStamp->size, currentStamp->lastModified));
+            if (!renamedFromTemporaryFile
+                    && now - currentStamp->lastModified < m_eventCoalescer.quietPeriod()) {
+                // Probably only partially written, keep the old state in the snapshot
+                // so that the file is reported when we look again
+                auto oldStamp = snapshot.constFind(file);
+                if (oldStamp == snapshot.constEnd()) {
+                    currentSnapshot.remove(file);
+                } else {
+                    currentSnapshot.insert(file, *oldStamp);
+                }
+                filesBeingWritten = true;
+                continue;
+            }
+        }
+        if (!QDir::match(filters, fileName)) {
+            // E.g. the camera info file which might affect all entities
+            otherFilesChanged = true;
+        } else if (pairedBySegmentationImages
+                   && snapshot.contains(file) != currentSnapshot.contains(file)) {
+            // An added or removed image moves the images after it to other segmentation
+            // images, only reloading all of them pairs them up again
+            otherFilesChanged = true;
+        }
+        reportedFiles.append(file);
+    }
+    snapshot = currentSnapshot;
+
+    if (filesBeingWritten) {
+        // Writing to a file doesn't necessarily trigger the watcher of its folder
+        m_eventCoalescer.addDirectory(path);
+    }
+    if (otherFilesChanged) {
+        Q_EMIT dataChanged(data);
+    } else if (!reportedFiles.isEmpty()) {
+        Q_EMIT filesChanged(data, reportedFiles);
+    }
+}
+
 bool LoadAndStoreStrategy::setPath(const QString &path, QString &oldPath) {
     // Only check if path exists if the new path is not equal to NO_PATH
     // NO_PATH is the path set in the beginning when the program is launched the
@@ -72,10 +328,15 @@ bool LoadAndStoreStrategy::setPath(const QString &path, QString &oldPath) {
 }
 
 void LoadAndStoreStrategy::onDirectoryChanged(const QString &path) {
-    if (path == m_imagesPath || path == m_segmentationImagesPath) {
+    if (path == m_imagesPath) {
+        handleFolderChanged(path, Data::Images, IMAGE_FILES_EXTENSIONS, false,
+                            m_imageFiles, m_hasImageFilesSnapshot);
+    } else if (path == m_segmentationImagesPath) {
+        // The strategies match segmentation images to images, i.e. any image might be affected
         Q_EMIT dataChanged(Data::Images);
     } else if (path == m_objectModelsPath) {
-        Q_EMIT dataChanged(Data::ObjectModels);
+        handleFolderChanged(path, Data::ObjectModels, OBJECT_MODEL_FILES_EXTENSIONS, true,
+                            m_objectModelFiles, m_hasObjectModelFilesSnapshot);
     } else if (path == m_posesFilePath) {
         Q_EMIT dataChanged(Data::Poses);
     }
@@ -91,17 +352,39 @@ void LoadAndStoreStrategy::onFileChanged(const QString &filePath) {
         }
         m_ignorePosesFileChanged = false;
     } else if (filePath.contains(m_imagesPath)
-               && IMAGE_FILES_EXTENSIONS.contains(filePath.right(4))) {
-        Q_EMIT dataChanged(Data::Images);
+               && QDir::match(IMAGE_FILES_EXTENSIONS, QFileInfo(filePath).fileName())) {
+        updateFileStamp(filePath, m_imageFiles, m_hasImageFilesSnapshot);
+        Q_EMIT filesChanged(Data::Images, {filePath});
     } else if (filePath.contains(m_objectModelsPath)
-               && OBJECT_MODEL_FILES_EXTENSIONS.contains(filePath.right(4))) {
-        Q_EMIT dataChanged(Data::ObjectModels);
+               && QDir::match(OBJECT_MODEL_FILES_EXTENSIONS, QFileInfo(filePath).fileName())) {
+        updateFileStamp(filePath, m_objectModelFiles, m_hasObjectModelFilesSnapshot);
+        Q_EMIT filesChanged(Data::ObjectModels, {filePath});
+    }
+}
+
+void LoadAndStoreStrategy::onFileSystemEventsReady(const QStringList &directories,
+                                                   const QStringList &files) {
+    QSet<QString> changedDirectories;
+    for (const QString &directory : directories) {
+        onDirectoryChanged(directory);
+        changedDirectories.insert(QFileInfo(directory).absoluteFilePath());
+    }
+    for (const QString &file : files) {
+        // The diff of the folder already contains the file
+        if (file != m_posesFilePath
+                && changedDirectories.contains(QFileInfo(file).absolutePath())) {
+            continue;
+        }
+        onFileChanged(file);
     }
 }
 
 void LoadAndStoreStrategy::connectWatcherSignals() {
+    // Events are collected first, a burst of events is handled at once
     connect(&m_fileSystemWatcher, &QFileSystemWatcher::directoryChanged,
-            this, &LoadAndStoreStrategy::onDirectoryChanged);
+            &m_eventCoalescer, &FileSystemEventCoalescer::addDirectory);
     connect(&m_fileSystemWatcher, &QFileSystemWatcher::fileChanged,
-            this, &LoadAndStoreStrategy::onFileChanged);
+            &m_eventCoalescer, &FileSystemEventCoalescer::addFile);
+    connect(&m_eventCoalescer, &FileSystemEventCoalescer::eventsReady,
+            this, &LoadAndStoreStrategy::onFileSystemEventsReady);
 }
@@ -5,12 +5,15 @@
 #include "image.hpp"
 #include "objectmodel.hpp"
 #include "data.hpp"
+#include "filesystemeventcoalescer.hpp"
 #include "settings/settingsstore.hpp"
 
 #include <QObject>
 #include <QString>
 #include <QList>
 #include <QDir>
+#include <QHash>
+#include <QStringList>
 #include <QFileSystemWatcher>
 
 using namespace std;
@@ -48,6 +51,18 @@ public:
     virtual bool persistPose(const Pose &objectImagePose,
                              bool deletePose) = 0;
 
+    /*!
+     * \brief persistPoses persists many changes at once, e.g. after refining or propagating
+     * poses or when saving the poses of an image. The default implementation persists the
+     * poses one by one, strategies that can write several poses at once should override it
+     * and persist either all changes or none.
+     * \param poses the poses to add or update
+     * \param removedPoses the poses to delete
+     * \return the IDs of the poses whose changes have actually been persisted
+     */
+    virtual QStringList persistPoses(const QList<PosePtr> &poses,
+                                     const QList<PosePtr> &removedPoses = QList<PosePtr>());
+
     void setImagesPath(const QString &imagesPath);
 
     void setSegmentationImagesPath(const QString &path);
@@ -58,6 +73,16 @@ public:
      */
     virtual QList<ImagePtr> loadImages() = 0;
 
+    /*!
+     * \brief loadImagesDelta loads only the images at the given absolute paths, e.g. after
+     * some files of the images folder changed. Images that don't exist anymore are simply
+     * not part of the result. The default implementation loads all images and picks the
+     * requested ones, strategies that can load single images should override it.
+     * \param absoluteImagePaths the paths of the images to load
+     * \return the images that could be loaded
+     */
+    virtual QList<ImagePtr> loadImagesDelta(const QStringList &absoluteImagePaths);
+
     virtual QList<QString> imagesWithInvalidData() const;
 
     void setObjectModelsPath(const QString &objectModelsPath);
@@ -78,16 +103,94 @@ public:
     virtual QList<PosePtr> loadPoses(const QList<ImagePtr> &images,
                                        const QList<ObjectModelPtr> &objectModels) = 0;
 
+    /*!
+     * \brief loadPosesDelta loads only the poses of the given images. The default
+     * implementation loads all poses and picks the requested ones.
+     * \param images all images, like for loadPoses
+     * \param objectModels all object models, like for loadPoses
+     * \param imagesToLoad the images to load the poses of
+     * \return the poses of imagesToLoad
+     */
+    virtual QList<PosePtr> loadPosesDelta(const QList<ImagePtr> &images,
+                                          const QList<ObjectModelPtr> &objectModels,
+                                          const QList<ImagePtr> &imagesToLoad);
+
     virtual QList<QString> posesWithInvalidData() const;
 
+    /*!
+     * \brief updateFileSnapshots remembers the files in the images and object models
+     * folders. When a folder changes afterwards only the files that differ from the
+     * snapshot are reported through filesChanged. Should be called after loading.
+     */
+    void updateFileSnapshots();
+
+    //! Size and modification time of a file to detect changes
+    struct FileStamp {
+        qint64 size;
+        qint64 lastModified;
+
+        bool operator==(const FileStamp &other) const {
+            return size == other.size && lastModified == other.lastModified;
+        }
+        bool operator!=(const FileStamp &other) const {
+            return !(*this == other);
+        }
+    };
+    typedef QHash<QString, FileStamp> FileSnapshot;
+
+    /*!
+     * \brief stampFile returns size and modification time of the file or folder, -1 for
+     * both if it doesn't exist.
+     */
+    static FileStamp stampFile(const QString &path);
+    static FileSnapshot snapshotFiles(const QString &path, bool recursive);
+
+    /*!
+     * \brief setFileSnapshots sets the snapshots of the images and object models folders
+     * that were taken elsewhere, e.g. while verifying a dataset manifest.
+     */
+    void setFileSnapshots(const FileSnapshot &imageFiles, const FileSnapshot &objectModelFiles);
+    FileSnapshot imageFilesSnapshot() const;
+    FileSnapshot objectModelFilesSnapshot() const;
+    QString imagesPath() const;
+    QString segmentationImagesPath() const;
+    QString objectModelsPath() const;
+    QString posesFilePath() const;
+
+    /*!
+     * \brief supportsManifest returns whether the loaded entities may be cached in a
+     * DatasetManifest, i.e. they only depend on the files of manifestDependencies. This is
+     * not the case e.g. for scripts that can read whatever they want.
+     */
+    virtual bool supportsManifest() const;
+
+    /*!
+     * \brief manifestDependencies returns the files and folders whose size and modification
+     * time are checked to find out whether a manifest is still valid. Folders change their
+     * modification time when files are added, removed or renamed in them.
+     */
+    virtual QStringList manifestDependencies() const;
+
 
 Q_SIGNALS:
     void error(const QString &error);
     void dataChanged(int data);
+    /*!
+     * \brief filesChanged is emitted instead of dataChanged when the files that changed
+     * are known, i.e. added, removed or modified images or object models.
+     * \param data either Data::Images or Data::ObjectModels
+     * \param absolutePaths the paths of the changed files
+     */
+    void filesChanged(int data, const QStringList &absolutePaths);
 
 protected Q_SLOTS:
     void onDirectoryChanged(const QString &path);
     void onFileChanged(const QString &filePath);
+    /*!
+     * \brief onFileSystemEventsReady handles the events the coalescer collected
+     * during a burst of changes.
+     */
+    void onFileSystemEventsReady(const QStringList &directories, const QStringList &files);
 
 protected:
     void connectWatcherSignals();
@@ -95,6 +198,23 @@ protected:
     //! Internal methods to react to path changes
     bool setPath(const QString &path, QString &oldPath);
 
+    /*!
+     * \brief changedFiles returns the paths of the files that were added, removed or
+     * modified between the two snapshots.
+     */
+    static QStringList changedFiles(const FileSnapshot &before, const FileSnapshot &after);
+    //! Updates the entry of a single file in the snapshot if there is one
+    static void updateFileStamp(const QString &filePath, FileSnapshot &snapshot, bool hasSnapshot);
+    /*!
+     * \brief handleFolderChanged diffs the folder against its snapshot and emits filesChanged
+     * if only files matching the filters changed, otherwise (e.g. a camera info file
+     * changed or images were added or removed while segmentation images are used)
+     * dataChanged. Temporary files are ignored and files that are still being
+     * written are postponed until they were not modified for the quiet period.
+     */
+    void handleFolderChanged(const QString &path, int data, const QStringList &filters,
+                             bool recursive, FileSnapshot &snapshot, bool &hasSnapshot);
+
 protected:
     //! Unmodifiable constants (i.e. not changable by the user at runtime)
     static const QStringList IMAGE_FILES_EXTENSIONS;
@@ -113,6 +233,8 @@ protected:
     QString m_segmentationImagesPath;
 
     QFileSystemWatcher m_fileSystemWatcher;
+    //! Merges the events of the watcher, a child to be moved to the thread of the strategy
+    FileSystemEventCoalescer m_eventCoalescer{this};
 
     // We need to ignore changes to the file once after we have written
     // a new pose to it because the model manager already emits a signal
@@ -120,6 +242,11 @@ protected:
     // We only want this signal when the poses file has been changed
     // externally
     bool m_ignorePosesFileChanged = false;
+
+    FileSnapshot m_imageFiles;
+    bool m_hasImageFilesSnapshot = false;
+    FileSnapshot m_objectModelFiles;
+    bool m_hasObjectModelFilesSnapshot = false;
 };
 
 //Q_DECLARE_METATYPE(LoadAndStoreStrategy::Error)
@@ -2,21 +2,41 @@ INCLUDEPATH += $$PWD
 
 HEADERS += \
     $$PWD/pythonloadandstorestrategy.hpp \
+    $$PWD/pythonprocessloadandstorestrategy.hpp \
+    $$PWD/pythonscriptdata.hpp \
+    $$PWD/pythonworkerpool.hpp \
+    $$PWD/asyncmodelmanager.hpp \
     $$PWD/cachingmodelmanager.hpp \
     $$PWD/data.hpp \
+    $$PWD/datasetmanifest.hpp \
+    $$PWD/filesystemeventcoalescer.hpp \
     $$PWD/image.hpp \
+    $$PWD/internpool.hpp \
     $$PWD/loadandstorestrategy.hpp \
     $$PWD/modelmanager.hpp \
+    $$PWD/modelsnapshot.hpp \
     $$PWD/objectmodel.hpp \
     $$PWD/jsonloadandstorestrategy.hpp \
-    $$PWD/pose.hpp
+    $$PWD/pose.hpp \
+    $$PWD/poseid.hpp \
+    $$PWD/posestore.hpp
 
 SOURCES += \
     $$PWD/pythonloadandstorestrategy.cpp \
+    $$PWD/pythonprocessloadandstorestrategy.cpp \
+    $$PWD/pythonscriptdata.cpp \
+    $$PWD/pythonworkerpool.cpp \
+    $$PWD/asyncmodelmanager.cpp \
+    $$PWD/datasetmanifest.cpp \
+    $$PWD/filesystemeventcoalescer.cpp \
     $$PWD/image.cpp \
+    $$PWD/internpool.cpp \
     $$PWD/objectmodel.cpp \
     $$PWD/loadandstorestrategy.cpp \
     $$PWD/cachingmodelmanager.cpp \
     $$PWD/modelmanager.cpp \
+    $$PWD/modelsnapshot.cpp \
     $$PWD/jsonloadandstorestrategy.cpp \
-    $$PWD/pose.cpp
+    $$PWD/pose.cpp \
+    $$PWD/poseid.cpp \
+    $$PWD/posestore.cpp
@@ -2,6 +2,10 @@
 
 ModelManager::ModelManager(LoadAndStoreStrategyPtr loadAndStoreStrategy) : m_loadAndStoreStrategy(loadAndStoreStrategy) {
     qRegisterMetaType<ModelManager::State>("ModelManager::State");
+    // The signals of partial reloads are delivered across threads
+    qRegisterMetaType<DataDelta>("DataDelta");
+    qRegisterMetaType<QList<ImagePtr>>("QList<ImagePtr>");
+    qRegisterMetaType<QList<ObjectModelPtr>>("QList<ObjectModelPtr>");
 }
 
 ModelManager::~ModelManager() {
@@ -6,6 +6,7 @@
 #include "image.hpp"
 #include "data.hpp"
 #include "loadandstorestrategy.hpp"
+#include "modelsnapshot.hpp"
 #include <QObject>
 #include <QString>
 #include <QList>
@@ -95,8 +96,23 @@ public:
      */
     virtual QList<PosePtr> poses() const = 0;
 
+    /*!
+     * \brief storedPoses returns copies of all poses with the values as they are stored by
+     * this manager. Unlike the poses returned by poses() the copies are not shared with the
+     * views, i.e. they can be read on the thread of the manager while the views edit poses.
+     * \return copies of the poses maintained by this manager
+     */
+    virtual QList<PosePtr> storedPoses() const = 0;
+
     virtual PosePtr poseById(const QString &id) const = 0;
 
+    /*!
+     * \brief snapshot returns the latest published snapshot of the images and object models.
+     * Unlike the other methods it can be called from any thread, it neither copies the
+     * lists nor waits for the manager to finish what it is doing.
+     */
+    virtual ModelSnapshotPtr snapshot() const = 0;
+
     /*!
      * \brief getPosesForImageAndObjectModel Returns all poses for the given image and object model.
      * \param imagePath the image
@@ -131,7 +147,8 @@ public:
     /*!
      * \brief addObjectImagePose Updates the given ObjectImagePose and automatically persists it according to the
      * LoadAndStoreStrategy of this Manager. If this manager does not manage the given ObjectImageCorresopndence false will be
-     * returned.
+     * returned. Pose objects that have been returned before keep their values, whoever holds them is
+     * responsible for showing the new ones.
      * \param objectImagePose the pose to be updated
      * \return true if updating  and also persisting the pose was successful, false if this manager does not manage the given
      * pose or persisting it has failed
@@ -140,6 +157,30 @@ public:
                             const QVector3D &position,
                             const QMatrix3x3 &rotation) = 0;
 
+    /*!
+     * \brief updatePoses updates many poses at once and persists them in one go, e.g. after
+     * refining all poses. Like with updatePose the pose objects that have been returned before
+     * keep their values.
+     * \param poses the new values, only the ID, position and rotation of the poses are used
+     * \return the IDs of the poses that have been updated, poses that this manager does not
+     * manage are skipped, only the ones that could be persisted are updated
+     */
+    virtual QStringList updatePoses(const QList<PosePtr> &poses) = 0;
+
+    /*!
+     * \brief savePoses adds, updates and removes many poses at once and persists all of the
+     * changes in one go, e.g. when saving the edited poses of an image or adding propagated
+     * poses.
+     * \param posesToAdd the poses to add, they are copied
+     * \param posesToUpdate the new values, only the ID, position and rotation are used
+     * \param poseIdsToRemove the IDs of the poses to remove
+     * \return the IDs of the poses whose changes have been persisted and applied, exactly
+     * these changes have been made. Poses this manager does not manage are skipped.
+     */
+    virtual QStringList savePoses(const QList<PosePtr> &posesToAdd,
+                                  const QList<PosePtr> &posesToUpdate,
+                                  const QStringList &poseIdsToRemove) = 0;
+
     /*!
      * \brief removeObjectImagePose Removes the given ObjectImagePose if it is present in the list
      * of poses mainainted by this manager.
@@ -158,10 +199,28 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     void dataChanged(int data);
+    /*!
+     * \brief imagesChanged is emitted instead of dataChanged when only some images were
+     * added, removed or modified on the filesystem and have been reloaded.
+     * \param images the new list of all images
+     * \param delta the rows that changed
+     */
+    void imagesChanged(const QList<ImagePtr> &images, const DataDelta &delta);
+    //! Like imagesChanged but for object models
+    void objectModelsChanged(const QList<ObjectModelPtr> &objectModels, const DataDelta &delta);
+    /*!
+     * \brief posesReloaded is emitted when the poses of only some images have been reloaded,
+     * e.g. because the poses file was modified externally.
+     * \param images the images whose poses were reloaded, removed images are included
+     */
+    void posesReloaded(const QList<ImagePtr> &images);
     void poseAdded(PosePtr pose);
     void poseUpdated(PosePtr pose);
     void poseDeleted(PosePtr pose);
     void stateChanged(ModelManager::State state, const QString &error);
 };
 
+Q_DECLARE_METATYPE(QList<ImagePtr>)
+Q_DECLARE_METATYPE(QList<ObjectModelPtr>)
+
 #endif // MODELMANAGER_H
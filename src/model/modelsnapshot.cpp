@@ -0,0 +1,36 @@
+#include "modelsnapshot.hpp"
+
+ModelSnapshot::ModelSnapshot() {
+}
+
+ModelSnapshot::ModelSnapshot(quint64 version,
+                             quint64 imagesVersion,
+                             quint64 objectModelsVersion,
+                             const QList<ImagePtr> &images,
+                             const QList<ObjectModelPtr> &objectModels)
+    : m_version(version)
+    , m_imagesVersion(imagesVersion)
+    , m_objectModelsVersion(objectModelsVersion)
+    , m_images(images)
+    , m_objectModels(objectModels) {
+}
+
+quint64 ModelSnapshot::version() const {
+    return m_version;
+}
+
+quint64 ModelSnapshot::imagesVersion() const {
+    return m_imagesVersion;
+}
+
+quint64 ModelSnapshot::objectModelsVersion() const {
+    return m_objectModelsVersion;
+}
+
+const QList<ImagePtr> &ModelSnapshot::images() const {
+    return m_images;
+}
+
+const QList<ObjectModelPtr> &ModelSnapshot::objectModels() const {
+    return m_objectModels;
+}
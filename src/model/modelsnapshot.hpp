@@ -0,0 +1,54 @@
+#ifndef MODELSNAPSHOT_H
+#define MODELSNAPSHOT_H
+
+#include "image.hpp"
+#include "objectmodel.hpp"
+
+#include <QList>
+#include <QSharedPointer>
+
+/*!
+ * \brief The ModelSnapshot class is an immutable view of the images and object models of
+ * the model manager at one point in time. The manager publishes a new snapshot whenever
+ * its data changes and never modifies a published one, i.e. readers on any thread can
+ * hold on to a snapshot as long as they like without copying the lists or locking.
+ *
+ * Every snapshot carries versions that only increase. Consumers remember the version they
+ * last refreshed from and skip refreshing when it didn't change. The version of a list is
+ * only increased when its content actually differs, e.g. reloading the same folder again
+ * keeps the version of the images.
+ *
+ * Poses are not part of a snapshot since they are handed out as Pose objects which the
+ * views modify while editing. The manager publishes a snapshot for every change of the
+ * poses too though, i.e. an unchanged version means that the poses are unchanged as well.
+ */
+class ModelSnapshot {
+
+public:
+    //! Constructs an empty snapshot with all versions 0
+    ModelSnapshot();
+    ModelSnapshot(quint64 version,
+                  quint64 imagesVersion,
+                  quint64 objectModelsVersion,
+                  const QList<ImagePtr> &images,
+                  const QList<ObjectModelPtr> &objectModels);
+
+    //! Increases with every published snapshot, i.e. also when only poses changed
+    quint64 version() const;
+    quint64 imagesVersion() const;
+    quint64 objectModelsVersion() const;
+
+    const QList<ImagePtr> &images() const;
+    const QList<ObjectModelPtr> &objectModels() const;
+
+private:
+    quint64 m_version = 0;
+    quint64 m_imagesVersion = 0;
+    quint64 m_objectModelsVersion = 0;
+    QList<ImagePtr> m_images;
+    QList<ObjectModelPtr> m_objectModels;
+};
+
+typedef QSharedPointer<const ModelSnapshot> ModelSnapshotPtr;
+
+#endif // MODELSNAPSHOT_H
@@ -1,13 +1,16 @@
 #include "objectmodel.hpp"
+#include "internpool.hpp"
+
 #include <QDir>
 
 ObjectModel::ObjectModel(const QString &id, const QString& objectModelPath, const QString& basePath)
     : m_id(id),
       m_objectModelPath(objectModelPath),
-      m_basePath(basePath) {
+      m_basePath(InternPool::string(basePath)) {
 }
 
 ObjectModel::ObjectModel(const ObjectModel &other) {
+    m_id = other.m_id;
     m_objectModelPath = other.m_objectModelPath;
     m_basePath = other.m_basePath;
 }
@@ -0,0 +1,141 @@
+#include "poseid.hpp"
+
+#include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QWriteLocker>
+
+namespace {
+
+// Keys of legacy ids have the highest bit set, generated ids won't reach it before the
+// year 35000
+const quint64 LEGACY_FLAG = quint64(1) << 63;
+// The lower bits of generated ids count the ids created within the same millisecond
+const int COUNTER_BITS = 12;
+
+QMutex generateMutex;
+quint64 lastGeneratedValue = 0;
+
+QReadWriteLock legacyLock;
+QHash<QString, quint64> legacyKeys;
+QHash<quint64, QString> legacyTexts;
+// Keys are never reused, released ids must not turn into other ones
+quint64 nextLegacyKey = LEGACY_FLAG | 1;
+
+}
+
+PoseId::PoseId() {
+}
+
+PoseId::PoseId(quint64 value) : m_value(value) {
+}
+
+PoseId PoseId::generate() {
+    const quint64 timeValue = quint64(QDateTime::currentMSecsSinceEpoch()) << COUNTER_BITS;
+    QMutexLocker locker(&generateMutex);
+    // Strictly increasing, even if the clock is set back
+    lastGeneratedValue = qMax(lastGeneratedValue + 1, timeValue);
+    return PoseId(lastGeneratedValue);
+}
+
+quint64 PoseId::parseCompact(const QString &text) {
+    // 'p' plus at most 13 digits, which is enough for 63 bits in base 36
+    if (text.size() < 2 || text.size() > 14 || text[0] != QLatin1Char('p')) {
+        return 0;
+    }
+    const QString digits = text.mid(1);
+    bool ok = false;
+    const quint64 value = digits.toULongLong(&ok, 36);
+    // Only the exact text we would produce, otherwise "p0a" and "pA" would both map to the
+    // same key as "pa"
+    if (!ok || value == 0 || (value & LEGACY_FLAG) || QString::number(value, 36) != digits) {
+        return 0;
+    }
+    return value;
+}
+
+PoseId PoseId::fromString(const QString &text) {
+    const quint64 value = parseCompact(text);
+    if (value != 0) {
+        return PoseId(value);
+    }
+    if (text.isEmpty()) {
+        return PoseId();
+    }
+    {
+        QReadLocker locker(&legacyLock);
+        auto it = legacyKeys.constFind(text);
+        if (it != legacyKeys.constEnd()) {
+            return PoseId(*it);
+        }
+    }
+    QWriteLocker locker(&legacyLock);
+    // Another thread might have registered it in the meantime
+    auto it = legacyKeys.constFind(text);
+    if (it != legacyKeys.constEnd()) {
+        return PoseId(*it);
+    }
+    const quint64 key = nextLegacyKey++;
+    legacyTexts.insert(key, text);
+    legacyKeys.insert(text, key);
+    return PoseId(key);
+}
+
+void PoseId::advancePast(const PoseId &id) {
+    if (!id.isValid() || id.isLegacy()) {
+        return;
+    }
+    QMutexLocker locker(&generateMutex);
+    lastGeneratedValue = qMax(lastGeneratedValue, id.m_value);
+}
+
+void PoseId::releaseLegacyIds(const QSet<PoseId> &usedIds) {
+    QWriteLocker locker(&legacyLock);
+    for (auto it = legacyTexts.begin(); it != legacyTexts.end();) {
+        if (usedIds.contains(PoseId(it.key()))) {
+            ++it;
+        } else {
+            legacyKeys.remove(it.value());
+            it = legacyTexts.erase(it);
+        }
+    }
+}
+
+int PoseId::legacyIdCount() {
+    QReadLocker locker(&legacyLock);
+    return legacyTexts.size();
+}
+
+PoseId PoseId::find(const QString &text) {
+    const quint64 value = parseCompact(text);
+    if (value != 0) {
+        return PoseId(value);
+    }
+    QReadLocker locker(&legacyLock);
+    return PoseId(legacyKeys.value(text, 0));
+}
+
+QString PoseId::toString() const {
+    if (m_value == 0) {
+        return QString();
+    }
+    if (isLegacy()) {
+        QReadLocker locker(&legacyLock);
+        return legacyTexts.value(m_value);
+    }
+    return QLatin1Char('p') + QString::number(m_value, 36);
+}
+
+quint64 PoseId::value() const {
+    return m_value;
+}
+
+bool PoseId::isValid() const {
+    return m_value != 0;
+}
+
+bool PoseId::isLegacy() const {
+    return m_value & LEGACY_FLAG;
+}
@@ -0,0 +1,87 @@
+#ifndef POSEID_H
+#define POSEID_H
+
+#include <QHash>
+#include <QMetaType>
+#include <QSet>
+#include <QString>
+
+/*!
+ * \brief The PoseId class is the 64 bit key the model uses to look up poses. Comparing and
+ * hashing it is a lot cheaper than working with the id strings.
+ *
+ * New ids are generated from the current time in milliseconds and a counter, which keeps
+ * them unique and increasing even if thousands of poses are created at once. Their text
+ * form is a 'p' followed by the value in base 36, e.g. p1ry3c5vk00.
+ *
+ * Ids of existing datasets, e.g. 000001_obj_01_1.3.19_12:00:00, stay valid. They are
+ * registered once in a table and get a key from a separate range, toString returns the
+ * original text so that they are written back unchanged. The model manager releases the
+ * ones of poses that are gone after loading.
+ */
+class PoseId {
+
+public:
+    //! Constructs an invalid id
+    PoseId();
+
+    /*!
+     * \brief generate returns a new unique id, it is thread-safe.
+     */
+    static PoseId generate();
+
+    /*!
+     * \brief fromString returns the id for the given text, legacy ids are registered if
+     * they haven't been seen before.
+     */
+    static PoseId fromString(const QString &text);
+
+    /*!
+     * \brief find is like fromString but doesn't register unknown legacy ids, e.g. to look
+     * up ids that were passed in from outside.
+     * \return an invalid id if the text is a legacy id that hasn't been registered
+     */
+    static PoseId find(const QString &text);
+
+    /*!
+     * \brief advancePast makes generate only return ids greater than the given one, e.g.
+     * the greatest one of a loaded dataset that was created on a clock running ahead.
+     */
+    static void advancePast(const PoseId &id);
+
+    /*!
+     * \brief releaseLegacyIds removes all legacy ids but the given ones from the table.
+     * toString returns an empty string for released ids and their keys are never handed
+     * out again. Must not run while other threads register ids that are about to be used.
+     */
+    static void releaseLegacyIds(const QSet<PoseId> &usedIds);
+    //! The number of registered legacy ids, e.g. for diagnostics
+    static int legacyIdCount();
+
+    QString toString() const;
+    quint64 value() const;
+    bool isValid() const;
+    //! Whether the id has been read from a dataset and doesn't use the compact form
+    bool isLegacy() const;
+
+    bool operator==(const PoseId &other) const { return m_value == other.m_value; }
+    bool operator!=(const PoseId &other) const { return m_value != other.m_value; }
+    bool operator<(const PoseId &other) const { return m_value < other.m_value; }
+
+private:
+    explicit PoseId(quint64 value);
+    //! Parses the compact form, returns 0 if the text isn't in exactly that form
+    static quint64 parseCompact(const QString &text);
+
+private:
+    //! 0 is invalid
+    quint64 m_value = 0;
+};
+
+inline uint qHash(const PoseId &id, uint seed = 0) {
+    return qHash(id.value(), seed);
+}
+
+Q_DECLARE_METATYPE(PoseId)
+
+#endif // POSEID_H
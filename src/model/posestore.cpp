@@ -0,0 +1,151 @@
+#include "posestore.hpp"
+
+PoseStore::PoseStore() {
+}
+
+int PoseStore::size() const {
+    return m_ids.size();
+}
+
+bool PoseStore::isEmpty() const {
+    return m_ids.isEmpty();
+}
+
+void PoseStore::clear() {
+    m_ids.clear();
+    m_positions.clear();
+    m_rotations.clear();
+    m_imageIndices.clear();
+    m_objectModelIndices.clear();
+}
+
+void PoseStore::reserve(int size) {
+    m_ids.reserve(size);
+    m_positions.reserve(size);
+    m_rotations.reserve(size);
+    m_imageIndices.reserve(size);
+    m_objectModelIndices.reserve(size);
+}
+
+void PoseStore::squeeze() {
+    m_ids.squeeze();
+    m_positions.squeeze();
+    m_rotations.squeeze();
+    m_imageIndices.squeeze();
+    m_objectModelIndices.squeeze();
+}
+
+qint64 PoseStore::memoryUsage() const {
+    return qint64(m_ids.capacity()) * sizeof(PoseId)
+            + qint64(m_positions.capacity()) * sizeof(QVector3D)
+            + qint64(m_rotations.capacity()) * sizeof(QQuaternion)
+            + qint64(m_imageIndices.capacity()) * sizeof(qint32)
+            + qint64(m_objectModelIndices.capacity()) * sizeof(qint32);
+}
+
+int PoseStore::append(const PoseId &id,
+                      const QVector3D &position,
+                      const QQuaternion &rotation,
+                      int imageIndex,
+                      int objectModelIndex) {
+    m_ids.append(id);
+    m_positions.append(position);
+    m_rotations.append(rotation);
+    m_imageIndices.append(imageIndex);
+    m_objectModelIndices.append(objectModelIndex);
+    return m_ids.size() - 1;
+}
+
+void PoseStore::append(const PoseStore &other) {
+    m_ids += other.m_ids;
+    m_positions += other.m_positions;
+    m_rotations += other.m_rotations;
+    m_imageIndices += other.m_imageIndices;
+    m_objectModelIndices += other.m_objectModelIndices;
+}
+
+void PoseStore::removeAt(int row) {
+    m_ids.removeAt(row);
+    m_positions.removeAt(row);
+    m_rotations.removeAt(row);
+    m_imageIndices.removeAt(row);
+    m_objectModelIndices.removeAt(row);
+}
+
+void PoseStore::removeRowsOfImages(const QSet<int> &imageIndices) {
+    if (imageIndices.isEmpty()) {
+        return;
+    }
+    QVector<bool> keep(size());
+    for (int row = 0; row < size(); row++) {
+        keep[row] = !imageIndices.contains(m_imageIndices[row]);
+    }
+    keepRows(keep);
+}
+
+void PoseStore::remapImageIndices(const QVector<int> &mapping) {
+    QVector<bool> keep(size());
+    for (int row = 0; row < size(); row++) {
+        const int newIndex = mapping.value(m_imageIndices[row], -1);
+        m_imageIndices[row] = newIndex;
+        keep[row] = newIndex != -1;
+    }
+    keepRows(keep);
+}
+
+void PoseStore::remapObjectModelIndices(const QVector<int> &mapping) {
+    QVector<bool> keep(size());
+    for (int row = 0; row < size(); row++) {
+        const int newIndex = mapping.value(m_objectModelIndices[row], -1);
+        m_objectModelIndices[row] = newIndex;
+        keep[row] = newIndex != -1;
+    }
+    keepRows(keep);
+}
+
+void PoseStore::keepRows(const QVector<bool> &keep) {
+    int newRow = 0;
+    for (int row = 0; row < size(); row++) {
+        if (!keep[row]) {
+            continue;
+        }
+        if (newRow != row) {
+            m_ids[newRow] = m_ids[row];
+            m_positions[newRow] = m_positions[row];
+            m_rotations[newRow] = m_rotations[row];
+            m_imageIndices[newRow] = m_imageIndices[row];
+            m_objectModelIndices[newRow] = m_objectModelIndices[row];
+        }
+        newRow++;
+    }
+    m_ids.resize(newRow);
+    m_positions.resize(newRow);
+    m_rotations.resize(newRow);
+    m_imageIndices.resize(newRow);
+    m_objectModelIndices.resize(newRow);
+}
+
+void PoseStore::setPose(int row, const QVector3D &position, const QQuaternion &rotation) {
+    m_positions[row] = position;
+    m_rotations[row] = rotation;
+}
+
+PoseId PoseStore::id(int row) const {
+    return m_ids[row];
+}
+
+QVector3D PoseStore::position(int row) const {
+    return m_positions[row];
+}
+
+QQuaternion PoseStore::rotation(int row) const {
+    return m_rotations[row];
+}
+
+int PoseStore::imageIndex(int row) const {
+    return m_imageIndices[row];
+}
+
+int PoseStore::objectModelIndex(int row) const {
+    return m_objectModelIndices[row];
+}
@@ -0,0 +1,79 @@
+#ifndef POSESTORE_H
+#define POSESTORE_H
+
+#include "poseid.hpp"
+
+#include <QQuaternion>
+#include <QSet>
+#include <QVector>
+#include <QVector3D>
+
+/*!
+ * \brief The PoseStore class holds the values of many poses in flat arrays instead of one
+ * QObject per pose. The image and object model of a pose are stored as indices into the
+ * lists of the model manager, which makes a pose take only a few dozen bytes.
+ *
+ * The model manager creates Pose objects from the rows on demand, i.e. only for the poses
+ * that are actually displayed or edited.
+ */
+class PoseStore {
+
+public:
+    PoseStore();
+
+    int size() const;
+    bool isEmpty() const;
+    void clear();
+    void reserve(int size);
+    //! Releases the memory reserved for poses that were removed or never added
+    void squeeze();
+    //! The bytes the arrays of the store take, including reserved ones
+    qint64 memoryUsage() const;
+
+    /*!
+     * \brief append adds a pose to the end of the store.
+     * \return the row of the new pose
+     */
+    int append(const PoseId &id,
+               const QVector3D &position,
+               const QQuaternion &rotation,
+               int imageIndex,
+               int objectModelIndex);
+    //! Appends all poses of the other store, their indices have to refer to the same lists
+    void append(const PoseStore &other);
+
+    //! Removes the pose at the given row, all following rows move up by one
+    void removeAt(int row);
+    //! Removes all poses that belong to one of the images with the given indices
+    void removeRowsOfImages(const QSet<int> &imageIndices);
+
+    /*!
+     * \brief remapImageIndices updates the image indices after the list of images changed.
+     * \param mapping the new index for every old index, poses of images mapped to -1 are
+     * removed
+     */
+    void remapImageIndices(const QVector<int> &mapping);
+    //! Same as remapImageIndices for the object models
+    void remapObjectModelIndices(const QVector<int> &mapping);
+
+    void setPose(int row, const QVector3D &position, const QQuaternion &rotation);
+
+    PoseId id(int row) const;
+    QVector3D position(int row) const;
+    QQuaternion rotation(int row) const;
+    int imageIndex(int row) const;
+    int objectModelIndex(int row) const;
+
+private:
+    //! Removes all rows that are not flagged, keeping the order of the remaining ones
+    void keepRows(const QVector<bool> &keep);
+
+private:
+    QVector<PoseId> m_ids;
+    QVector<QVector3D> m_positions;
+    QVector<QQuaternion> m_rotations;
+    QVector<qint32> m_imageIndices;
+    QVector<qint32> m_objectModelIndices;
+};
+
+#endif // POSESTORE_H
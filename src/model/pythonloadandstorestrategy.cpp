@@ -1,289 +1,477 @@
 #include "pythonloadandstorestrategy.hpp"
+#include "pythonscriptdata.hpp"
 #include "misc/generalhelper.hpp"
 #include "misc/global.hpp"
+#include "misc/tracing.hpp"
 
 #include <Python.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/embed.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <QAbstractEventDispatcher>
+#include <QDir>
 #include <QFileInfo>
 #include <QList>
-#include <QElapsedTimer>
-
-const char * KEY_LOAD_IMAGES = "load_images";
-const char * KEY_LOAD_OBJECT_MODELS = "load_object_models";
-const char * KEY_LOAD_POSES = "load_poses";
-const char * KEY_PERSIST_POSE = "persist_pose";
-const char * KEY_IMG_ID = "img_id";
-const char * KEY_IMG_PATH = "img_path";
-const char * KEY_BASE_PATH = "base_path";
-const char * KEY_SEGMENTATION_IMAGE_PATH = "segmentation_image_path";
-const char * KEY_NEAR_PLANE = "near_plane";
-const char * KEY_FAR_PLANE = "far_plane";
-const char * KEY_OBJ_ID = "obj_id";
-const char * KEY_OBJ_MODEL_PATH = "obj_model_path";
-const char * KEY_K = "K";
-const char * KEY_R = "R";
-const char * KEY_T = "t";
-const char * KEY_POSE_ID = "pose_id";
+#include <QVector>
 
-PythonLoadAndStoreStrategy::PythonLoadAndStoreStrategy() {
-    py::initialize_interpreter();
-    m_sys  = py::module::import("sys");
-}
+#include <cstring>
+#include <vector>
 
-PythonLoadAndStoreStrategy::~PythonLoadAndStoreStrategy() {
-    // Necessary to avoid crashes
-    m_script.dec_ref();
-    py::finalize_interpreter();
-}
+using namespace PythonScriptData;
 
-void PythonLoadAndStoreStrategy::applySettings(SettingsPtr settings) {
-    m_loadSaveScript = settings->loadSaveScriptPath();
-    QFileInfo fileInfo(m_loadSaveScript);
-    if (m_scriptInitialized) {
-        // Remove inserted path
-        //sys.attr("path").attr("remove")(0);
+namespace {
+
+/*!
+ * \brief readFloatArray copies the values of a NumPy array into values with one memcpy
+ * through the buffer protocol. Float64 arrays in C order are copied from their own
+ * buffer, all others are converted in one go by NumPy first instead of element by element.
+ * \return false if the array is not numeric
+ */
+bool readFloatArray(const py::handle &item, QVector<double> &values) {
+    auto array = py::array_t<double, py::array::c_style | py::array::forcecast>::ensure(item);
+    if (!array) {
+        PyErr_Clear();
+        return false;
     }
-    try {
-        QString dirname = fileInfo.dir().absolutePath();
-        m_sys.attr("path").attr("insert")(0, dirname.toUtf8().data());
-        QString filename = fileInfo.fileName();
-        if (m_scriptInitialized) {
-            m_script.reload();
-        } else {
-            m_script = py::module::import(filename.mid(0, filename.length() - 3).toUtf8().data());
+    values.resize((int) array.size());
+    std::memcpy(values.data(), array.data(), array.size() * sizeof(double));
+    return true;
+}
+
+/*!
+ * \brief fromPython converts the return values of the script to the QVariants the
+ * conversions of PythonScriptData work with, i.e. the same as the worker processes send.
+ * Numeric NumPy arrays become QVector<double> and NumPy scalars the matching plain type,
+ * unsupported objects become invalid.
+ */
+QVariant fromPython(const py::handle &item) {
+    if (item.is_none()) {
+        return QVariant();
+    } else if (py::isinstance<py::bool_>(item)) {
+        // Before int, bool is a subclass of it
+        return QVariant(item.cast<bool>());
+    } else if (py::isinstance<py::int_>(item)) {
+        return QVariant((qint64) item.cast<long long>());
+    } else if (py::isinstance<py::float_>(item)) {
+        return QVariant(item.cast<double>());
+    } else if (py::isinstance<py::str>(item)) {
+        return QString::fromStdString(item.cast<std::string>());
+    } else if (py::isinstance<py::array>(item)) {
+        QVector<double> values;
+        if (!readFloatArray(item, values)) {
+            return QVariant();
         }
-        m_scriptInitialized = true;
-    } catch (py::error_already_set &e) {
-        m_scriptInitialized = false;
-        QString message = "Failed to load the requested Pyton script: ";
-        message += QString::fromUtf8(e.what());
-        Q_EMIT error(tr(message.toStdString().c_str()));
+        return QVariant::fromValue(values);
+    } else if (py::isinstance<py::list>(item) || py::isinstance<py::tuple>(item)) {
+        QVariantList list;
+        for (auto element : item) {
+            list.append(fromPython(element));
+        }
+        return list;
+    } else if (py::isinstance<py::dict>(item)) {
+        QVariantMap map;
+        for (auto element : py::reinterpret_borrow<py::dict>(item)) {
+            map.insert(QString::fromStdString(py::str(element.first).cast<std::string>()),
+                       fromPython(element.second));
+        }
+        return map;
+    } else if (py::hasattr(item, "dtype") && py::hasattr(item, "item")) {
+        // NumPy scalars like np.int64 or np.float32 are no ints or floats for Python,
+        // item() converts them. Checked last to keep the common types fast.
+        return fromPython(item.attr("item")());
     }
-    LoadAndStoreStrategy::applySettings(settings);
+    return QVariant();
 }
 
-bool PythonLoadAndStoreStrategy::extractPath(py::dict &dict, const char *key,
-                                             QString &toSet, const QString &type,
-                                             const QString &identifier,
-                                             QList<QString> &invalidData,
-                                             bool required) {
-    if (dict.contains(key)) {
-        py::object pathItem = dict[key];
-        if (py::isinstance<py::str>(pathItem)) {
-            toSet = QString::fromStdString(
-                        dict[key].cast<std::string>());
-            return true;
-        } else {
-            qDebug() << "\'" + QString::fromStdString(key) + "\'" + " in return dict but is"
-                        " not a string (" + identifier + "). Skipping " + type + ".";
-            invalidData.append(identifier);
-            return false;
+//! The reverse of fromPython for the arguments passed to the script
+py::object toPython(const QVariant &value) {
+    switch (value.userType()) {
+    case QMetaType::Bool:
+        return py::bool_(value.toBool());
+    case QMetaType::Double:
+        return py::float_(value.toDouble());
+    case QMetaType::QString:
+        return py::str(value.toString().toStdString());
+    case QMetaType::QVariantList: {
+        py::list list;
+        for (const QVariant &item : value.toList()) {
+            list.append(toPython(item));
         }
-    } else if (!required) {
-        return true;
-    } else {
-        qDebug() << "\'" + QString::fromStdString(key) + "\'" + " not in return dict but is "
-                    "required (ID: " + identifier + "). Skipping image.";
-        m_imagesWithInvalidData.append(identifier);
-        return false;
+        return list;
+    }
+    default:
+        return py::none();
     }
 }
 
-bool PythonLoadAndStoreStrategy::extractID(py::dict &dict, const char *key,
-                                           QString &toSet, const QString &type,
-                                           const int defaultID) {
-    if (dict.contains(key)) {
-        py::object imageIDItem = dict[key];
-        // image_id can be a string or an int
-        if (py::isinstance<py::str>(imageIDItem)) {
-            toSet = QString::fromStdString(dict[key].cast<std::string>());
-        } else if (py::isinstance<py::int_>(imageIDItem)) {
-            toSet = QString::number(dict[key].cast<int>());
-        } else {
-            qDebug() << "\'" + QString::fromStdString(key) + "\'" + " in return dict but is neither "
-                        "string nor int (Index: " + QString::number(defaultID) + ")."
-                        " Skipping " + type + ".";
-            m_imagesWithInvalidData.append(QString::number(defaultID));
-            return false;
+/*!
+ * \brief The StructuredArrayReader class reads the records of a one-dimensional NumPy
+ * structured array (e.g. with dtype [('img_id', 'i4'), ('R', 'f8', (3, 3)), ...]) directly
+ * from its memory. This way loading hundreds of thousands of entries does not involve
+ * a single Python call per entry.
+ */
+class StructuredArrayReader {
+
+public:
+    explicit StructuredArrayReader(const py::array &array)
+        : m_array(array) {
+        py::object fields = array.dtype().attr("fields");
+        if (array.ndim() != 1 || fields.is_none()) {
+            return;
+        }
+        m_data = static_cast<const char*>(array.data());
+        m_stride = array.strides(0);
+        m_size = array.shape(0);
+        for (auto item : py::dict(fields)) {
+            py::tuple description = py::reinterpret_borrow<py::tuple>(item.second);
+            py::dtype type = py::reinterpret_borrow<py::dtype>(description[0]);
+            Field field;
+            field.offset = description[1].cast<ssize_t>();
+            field.count = 1;
+            py::object subarray = type.attr("subdtype");
+            if (!subarray.is_none()) {
+                // Sub-arrays like ('R', 'f8', (3, 3)), the values are stored inline
+                py::tuple subarrayDescription = py::reinterpret_borrow<py::tuple>(subarray);
+                type = py::reinterpret_borrow<py::dtype>(subarrayDescription[0]);
+                for (auto dimension : py::tuple(subarrayDescription[1])) {
+                    field.count *= dimension.cast<ssize_t>();
+                }
+            }
+            field.kind = type.kind();
+            field.itemSize = type.itemsize();
+            if (type.attr("byteorder").cast<std::string>() == ">") {
+                qDebug() << "Ignoring big endian field" << QString::fromStdString(item.first.cast<std::string>())
+                         << "of structured array.";
+                continue;
+            }
+            m_fields[QString::fromStdString(item.first.cast<std::string>())] = field;
         }
-    } else {
-        // If we don't find any ID simply use the index
-        toSet = QString::number(defaultID);
+        m_valid = true;
+    }
+
+    bool isValid() const {
+        return m_valid;
     }
-    return true;
-}
 
+    ssize_t size() const {
+        return m_size;
+    }
 
+    bool hasField(const char *name) const {
+        return m_fields.contains(name);
+    }
 
-template<class T>
-bool PythonLoadAndStoreStrategy::extractIDOrPathAndRetrieve(pybind11::dict &dict, const char *id_key,
-                                                            const char *path_key, int i, int j,
-                                                            T &itemToSet, QList<QString> &invalidData,
-                                                            QMap<QString, T> itemsForID,
-                                                            QMap<QString, T> itemsForPath,
-                                                            const QString &type) {
-    if (dict.contains(id_key)) {
-        py::object idItem = dict[id_key];
-        py::isinstance<py::int_>(idItem);
-        QString id;
-        if (py::isinstance<py::int_>(idItem)) {
-            id = QString::number(idItem.cast<int>());
-        } else if (py::isinstance<py::str>(idItem)) {
-            id = QString::fromStdString(idItem.cast<std::string>());
-        } else {
-            qDebug() << "\'img_id\' in return dict but is neither "
-                        "string nor int (Index: "  + QString::number(i) + ", " +
-                        QString::number(j) + "). Skipping " + type + ".";
-            invalidData.append(QString::number(i) + ", " +
-                                          QString::number(j));
+    bool readFloats(const char *name, ssize_t index, float *values, ssize_t count) const {
+        if (!m_fields.contains(name)) {
             return false;
         }
-        if (itemsForID.contains(id)) {
-            itemToSet = itemsForID[id];
-            return true;
-        } else {
-            qDebug() << "The specified image " + id + " "
-                        "could not be found. Skipping " + type + ".";
-            invalidData.append(QString::number(i) + ", " +
-                                          QString::number(j));
+        const Field &field = m_fields[name];
+        if (field.kind != 'f' || field.count != count) {
             return false;
         }
-    } else if (dict.contains(path_key)) {
-        py::object pathItem = dict[path_key];
-        if (py::isinstance<py::str>(pathItem)) {
-            QString path = QString::fromStdString(pathItem.cast<std::string>());
-            if (itemsForPath.contains(path)) {
-                itemToSet = itemsForPath[path];
-                return true;
+        const char *data = m_data + index * m_stride + field.offset;
+        // Records are packed by default, i.e. the values might not be aligned
+        for (ssize_t i = 0; i < count; i++) {
+            if (field.itemSize == 4) {
+                std::memcpy(&values[i], data + i * 4, 4);
+            } else if (field.itemSize == 8) {
+                double value;
+                std::memcpy(&value, data + i * 8, 8);
+                values[i] = (float) value;
             } else {
-                qDebug() << "The specified image " + path + " "
-                            "could not be found. Skipping " + type + ".";
-                invalidData.append(QString::number(i) + ", " +
-                                              QString::number(j));
                 return false;
             }
-        } else {
-            qDebug() << "\'img_path\' in return dict but is neither "
-                        "string nor int (Index: "  + QString::number(i) + ", " +
-                        QString::number(j) + "). Skipping " + type + ".";
-            invalidData.append(QString::number(i) + ", " +
-                                          QString::number(j));
-            return false;
         }
-    } else {
-        qDebug() << "The return dict for the pose contains neither "
-                    "\'img_id\' nor \'img_path\' but one needs to be present "
-                    "(Index: "  + QString::number(i) + ", " + QString::number(j) +  "). Skipping " + type + ".";
-        invalidData.append(QString::number(i) + ", " + QString::number(j));
-        return false;
+        return true;
     }
-}
 
-bool PythonLoadAndStoreStrategy::extract3x3Matrix(py::dict &dict, const char *key,
-                                                  QMatrix3x3 &toSet, const QString &parentType,
-                                                  const QString &name,
-                                                  const QString &identifier,
-                                                  QList<QString> &invalidData) {
-    if (dict.contains(key)) {
-        py::object item = dict[key];
-        if (py::isinstance<py::list>(item)) {
-            py::list list = py::list(item);
-            int size = list.size();
-            if (size == 9) {
-                float converted[9];
-                for (int j = 0; j < size; j++) {
-                    if (py::isinstance<py::float_>(list[j])) {
-                        converted[j] = list[j].cast<float>();
-                    } else {
-                        qDebug() << name + "contains non-float values "
-                                    "(" + identifier + "). Skipping " + parentType + ".";
-                        invalidData.append(identifier);
-                        return false;
-                    }
-                }
-                toSet = QMatrix3x3(converted);
-                return true;
+    bool readFloat(const char *name, ssize_t index, float &value) const {
+        return readFloats(name, index, &value, 1);
+    }
+
+    /*!
+     * \brief readString reads string fields (unicode or bytes) and integer fields, the
+     * latter because IDs can be both.
+     */
+    bool readString(const char *name, ssize_t index, QString &value) const {
+        if (!m_fields.contains(name)) {
+            return false;
+        }
+        const Field &field = m_fields[name];
+        if (field.count != 1) {
+            return false;
+        }
+        const char *data = m_data + index * m_stride + field.offset;
+        if (field.kind == 'U') {
+            // Fixed length UCS4, padded with zeros
+            int length = 0;
+            int maximumLength = (int) (field.itemSize / 4);
+            std::vector<uint> characters(maximumLength);
+            std::memcpy(characters.data(), data, field.itemSize);
+            while (length < maximumLength && characters[length] != 0) {
+                length++;
+            }
+            value = QString::fromUcs4(characters.data(), length);
+            return true;
+        } else if (field.kind == 'S') {
+            value = QString::fromUtf8(data, (int) qstrnlen(data, (uint) field.itemSize));
+            return true;
+        } else if (field.kind == 'i' || field.kind == 'u') {
+            qint64 number = 0;
+            if (field.itemSize == 1) {
+                number = field.kind == 'i' ? *reinterpret_cast<const qint8*>(data)
+                                           : *reinterpret_cast<const quint8*>(data);
+            } else if (field.itemSize == 2) {
+                qint16 signedValue; quint16 unsignedValue;
+                std::memcpy(&signedValue, data, 2);
+                std::memcpy(&unsignedValue, data, 2);
+                number = field.kind == 'i' ? signedValue : unsignedValue;
+            } else if (field.itemSize == 4) {
+                qint32 signedValue; quint32 unsignedValue;
+                std::memcpy(&signedValue, data, 4);
+                std::memcpy(&unsignedValue, data, 4);
+                number = field.kind == 'i' ? (qint64) signedValue : (qint64) unsignedValue;
+            } else if (field.itemSize == 8) {
+                std::memcpy(&number, data, 8);
             } else {
-                qDebug() << name + " is not a 3x3 matrix "
-                            "(doesn't contain 9 entries)  (" + identifier + "). "
-                            "Skipping " + parentType + ".";
-                invalidData.append(identifier);
                 return false;
             }
-        } else {
-            qDebug() << name + " is not a list of floats "
-                        "(" + identifier + "). Skipping " + parentType + ".";
-            invalidData.append(identifier);
-            return false;
+            value = QString::number(number);
+            return true;
         }
-    } else {
-        qDebug() << name + " \"" + key + "\" not in return dict "
-                    "(" + identifier + "). Skipping " + parentType + ".";
-        invalidData.append(identifier);
         return false;
     }
+
+private:
+    struct Field {
+        ssize_t offset;
+        char kind;
+        ssize_t itemSize;
+        ssize_t count;
+    };
+
+    // Keeps the memory alive
+    py::array m_array;
+    bool m_valid = false;
+    const char *m_data = Q_NULLPTR;
+    ssize_t m_stride = 0;
+    ssize_t m_size = 0;
+    QMap<QString, Field> m_fields;
+};
+
 }
 
-bool PythonLoadAndStoreStrategy::extract3DVector(py::dict &dict, const char *key,
-                                               QVector3D &toSet, const QString &parentType,
-                                                 const QString &name,
-                                               const QString &identifier,
-                                               QList<QString> &invalidData) {
-    if (dict.contains(key)) {
-        py::object tItem = dict[key];
-        if (py::isinstance<py::list>(tItem)) {
-            py::list t = py::list(tItem);
-            int tSize = t.size();
-            if (tSize == 3) {
-                float tConverted[3];
-                for (int j = 0; j < tSize; j++) {
-                    if (py::isinstance<py::float_>(t[j])) {
-                        tConverted[j] = t[j].cast<float>();
-                    } else {
-                        qDebug() << "Translation vector contains non-float values "
-                                    "(ID:" << identifier << "). Skipping " + parentType + ".";
-                        invalidData.append(identifier);
-                        continue;
-                    }
-                }
-                toSet = QVector3D(tConverted[0],
-                                  tConverted[1],
-                                  tConverted[2]);
-                return true;
+PythonLoadAndStoreStrategy::PythonLoadAndStoreStrategy() {
+    // The interpreter is only started when the strategy is used for the first
+    // time (see ensureScriptLoaded), most users never need it
+}
+
+PythonLoadAndStoreStrategy::~PythonLoadAndStoreStrategy() {
+    if (!m_interpreterInitialized) {
+        return;
+    }
+    if (m_interpreterThread == QThread::currentThread()) {
+        finalizeInterpreter();
+    } else if (m_interpreterThread->isRunning()) {
+        // The interpreter has to be finalized by the thread that initialized it, that's
+        // usually the model manager thread while the strategy is destroyed by the GUI thread
+        QMetaObject::invokeMethod(m_interpreterThread->eventDispatcher(),
+                                  [this]() { finalizeInterpreter(); },
+                                  Qt::BlockingQueuedConnection);
+    }
+    // Otherwise the thread is gone already and the interpreter is left to the OS on exit,
+    // finalizing it from here would crash
+}
+
+void PythonLoadAndStoreStrategy::finalizeInterpreter() {
+    PyGILState_Ensure();
+    // Release the modules before the interpreter is gone, necessary to avoid crashes
+    m_script = py::module();
+    m_sys = py::module();
+    py::finalize_interpreter();
+    m_interpreterInitialized = false;
+}
+
+void PythonLoadAndStoreStrategy::applySettings(SettingsPtr settings) {
+    {
+        QMutexLocker locker(&m_scriptMutex);
+        // Applying the settings again after editing the script reloads it
+        if (m_loadSaveScript != settings->loadSaveScriptPath() || !m_scriptInitialized
+                || QFileInfo(settings->loadSaveScriptPath()).lastModified() != m_loadedScriptLastModified) {
+            // Only remember to (re)load the script, applying the settings happens
+            // on startup and must not start the interpreter
+            m_loadSaveScript = settings->loadSaveScriptPath();
+            m_scriptNeedsLoading = true;
+        }
+    }
+    LoadAndStoreStrategy::applySettings(settings);
+}
+
+void PythonLoadAndStoreStrategy::warmUp() {
+    TRACE_SCOPE("load", "PythonLoadAndStoreStrategy::warmUp");
+    ensureScriptLoaded();
+}
+
+bool PythonLoadAndStoreStrategy::ensureScriptLoaded() {
+    QMutexLocker locker(&m_scriptMutex);
+    if (!m_interpreterInitialized) {
+        TRACE_SCOPE("load", "PythonLoadAndStoreStrategy::initializeInterpreter");
+        try {
+            py::initialize_interpreter();
+            m_sys = py::module::import("sys");
+        } catch (std::exception &e) {
+            QString message = "Failed to initialize the Python interpreter: ";
+            message += QString::fromUtf8(e.what());
+            Q_EMIT error(tr(message.toStdString().c_str()));
+            return false;
+        }
+        // The strategy is used from the model manager thread and the GUI thread,
+        // every call acquires the GIL for itself
+        PyEval_SaveThread();
+        m_interpreterInitialized = true;
+        m_interpreterThread = QThread::currentThread();
+    }
+    if (m_scriptNeedsLoading) {
+        m_scriptNeedsLoading = false;
+        py::gil_scoped_acquire gil;
+        QFileInfo fileInfo(m_loadSaveScript);
+        m_loadedScriptLastModified = fileInfo.lastModified();
+        try {
+            QString dirname = fileInfo.dir().absolutePath();
+            m_sys.attr("path").attr("insert")(0, dirname.toUtf8().data());
+            QString filename = fileInfo.fileName();
+            if (m_scriptInitialized) {
+                m_script.reload();
             } else {
-                qDebug() << name + " does not contain exactly 3 floats "
-                            "(ID:" << identifier << "). Skipping " + parentType + ".";
-                invalidData.append(identifier);
-                return false;
+                m_script = py::module::import(filename.mid(0, filename.length() - 3).toUtf8().data());
             }
-        } else {
-            qDebug() << "Return value is not a list of floats "
-                        "(ID:" << identifier << "). Skipping " + parentType + ".";
-            invalidData.append(identifier);
-            return false;
+            m_scriptInitialized = true;
+        } catch (py::error_already_set &e) {
+            m_scriptInitialized = false;
+            QString message = "Failed to load the requested Pyton script: ";
+            message += QString::fromUtf8(e.what());
+            Q_EMIT error(tr(message.toStdString().c_str()));
         }
-    } else {
-        qDebug() << name + " \"" + key + "\" not in return dict"
-                    " (ID:" << identifier << "). Skipping " + parentType + ".";
-        invalidData.append(identifier);
-        return false;
     }
+    return m_scriptInitialized;
+}
 
+QList<ImagePtr> PythonLoadAndStoreStrategy::loadImagesFromArray(const py::array &array) {
+    QList<ImagePtr> images;
+    StructuredArrayReader reader(array);
+    if (!reader.isValid()) {
+        Q_EMIT error(tr("Failed to load images. The returned array is not a "
+                        "one-dimensional structured array."));
+        return images;
+    }
+    const bool hasCameraExtrinsics = reader.hasField(KEY_CAM_R_W2C) && reader.hasField(KEY_CAM_T_W2C);
+    images.reserve((int) reader.size());
+    for (ssize_t i = 0; i < reader.size(); i++) {
+        QString imageID, imagePath, basePath, depthImagePath;
+        float cameraMatrix[9];
+        if (!reader.readString(KEY_IMG_ID, i, imageID)) {
+            // Like for dicts the index is the fallback
+            imageID = QString::number(i);
+        }
+        if (!reader.readString(KEY_IMG_PATH, i, imagePath)
+                || !reader.readString(KEY_BASE_PATH, i, basePath)
+                || !reader.readFloats(KEY_K, i, cameraMatrix, 9)) {
+            qDebug() << "Image" << imageID << "is missing the image path, base path or a "
+                        "valid camera matrix. Skipping image.";
+            m_imagesWithInvalidData.append(imageID);
+            continue;
+        }
+        float nearPlane = NEAR_PLANE;
+        float farPlane = FAR_PLANE;
+        reader.readFloat(KEY_NEAR_PLANE, i, nearPlane);
+        reader.readFloat(KEY_FAR_PLANE, i, farPlane);
+        ImagePtr image(new Image(imageID, imagePath, basePath,
+                                 QMatrix3x3(cameraMatrix), nearPlane, farPlane));
+        if (reader.readString(KEY_DEPTH_IMAGE_PATH, i, depthImagePath) && !depthImagePath.isEmpty()) {
+            float depthScale = 1.f;
+            reader.readFloat(KEY_DEPTH_SCALE, i, depthScale);
+            image->setDepthImage(QDir(basePath).absoluteFilePath(depthImagePath), depthScale);
+        }
+        if (hasCameraExtrinsics) {
+            float cameraRotation[9];
+            float cameraTranslation[3];
+            if (reader.readFloats(KEY_CAM_R_W2C, i, cameraRotation, 9)
+                    && reader.readFloats(KEY_CAM_T_W2C, i, cameraTranslation, 3)) {
+                image->setCameraExtrinsics(QMatrix3x3(cameraRotation),
+                                           QVector3D(cameraTranslation[0],
+                                                     cameraTranslation[1],
+                                                     cameraTranslation[2]));
+            }
+        }
+        QString sceneId;
+        if (reader.readString(KEY_SCENE_ID, i, sceneId)) {
+            image->setSceneId(sceneId);
+        }
+        images.append(image);
+    }
+    return images;
 }
 
-bool PythonLoadAndStoreStrategy::extractFloat(py::dict &dict, const char *key,
-                                              float &toSet, float defaultValue) {
-    if (dict.contains(key)) {
-        toSet = dict[key].cast<float>();
-    } else {
-        toSet = defaultValue;
+QList<PosePtr> PythonLoadAndStoreStrategy::loadPosesFromArray(const py::array &array,
+                                                              const QMap<QString, ImagePtr> &imagesForID,
+                                                              const QMap<QString, ImagePtr> &imagesForPath,
+                                                              const QMap<QString, ObjectModelPtr> &objectModelsForID,
+                                                              const QMap<QString, ObjectModelPtr> &objectModelsForPath) {
+    QList<PosePtr> poses;
+    StructuredArrayReader reader(array);
+    if (!reader.isValid()) {
+        Q_EMIT error(tr("Failed to load poses. The returned array is not a "
+                        "one-dimensional structured array."));
+        return poses;
     }
-    return true;
+    // Decide once which fields identify images and object models instead of for every pose
+    const bool imagesByID = reader.hasField(KEY_IMG_ID);
+    const bool objectModelsByID = reader.hasField(KEY_OBJ_ID);
+    if ((!imagesByID && !reader.hasField(KEY_IMG_PATH))
+            || (!objectModelsByID && !reader.hasField(KEY_OBJ_MODEL_PATH))) {
+        Q_EMIT error(tr("Failed to load poses. The structured array needs the fields "
+                        "img_id or img_path and obj_id or obj_model_path."));
+        return poses;
+    }
+    const bool hasPoseIDs = reader.hasField(KEY_POSE_ID);
+    poses.reserve((int) reader.size());
+    for (ssize_t i = 0; i < reader.size(); i++) {
+        QString index = QString::number(i);
+        QString imageKey, objectModelKey;
+        reader.readString(imagesByID ? KEY_IMG_ID : KEY_IMG_PATH, i, imageKey);
+        reader.readString(objectModelsByID ? KEY_OBJ_ID : KEY_OBJ_MODEL_PATH, i, objectModelKey);
+        ImagePtr image = imagesByID ? imagesForID.value(imageKey) : imagesForPath.value(imageKey);
+        ObjectModelPtr objectModel = objectModelsByID ? objectModelsForID.value(objectModelKey)
+                                                      : objectModelsForPath.value(objectModelKey);
+        if (image.isNull() || objectModel.isNull()) {
+            qDebug() << "The image" << imageKey << "or object model" << objectModelKey
+                     << "of the pose could not be found (Index:" << i << "). Skipping pose.";
+            m_posesWithInvalidData.append(index);
+            continue;
+        }
+        float rotation[9];
+        float translation[3];
+        if (!reader.readFloats(KEY_R, i, rotation, 9) || !reader.readFloats(KEY_T, i, translation, 3)) {
+            qDebug() << "The pose has no valid rotation matrix or translation vector "
+                        "(Index:" << i << "). Skipping pose.";
+            m_posesWithInvalidData.append(index);
+            continue;
+        }
+        QString poseID;
+        if (!hasPoseIDs || !reader.readString(KEY_POSE_ID, i, poseID) || poseID.isEmpty()) {
+            poseID = GeneralHelper::createPoseId();
+        }
+        poses.append(PosePtr(new Pose(poseID,
+                                      QVector3D(translation[0], translation[1], translation[2]),
+                                      QMatrix3x3(rotation),
+                                      image, objectModel)));
+    }
+    return poses;
 }
 
 QList<ImagePtr> PythonLoadAndStoreStrategy::loadImages() {
+    TRACE_SCOPE("load", "PythonLoadAndStoreStrategy::loadImages");
     QList<ImagePtr> images;
     m_imagesWithInvalidData.clear();
 
@@ -293,59 +481,21 @@ QList<ImagePtr> PythonLoadAndStoreStrategy::loadImages() {
         return images;
     }
 
-    if (!m_scriptInitialized) {
-        // There was a previous error while loading the script (see applySettings)
+    if (!ensureScriptLoaded()) {
+        // There was an error while loading the script (see ensureScriptLoaded)
         Q_EMIT error(tr("The Python script could not be loaded (see previous errors)."));
         return images;
     }
 
+    py::gil_scoped_acquire gil;
+
     try {
         py::object result = m_script.attr(KEY_LOAD_IMAGES)(m_imagesPath.toUtf8().data(), py::none());
 
-        if (py::isinstance<py::list>(result)) {
-            py::list result_list = py::list(result);
-            int length = result_list.size();
-            for (int i = 0; i < length; i++) {
-                py::object item = result_list[i];
-                if (py::isinstance<py::dict>(item)) {
-                    py::dict itemDict = py::dict(item);
-                    QString imageID, imagePath, basePath, segmentationImagePath;
-                    float nearPlane, farPlane;
-                    QMatrix3x3 cameraMatrix;
-                    if (!extractID(itemDict, KEY_IMG_ID, imageID, "image", i)) {
-                        continue;
-                    }
-                    if (!extractPath(itemDict, KEY_IMG_PATH, imagePath,
-                                     "image", imageID, m_imagesWithInvalidData,
-                                     true)) {
-                        continue;
-                    }
-                    if (!extractPath(itemDict, KEY_BASE_PATH, basePath,
-                                     "image", imageID, m_imagesWithInvalidData,
-                                     true)) {
-                        continue;
-                    }
-                    // Path is not required and extractPath returns true if
-                    // the key is not present
-                    if (!extractPath(itemDict, KEY_SEGMENTATION_IMAGE_PATH, segmentationImagePath,
-                                     "image", imageID, m_imagesWithInvalidData,
-                                     false)) {
-                        continue;
-                    }
-                    if (!extract3x3Matrix(itemDict, KEY_K, cameraMatrix, "image", "Camera matrix",
-                                          imagePath, m_imagesWithInvalidData)) {
-                        continue;
-                    }
-                    extractFloat(itemDict, KEY_NEAR_PLANE, nearPlane, NEAR_PLANE);
-                    extractFloat(itemDict, KEY_FAR_PLANE, farPlane, FAR_PLANE);
-                    images.append(ImagePtr(new Image(imageID, imagePath, basePath,
-                                                     cameraMatrix, nearPlane, farPlane)));
-                } else {
-                    qDebug() << "Return value for image is not a dict. Skipping image.";
-                    m_imagesWithInvalidData.append(QString::number(i));
-                    continue;
-                }
-            }
+        if (py::isinstance<py::array>(result)) {
+            images = loadImagesFromArray(py::reinterpret_borrow<py::array>(result));
+        } else if (py::isinstance<py::list>(result)) {
+            images = imagesFromList(fromPython(result).toList(), m_imagesWithInvalidData);
         } else if (py::isinstance<py::str>(result)) {
             QString message = "Failed to load images. "
                               "The script produced an error while "
@@ -354,7 +504,7 @@ QList<ImagePtr> PythonLoadAndStoreStrategy::loadImages() {
             Q_EMIT error(tr(message.toStdString().c_str()));
         } else {
             Q_EMIT error(tr("Failed to load images. Return value for images is "
-                            "not a list of dicts. No images were loaded."));
+                            "neither a list of dicts nor a structured array. No images were loaded."));
         }
     } catch (py::error_already_set &e) {
         QString message = "Failed to load images. The script produced "
@@ -369,6 +519,7 @@ QList<ImagePtr> PythonLoadAndStoreStrategy::loadImages() {
 }
 
 QList<ObjectModelPtr> PythonLoadAndStoreStrategy::loadObjectModels() {
+    TRACE_SCOPE("load", "PythonLoadAndStoreStrategy::loadObjectModels");
     QList<ObjectModelPtr> objectModels;
     m_objectModelsWithInvalidData.clear();
 
@@ -378,43 +529,19 @@ QList<ObjectModelPtr> PythonLoadAndStoreStrategy::loadObjectModels() {
         return objectModels;
     }
 
-    if (!m_scriptInitialized) {
-        // There was a previous error while loading the script (see applySettings)
+    if (!ensureScriptLoaded()) {
+        // There was an error while loading the script (see ensureScriptLoaded)
         Q_EMIT error(tr("The Python script could not be loaded (see previous errors)."));
         return objectModels;
     }
 
+    py::gil_scoped_acquire gil;
+
     try {
         py::object result = m_script.attr(KEY_LOAD_OBJECT_MODELS)(m_objectModelsPath.toUtf8().data());
 
         if (py::isinstance<py::list>(result)) {
-            py::list result_list = py::list(result);
-            int length = result_list.size();
-            for (int i = 0; i < length; i++) {
-                py::object item = result_list[i];
-                if (py::isinstance<py::dict>(item)) {
-                    py::dict itemDict = py::dict(item);
-                    QString objID, objectModelPath, basePath;
-                    if (!extractID(itemDict, KEY_OBJ_ID, objID, "object model", i)) {
-                        continue;
-                    }
-                    if (!extractPath(itemDict, KEY_OBJ_MODEL_PATH, objectModelPath,
-                                     "object model", objID, m_objectModelsWithInvalidData,
-                                     true)) {
-                        continue;
-                    }
-                    if (!extractPath(itemDict, KEY_BASE_PATH, basePath,
-                                     "object model", objID, m_objectModelsWithInvalidData,
-                                     true)) {
-                        continue;
-                    }
-                    objectModels.append(ObjectModelPtr(new ObjectModel(objID, objectModelPath, basePath)));
-                } else {
-                    qDebug() << "Return value for object model is not a dict. Skipping object model.";
-                    m_objectModelsWithInvalidData.append(QString::number(i));
-                    continue;
-                }
-            }
+            objectModels = objectModelsFromList(fromPython(result).toList(), m_objectModelsWithInvalidData);
         } else if (py::isinstance<py::str>(result)) {
             QString message = "Failed to load object models. "
                               "The script produced an error while "
@@ -440,44 +567,26 @@ QList<ObjectModelPtr> PythonLoadAndStoreStrategy::loadObjectModels() {
 }
 
 bool PythonLoadAndStoreStrategy::persistPose(const Pose &objectImagePose, bool deletePose) {
+    TRACE_SCOPE_DETAIL("save", "PythonLoadAndStoreStrategy::persistPose", objectImagePose.id());
     QFileInfo fileInfo(m_loadSaveScript);
     if (!fileInfo.exists()) {
         Q_EMIT error(tr("The script does not exist."));
         return false;
     }
 
-    if (!m_scriptInitialized) {
-        // There was a previous error while loading the script (see applySettings)
+    if (!ensureScriptLoaded()) {
+        // There was an error while loading the script (see ensureScriptLoaded)
         Q_EMIT error(tr("The Python script could not be loaded (see previous errors)."));
         return false;
     }
 
-    try {
-        QString poseIdD = objectImagePose.id();
-        QString imageID = objectImagePose.image()->id();
-        QString objID = objectImagePose.objectModel()->id();
-        QString imagePath = objectImagePose.image()->imagePath();
-        QString objectModelPath = objectImagePose.objectModel()->path();
-        py::list rotation;
-        // Transposed because QMatrix3x3 transposes it when loading from the float array
-        const float* rotationValues = objectImagePose.rotation().toRotationMatrix().transposed().constData();
-        for (int i = 0; i < 9; i++) {
-            rotation.append(rotationValues[i]);
-        }
-        py::list translation;
-        for (int i = 0; i < 3; i++) {
-            translation.append(objectImagePose.position()[0]);
+    py::gil_scoped_acquire gil;
 
-        }
-        py::object result = m_script.attr(KEY_PERSIST_POSE)(m_posesFilePath.toStdString(),
-                                                            poseIdD.toStdString(),
-                                                            imageID.toStdString(),
-                                                            imagePath.toStdString(),
-                                                            objID.toStdString(),
-                                                            objectModelPath.toStdString(),
-                                                            rotation,
-                                                            translation,
-                                                            deletePose);
+    try {
+        py::tuple arguments = py::tuple(toPython(persistPoseArguments(m_posesFilePath,
+                                                                      objectImagePose,
+                                                                      deletePose)));
+        py::object result = m_script.attr(KEY_PERSIST_POSE)(*arguments);
         if (py::isinstance<py::bool_>(result)) {
             return result.cast<bool>();
         } else if (py::isinstance<py::str>(result)) {
@@ -502,6 +611,7 @@ bool PythonLoadAndStoreStrategy::persistPose(const Pose &objectImagePose, bool d
 
 QList<PosePtr> PythonLoadAndStoreStrategy::loadPoses(const QList<ImagePtr> &images,
                                                      const QList<ObjectModelPtr> &objectModels) {
+    TRACE_SCOPE("load", "PythonLoadAndStoreStrategy::loadPoses");
     QList<PosePtr> poses;
     m_posesWithInvalidData.clear();
 
@@ -511,12 +621,14 @@ QList<PosePtr> PythonLoadAndStoreStrategy::loadPoses(const QList<ImagePtr> &imag
         return poses;
     }
 
-    if (!m_scriptInitialized) {
-        // There was a previous error while loading the script (see applySettings)
+    if (!ensureScriptLoaded()) {
+        // There was an error while loading the script (see ensureScriptLoaded)
         Q_EMIT error(tr("The Python script could not be loaded (see previous errors)."));
         return poses;
     }
 
+    py::gil_scoped_acquire gil;
+
     // For faster lookup by ID
     QMap<QString, ImagePtr> imagesForID;
     QMap<QString, ImagePtr> imagesForPath;
@@ -540,70 +652,13 @@ QList<PosePtr> PythonLoadAndStoreStrategy::loadPoses(const QList<ImagePtr> &imag
     try {
         py::object result = m_script.attr(KEY_LOAD_POSES)(m_posesFilePath.toUtf8().data());
 
-        if (py::isinstance<py::list>(result)) {
-            py::list result_list = py::list(result);
-            int length = result_list.size();
-            for (int i = 0; i < length; i++) {
-                py::object itemPosesForImages = result_list[i];
-                if (py::isinstance<py::list>(itemPosesForImages)) {
-                    py::list listPosesForImages = py::list(itemPosesForImages);
-                    int length = listPosesForImages.size();
-                    for (int j = 0; j < length; j++) {
-                        if (py::isinstance<py::dict>(listPosesForImages[j])) {
-                            py::dict poseDict = py::dict(listPosesForImages[j]);
-                            QString poseID;
-                            ImagePtr image;
-                            ObjectModelPtr objectModel;
-                            QMatrix3x3 rotation;
-                            QVector3D translation;
-                            if (!extractIDOrPathAndRetrieve(poseDict, KEY_IMG_ID, KEY_IMG_PATH,
-                                                            i, j, image, m_posesWithInvalidData,
-                                                            imagesForID, imagesForPath, "pose")) {
-                                continue;
-                            }
-                            if (!extractIDOrPathAndRetrieve(poseDict, KEY_OBJ_ID, KEY_OBJ_MODEL_PATH,
-                                                            i, j, objectModel, m_posesWithInvalidData,
-                                                            objectModelsForID, objectModelsForPath, "pose")) {
-                                continue;
-                            }
-                            // Can only do this at the end since we need the image and object model
-                            // to create an ID if we don't receive one
-                            if (poseDict.contains(KEY_POSE_ID)) {
-                                py::object poseIDItem = poseDict[KEY_POSE_ID];
-                                if (py::isinstance<py::str>(poseIDItem)) {
-                                    poseID = QString::fromStdString(poseDict[KEY_POSE_ID].cast<std::string>());
-                                } else {
-                                    qDebug() << "\"poseID\" in return dict but is not "
-                                                "a string (Index: "  << i << ", " << j <<  "). Skipping pose.";
-                                    m_posesWithInvalidData.append(QString::number(i) + ", " +
-                                                                  QString::number(j));
-                                    continue;
-                                }
-                            } else {
-                                // No error, if no ID is present, create one
-                                poseID = GeneralHelper::createPoseId(*image, *objectModel);
-                            }
-                            // Get rotation
-                            if (!extract3x3Matrix(poseDict, KEY_R, rotation, "pose", "Rotation matrix",
-                                                  poseID, m_posesWithInvalidData)) {
-                                continue;
-                            }
-                            if (!extract3DVector(poseDict, KEY_T, translation, "pose", "Translation vector",
-                                                  poseID, m_posesWithInvalidData)) {
-                                continue;
-                            }
-                            // Get translation
-                            poses.append(PosePtr(new Pose(poseID, translation, rotation, image, objectModel)));
-                        } else {
-                            qDebug() << "Return value for pose is not "
-                                        "a dict (Index:" << i << ", " << j << "). Skipping pose.";
-                        }
-                    }
-                } else {
-                    qDebug() << "Return value of poses for image is not "
-                                "a list of dicts. Skipping image.";
-                }
-            }
+        if (py::isinstance<py::array>(result)) {
+            poses = loadPosesFromArray(py::reinterpret_borrow<py::array>(result),
+                                       imagesForID, imagesForPath,
+                                       objectModelsForID, objectModelsForPath);
+        } else if (py::isinstance<py::list>(result)) {
+            poses = posesFromList(fromPython(result).toList(), imagesForID, imagesForPath,
+                                  objectModelsForID, objectModelsForPath, m_posesWithInvalidData);
         } else if (py::isinstance<py::str>(result)) {
             QString message = "Failed to load poses. "
                               "The script produced an error while "
@@ -612,8 +667,8 @@ QList<PosePtr> PythonLoadAndStoreStrategy::loadPoses(const QList<ImagePtr> &imag
             Q_EMIT error(tr(message.toStdString().c_str()));
         } else {
             Q_EMIT error(tr("Failed to load poses. "
-                            "Return value for poses is not a list of dicts. "
-                            "No poses were loaded."));
+                            "Return value for poses is neither a list of dicts "
+                            "nor a structured array. No poses were loaded."));
         }
     } catch (py::error_already_set &e) {
         QString message = "Failed to load poses. "
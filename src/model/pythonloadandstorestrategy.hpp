@@ -4,10 +4,19 @@
 #include "model/loadandstorestrategy.hpp"
 
 #include <QObject>
+#include <QMutex>
+#include <QDateTime>
+#include <QThread>
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 
 namespace py = pybind11;
 
+/*!
+ * \brief The PythonLoadAndStoreStrategy class delegates loading and storing to a user
+ * provided Python script. The embedded interpreter is started lazily the first time
+ * the strategy is actually used, i.e. users of other strategies never pay for it.
+ */
 class PythonLoadAndStoreStrategy : public LoadAndStoreStrategy {
 
     Q_OBJECT
@@ -28,41 +37,53 @@ public:
     QList<PosePtr> loadPoses(const QList<ImagePtr> &images,
                              const QList<ObjectModelPtr> &objectModels) override;
 
+public Q_SLOTS:
+    /*!
+     * \brief warmUp starts the interpreter and loads the script ahead of time. Meant to
+     * be invoked queued on the thread of the strategy after the UI has been shown.
+     */
+    void warmUp();
+
 private:
-    bool extractPath(py::dict &dict, const char *key,
-                     QString &toSet, const QString &type,
-                     const QString &identifier,
-                     QList<QString> &invalidData,
-                     bool required);
-    bool extractID(py::dict &dict, const char *key,
-                   QString &toSet, const QString &type,
-                   const int defaultID);
-    template<class T>
-    bool extractIDOrPathAndRetrieve(py::dict &dict, const char *id_key,
-                                    const char *path_key,
-                                    int i, int j, T &itemToSet,
-                                    QList<QString> &invalidData,
-                                    QMap<QString, T> itemsForID,
-                                    QMap<QString, T> itemsForPath,
-                                    const QString &type);
-    bool extract3x3Matrix(py::dict &dict, const char *key,
-                          QMatrix3x3 &toSet, const QString &parentType,
-                          const QString &name,
-                          const QString &identifier,
-                          QList<QString> &invalidData);
-    bool extract3DVector(py::dict &dict, const char *key,
-                       QVector3D &toSet, const QString &parentType,
-                         const QString &name,
-                       const QString &identifier,
-                       QList<QString> &invalidData);
-    bool extractFloat(py::dict &dict, const char *key,
-                      float &toSet, float defaultValue);
+    /*!
+     * \brief ensureScriptLoaded starts the interpreter if necessary and (re)loads the
+     * script if the settings changed since. Thread-safe, the GIL is not held afterwards.
+     * \return true if the script is ready to be used
+     */
+    bool ensureScriptLoaded();
+    //! Must be called by the thread that initialized the interpreter
+    void finalizeInterpreter();
+
+    /*!
+     * \brief loadImagesFromArray reads images from a NumPy structured array with one record
+     * per image. The fields are named like the keys of the dicts, e.g. img_path, base_path
+     * and K (9 floats).
+     */
+    QList<ImagePtr> loadImagesFromArray(const py::array &array);
+    /*!
+     * \brief loadPosesFromArray reads poses from a NumPy structured array with one record
+     * per pose, e.g. with the fields img_id, obj_id, R (9 floats), t (3 floats) and optionally
+     * pose_id. The records are read directly from the array's memory.
+     */
+    QList<PosePtr> loadPosesFromArray(const py::array &array,
+                                      const QMap<QString, ImagePtr> &imagesForID,
+                                      const QMap<QString, ImagePtr> &imagesForPath,
+                                      const QMap<QString, ObjectModelPtr> &objectModelsForID,
+                                      const QMap<QString, ObjectModelPtr> &objectModelsForPath);
 
 private:
     QString m_loadSaveScript;
     py::module m_sys;
     py::module m_script;
     bool m_scriptInitialized = false;
+    bool m_interpreterInitialized = false;
+    bool m_scriptNeedsLoading = false;
+    //! To reload the script when the settings are applied after it has been edited
+    QDateTime m_loadedScriptLastModified;
+    //! Python wants to be finalized by the thread that initialized it
+    QThread *m_interpreterThread = Q_NULLPTR;
+    // Guards the initialization of the interpreter and the script
+    QMutex m_scriptMutex;
 };
 
 typedef QSharedPointer<PythonLoadAndStoreStrategy> PythonLoadAndStoreStrategyPtr;
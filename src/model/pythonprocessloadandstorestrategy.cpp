@@ -0,0 +1,241 @@
+#include "pythonprocessloadandstorestrategy.hpp"
+#include "pythonscriptdata.hpp"
+#include "misc/tracing.hpp"
+#include "misc/memoryaccounting.hpp"
+
+#include <QFileInfo>
+#include <QtDebug>
+
+using namespace PythonScriptData;
+
+PythonProcessLoadAndStoreStrategy::PythonProcessLoadAndStoreStrategy() {
+    // Reports come from the thread of the strategy, i.e. evicting stops the workers of
+    // that thread
+    connect(MemoryAccounting::instance(), &MemoryAccounting::budgetExceeded,
+            this, &PythonProcessLoadAndStoreStrategy::onMemoryBudgetExceeded);
+}
+
+PythonProcessLoadAndStoreStrategy::~PythonProcessLoadAndStoreStrategy() {
+    MemoryAccounting::instance()->reportUsage(MemoryAccounting::PYTHON_HEAP, 0);
+}
+
+void PythonProcessLoadAndStoreStrategy::applySettings(SettingsPtr settings) {
+    m_loadSaveScript = settings->loadSaveScriptPath();
+    m_workerPool.setScript(m_loadSaveScript);
+    const QString interpreter = settings->pythonInterpreterPath();
+    m_workerPool.setInterpreter(interpreter.isEmpty() || interpreter == Global::NO_PATH
+                                ? "python3" : interpreter);
+    LoadAndStoreStrategy::applySettings(settings);
+}
+
+bool PythonProcessLoadAndStoreStrategy::callScript(const QString &function,
+                                                   const QVariantList &arguments,
+                                                   QVariant &result,
+                                                   const QString &failure) {
+    QString errorMessage;
+    const bool called = m_workerPool.call(function, arguments, result, errorMessage);
+    reportWorkerMemory();
+    if (!called) {
+        QString message = failure + " The script produced an error: " + errorMessage;
+        Q_EMIT error(tr(message.toStdString().c_str()));
+        return false;
+    }
+    if (result.userType() == QMetaType::QString) {
+        QString message = failure + " The script produced an error: " + result.toString();
+        Q_EMIT error(tr(message.toStdString().c_str()));
+        return false;
+    }
+    return true;
+}
+
+void PythonProcessLoadAndStoreStrategy::reportWorkerMemory() {
+    qint64 bytes = 0;
+    for (qint64 processId : m_workerPool.processIdsOfCurrentThread()) {
+        bytes += qMax<qint64>(0, MemoryAccounting::processMemory(processId));
+    }
+    MemoryAccounting::instance()->reportUsage(MemoryAccounting::PYTHON_HEAP, bytes);
+}
+
+void PythonProcessLoadAndStoreStrategy::onMemoryBudgetExceeded(const QString &subsystem,
+                                                               qint64 bytesToFree) {
+    Q_UNUSED(bytesToFree)
+    if (subsystem != MemoryAccounting::PYTHON_HEAP) {
+        return;
+    }
+    // The heaps of the workers can't be trimmed from the outside but the workers only
+    // hold the script's state between calls and get started again on the next one
+    m_workerPool.stopWorkersOfCurrentThread();
+    reportWorkerMemory();
+}
+
+QVariant PythonProcessLoadAndStoreStrategy::loadImagesSharded(bool &success) {
+    const QVariantList commonArguments({m_imagesPath, pathOrNone(m_segmentationImagesPath)});
+    QVariant shards;
+    success = callScript(KEY_LIST_IMAGE_SHARDS, commonArguments, shards, "Failed to load images.");
+    if (!success) {
+        return QVariant();
+    }
+    QList<QVariantList> argumentLists;
+    for (const QVariant &shard : shards.toList()) {
+        argumentLists.append(QVariantList(commonArguments) << shard);
+    }
+    QVariantList results;
+    QString errorMessage;
+    success = m_workerPool.callParallel(KEY_LOAD_IMAGES_SHARD, argumentLists, results, errorMessage);
+    reportWorkerMemory();
+    if (!success) {
+        QString message = "Failed to load images. The script produced an error: " + errorMessage;
+        Q_EMIT error(tr(message.toStdString().c_str()));
+        return QVariant();
+    }
+    // Concatenated in the order of the shards, i.e. the images have the same order as
+    // if they had been loaded in one go
+    QVariantList images;
+    for (const QVariant &result : results) {
+        if (result.userType() == QMetaType::QString) {
+            QString message = "Failed to load images. The script produced an error: " + result.toString();
+            Q_EMIT error(tr(message.toStdString().c_str()));
+            success = false;
+            return QVariant();
+        }
+        images += result.toList();
+    }
+    return images;
+}
+
+QList<ImagePtr> PythonProcessLoadAndStoreStrategy::loadImages() {
+    TRACE_SCOPE("load", "PythonProcessLoadAndStoreStrategy::loadImages");
+    QList<ImagePtr> images;
+    m_imagesWithInvalidData.clear();
+
+    if (!QFileInfo(m_loadSaveScript).exists()) {
+        Q_EMIT error(tr("The script does not exist."));
+        return images;
+    }
+
+    QVariant result;
+    bool success;
+    if (m_workerPool.hasFunction(KEY_LIST_IMAGE_SHARDS)
+            && m_workerPool.hasFunction(KEY_LOAD_IMAGES_SHARD)) {
+        result = loadImagesSharded(success);
+    } else {
+        success = callScript(KEY_LOAD_IMAGES,
+                             {m_imagesPath, pathOrNone(m_segmentationImagesPath)},
+                             result, "Failed to load images.");
+    }
+    if (!success) {
+        return images;
+    }
+    if (result.userType() != QMetaType::QVariantList) {
+        Q_EMIT error(tr("Failed to load images. Return value for images is "
+                        "neither a list of dicts nor a structured array. No images were loaded."));
+        return images;
+    }
+
+    images = imagesFromList(result.toList(), m_imagesWithInvalidData);
+    if (m_imagesWithInvalidData.size() > 0) {
+        Q_EMIT error(tr("There were images with invalid data."));
+    }
+    return images;
+}
+
+QList<ObjectModelPtr> PythonProcessLoadAndStoreStrategy::loadObjectModels() {
+    TRACE_SCOPE("load", "PythonProcessLoadAndStoreStrategy::loadObjectModels");
+    QList<ObjectModelPtr> objectModels;
+    m_objectModelsWithInvalidData.clear();
+
+    if (!QFileInfo(m_loadSaveScript).exists()) {
+        Q_EMIT error(tr("The script does not exist."));
+        return objectModels;
+    }
+
+    QVariant result;
+    if (!callScript(KEY_LOAD_OBJECT_MODELS, {m_objectModelsPath}, result,
+                    "Failed to load object models.")) {
+        return objectModels;
+    }
+    if (result.userType() != QMetaType::QVariantList) {
+        Q_EMIT error(tr("Failed to load object models. "
+                        "Return value for object models is not a list of dicts. "
+                        "No object models were loaded."));
+        return objectModels;
+    }
+
+    objectModels = objectModelsFromList(result.toList(), m_objectModelsWithInvalidData);
+    if (m_objectModelsWithInvalidData.size() > 0) {
+        Q_EMIT error(tr("There were object models with invalid data."));
+    }
+    return objectModels;
+}
+
+bool PythonProcessLoadAndStoreStrategy::persistPose(const Pose &objectImagePose, bool deletePose) {
+    TRACE_SCOPE_DETAIL("save", "PythonProcessLoadAndStoreStrategy::persistPose", objectImagePose.id());
+    if (!QFileInfo(m_loadSaveScript).exists()) {
+        Q_EMIT error(tr("The script does not exist."));
+        return false;
+    }
+
+    QVariant result;
+    if (!callScript(KEY_PERSIST_POSE,
+                    persistPoseArguments(m_posesFilePath, objectImagePose, deletePose),
+                    result, "Failed to persist a pose.")) {
+        return false;
+    }
+    if (result.userType() != QMetaType::Bool) {
+        Q_EMIT error(tr("Failed to persist a pose. The script return an unkown return type."));
+        return false;
+    }
+    return result.toBool();
+}
+
+QList<PosePtr> PythonProcessLoadAndStoreStrategy::loadPoses(const QList<ImagePtr> &images,
+                                                            const QList<ObjectModelPtr> &objectModels) {
+    TRACE_SCOPE("load", "PythonProcessLoadAndStoreStrategy::loadPoses");
+    QList<PosePtr> poses;
+    m_posesWithInvalidData.clear();
+
+    if (!QFileInfo(m_loadSaveScript).exists()) {
+        Q_EMIT error(tr("The script does not exist."));
+        return poses;
+    }
+
+    QVariant result;
+    if (!callScript(KEY_LOAD_POSES, {m_posesFilePath}, result, "Failed to load poses.")) {
+        return poses;
+    }
+    if (result.userType() != QMetaType::QVariantList) {
+        Q_EMIT error(tr("Failed to load poses. "
+                        "Return value for poses is neither a list of dicts "
+                        "nor a structured array. No poses were loaded."));
+        return poses;
+    }
+
+    // For faster lookup by ID
+    QMap<QString, ImagePtr> imagesForID;
+    QMap<QString, ImagePtr> imagesForPath;
+    for (const ImagePtr &image : images) {
+        imagesForID[image->id()] = image;
+        imagesForPath[image->imagePath()] = image;
+    }
+    QMap<QString, ObjectModelPtr> objectModelsForID;
+    QMap<QString, ObjectModelPtr> objectModelsForPath;
+    for (const ObjectModelPtr &objectModel : objectModels) {
+        objectModelsForID[objectModel->id()] = objectModel;
+        objectModelsForPath[objectModel->path()] = objectModel;
+    }
+
+    // Either a list of lists of poses per image or a flat list of poses, the latter
+    // is what structured arrays arrive as
+    poses = posesFromList(result.toList(), imagesForID, imagesForPath,
+                          objectModelsForID, objectModelsForPath, m_posesWithInvalidData);
+
+    if (m_posesWithInvalidData.size() > 0) {
+        Q_EMIT error(tr("There were poses with invalid data."));
+        qDebug() << "Poses with invalid data: ";
+        qDebug() << m_posesWithInvalidData;
+    }
+    if (poses.size() == 0) {
+        Q_EMIT error(tr("No poses loaded (either there exist none or all contained invalid data)."));
+    }
+    return poses;
+}
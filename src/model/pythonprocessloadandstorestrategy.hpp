@@ -0,0 +1,64 @@
+#ifndef PYTHONPROCESSLOADANDSTORESTRATEGY_H
+#define PYTHONPROCESSLOADANDSTORESTRATEGY_H
+
+#include "model/loadandstorestrategy.hpp"
+#include "model/pythonworkerpool.hpp"
+
+#include <QObject>
+#include <QVariant>
+
+/*!
+ * \brief The PythonProcessLoadAndStoreStrategy class uses the same scripts as the
+ * PythonLoadAndStoreStrategy but runs them in separate Python processes (see
+ * PythonWorkerPool) instead of the embedded interpreter. Calls are therefore not
+ * serialized by the GIL, a crashing or hanging script does not take down the program
+ * and no interpreter has to be finalized on exit.
+ *
+ * Scripts can optionally split image loading into shards which are loaded in parallel:
+ * list_image_shards(images_path, segmentation_images_path) returns a list of shards
+ * (e.g. subdirectories) and load_images_shard(images_path, segmentation_images_path, shard)
+ * returns the images of one shard like load_images does.
+ */
+class PythonProcessLoadAndStoreStrategy : public LoadAndStoreStrategy {
+
+    Q_OBJECT
+
+public:
+    PythonProcessLoadAndStoreStrategy();
+
+    ~PythonProcessLoadAndStoreStrategy();
+
+    void applySettings(SettingsPtr settings) override;
+
+    bool persistPose(const Pose &objectImagePose, bool deletePose) override;
+
+    QList<ImagePtr> loadImages() override;
+
+    QList<ObjectModelPtr> loadObjectModels() override;
+
+    QList<PosePtr> loadPoses(const QList<ImagePtr> &images,
+                             const QList<ObjectModelPtr> &objectModels) override;
+
+private:
+    /*!
+     * \brief callScript calls the function of the script and emits an error if it fails
+     * or returns a string (which scripts use to report errors).
+     * \param failure the beginning of the error message, e.g. "Failed to load images."
+     */
+    bool callScript(const QString &function, const QVariantList &arguments,
+                    QVariant &result, const QString &failure);
+    //! Reports the memory of the workers of the calling thread as PYTHON_HEAP
+    void reportWorkerMemory();
+    QVariant loadImagesSharded(bool &success);
+
+private Q_SLOTS:
+    void onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree);
+
+private:
+    QString m_loadSaveScript;
+    PythonWorkerPool m_workerPool;
+};
+
+typedef QSharedPointer<PythonProcessLoadAndStoreStrategy> PythonProcessLoadAndStoreStrategyPtr;
+
+#endif // PYTHONPROCESSLOADANDSTORESTRATEGY_H
@@ -0,0 +1,285 @@
+#include "pythonscriptdata.hpp"
+#include "misc/generalhelper.hpp"
+#include "misc/global.hpp"
+
+#include <QDir>
+#include <QMatrix3x3>
+#include <QVector>
+#include <QVector3D>
+#include <QtDebug>
+
+namespace PythonScriptData {
+
+namespace {
+
+void flatten(const QVariant &value, QVector<double> &values) {
+    if (value.userType() == qMetaTypeId<QVector<double>>()) {
+        values += value.value<QVector<double>>();
+    } else if (value.userType() == QMetaType::QVariantList) {
+        // Nested lists like [[1, 0, 0], [0, 1, 0], [0, 0, 1]]
+        for (const QVariant &item : value.toList()) {
+            flatten(item, values);
+        }
+    } else if (value.userType() == QMetaType::Double || value.userType() == QMetaType::LongLong) {
+        values.append(value.toDouble());
+    } else {
+        // Makes the count check fail
+        values.append(qQNaN());
+        values.append(qQNaN());
+    }
+}
+
+}
+
+bool readFloats(const QVariantMap &map, const QString &key, float *values, int count) {
+    if (!map.contains(key)) {
+        return false;
+    }
+    QVector<double> flattened;
+    flatten(map[key], flattened);
+    if (flattened.size() != count) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (qIsNaN(flattened[i])) {
+            return false;
+        }
+        values[i] = (float) flattened[i];
+    }
+    return true;
+}
+
+float readFloat(const QVariantMap &map, const QString &key, float defaultValue) {
+    const QVariant value = map.value(key);
+    if (value.userType() == QMetaType::Double || value.userType() == QMetaType::LongLong) {
+        return value.toFloat();
+    }
+    return defaultValue;
+}
+
+bool readIdentifier(const QVariantMap &map, const QString &key, QString &identifier) {
+    const QVariant value = map.value(key);
+    if (value.userType() == QMetaType::QString) {
+        identifier = value.toString();
+        return true;
+    } else if (value.userType() == QMetaType::LongLong) {
+        identifier = QString::number(value.toLongLong());
+        return true;
+    }
+    return false;
+}
+
+bool readString(const QVariantMap &map, const QString &key, QString &string) {
+    const QVariant value = map.value(key);
+    if (value.userType() == QMetaType::QString) {
+        string = value.toString();
+        return true;
+    }
+    return false;
+}
+
+QVariant pathOrNone(const QString &path) {
+    return path.isEmpty() || path == Global::NO_PATH ? QVariant() : QVariant(path);
+}
+
+namespace {
+
+ImagePtr imageFromMap(const QVariantMap &map, int index, QString &identifier) {
+    if (!readIdentifier(map, KEY_IMG_ID, identifier)) {
+        // The index is the fallback if the script doesn't provide IDs
+        identifier = QString::number(index);
+    }
+    QString imagePath, basePath;
+    float cameraMatrix[9];
+    if (!readString(map, KEY_IMG_PATH, imagePath)
+            || !readString(map, KEY_BASE_PATH, basePath)
+            || !readFloats(map, KEY_K, cameraMatrix, 9)) {
+        qDebug() << "Image" << identifier << "is missing the image path, base path or a "
+                    "valid camera matrix. Skipping image.";
+        return ImagePtr();
+    }
+    ImagePtr image(new Image(identifier, imagePath, basePath, QMatrix3x3(cameraMatrix),
+                             readFloat(map, KEY_NEAR_PLANE, NEAR_PLANE),
+                             readFloat(map, KEY_FAR_PLANE, FAR_PLANE)));
+    QString depthImagePath;
+    if (readString(map, KEY_DEPTH_IMAGE_PATH, depthImagePath) && !depthImagePath.isEmpty()) {
+        // Like the image path the depth image path is relative to the base path
+        image->setDepthImage(QDir(basePath).absoluteFilePath(depthImagePath),
+                             readFloat(map, KEY_DEPTH_SCALE, 1.f));
+    }
+    if (map.contains(KEY_CAM_R_W2C)) {
+        // The camera extrinsics are optional but if they are given they have to be valid
+        float cameraRotation[9];
+        float cameraTranslation[3];
+        if (!readFloats(map, KEY_CAM_R_W2C, cameraRotation, 9)
+                || !readFloats(map, KEY_CAM_T_W2C, cameraTranslation, 3)) {
+            qDebug() << "Image" << identifier << "has invalid camera extrinsics. Skipping image.";
+            return ImagePtr();
+        }
+        image->setCameraExtrinsics(QMatrix3x3(cameraRotation),
+                                   QVector3D(cameraTranslation[0],
+                                             cameraTranslation[1],
+                                             cameraTranslation[2]));
+    }
+    QString sceneId;
+    if (readIdentifier(map, KEY_SCENE_ID, sceneId)) {
+        image->setSceneId(sceneId);
+    }
+    return image;
+}
+
+ObjectModelPtr objectModelFromMap(const QVariantMap &map, int index, QString &identifier) {
+    if (!readIdentifier(map, KEY_OBJ_ID, identifier)) {
+        identifier = QString::number(index);
+    }
+    QString objectModelPath, basePath;
+    if (!readString(map, KEY_OBJ_MODEL_PATH, objectModelPath)
+            || !readString(map, KEY_BASE_PATH, basePath)) {
+        qDebug() << "Object model" << identifier << "is missing the object model path "
+                    "or base path. Skipping object model.";
+        return ObjectModelPtr();
+    }
+    return ObjectModelPtr(new ObjectModel(identifier, objectModelPath, basePath));
+}
+
+PosePtr poseFromMap(const QVariantMap &map, const QString &index,
+                    const QMap<QString, ImagePtr> &imagesForID,
+                    const QMap<QString, ImagePtr> &imagesForPath,
+                    const QMap<QString, ObjectModelPtr> &objectModelsForID,
+                    const QMap<QString, ObjectModelPtr> &objectModelsForPath) {
+    QString key;
+    ImagePtr image;
+    if (readIdentifier(map, KEY_IMG_ID, key)) {
+        image = imagesForID.value(key);
+    } else if (readString(map, KEY_IMG_PATH, key)) {
+        image = imagesForPath.value(key);
+    }
+    ObjectModelPtr objectModel;
+    if (readIdentifier(map, KEY_OBJ_ID, key)) {
+        objectModel = objectModelsForID.value(key);
+    } else if (readString(map, KEY_OBJ_MODEL_PATH, key)) {
+        objectModel = objectModelsForPath.value(key);
+    }
+    if (image.isNull() || objectModel.isNull()) {
+        qDebug() << "The image or object model of the pose could not be found "
+                    "(Index:" << index << "). Skipping pose.";
+        return PosePtr();
+    }
+    float rotation[9];
+    float translation[3];
+    if (!readFloats(map, KEY_R, rotation, 9) || !readFloats(map, KEY_T, translation, 3)) {
+        qDebug() << "The pose has no valid rotation matrix or translation vector "
+                    "(Index:" << index << "). Skipping pose.";
+        return PosePtr();
+    }
+    QString poseID;
+    if (!readIdentifier(map, KEY_POSE_ID, poseID) || poseID.isEmpty()) {
+        // No error, if no ID is present, create one
+        poseID = GeneralHelper::createPoseId();
+    }
+    return PosePtr(new Pose(poseID,
+                            QVector3D(translation[0], translation[1], translation[2]),
+                            QMatrix3x3(rotation),
+                            image, objectModel));
+}
+
+}
+
+QList<ImagePtr> imagesFromList(const QVariantList &list, QList<QString> &invalidData) {
+    QList<ImagePtr> images;
+    images.reserve(list.size());
+    for (int i = 0; i < list.size(); i++) {
+        if (list[i].userType() != QMetaType::QVariantMap) {
+            qDebug() << "Return value for image is not a dict. Skipping image.";
+            invalidData.append(QString::number(i));
+            continue;
+        }
+        QString imageID;
+        ImagePtr image = imageFromMap(list[i].toMap(), i, imageID);
+        if (image.isNull()) {
+            invalidData.append(imageID);
+            continue;
+        }
+        images.append(image);
+    }
+    return images;
+}
+
+QList<ObjectModelPtr> objectModelsFromList(const QVariantList &list, QList<QString> &invalidData) {
+    QList<ObjectModelPtr> objectModels;
+    for (int i = 0; i < list.size(); i++) {
+        if (list[i].userType() != QMetaType::QVariantMap) {
+            qDebug() << "Return value for object model is not a dict. Skipping object model.";
+            invalidData.append(QString::number(i));
+            continue;
+        }
+        QString objectModelID;
+        ObjectModelPtr objectModel = objectModelFromMap(list[i].toMap(), i, objectModelID);
+        if (objectModel.isNull()) {
+            invalidData.append(objectModelID);
+            continue;
+        }
+        objectModels.append(objectModel);
+    }
+    return objectModels;
+}
+
+QList<PosePtr> posesFromList(const QVariantList &list,
+                             const QMap<QString, ImagePtr> &imagesForID,
+                             const QMap<QString, ImagePtr> &imagesForPath,
+                             const QMap<QString, ObjectModelPtr> &objectModelsForID,
+                             const QMap<QString, ObjectModelPtr> &objectModelsForPath,
+                             QList<QString> &invalidData) {
+    QList<PosePtr> poses;
+    for (int i = 0; i < list.size(); i++) {
+        QVariantList posesForImage;
+        bool flat = list[i].userType() == QMetaType::QVariantMap;
+        if (flat) {
+            posesForImage.append(list[i]);
+        } else {
+            posesForImage = list[i].toList();
+        }
+        for (int j = 0; j < posesForImage.size(); j++) {
+            const QString index = flat ? QString::number(i)
+                                       : QString::number(i) + ", " + QString::number(j);
+            if (posesForImage[j].userType() != QMetaType::QVariantMap) {
+                qDebug() << "Return value for pose is not a dict (Index:" << index << "). Skipping pose.";
+                invalidData.append(index);
+                continue;
+            }
+            PosePtr pose = poseFromMap(posesForImage[j].toMap(), index,
+                                       imagesForID, imagesForPath,
+                                       objectModelsForID, objectModelsForPath);
+            if (pose.isNull()) {
+                invalidData.append(index);
+            } else {
+                poses.append(pose);
+            }
+        }
+    }
+    return poses;
+}
+
+QVariantList persistPoseArguments(const QString &posesFilePath, const Pose &pose, bool deletePose) {
+    QVariantList rotation;
+    // Transposed because QMatrix3x3 transposes it when loading from the float array
+    const QMatrix3x3 rotationMatrix = pose.rotation().toRotationMatrix().transposed();
+    for (int i = 0; i < 9; i++) {
+        rotation.append((double) rotationMatrix.constData()[i]);
+    }
+    QVariantList translation;
+    for (int i = 0; i < 3; i++) {
+        translation.append((double) pose.position()[i]);
+    }
+    return {posesFilePath,
+            pose.id(),
+            pose.image()->id(),
+            pose.image()->imagePath(),
+            pose.objectModel()->id(),
+            pose.objectModel()->path(),
+            rotation,
+            translation,
+            deletePose};
+}
+
+}
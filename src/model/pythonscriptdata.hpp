@@ -0,0 +1,90 @@
+#ifndef PYTHONSCRIPTDATA_H
+#define PYTHONSCRIPTDATA_H
+
+#include "image.hpp"
+#include "objectmodel.hpp"
+#include "pose.hpp"
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVariant>
+
+/*!
+ * \brief The PythonScriptData namespace holds what the strategies running load and store
+ * scripts share, no matter whether the script runs in the embedded interpreter or in
+ * worker processes: the names the scripts use and the conversion of their return values
+ * to entities.
+ *
+ * Return values are handled as QVariant, i.e. QVariantList, QVariantMap, QString, qint64,
+ * double, bool or QVector<double> for NumPy arrays. That's what PythonWorkerPool delivers
+ * and what the embedded interpreter converts its Python objects to.
+ */
+namespace PythonScriptData {
+
+// The functions of the scripts
+const char KEY_LOAD_IMAGES[] = "load_images";
+const char KEY_LIST_IMAGE_SHARDS[] = "list_image_shards";
+const char KEY_LOAD_IMAGES_SHARD[] = "load_images_shard";
+const char KEY_LOAD_OBJECT_MODELS[] = "load_object_models";
+const char KEY_LOAD_POSES[] = "load_poses";
+const char KEY_PERSIST_POSE[] = "persist_pose";
+// The keys of the returned dicts, structured arrays use them as field names
+const char KEY_IMG_ID[] = "img_id";
+const char KEY_IMG_PATH[] = "img_path";
+const char KEY_BASE_PATH[] = "base_path";
+const char KEY_SEGMENTATION_IMAGE_PATH[] = "segmentation_image_path";
+const char KEY_NEAR_PLANE[] = "near_plane";
+const char KEY_FAR_PLANE[] = "far_plane";
+const char KEY_DEPTH_IMAGE_PATH[] = "depth_image_path";
+const char KEY_DEPTH_SCALE[] = "depth_scale";
+const char KEY_CAM_R_W2C[] = "cam_R_w2c";
+const char KEY_CAM_T_W2C[] = "cam_t_w2c";
+const char KEY_SCENE_ID[] = "scene_id";
+const char KEY_OBJ_ID[] = "obj_id";
+const char KEY_OBJ_MODEL_PATH[] = "obj_model_path";
+const char KEY_K[] = "K";
+const char KEY_R[] = "R";
+const char KEY_T[] = "t";
+const char KEY_POSE_ID[] = "pose_id";
+
+//! Reads exactly count numbers from arrays or (nested) lists
+bool readFloats(const QVariantMap &map, const QString &key, float *values, int count);
+float readFloat(const QVariantMap &map, const QString &key, float defaultValue);
+//! Reads IDs which can be strings or ints
+bool readIdentifier(const QVariantMap &map, const QString &key, QString &identifier);
+bool readString(const QVariantMap &map, const QString &key, QString &string);
+//! Paths that are not set are passed to the scripts as None
+QVariant pathOrNone(const QString &path);
+
+/*!
+ * \brief imagesFromList creates the images described by the list of dicts the script
+ * returned. Dicts without ID get their index as ID.
+ * \param invalidData the IDs (or indices) of invalid dicts are appended to it
+ */
+QList<ImagePtr> imagesFromList(const QVariantList &list, QList<QString> &invalidData);
+//! Same as imagesFromList for object models
+QList<ObjectModelPtr> objectModelsFromList(const QVariantList &list, QList<QString> &invalidData);
+/*!
+ * \brief posesFromList creates the poses described by the list the script returned, either
+ * a list of lists of dicts per image or a flat list of dicts. The image and object model of
+ * a pose are looked up by ID or path.
+ * \param invalidData the indices of invalid dicts are appended to it, e.g. "3, 1"
+ */
+QList<PosePtr> posesFromList(const QVariantList &list,
+                             const QMap<QString, ImagePtr> &imagesForID,
+                             const QMap<QString, ImagePtr> &imagesForPath,
+                             const QMap<QString, ObjectModelPtr> &objectModelsForID,
+                             const QMap<QString, ObjectModelPtr> &objectModelsForPath,
+                             QList<QString> &invalidData);
+
+/*!
+ * \brief persistPoseArguments returns the arguments of persist_pose, i.e. the poses file,
+ * the IDs and paths of the pose, its image and its object model, R, t and whether to
+ * delete the pose.
+ */
+QVariantList persistPoseArguments(const QString &posesFilePath, const Pose &pose, bool deletePose);
+
+}
+
+#endif // PYTHONSCRIPTDATA_H
@@ -0,0 +1,668 @@
+#include "pythonworkerpool.hpp"
+
+#include <QAbstractEventDispatcher>
+#include <QBuffer>
+#include <QDataStream>
+#include <QMutexLocker>
+#include <QVector>
+#include <QtEndian>
+#include <QtDebug>
+
+namespace {
+
+// Must match the tags of resources/python/pythonworker.py
+enum Tag : quint8 {
+    TagNone = 0,
+    TagBool,
+    TagInt,
+    TagFloat,
+    TagString,
+    TagList,
+    TagDict,
+    TagFloatArray,
+    TagStructuredArray
+};
+
+const QString OPERATION_CALL = "call";
+const QString OPERATION_HAS = "has";
+const QString WORKER_SCRIPT = ":/python/pythonworker.py";
+const int START_TIMEOUT = 10000;
+const int WRITE_TIMEOUT = 10000;
+
+void writeString(QDataStream &stream, const QString &string) {
+    const QByteArray utf8 = string.toUtf8();
+    stream << (quint32) utf8.size();
+    stream.writeRawData(utf8.constData(), utf8.size());
+}
+
+void writeValue(QDataStream &stream, const QVariant &value) {
+    switch (value.userType()) {
+    case QMetaType::Bool:
+        stream << (quint8) TagBool << (quint8) value.toBool();
+        break;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+        stream << (quint8) TagInt << (qint64) value.toLongLong();
+        break;
+    case QMetaType::Float:
+    case QMetaType::Double:
+        stream << (quint8) TagFloat << value.toDouble();
+        break;
+    case QMetaType::QString:
+        stream << (quint8) TagString;
+        writeString(stream, value.toString());
+        break;
+    case QMetaType::QVariantList: {
+        const QVariantList list = value.toList();
+        stream << (quint8) TagList << (quint32) list.size();
+        for (const QVariant &item : list) {
+            writeValue(stream, item);
+        }
+        break;
+    }
+    case QMetaType::QVariantMap: {
+        const QVariantMap map = value.toMap();
+        stream << (quint8) TagDict << (quint32) map.size();
+        for (auto it = map.constBegin(); it != map.constEnd(); it++) {
+            stream << (quint8) TagString;
+            writeString(stream, it.key());
+            writeValue(stream, it.value());
+        }
+        break;
+    }
+    default:
+        if (value.userType() == qMetaTypeId<QVector<double>>()) {
+            const QVector<double> values = value.value<QVector<double>>();
+            stream << (quint8) TagFloatArray << (quint32) values.size();
+            for (double v : values) {
+                stream << v;
+            }
+        } else {
+            // Invalid variants become None
+            stream << (quint8) TagNone;
+        }
+    }
+}
+
+bool hasBytes(QDataStream &stream, quint64 size) {
+    if ((quint64) stream.device()->bytesAvailable() < size) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+    return true;
+}
+
+QVariant readValue(QDataStream &stream);
+
+/*!
+ * \brief readColumn reads one column of a structured array into the records. Numeric
+ * columns are one block of values, width values per record. A single value becomes a
+ * qint64 or double like a Python scalar, several ones a QVector<double> like an array.
+ */
+void readColumn(QDataStream &stream, const QString &name, QVector<QVariantMap> &records) {
+    const quint32 count = (quint32) records.size();
+    char tag = 0;
+    stream.device()->peek(&tag, 1);
+    if (tag != TagInt && tag != TagFloat) {
+        const QVariantList values = readValue(stream).toList();
+        if (stream.status() == QDataStream::Ok && (quint32) values.size() != count) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+        }
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+            records[i].insert(name, values[i]);
+        }
+        return;
+    }
+    quint8 columnTag;
+    quint32 width;
+    stream >> columnTag >> width;
+    if (stream.status() != QDataStream::Ok || !hasBytes(stream, 8 * (quint64) count * width)) {
+        return;
+    }
+    for (quint32 i = 0; i < count; i++) {
+        if (width == 1 && columnTag == TagInt) {
+            qint64 value;
+            stream >> value;
+            records[i].insert(name, QVariant(value));
+        } else if (width == 1) {
+            double value;
+            stream >> value;
+            records[i].insert(name, QVariant(value));
+        } else {
+            QVector<double> values(width);
+            for (quint32 j = 0; j < width; j++) {
+                if (columnTag == TagInt) {
+                    qint64 value;
+                    stream >> value;
+                    values[j] = value;
+                } else {
+                    stream >> values[j];
+                }
+            }
+            records[i].insert(name, QVariant::fromValue(values));
+        }
+    }
+}
+
+QVariant readValue(QDataStream &stream) {
+    quint8 tag;
+    stream >> tag;
+    switch (tag) {
+    case TagNone:
+        return QVariant();
+    case TagBool: {
+        quint8 value;
+        stream >> value;
+        return QVariant(value != 0);
+    }
+    case TagInt: {
+        qint64 value;
+        stream >> value;
+        return QVariant(value);
+    }
+    case TagFloat: {
+        double value;
+        stream >> value;
+        return QVariant(value);
+    }
+    default:
+        break;
+    }
+    quint32 count;
+    stream >> count;
+    if (stream.status() != QDataStream::Ok) {
+        return QVariant();
+    }
+    switch (tag) {
+    case TagString: {
+        if (!hasBytes(stream, count)) {
+            return QVariant();
+        }
+        QByteArray utf8(count, Qt::Uninitialized);
+        stream.readRawData(utf8.data(), count);
+        return QString::fromUtf8(utf8);
+    }
+    case TagList: {
+        // Every value takes at least one byte, protects against corrupt counts
+        if (!hasBytes(stream, count)) {
+            return QVariant();
+        }
+        QVariantList list;
+        list.reserve(count);
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+            list.append(readValue(stream));
+        }
+        return list;
+    }
+    case TagDict: {
+        if (!hasBytes(stream, 2 * (quint64) count)) {
+            return QVariant();
+        }
+        QVariantMap map;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+            const QString key = readValue(stream).toString();
+            map.insert(key, readValue(stream));
+        }
+        return map;
+    }
+    case TagFloatArray: {
+        if (!hasBytes(stream, 8 * (quint64) count)) {
+            return QVariant();
+        }
+        QVector<double> values(count);
+        for (quint32 i = 0; i < count; i++) {
+            stream >> values[i];
+        }
+        return QVariant::fromValue(values);
+    }
+    case TagStructuredArray: {
+        // The records as list of dicts, like the scripts return them without NumPy
+        quint32 fieldCount;
+        stream >> fieldCount;
+        // Every column takes at least one byte per record, protects against corrupt counts
+        if (stream.status() != QDataStream::Ok || fieldCount == 0
+                || !hasBytes(stream, (quint64) fieldCount * count)) {
+            return QVariant();
+        }
+        QVector<QVariantMap> records(count);
+        for (quint32 i = 0; i < fieldCount && stream.status() == QDataStream::Ok; i++) {
+            const QString name = readValue(stream).toString();
+            readColumn(stream, name, records);
+        }
+        QVariantList list;
+        list.reserve(count);
+        for (const QVariantMap &record : records) {
+            list.append(record);
+        }
+        return list;
+    }
+    default:
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return QVariant();
+    }
+}
+
+QByteArray encodeFrame(const QVariant &value) {
+    QByteArray frame(4, 0);
+    QBuffer buffer(&frame);
+    buffer.open(QIODevice::WriteOnly | QIODevice::Append);
+    QDataStream stream(&buffer);
+    writeValue(stream, value);
+    buffer.close();
+    qToBigEndian<quint32>(frame.size() - 4, reinterpret_cast<uchar*>(frame.data()));
+    return frame;
+}
+
+/*!
+ * \brief takeFrame removes the first complete frame from the buffer.
+ * \return false if the buffer does not contain a complete frame yet
+ */
+bool takeFrame(QByteArray &buffer, QByteArray &payload) {
+    if (buffer.size() < 4) {
+        return false;
+    }
+    const quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(buffer.constData()));
+    if ((quint64) buffer.size() < 4 + (quint64) size) {
+        return false;
+    }
+    payload = buffer.mid(4, size);
+    buffer.remove(0, 4 + size);
+    return true;
+}
+
+}
+
+PythonWorkerPool::PythonWorkerPool()
+    : m_maximumWorkers(qBound(1, QThread::idealThreadCount(), 8)) {
+}
+
+PythonWorkerPool::~PythonWorkerPool() {
+    QHash<QThread*, QList<Worker*>> workers;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const QMetaObject::Connection &connection : m_threadFinishedConnections) {
+            QObject::disconnect(connection);
+        }
+        m_threadFinishedConnections.clear();
+        workers.swap(m_workers);
+    }
+    for (auto it = workers.constBegin(); it != workers.constEnd(); it++) {
+        QThread *thread = it.key();
+        const QList<Worker*> threadWorkers = it.value();
+        // QProcess must be deleted by the thread that created it, the pool is usually
+        // destroyed by the GUI thread while the workers belong to the model manager thread
+        if (thread == QThread::currentThread()) {
+            deleteWorkers(threadWorkers);
+        } else if (thread->loopLevel() > 0) {
+            QMetaObject::invokeMethod(thread->eventDispatcher(),
+                                      [threadWorkers]() { deleteWorkers(threadWorkers); },
+                                      Qt::QueuedConnection);
+        } else if (thread->isRunning()) {
+            // Threads without event loop, e.g. of the global thread pool, clean up when
+            // they are done. The lambda must not use the pool, it is gone by then.
+            QObject::connect(thread, &QThread::finished,
+                             [threadWorkers]() { deleteWorkers(threadWorkers); });
+        }
+    }
+}
+
+void PythonWorkerPool::setInterpreter(const QString &interpreter) {
+    QMutexLocker locker(&m_mutex);
+    if (m_interpreter != interpreter) {
+        m_interpreter = interpreter;
+        m_scriptGeneration++;
+    }
+}
+
+void PythonWorkerPool::setScript(const QString &script) {
+    QMutexLocker locker(&m_mutex);
+    // Also when the script didn't change, it might have been edited
+    m_script = script;
+    m_scriptGeneration++;
+}
+
+void PythonWorkerPool::setMaximumWorkers(int maximumWorkers) {
+    QMutexLocker locker(&m_mutex);
+    m_maximumWorkers = qMax(1, maximumWorkers);
+}
+
+void PythonWorkerPool::setCallTimeout(int callTimeout) {
+    QMutexLocker locker(&m_mutex);
+    m_callTimeout = callTimeout;
+}
+
+QList<PythonWorkerPool::Worker*> PythonWorkerPool::workersOfCurrentThread(int count) {
+    QMutexLocker locker(&m_mutex);
+    QThread *thread = QThread::currentThread();
+    if (!m_workers.contains(thread)) {
+        // Direct connection, i.e. the workers are deleted by their own thread when it
+        // finishes, e.g. when the global thread pool expires an idle thread
+        m_threadFinishedConnections[thread] =
+                QObject::connect(thread, &QThread::finished,
+                                 [this, thread]() { removeWorkersOfThread(thread); });
+    }
+    QList<Worker*> &workers = m_workers[thread];
+    while (workers.size() < count) {
+        workers.append(new Worker);
+    }
+    return workers.mid(0, count);
+}
+
+void PythonWorkerPool::removeWorkersOfThread(QThread *thread) {
+    QList<Worker*> workers;
+    {
+        QMutexLocker locker(&m_mutex);
+        workers = m_workers.take(thread);
+        QObject::disconnect(m_threadFinishedConnections.take(thread));
+    }
+    deleteWorkers(workers);
+}
+
+void PythonWorkerPool::deleteWorkers(const QList<Worker*> &workers) {
+    for (Worker *worker : workers) {
+        stopWorker(worker);
+        delete worker;
+    }
+}
+
+bool PythonWorkerPool::ensureWorkerRunning(Worker *worker, QString &errorMessage) {
+    QString interpreter;
+    QString script;
+    QString workerScriptPath;
+    int scriptGeneration;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_workerScript.isNull()) {
+            m_workerScript.reset(QTemporaryFile::createNativeFile(WORKER_SCRIPT));
+            if (m_workerScript.isNull()) {
+                errorMessage = "Could not extract the Python worker script.";
+                return false;
+            }
+        }
+        interpreter = m_interpreter;
+        script = m_script;
+        workerScriptPath = m_workerScript->fileName();
+        scriptGeneration = m_scriptGeneration;
+    }
+    if (worker->process && worker->process->state() == QProcess::Running
+            && worker->scriptGeneration == scriptGeneration) {
+        return true;
+    }
+
+    stopWorker(worker);
+    worker->process = new QProcess;
+    // Output of the script (e.g. print) ends up in the console of the program
+    worker->process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    worker->process->start(interpreter, {"-u", workerScriptPath, script});
+    if (!worker->process->waitForStarted(START_TIMEOUT)) {
+        errorMessage = "Could not start the Python interpreter " + interpreter + ": "
+                       + worker->process->errorString();
+        stopWorker(worker);
+        return false;
+    }
+    worker->scriptGeneration = scriptGeneration;
+
+    // The worker reports whether it could import the script
+    bool success = false;
+    QVariant result;
+    worker->callTimer.start();
+    CallState state = receiveResponse(worker, true, success, result);
+    if (state != Finished || !success) {
+        errorMessage = "Failed to load the requested Python script: ";
+        errorMessage += state == Finished ? result.toString() : "the worker did not start properly.";
+        stopWorker(worker);
+        return false;
+    }
+    return true;
+}
+
+void PythonWorkerPool::stopWorker(Worker *worker) {
+    if (worker->process) {
+        worker->process->kill();
+        worker->process->waitForFinished(1000);
+        delete worker->process;
+        worker->process = Q_NULLPTR;
+    }
+    worker->buffer.clear();
+}
+
+bool PythonWorkerPool::sendRequest(Worker *worker, const QString &operation,
+                                   const QString &function, const QVariantList &arguments) {
+    const QByteArray frame = encodeFrame(QVariantList({operation, function, arguments}));
+    worker->buffer.clear();
+    worker->callTimer.start();
+    if (worker->process->write(frame) != frame.size()) {
+        return false;
+    }
+    // Without event loop the bytes are only written while waiting, the worker needs the
+    // whole request before callParallel blocks on another worker
+    while (worker->process->bytesToWrite() > 0) {
+        if (!worker->process->waitForBytesWritten(WRITE_TIMEOUT)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PythonWorkerPool::CallState PythonWorkerPool::receiveResponse(Worker *worker, bool block,
+                                                              bool &success, QVariant &result) {
+    int callTimeout;
+    {
+        QMutexLocker locker(&m_mutex);
+        callTimeout = m_callTimeout;
+    }
+    Q_FOREVER {
+        QByteArray payload;
+        if (takeFrame(worker->buffer, payload)) {
+            QDataStream stream(payload);
+            const QVariantList response = readValue(stream).toList();
+            if (stream.status() != QDataStream::Ok || response.size() != 2) {
+                // The worker and the program are out of sync, start over
+                qDebug() << "Received an invalid response from the Python worker.";
+                stopWorker(worker);
+                return Crashed;
+            }
+            success = response[0].toBool();
+            result = response[1];
+            return Finished;
+        }
+        if (worker->process->state() != QProcess::Running) {
+            return Crashed;
+        }
+        const qint64 remaining = callTimeout - worker->callTimer.elapsed();
+        if (remaining <= 0) {
+            return TimedOut;
+        }
+        // Also writes pending request bytes to the worker
+        const bool ready = worker->process->waitForReadyRead(block ? (int) remaining : 0);
+        worker->buffer += worker->process->readAllStandardOutput();
+        if (!ready && !block && worker->process->state() == QProcess::Running) {
+            return Pending;
+        }
+    }
+}
+
+PythonWorkerPool::CallState PythonWorkerPool::callBlocking(Worker *worker, const QString &operation,
+                                                           const QString &function,
+                                                           const QVariantList &arguments,
+                                                           bool &success, QVariant &result,
+                                                           QString &errorMessage) {
+    success = false;
+    if (!ensureWorkerRunning(worker, errorMessage)) {
+        // Not worth retrying, the next worker would fail the same way
+        return Finished;
+    }
+    CallState state = Crashed;
+    if (sendRequest(worker, operation, function, arguments)) {
+        state = receiveResponse(worker, true, success, result);
+    }
+    if (state == Crashed) {
+        errorMessage = "The Python worker exited unexpectedly while calling " + function + ".";
+        stopWorker(worker);
+    } else if (state == TimedOut) {
+        errorMessage = "The Python worker did not finish " + function + " in time and was stopped.";
+        stopWorker(worker);
+    } else if (!success) {
+        errorMessage = result.toString();
+    }
+    return state;
+}
+
+bool PythonWorkerPool::call(const QString &function, const QVariantList &arguments,
+                            QVariant &result, QString &errorMessage) {
+    Worker *worker = workersOfCurrentThread(1).first();
+    bool success = false;
+    // A crashed worker is replaced and the call repeated once, if the script crashes
+    // the interpreter every time there is no point in trying further
+    for (int attempt = 0; attempt < 2; attempt++) {
+        CallState state = callBlocking(worker, OPERATION_CALL, function, arguments,
+                                       success, result, errorMessage);
+        if (state != Crashed) {
+            break;
+        }
+        qDebug() << "Restarting the Python worker after it crashed while calling" << function;
+    }
+    return success;
+}
+
+bool PythonWorkerPool::hasFunction(const QString &function) {
+    int scriptGeneration;
+    {
+        QMutexLocker locker(&m_mutex);
+        scriptGeneration = m_scriptGeneration;
+        if (m_functionsGeneration == scriptGeneration && m_functions.contains(function)) {
+            return m_functions.value(function);
+        }
+    }
+    Worker *worker = workersOfCurrentThread(1).first();
+    bool success = false;
+    QVariant result;
+    QString errorMessage;
+    callBlocking(worker, OPERATION_HAS, function, QVariantList(), success, result, errorMessage);
+    if (!success) {
+        // E.g. the script couldn't be imported, asking again might succeed
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    // The script might have been changed while asking
+    if (m_scriptGeneration == scriptGeneration) {
+        if (m_functionsGeneration != scriptGeneration) {
+            m_functions.clear();
+            m_functionsGeneration = scriptGeneration;
+        }
+        m_functions.insert(function, result.toBool());
+    }
+    return result.toBool();
+}
+
+bool PythonWorkerPool::callParallel(const QString &function, const QList<QVariantList> &argumentLists,
+                                    QVariantList &results, QString &errorMessage) {
+    results.clear();
+    if (argumentLists.isEmpty()) {
+        return true;
+    }
+    int maximumWorkers;
+    {
+        QMutexLocker locker(&m_mutex);
+        maximumWorkers = m_maximumWorkers;
+    }
+    const QList<Worker*> workers = workersOfCurrentThread(qMin(maximumWorkers, argumentLists.size()));
+
+    for (int i = 0; i < argumentLists.size(); i++) {
+        results.append(QVariant());
+    }
+    QList<int> queue;
+    for (int i = 0; i < argumentLists.size(); i++) {
+        queue.append(i);
+    }
+    QVector<bool> retried(argumentLists.size(), false);
+    // The index of the arguments each worker is processing, -1 if it is idle
+    QVector<int> assigned(workers.size(), -1);
+    // The busy workers in the order they got their calls, the first one is due next
+    QList<int> busy;
+    bool success = true;
+
+    // Returns false if the response of the worker is not complete yet
+    auto collect = [&](int w, bool block) {
+        Worker *worker = workers[w];
+        bool callSucceeded = false;
+        QVariant result;
+        const CallState state = receiveResponse(worker, block, callSucceeded, result);
+        if (state == Pending) {
+            return false;
+        }
+        const int index = assigned[w];
+        assigned[w] = -1;
+        busy.removeOne(w);
+        if (state == Finished && callSucceeded) {
+            results[index] = result;
+        } else if (state == Crashed && !retried[index]) {
+            qDebug() << "Restarting the Python worker after it crashed while calling" << function;
+            stopWorker(worker);
+            retried[index] = true;
+            queue.prepend(index);
+        } else {
+            if (state != Finished) {
+                stopWorker(worker);
+            }
+            if (success) {
+                errorMessage = state == Finished ? result.toString()
+                                                 : "The Python worker failed while calling " + function + ".";
+            }
+            success = false;
+        }
+        return true;
+    };
+
+    // All workers run at the same time, this thread only hands out the calls and
+    // collects the results
+    while (!busy.isEmpty() || (success && !queue.isEmpty())) {
+        for (int w = 0; w < workers.size() && success && !queue.isEmpty(); w++) {
+            if (assigned[w] >= 0) {
+                continue;
+            }
+            QString workerError;
+            if (!ensureWorkerRunning(workers[w], workerError)
+                    || !sendRequest(workers[w], OPERATION_CALL, function, argumentLists[queue.first()])) {
+                errorMessage = workerError;
+                success = false;
+                break;
+            }
+            assigned[w] = queue.takeFirst();
+            busy.append(w);
+        }
+        // Takes what has arrived so far, if nothing is complete this thread sleeps until
+        // the worker that is due next responds
+        bool collected = false;
+        for (int w : QList<int>(busy)) {
+            collected |= collect(w, false);
+        }
+        if (!collected && !busy.isEmpty()) {
+            collect(busy.first(), true);
+        }
+    }
+    return success;
+}
+
+QList<qint64> PythonWorkerPool::processIdsOfCurrentThread() {
+    QMutexLocker locker(&m_mutex);
+    QList<qint64> processIds;
+    for (Worker *worker : m_workers.value(QThread::currentThread())) {
+        if (worker->process && worker->process->state() == QProcess::Running) {
+            processIds.append(worker->process->processId());
+        }
+    }
+    return processIds;
+}
+
+void PythonWorkerPool::stopWorkersOfCurrentThread() {
+    QList<Worker*> workers;
+    {
+        QMutexLocker locker(&m_mutex);
+        workers = m_workers.value(QThread::currentThread());
+    }
+    for (Worker *worker : workers) {
+        stopWorker(worker);
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef PYTHONWORKERPOOL_H
+#define PYTHONWORKERPOOL_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QProcess>
+#include <QScopedPointer>
+#include <QString>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QVariant>
+
+/*!
+ * \brief The PythonWorkerPool class runs the functions of a load and store script in
+ * separate Python processes (see resources/python/pythonworker.py). Arguments and results
+ * are exchanged as length prefixed frames of tagged binary values: None, bool, int, float,
+ * string, list, dict and arrays of doubles which NumPy arrays are sent as. Structured
+ * arrays are sent column by column and arrive as list of dicts. Results arrive as
+ * QVariant, i.e. QVariantList, QVariantMap, QString, qint64, double, bool or
+ * QVector<double>.
+ *
+ * Every calling thread gets its own workers since QProcess can only be used from the
+ * thread that created it. They are stopped when their thread finishes. Workers that crash
+ * or don't respond within the timeout are killed and replaced, the application itself is
+ * never affected.
+ */
+class PythonWorkerPool {
+
+public:
+    PythonWorkerPool();
+    ~PythonWorkerPool();
+
+    /*!
+     * \brief setInterpreter sets the Python executable that runs the workers. Running
+     * workers are replaced on their next use.
+     */
+    void setInterpreter(const QString &interpreter);
+    /*!
+     * \brief setScript sets the load and store script the workers import. Running
+     * workers are replaced on their next use.
+     */
+    void setScript(const QString &script);
+    //! The maximum number of workers per calling thread used by callParallel
+    void setMaximumWorkers(int maximumWorkers);
+    //! The time in milliseconds one call may take before its worker is killed
+    void setCallTimeout(int callTimeout);
+
+    /*!
+     * \brief call calls the function of the script with the given arguments in a worker of
+     * the calling thread. If the worker crashed the call is repeated once with a new worker.
+     * \param result set to the return value of the function
+     * \param errorMessage set to the reason if the call failed, e.g. the Python traceback
+     * \return true if the function returned normally
+     */
+    bool call(const QString &function, const QVariantList &arguments,
+              QVariant &result, QString &errorMessage);
+
+    /*!
+     * \brief hasFunction checks whether the script defines the function, to support
+     * optional functions. The answer is remembered until the script is set again.
+     */
+    bool hasFunction(const QString &function);
+
+    /*!
+     * \brief callParallel calls the function once for every list of arguments, distributed
+     * over up to maximumWorkers workers of the calling thread.
+     * \param results set to the return values in the order of the argument lists
+     * \param errorMessage set to the reason of the first failed call
+     * \return true if all calls succeeded
+     */
+    bool callParallel(const QString &function, const QList<QVariantList> &argumentLists,
+                      QVariantList &results, QString &errorMessage);
+
+    //! The process ids of the running workers of the calling thread
+    QList<qint64> processIdsOfCurrentThread();
+    /*!
+     * \brief stopWorkersOfCurrentThread stops the workers of the calling thread to free
+     * their memory, they are started again on the next call.
+     */
+    void stopWorkersOfCurrentThread();
+
+private:
+    struct Worker {
+        QProcess *process = Q_NULLPTR;
+        // Bytes of partially received frames
+        QByteArray buffer;
+        int scriptGeneration = -1;
+        QElapsedTimer callTimer;
+    };
+
+    enum CallState {
+        Finished,
+        Pending,
+        Crashed,
+        TimedOut
+    };
+
+    /*!
+     * \brief workersOfCurrentThread returns the given number of workers of the calling
+     * thread, creating them if necessary. Their processes are started on first use.
+     */
+    QList<Worker*> workersOfCurrentThread(int count);
+    //! Called by the thread itself when it finished
+    void removeWorkersOfThread(QThread *thread);
+    //! Must be called by the thread the workers belong to
+    static void deleteWorkers(const QList<Worker*> &workers);
+    bool ensureWorkerRunning(Worker *worker, QString &errorMessage);
+    static void stopWorker(Worker *worker);
+    bool sendRequest(Worker *worker, const QString &operation,
+                     const QString &function, const QVariantList &arguments);
+    /*!
+     * \brief receiveResponse reads the response of the worker to the last request. If block
+     * is false it only takes what the worker has sent so far.
+     * \param success set to whether the function returned normally
+     * \param result set to the return value or the error message of the worker
+     * \return Pending if the response is not complete yet
+     */
+    CallState receiveResponse(Worker *worker, bool block, bool &success, QVariant &result);
+    CallState callBlocking(Worker *worker, const QString &operation,
+                           const QString &function, const QVariantList &arguments,
+                           bool &success, QVariant &result, QString &errorMessage);
+
+private:
+    // Guards the settings and the map of workers, the workers themselves are only
+    // touched by the thread they belong to
+    QMutex m_mutex;
+    QString m_interpreter = "python3";
+    QString m_script;
+    int m_scriptGeneration = 0;
+    // The answers of hasFunction for the script of m_functionsGeneration
+    QHash<QString, bool> m_functions;
+    int m_functionsGeneration = -1;
+    int m_maximumWorkers;
+    int m_callTimeout = 120000;
+    // The worker script extracted from the resources, the interpreter needs a real file
+    QScopedPointer<QTemporaryFile> m_workerScript;
+    QHash<QThread*, QList<Worker*>> m_workers;
+    QHash<QThread*, QMetaObject::Connection> m_threadFinishedConnections;
+};
+
+#endif // PYTHONWORKERPOOL_H
@@ -0,0 +1,187 @@
+#include "depthmap.hpp"
+
+#include <QFileInfo>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QRegularExpression>
+#include <QtEndian>
+#include <QDebug>
+
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include <cstring>
+
+namespace {
+
+// The number of depth maps kept mapped by loadCached
+const int CACHE_CAPACITY = 4;
+
+QMutex cacheMutex;
+// Most recently used at the front
+QList<QPair<QString, DepthMapPtr>> cache;
+
+}
+
+DepthMap::DepthMap(const QString &absolutePath, float depthScale)
+    : m_file(absolutePath)
+    , m_depthScale(depthScale) {
+}
+
+DepthMap::~DepthMap() {
+    // Release the view into the mapped memory before unmapping it
+    m_data.release();
+    if (m_mapped) {
+        m_file.unmap(m_mapped);
+    }
+}
+
+DepthMapPtr DepthMap::load(const QString &absolutePath, float depthScale, QString *errorMessage) {
+    QSharedPointer<DepthMap> depthMap(new DepthMap(absolutePath, depthScale));
+    QString error;
+    if (!depthMap->mapAndDecode(error)) {
+        qDebug() << "Could not load depth map" << absolutePath << ":" << error;
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        return DepthMapPtr();
+    }
+    return depthMap;
+}
+
+DepthMapPtr DepthMap::loadCached(const QString &absolutePath, float depthScale, QString *errorMessage) {
+    {
+        QMutexLocker locker(&cacheMutex);
+        for (int i = 0; i < cache.size(); i++) {
+            if (cache[i].first == absolutePath && cache[i].second->m_depthScale == depthScale) {
+                cache.move(i, 0);
+                return cache.first().second;
+            }
+        }
+    }
+    DepthMapPtr depthMap = load(absolutePath, depthScale, errorMessage);
+    if (!depthMap.isNull()) {
+        QMutexLocker locker(&cacheMutex);
+        cache.prepend(qMakePair(absolutePath, depthMap));
+        while (cache.size() > CACHE_CAPACITY) {
+            cache.removeLast();
+        }
+    }
+    return depthMap;
+}
+
+void DepthMap::clearCache() {
+    QMutexLocker locker(&cacheMutex);
+    cache.clear();
+}
+
+int DepthMap::width() const {
+    return m_data.cols;
+}
+
+int DepthMap::height() const {
+    return m_data.rows;
+}
+
+bool DepthMap::mapAndDecode(QString &errorMessage) {
+    if (!m_file.open(QFile::ReadOnly)) {
+        errorMessage = "Could not open file.";
+        return false;
+    }
+    qint64 size = m_file.size();
+    m_mapped = m_file.map(0, size);
+    if (!m_mapped) {
+        errorMessage = "Could not map file.";
+        return false;
+    }
+
+    if (QFileInfo(m_file.fileName()).suffix().toLower() == "npy") {
+        return wrapNumpy(m_mapped, size, errorMessage);
+    }
+
+    // Compressed formats have to be decoded but at least without reading
+    // the file into an intermediate buffer first
+    cv::Mat encoded(1, (int) size, CV_8U, m_mapped);
+    m_data = cv::imdecode(encoded, cv::IMREAD_ANYDEPTH | cv::IMREAD_GRAYSCALE);
+    // The encoded data is not needed anymore
+    m_file.unmap(m_mapped);
+    m_mapped = Q_NULLPTR;
+    if (m_data.empty()) {
+        errorMessage = "Could not decode depth image.";
+        return false;
+    }
+    if (m_data.type() != CV_16U && m_data.type() != CV_32F) {
+        m_data.convertTo(m_data, CV_32F);
+    }
+    return true;
+}
+
+bool DepthMap::wrapNumpy(uchar *data, qint64 size, QString &errorMessage) {
+    // See https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+    if (size < 10 || memcmp(data, "\x93NUMPY", 6) != 0) {
+        errorMessage = "Not a NumPy file.";
+        return false;
+    }
+    int majorVersion = data[6];
+    qint64 headerLength;
+    qint64 headerStart;
+    if (majorVersion == 1) {
+        headerLength = qFromLittleEndian<quint16>(data + 8);
+        headerStart = 10;
+    } else {
+        headerLength = qFromLittleEndian<quint32>(data + 8);
+        headerStart = 12;
+    }
+    if (headerStart + headerLength > size) {
+        errorMessage = "Truncated NumPy header.";
+        return false;
+    }
+    QString header = QString::fromLatin1((const char *) data + headerStart, (int) headerLength);
+
+    QRegularExpressionMatch descr =
+            QRegularExpression("'descr':\\s*'([<>|=])([uif])(\\d)'").match(header);
+    QRegularExpressionMatch shape =
+            QRegularExpression("'shape':\\s*\\((\\d+),\\s*(\\d+),?\\s*\\)").match(header);
+    if (!descr.hasMatch() || !shape.hasMatch() || header.contains("'fortran_order': True")) {
+        errorMessage = "Only C-ordered two-dimensional NumPy arrays are supported.";
+        return false;
+    }
+
+    QString kind = descr.captured(2) + descr.captured(3);
+    int type;
+    if (kind == "u2") {
+        type = CV_16U;
+    } else if (kind == "f4") {
+        type = CV_32F;
+    } else {
+        errorMessage = "Unsupported NumPy data type " + kind + " (use uint16 or float32).";
+        return false;
+    }
+
+    int rows = shape.captured(1).toInt();
+    int cols = shape.captured(2).toInt();
+    qint64 dataStart = headerStart + headerLength;
+    if (dataStart + (qint64) rows * cols * CV_ELEM_SIZE(type) > size) {
+        errorMessage = "Truncated NumPy data.";
+        return false;
+    }
+
+    m_data = cv::Mat(rows, cols, type, data + dataStart);
+    if (descr.captured(1) == ">") {
+        // Big endian data cannot be used in place, swap into owned memory
+        cv::Mat swapped = m_data.clone();
+        if (type == CV_16U) {
+            for (ushort *value = swapped.ptr<ushort>(); value < swapped.ptr<ushort>() + swapped.total(); value++) {
+                *value = qFromBigEndian(*value);
+            }
+        } else {
+            for (quint32 *value = (quint32 *) swapped.data;
+                 value < (quint32 *) swapped.data + swapped.total(); value++) {
+                *value = qFromBigEndian(*value);
+            }
+        }
+        m_data = swapped;
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef DEPTHMAP_H
+#define DEPTHMAP_H
+
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+
+#include <opencv2/core/core.hpp>
+
+class DepthMap;
+typedef QSharedPointer<const DepthMap> DepthMapPtr;
+
+/*!
+ * \brief The DepthMap class gives access to a depth image that is aligned with an image.
+ * The file is memory-mapped: uncompressed NumPy .npy files (uint16 or float32) are read in
+ * place without any copy, compressed formats like 16 bit PNGs are decoded directly from
+ * the mapped memory.
+ */
+class DepthMap {
+
+public:
+    ~DepthMap();
+
+    /*!
+     * \brief load maps the depth image at the given path.
+     * \param absolutePath the path to the depth image
+     * \param depthScale the factor that converts the stored values to object model units
+     * \param errorMessage set to the reason of failure if the file could not be loaded
+     * \return the depth map or a null pointer on failure
+     */
+    static DepthMapPtr load(const QString &absolutePath, float depthScale,
+                            QString *errorMessage = Q_NULLPTR);
+
+    /*!
+     * \brief loadCached is the same as load but keeps the most recently used depth maps
+     * around, refining several poses of the same image maps the file only once. This
+     * function is thread-safe.
+     */
+    static DepthMapPtr loadCached(const QString &absolutePath, float depthScale,
+                                  QString *errorMessage = Q_NULLPTR);
+
+    static void clearCache();
+
+    int width() const;
+    int height() const;
+
+    //! Returns the depth at the given pixel in object model units, 0 if there is no measurement.
+    inline float depth(int x, int y) const {
+        if (m_data.type() == CV_16U) {
+            return m_data.at<ushort>(y, x) * m_depthScale;
+        }
+        return m_data.at<float>(y, x) * m_depthScale;
+    }
+
+private:
+    DepthMap(const QString &absolutePath, float depthScale);
+    bool mapAndDecode(QString &errorMessage);
+    bool wrapNumpy(uchar *data, qint64 size, QString &errorMessage);
+
+private:
+    Q_DISABLE_COPY(DepthMap)
+
+    QFile m_file;
+    uchar *m_mapped = Q_NULLPTR;
+    // Either points into m_mapped or owns decoded memory, CV_16U or CV_32F
+    cv::Mat m_data;
+    float m_depthScale;
+};
+
+#endif // DEPTHMAP_H
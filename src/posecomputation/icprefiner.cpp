@@ -0,0 +1,315 @@
+#include "icprefiner.hpp"
+#include "depthmap.hpp"
+#include "kdtree.hpp"
+#include "mesh.hpp"
+#include "silhouetterenderer.hpp"
+
+#include <opencv2/calib3d/calib3d.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// All distances are relative to the size (bounding box diagonal) of the object model
+// to be independent of the unit the object models and depth maps are in
+
+// Correspondences farther apart than this are ignored in the first iteration
+const float INITIAL_REJECTION_DISTANCE = 0.1f;
+// The rejection distance adapts to the median correspondence distance but never
+// gets smaller than this
+const float MINIMUM_REJECTION_DISTANCE = 0.005f;
+// A model point counts as explained by the depth map if a depth point is that close
+const float SCORE_DISTANCE = 0.02f;
+// Depth points are kept if they lie in the depth range of the object enlarged by this
+const float DEPTH_RANGE_MARGIN = 0.1f;
+// The region around the projected object that depth points are taken from, relative
+// to the size of the projection
+const double REGION_MARGIN = 0.1;
+// ICP stops when an update moves the object less than this
+const double CONVERGENCE_TRANSLATION = 1e-4;
+const double CONVERGENCE_ROTATION = 1e-5;
+// Need at least this many correspondences for a meaningful alignment
+const int MINIMUM_CORRESPONDENCES = 10;
+
+float modelSize(const Mesh &mesh) {
+    cv::Point3f minimum(std::numeric_limits<float>::max(),
+                        std::numeric_limits<float>::max(),
+                        std::numeric_limits<float>::max());
+    cv::Point3f maximum(std::numeric_limits<float>::lowest(),
+                        std::numeric_limits<float>::lowest(),
+                        std::numeric_limits<float>::lowest());
+    for (const cv::Point3f &v : mesh.vertices) {
+        minimum.x = std::min(minimum.x, v.x);
+        minimum.y = std::min(minimum.y, v.y);
+        minimum.z = std::min(minimum.z, v.z);
+        maximum.x = std::max(maximum.x, v.x);
+        maximum.y = std::max(maximum.y, v.y);
+        maximum.z = std::max(maximum.z, v.z);
+    }
+    return (float) cv::norm(maximum - minimum);
+}
+
+inline cv::Point3f transform(const cv::Matx33d &rotation, const cv::Vec3d &translation,
+                             const cv::Point3f &point) {
+    cv::Vec3d p = rotation * cv::Vec3d(point.x, point.y, point.z) + translation;
+    return cv::Point3f((float) p[0], (float) p[1], (float) p[2]);
+}
+
+/*!
+ * Samples the centroids of the faces that point towards the camera at the given pose.
+ * Counter-clockwise winding is assumed like OBJ and PLY files use it. Falls back to
+ * the vertices if the mesh has no faces or none of them are front facing.
+ */
+std::vector<cv::Point3f> sampleVisibleSurface(const Mesh &mesh,
+                                              const cv::Matx33d &rotation,
+                                              const cv::Vec3d &translation,
+                                              int maximumPoints) {
+    std::vector<cv::Point3f> samples;
+    for (const cv::Vec3i &face : mesh.triangles) {
+        cv::Point3f a = transform(rotation, translation, mesh.vertices[face[0]]);
+        cv::Point3f b = transform(rotation, translation, mesh.vertices[face[1]]);
+        cv::Point3f c = transform(rotation, translation, mesh.vertices[face[2]]);
+        cv::Point3f centroid = (a + b + c) * (1.f / 3.f);
+        if ((b - a).cross(c - a).dot(centroid) < 0) {
+            const cv::Point3f &ma = mesh.vertices[face[0]];
+            const cv::Point3f &mb = mesh.vertices[face[1]];
+            const cv::Point3f &mc = mesh.vertices[face[2]];
+            samples.push_back((ma + mb + mc) * (1.f / 3.f));
+        }
+    }
+    if (samples.empty()) {
+        samples = mesh.vertices;
+    }
+    if ((int) samples.size() > maximumPoints) {
+        std::vector<cv::Point3f> subsampled;
+        subsampled.reserve(maximumPoints);
+        double stride = samples.size() / (double) maximumPoints;
+        for (int i = 0; i < maximumPoints; i++) {
+            subsampled.push_back(samples[(size_t) (i * stride)]);
+        }
+        samples.swap(subsampled);
+    }
+    return samples;
+}
+
+float score(const KdTree &tree,
+            const std::vector<cv::Point3f> &modelPoints,
+            const cv::Matx33d &rotation,
+            const cv::Vec3d &translation,
+            float scoreDistance) {
+    const float squaredScoreDistance = scoreDistance * scoreDistance;
+    int explained = 0;
+    float squaredDistance;
+    for (const cv::Point3f &point : modelPoints) {
+        tree.nearest(transform(rotation, translation, point), squaredDistance);
+        if (squaredDistance < squaredScoreDistance) {
+            explained++;
+        }
+    }
+    return modelPoints.empty() ? 0.f : explained / (float) modelPoints.size();
+}
+
+}
+
+IcpRefiner::IcpRefiner() {
+}
+
+PoseRefinementResult IcpRefiner::refinePoseBlocking(const PoseRefinementTask &task) const {
+    using namespace PoseRefinement;
+
+    if (task.absoluteDepthImagePath.isEmpty()) {
+        return failedResult(task, "The image has no depth image.");
+    }
+
+    QString meshError;
+    MeshPtr mesh = MeshLoader::loadCached(task.absoluteObjectModelPath, &meshError);
+    if (mesh.isNull()) {
+        return failedResult(task, meshError);
+    }
+    if (mesh->vertices.empty()) {
+        return failedResult(task, "The object model is empty.");
+    }
+
+    QString depthError;
+    DepthMapPtr depthMap = DepthMap::loadCached(task.absoluteDepthImagePath, task.depthScale, &depthError);
+    if (depthMap.isNull()) {
+        return failedResult(task, depthError);
+    }
+
+    const cv::Matx33d cameraMatrix = toMatx(task.cameraMatrix);
+    const cv::Matx33d initialRotation = toMatx(task.rotation);
+    const cv::Vec3d initialTranslation = toVec(task.position);
+    const float size = modelSize(*mesh);
+
+    cv::Rect projected = SilhouetteRenderer::projectedBoundingRect(*mesh, cameraMatrix,
+                                                                   initialRotation,
+                                                                   initialTranslation);
+    if (projected.area() == 0) {
+        return failedResult(task, "The object is behind the camera.");
+    }
+    int marginX = (int) (projected.width * REGION_MARGIN);
+    int marginY = (int) (projected.height * REGION_MARGIN);
+    cv::Rect regionOfInterest(projected.x - marginX, projected.y - marginY,
+                              projected.width + 2 * marginX, projected.height + 2 * marginY);
+    regionOfInterest &= cv::Rect(0, 0, depthMap->width(), depthMap->height());
+    if (regionOfInterest.area() == 0) {
+        return failedResult(task, "The object is outside of the depth image.");
+    }
+
+    // Only depth points in the depth range of the object are candidates, this removes
+    // most of the background and occluders before building the tree
+    float minimumZ = std::numeric_limits<float>::max();
+    float maximumZ = std::numeric_limits<float>::lowest();
+    for (const cv::Point3f &v : mesh->vertices) {
+        float z = transform(initialRotation, initialTranslation, v).z;
+        minimumZ = std::min(minimumZ, z);
+        maximumZ = std::max(maximumZ, z);
+    }
+    minimumZ -= DEPTH_RANGE_MARGIN * size;
+    maximumZ += DEPTH_RANGE_MARGIN * size;
+
+    const int stride = std::max(1, (int) std::ceil(std::sqrt(regionOfInterest.area()
+                                                             / (double) m_maximumDepthPoints)));
+    const double fx = cameraMatrix(0, 0);
+    const double fy = cameraMatrix(1, 1);
+    const double cx = cameraMatrix(0, 2);
+    const double cy = cameraMatrix(1, 2);
+    std::vector<cv::Point3f> depthPoints;
+    depthPoints.reserve(m_maximumDepthPoints);
+    for (int y = regionOfInterest.y; y < regionOfInterest.y + regionOfInterest.height; y += stride) {
+        for (int x = regionOfInterest.x; x < regionOfInterest.x + regionOfInterest.width; x += stride) {
+            float z = depthMap->depth(x, y);
+            if (z <= 0 || z < minimumZ || z > maximumZ) {
+                continue;
+            }
+            depthPoints.push_back(cv::Point3f((float) ((x - cx) * z / fx),
+                                              (float) ((y - cy) * z / fy),
+                                              z));
+        }
+    }
+    if ((int) depthPoints.size() < MINIMUM_CORRESPONDENCES) {
+        return failedResult(task, "The depth image has no measurements near the pose.");
+    }
+
+    const KdTree tree(depthPoints);
+    const std::vector<cv::Point3f> modelPoints =
+            sampleVisibleSurface(*mesh, initialRotation, initialTranslation, m_maximumModelPoints);
+    const float scoreDistance = SCORE_DISTANCE * size;
+    const float initialScore = score(tree, modelPoints, initialRotation, initialTranslation, scoreDistance);
+
+    cv::Matx33d rotation = initialRotation;
+    cv::Vec3d translation = initialTranslation;
+    float rejectionDistance = INITIAL_REJECTION_DISTANCE * size;
+    std::vector<cv::Point3f> source;
+    std::vector<cv::Point3f> target;
+    std::vector<float> distances;
+    source.reserve(modelPoints.size());
+    target.reserve(modelPoints.size());
+    distances.reserve(modelPoints.size());
+
+    for (int iteration = 0; iteration < m_maximumIterations; iteration++) {
+        source.clear();
+        target.clear();
+        distances.clear();
+        const float squaredRejectionDistance = rejectionDistance * rejectionDistance;
+        float squaredDistance;
+        for (const cv::Point3f &point : modelPoints) {
+            cv::Point3f transformed = transform(rotation, translation, point);
+            int nearest = tree.nearest(transformed, squaredDistance);
+            if (nearest >= 0 && squaredDistance < squaredRejectionDistance) {
+                source.push_back(transformed);
+                target.push_back(depthPoints[nearest]);
+                distances.push_back(std::sqrt(squaredDistance));
+            }
+        }
+        if ((int) source.size() < MINIMUM_CORRESPONDENCES) {
+            break;
+        }
+
+        // Closed form rigid alignment of the correspondences (Kabsch)
+        cv::Point3d sourceCentroid(0, 0, 0);
+        cv::Point3d targetCentroid(0, 0, 0);
+        for (size_t i = 0; i < source.size(); i++) {
+            sourceCentroid += cv::Point3d(source[i]);
+            targetCentroid += cv::Point3d(target[i]);
+        }
+        sourceCentroid *= 1.0 / source.size();
+        targetCentroid *= 1.0 / source.size();
+        cv::Matx33d covariance = cv::Matx33d::zeros();
+        for (size_t i = 0; i < source.size(); i++) {
+            cv::Vec3d s = cv::Vec3d(cv::Point3d(source[i]) - sourceCentroid);
+            cv::Vec3d t = cv::Vec3d(cv::Point3d(target[i]) - targetCentroid);
+            covariance += s * t.t();
+        }
+        cv::Mat w, u, vt;
+        cv::SVD::compute(cv::Mat(covariance), w, u, vt);
+        cv::Matx33d deltaRotation = cv::Matx33d(cv::Mat(vt.t() * u.t()));
+        if (cv::determinant(deltaRotation) < 0) {
+            // Reflection, flip the axis of the smallest singular value
+            cv::Mat v = vt.t();
+            v.col(2) *= -1;
+            deltaRotation = cv::Matx33d(cv::Mat(v * u.t()));
+        }
+        cv::Vec3d deltaTranslation = cv::Vec3d(targetCentroid)
+                - deltaRotation * cv::Vec3d(sourceCentroid);
+
+        rotation = deltaRotation * rotation;
+        translation = deltaRotation * translation + deltaTranslation;
+
+        // Reject outliers more aggressively the closer the alignment gets
+        std::nth_element(distances.begin(), distances.begin() + distances.size() / 2, distances.end());
+        rejectionDistance = std::max(MINIMUM_REJECTION_DISTANCE * size,
+                                     std::min(rejectionDistance, 3.f * distances[distances.size() / 2]));
+
+        cv::Vec3d rotationVector;
+        cv::Rodrigues(deltaRotation, rotationVector);
+        if (cv::norm(deltaTranslation) < CONVERGENCE_TRANSLATION * size
+                && cv::norm(rotationVector) < CONVERGENCE_ROTATION) {
+            break;
+        }
+    }
+
+    const float finalScore = score(tree, modelPoints, rotation, translation, scoreDistance);
+
+    PoseRefinementResult result;
+    result.poseId = task.poseId;
+    result.success = true;
+    result.initialScore = initialScore;
+    if (finalScore >= initialScore) {
+        result.rotation = toQMatrix(rotation);
+        result.position = toQVector(translation);
+        result.finalScore = finalScore;
+    } else {
+        // ICP converged to something that fits the depth worse, e.g. because of occluders
+        result.rotation = task.rotation;
+        result.position = task.position;
+        result.finalScore = initialScore;
+    }
+    return result;
+}
+
+void IcpRefiner::setMaximumIterations(int maximumIterations) {
+    m_maximumIterations = maximumIterations;
+}
+
+int IcpRefiner::maximumIterations() const {
+    return m_maximumIterations;
+}
+
+void IcpRefiner::setMaximumModelPoints(int maximumModelPoints) {
+    m_maximumModelPoints = maximumModelPoints;
+}
+
+int IcpRefiner::maximumModelPoints() const {
+    return m_maximumModelPoints;
+}
+
+void IcpRefiner::setMaximumDepthPoints(int maximumDepthPoints) {
+    m_maximumDepthPoints = maximumDepthPoints;
+}
+
+int IcpRefiner::maximumDepthPoints() const {
+    return m_maximumDepthPoints;
+}
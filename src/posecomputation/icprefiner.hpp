@@ -0,0 +1,50 @@
+#ifndef ICPREFINER_H
+#define ICPREFINER_H
+
+#include "poserefinement.hpp"
+
+/*!
+ * \brief The IcpRefiner class refines poses by aligning points sampled on the visible
+ * surface of the object model to the points of the depth map of the image (iterative
+ * closest point). The depth map is back-projected only in the region around the pose
+ * and correspondences are looked up in a k-d tree, which makes a refinement take only
+ * a few milliseconds.
+ *
+ * The score of the results is the fraction of sampled model points that lie close to
+ * a depth point, i.e. how well the object's surface is explained by the measured depth.
+ */
+class IcpRefiner {
+
+public:
+    IcpRefiner();
+
+    /*!
+     * \brief refinePoseBlocking refines the pose in the calling thread. The task needs
+     * a depth image path.
+     */
+    PoseRefinementResult refinePoseBlocking(const PoseRefinementTask &task) const;
+
+    void setMaximumIterations(int maximumIterations);
+    int maximumIterations() const;
+
+    /*!
+     * \brief setMaximumModelPoints sets how many points are sampled on the visible
+     * surface of the object model at most.
+     */
+    void setMaximumModelPoints(int maximumModelPoints);
+    int maximumModelPoints() const;
+
+    /*!
+     * \brief setMaximumDepthPoints sets how many points of the depth map around the pose
+     * are used at most, the depth map is subsampled accordingly.
+     */
+    void setMaximumDepthPoints(int maximumDepthPoints);
+    int maximumDepthPoints() const;
+
+private:
+    int m_maximumIterations = 30;
+    int m_maximumModelPoints = 2000;
+    int m_maximumDepthPoints = 8000;
+};
+
+#endif // ICPREFINER_H
@@ -0,0 +1,82 @@
+#include "kdtree.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+inline float coordinate(const cv::Point3f &point, int axis) {
+    return axis == 0 ? point.x : (axis == 1 ? point.y : point.z);
+}
+
+inline float squaredDistance(const cv::Point3f &a, const cv::Point3f &b) {
+    cv::Point3f d = a - b;
+    return d.x * d.x + d.y * d.y + d.z * d.z;
+}
+
+}
+
+KdTree::KdTree(const std::vector<cv::Point3f> &points)
+    : m_points(points) {
+    m_indices.resize(m_points.size());
+    for (size_t i = 0; i < m_indices.size(); i++) {
+        m_indices[i] = (int) i;
+    }
+    m_nodes.reserve(m_points.size());
+    m_root = build(0, (int) m_indices.size(), 0);
+}
+
+int KdTree::build(int begin, int end, int depth) {
+    if (begin >= end) {
+        return -1;
+    }
+    int axis = depth % 3;
+    int middle = begin + (end - begin) / 2;
+    std::nth_element(m_indices.begin() + begin,
+                     m_indices.begin() + middle,
+                     m_indices.begin() + end,
+                     [this, axis](int a, int b) {
+        return coordinate(m_points[a], axis) < coordinate(m_points[b], axis);
+    });
+    int nodeIndex = (int) m_nodes.size();
+    m_nodes.push_back(Node{m_indices[middle], axis, -1, -1});
+    int left = build(begin, middle, depth + 1);
+    int right = build(middle + 1, end, depth + 1);
+    // Don't keep a reference across the recursion, the vector might have reallocated
+    m_nodes[nodeIndex].left = left;
+    m_nodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+int KdTree::nearest(const cv::Point3f &query, float &squaredDistance) const {
+    int best = -1;
+    squaredDistance = std::numeric_limits<float>::max();
+    search(m_root, query, best, squaredDistance);
+    return best;
+}
+
+void KdTree::search(int nodeIndex, const cv::Point3f &query,
+                    int &best, float &bestSquaredDistance) const {
+    if (nodeIndex < 0) {
+        return;
+    }
+    const Node &node = m_nodes[nodeIndex];
+    const cv::Point3f &point = m_points[node.point];
+    float distance = squaredDistance(point, query);
+    if (distance < bestSquaredDistance) {
+        bestSquaredDistance = distance;
+        best = node.point;
+    }
+    float difference = coordinate(query, node.axis) - coordinate(point, node.axis);
+    int nearSide = difference < 0 ? node.left : node.right;
+    int farSide = difference < 0 ? node.right : node.left;
+    search(nearSide, query, best, bestSquaredDistance);
+    // Only descend into the other half if the splitting plane is closer than the best match
+    if (difference * difference < bestSquaredDistance) {
+        search(farSide, query, best, bestSquaredDistance);
+    }
+}
+
+const std::vector<cv::Point3f> &KdTree::points() const {
+    return m_points;
+}
@@ -0,0 +1,45 @@
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \brief The KdTree class is a static three-dimensional k-d tree for exact nearest
+ * neighbor queries, e.g. to find correspondences between point clouds.
+ */
+class KdTree {
+
+public:
+    explicit KdTree(const std::vector<cv::Point3f> &points);
+
+    /*!
+     * \brief nearest finds the point closest to query.
+     * \param query the point to find the nearest neighbor of
+     * \param squaredDistance is set to the squared distance to the nearest neighbor
+     * \return the index of the nearest point in the points passed to the constructor
+     * or -1 if the tree is empty
+     */
+    int nearest(const cv::Point3f &query, float &squaredDistance) const;
+
+    const std::vector<cv::Point3f> &points() const;
+
+private:
+    struct Node {
+        int point;
+        int axis;
+        int left;
+        int right;
+    };
+
+    int build(int begin, int end, int depth);
+    void search(int node, const cv::Point3f &query, int &best, float &bestSquaredDistance) const;
+
+private:
+    std::vector<cv::Point3f> m_points;
+    std::vector<int> m_indices;
+    std::vector<Node> m_nodes;
+    int m_root = -1;
+};
+
+#endif // KDTREE_H
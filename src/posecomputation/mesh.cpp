@@ -0,0 +1,283 @@
+#include "mesh.hpp"
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QTextStream>
+#include <QDebug>
+
+namespace {
+
+struct PlyProperty {
+    QString name;
+    QString type;
+    bool isList = false;
+    QString countType;
+};
+
+struct PlyElement {
+    QString name;
+    int count = 0;
+    QList<PlyProperty> properties;
+};
+
+enum PlyFormat {
+    Ascii,
+    BinaryLittleEndian,
+    BinaryBigEndian
+};
+
+double readBinaryValue(QDataStream &stream, const QString &type) {
+    if (type == "char" || type == "int8") {
+        qint8 value; stream >> value; return value;
+    } else if (type == "uchar" || type == "uint8") {
+        quint8 value; stream >> value; return value;
+    } else if (type == "short" || type == "int16") {
+        qint16 value; stream >> value; return value;
+    } else if (type == "ushort" || type == "uint16") {
+        quint16 value; stream >> value; return value;
+    } else if (type == "int" || type == "int32") {
+        qint32 value; stream >> value; return value;
+    } else if (type == "uint" || type == "uint32") {
+        quint32 value; stream >> value; return value;
+    } else if (type == "float" || type == "float32") {
+        float value;
+        stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        stream >> value;
+        return value;
+    } else if (type == "double" || type == "float64") {
+        double value;
+        stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+        stream >> value;
+        return value;
+    }
+    stream.setStatus(QDataStream::ReadCorruptData);
+    return 0;
+}
+
+double readValue(QTextStream *textStream, QDataStream *dataStream, const QString &type) {
+    if (textStream) {
+        double value;
+        *textStream >> value;
+        return value;
+    }
+    return readBinaryValue(*dataStream, type);
+}
+
+bool streamOk(QTextStream *textStream, QDataStream *dataStream) {
+    return textStream ? textStream->status() == QTextStream::Ok
+                      : dataStream->status() == QDataStream::Ok;
+}
+
+void appendPolygon(Mesh &mesh, const std::vector<int> &polygon) {
+    // Fan triangulation, sufficient for the convex faces of typical models
+    for (size_t i = 2; i < polygon.size(); i++) {
+        mesh.triangles.push_back(cv::Vec3i(polygon[0], polygon[i - 1], polygon[i]));
+    }
+}
+
+QMutex cacheMutex;
+QMap<QString, MeshPtr> meshCache;
+
+}
+
+MeshPtr MeshLoader::loadCached(const QString &absolutePath, QString *errorMessage) {
+    {
+        QMutexLocker locker(&cacheMutex);
+        if (meshCache.contains(absolutePath)) {
+            return meshCache[absolutePath];
+        }
+    }
+    // Load without holding the lock, worst case two threads load the same mesh
+    MeshPtr mesh = load(absolutePath, errorMessage);
+    if (!mesh.isNull()) {
+        QMutexLocker locker(&cacheMutex);
+        meshCache[absolutePath] = mesh;
+    }
+    return mesh;
+}
+
+MeshPtr MeshLoader::load(const QString &absolutePath, QString *errorMessage) {
+    QSharedPointer<Mesh> mesh(new Mesh);
+    QString error;
+    QString suffix = QFileInfo(absolutePath).suffix().toLower();
+    bool loaded = false;
+    if (suffix == "obj") {
+        loaded = loadOBJ(absolutePath, *mesh, error);
+    } else if (suffix == "ply") {
+        loaded = loadPLY(absolutePath, *mesh, error);
+    } else {
+        error = "Unsupported mesh format " + suffix + ".";
+    }
+    if (loaded && (mesh->vertices.empty() || mesh->triangles.empty())) {
+        loaded = false;
+        error = "Mesh has no triangles.";
+    }
+    if (!loaded) {
+        qDebug() << "Could not load mesh" << absolutePath << ":" << error;
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        return MeshPtr();
+    }
+    return mesh;
+}
+
+void MeshLoader::clearCache() {
+    QMutexLocker locker(&cacheMutex);
+    meshCache.clear();
+}
+
+bool MeshLoader::loadOBJ(const QString &absolutePath, Mesh &mesh, QString &errorMessage) {
+    QFile file(absolutePath);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        errorMessage = "Could not open file.";
+        return false;
+    }
+    QTextStream stream(&file);
+    QString line;
+    std::vector<int> polygon;
+    while (stream.readLineInto(&line)) {
+        QStringList tokens = line.split(' ', Qt::SkipEmptyParts);
+        if (tokens.isEmpty()) {
+            continue;
+        }
+        if (tokens[0] == "v" && tokens.size() >= 4) {
+            mesh.vertices.push_back(cv::Point3f(tokens[1].toFloat(),
+                                                tokens[2].toFloat(),
+                                                tokens[3].toFloat()));
+        } else if (tokens[0] == "f" && tokens.size() >= 4) {
+            polygon.clear();
+            for (int i = 1; i < tokens.size(); i++) {
+                // Faces can be v, v/vt, v//vn or v/vt/vn and indices can be negative
+                int index = tokens[i].section('/', 0, 0).toInt();
+                index = index < 0 ? (int) mesh.vertices.size() + index : index - 1;
+                if (index < 0 || index >= (int) mesh.vertices.size()) {
+                    errorMessage = "Face references unknown vertex.";
+                    return false;
+                }
+                polygon.push_back(index);
+            }
+            appendPolygon(mesh, polygon);
+        }
+    }
+    return true;
+}
+
+bool MeshLoader::loadPLY(const QString &absolutePath, Mesh &mesh, QString &errorMessage) {
+    QFile file(absolutePath);
+    if (!file.open(QFile::ReadOnly)) {
+        errorMessage = "Could not open file.";
+        return false;
+    }
+
+    if (file.readLine().trimmed() != "ply") {
+        errorMessage = "Not a PLY file.";
+        return false;
+    }
+
+    PlyFormat format = Ascii;
+    QList<PlyElement> elements;
+    bool headerFinished = false;
+    while (!file.atEnd()) {
+        QStringList tokens = QString::fromLatin1(file.readLine()).simplified().split(' ');
+        if (tokens[0] == "end_header") {
+            headerFinished = true;
+            break;
+        } else if (tokens[0] == "format" && tokens.size() > 1) {
+            if (tokens[1] == "binary_little_endian") {
+                format = BinaryLittleEndian;
+            } else if (tokens[1] == "binary_big_endian") {
+                format = BinaryBigEndian;
+            }
+        } else if (tokens[0] == "element" && tokens.size() > 2) {
+            PlyElement element;
+            element.name = tokens[1];
+            element.count = tokens[2].toInt();
+            elements.append(element);
+        } else if (tokens[0] == "property" && !elements.isEmpty()) {
+            PlyProperty property;
+            if (tokens.size() > 4 && tokens[1] == "list") {
+                property.isList = true;
+                property.countType = tokens[2];
+                property.type = tokens[3];
+                property.name = tokens[4];
+            } else if (tokens.size() > 2) {
+                property.type = tokens[1];
+                property.name = tokens[2];
+            }
+            elements.last().properties.append(property);
+        }
+    }
+    if (!headerFinished) {
+        errorMessage = "PLY header is incomplete.";
+        return false;
+    }
+
+    QScopedPointer<QTextStream> textStream;
+    QScopedPointer<QDataStream> dataStream;
+    if (format == Ascii) {
+        textStream.reset(new QTextStream(&file));
+    } else {
+        dataStream.reset(new QDataStream(&file));
+        dataStream->setByteOrder(format == BinaryLittleEndian ? QDataStream::LittleEndian
+                                                              : QDataStream::BigEndian);
+    }
+
+    std::vector<int> polygon;
+    for (const PlyElement &element : elements) {
+        int xIndex = -1, yIndex = -1, zIndex = -1;
+        for (int p = 0; p < element.properties.size(); p++) {
+            const QString &name = element.properties[p].name;
+            if (name == "x") xIndex = p;
+            else if (name == "y") yIndex = p;
+            else if (name == "z") zIndex = p;
+        }
+        for (int i = 0; i < element.count; i++) {
+            cv::Point3f vertex;
+            for (int p = 0; p < element.properties.size(); p++) {
+                const PlyProperty &property = element.properties[p];
+                if (property.isList) {
+                    int count = (int) readValue(textStream.data(), dataStream.data(),
+                                                property.countType);
+                    polygon.clear();
+                    for (int j = 0; j < count; j++) {
+                        polygon.push_back((int) readValue(textStream.data(), dataStream.data(),
+                                                          property.type));
+                    }
+                    if (element.name == "face"
+                            && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                        appendPolygon(mesh, polygon);
+                    }
+                } else {
+                    float value = (float) readValue(textStream.data(), dataStream.data(),
+                                                    property.type);
+                    if (p == xIndex) vertex.x = value;
+                    else if (p == yIndex) vertex.y = value;
+                    else if (p == zIndex) vertex.z = value;
+                }
+            }
+            if (element.name == "vertex") {
+                mesh.vertices.push_back(vertex);
+            }
+            if (!streamOk(textStream.data(), dataStream.data())) {
+                errorMessage = "Unexpected end of PLY data.";
+                return false;
+            }
+        }
+    }
+
+    for (const cv::Vec3i &triangle : mesh.triangles) {
+        for (int j = 0; j < 3; j++) {
+            if (triangle[j] < 0 || triangle[j] >= (int) mesh.vertices.size()) {
+                errorMessage = "Face references unknown vertex.";
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <QSharedPointer>
+#include <QString>
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \brief The Mesh struct is a plain triangle mesh in object model coordinates, used by
+ * the pose computation algorithms that run on the CPU (independently of Qt3D).
+ */
+struct Mesh {
+    std::vector<cv::Point3f> vertices;
+    std::vector<cv::Vec3i> triangles;
+};
+
+typedef QSharedPointer<const Mesh> MeshPtr;
+
+/*!
+ * \brief The MeshLoader class reads triangle meshes from Wavefront OBJ and Stanford PLY
+ * (ASCII and binary) files. Loaded meshes are cached by path so that refining many poses
+ * of the same object model parses the file only once.
+ */
+class MeshLoader {
+
+public:
+    /*!
+     * \brief loadCached returns the cached mesh for the given path or loads it. This
+     * function is thread-safe.
+     * \param absolutePath the absolute path to the mesh file
+     * \param errorMessage set to the reason of failure if the mesh could not be loaded
+     * \return the mesh or a null pointer if loading failed
+     */
+    static MeshPtr loadCached(const QString &absolutePath, QString *errorMessage = Q_NULLPTR);
+
+    /*!
+     * \brief load loads the mesh at the given path bypassing the cache.
+     */
+    static MeshPtr load(const QString &absolutePath, QString *errorMessage = Q_NULLPTR);
+
+    static void clearCache();
+
+private:
+    static bool loadOBJ(const QString &absolutePath, Mesh &mesh, QString &errorMessage);
+    static bool loadPLY(const QString &absolutePath, Mesh &mesh, QString &errorMessage);
+};
+
+#endif // MESH_H
@@ -0,0 +1,24 @@
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/depthmap.hpp \
+    $$PWD/icprefiner.hpp \
+    $$PWD/kdtree.hpp \
+    $$PWD/mesh.hpp \
+    $$PWD/posepropagator.hpp \
+    $$PWD/poserecoverer.hpp \
+    $$PWD/poserefinement.hpp \
+    $$PWD/poserefiner.hpp \
+    $$PWD/silhouetterefiner.hpp \
+    $$PWD/silhouetterenderer.hpp
+
+SOURCES += \
+    $$PWD/depthmap.cpp \
+    $$PWD/icprefiner.cpp \
+    $$PWD/kdtree.cpp \
+    $$PWD/mesh.cpp \
+    $$PWD/posepropagator.cpp \
+    $$PWD/poserecoverer.cpp \
+    $$PWD/poserefiner.cpp \
+    $$PWD/silhouetterefiner.cpp \
+    $$PWD/silhouetterenderer.cpp
@@ -0,0 +1,141 @@
+#include "posepropagator.hpp"
+#include "poserefinement.hpp"
+
+#include <QHash>
+#include <QtConcurrent>
+
+namespace {
+
+// A pose in the world coordinate system of a scene
+struct WorldPose {
+    ObjectModelPtr objectModel;
+    cv::Matx33d rotation;
+    cv::Vec3d translation;
+};
+
+// A pose that already exists on a target image
+struct ExistingPose {
+    QString objectModelPath;
+    QVector3D position;
+};
+
+struct PropagationTask {
+    ImagePtr image;
+    QList<ExistingPose> existingPoses;
+};
+
+// Poses of the same object model closer than this fraction of their distance to the camera
+// are the same instance. Two instances can't be that close without intersecting while
+// poses that were propagated before (and maybe refined since) still are.
+const float SAME_INSTANCE_DISTANCE = 0.01f;
+
+WorldPose toWorld(const QVector3D &position, const QMatrix3x3 &rotation, const Image &image) {
+    using namespace PoseRefinement;
+    // x_camera = R_w2c * x_world + t_w2c <=> x_world = R_w2c^T * (x_camera - t_w2c)
+    const cv::Matx33d cameraRotationInverse = toMatx(image.cameraRotation()).t();
+    WorldPose worldPose;
+    worldPose.rotation = cameraRotationInverse * toMatx(rotation);
+    worldPose.translation = cameraRotationInverse * (toVec(position) - toVec(image.cameraTranslation()));
+    return worldPose;
+}
+
+void toCamera(const WorldPose &worldPose, const Image &image,
+              QVector3D &position, QMatrix3x3 &rotation) {
+    using namespace PoseRefinement;
+    const cv::Matx33d cameraRotation = toMatx(image.cameraRotation());
+    rotation = toQMatrix(cameraRotation * worldPose.rotation);
+    position = toQVector(cameraRotation * worldPose.translation + toVec(image.cameraTranslation()));
+}
+
+// Functor for QtConcurrent::mapped which requires result_type in Qt 5
+struct PropagateFunctor {
+    typedef QList<PropagatedPose> result_type;
+
+    QList<WorldPose> worldPoses;
+
+    QList<PropagatedPose> operator()(const PropagationTask &task) const {
+        QList<PropagatedPose> propagatedPoses;
+        for (const WorldPose &worldPose : worldPoses) {
+            PropagatedPose propagatedPose;
+            propagatedPose.image = task.image;
+            propagatedPose.objectModel = worldPose.objectModel;
+            toCamera(worldPose, *task.image, propagatedPose.position, propagatedPose.rotation);
+            if (!isAnnotated(propagatedPose, task.existingPoses)) {
+                propagatedPoses.append(propagatedPose);
+            }
+        }
+        return propagatedPoses;
+    }
+
+    // Rotations are not compared since symmetric objects can be annotated in any of them
+    static bool isAnnotated(const PropagatedPose &propagatedPose,
+                            const QList<ExistingPose> &existingPoses) {
+        const float maxDistance = SAME_INSTANCE_DISTANCE * propagatedPose.position.length();
+        for (const ExistingPose &existingPose : existingPoses) {
+            if (existingPose.objectModelPath == propagatedPose.objectModel->path()
+                    && existingPose.position.distanceToPoint(propagatedPose.position) <= maxDistance) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+}
+
+PosePropagator::PosePropagator() {
+}
+
+QFuture<QList<PropagatedPose>> PosePropagator::propagatePoses(const QList<PosePtr> &poses,
+                                                              const QList<ImagePtr> &images,
+                                                              const QList<PosePtr> &existingPoses) const {
+    PropagateFunctor functor;
+    QList<PropagationTask> tasks;
+    if (!poses.isEmpty() && poses.first()->image()->hasCameraExtrinsics()) {
+        const Image &sourceImage = *poses.first()->image();
+        for (const PosePtr &pose : poses) {
+            WorldPose worldPose = toWorld(pose->position(),
+                                          pose->rotation().toRotationMatrix(),
+                                          sourceImage);
+            worldPose.objectModel = pose->objectModel();
+            functor.worldPoses.append(worldPose);
+        }
+
+        QHash<QString, QList<ExistingPose>> existingPosesOfImages;
+        for (const PosePtr &pose : existingPoses) {
+            existingPosesOfImages[pose->image()->id()].append(
+                        ExistingPose{pose->objectModel()->path(), pose->position()});
+        }
+        for (const ImagePtr &image : sceneImages(sourceImage, images)) {
+            tasks.append(PropagationTask{image, existingPosesOfImages.value(image->id())});
+        }
+    }
+    return QtConcurrent::mapped(tasks, functor);
+}
+
+QList<ImagePtr> PosePropagator::sceneImages(const Image &image, const QList<ImagePtr> &images) {
+    QList<ImagePtr> result;
+    for (const ImagePtr &otherImage : images) {
+        if (otherImage->id() != image.id() && belongToSameScene(image, *otherImage)) {
+            result.append(otherImage);
+        }
+    }
+    return result;
+}
+
+bool PosePropagator::belongToSameScene(const Image &image, const Image &otherImage) {
+    return image.hasCameraExtrinsics()
+            && otherImage.hasCameraExtrinsics()
+            && !image.sceneId().isEmpty()
+            && image.sceneId() == otherImage.sceneId();
+}
+
+bool PosePropagator::transformPose(const QVector3D &position, const QMatrix3x3 &rotation,
+                                   const Image &sourceImage, const Image &targetImage,
+                                   QVector3D &targetPosition, QMatrix3x3 &targetRotation) {
+    if (!belongToSameScene(sourceImage, targetImage)) {
+        return false;
+    }
+    toCamera(toWorld(position, rotation, sourceImage), targetImage, targetPosition, targetRotation);
+    return true;
+}
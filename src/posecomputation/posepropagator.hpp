@@ -0,0 +1,70 @@
+#ifndef POSEPROPAGATOR_H
+#define POSEPROPAGATOR_H
+
+#include "model/image.hpp"
+#include "model/objectmodel.hpp"
+#include "model/pose.hpp"
+
+#include <QFuture>
+#include <QList>
+#include <QMatrix3x3>
+#include <QVector3D>
+
+/*!
+ * \brief The PropagatedPose struct holds the values of a pose transferred to another image.
+ */
+struct PropagatedPose {
+    ImagePtr image;
+    ObjectModelPtr objectModel;
+    QVector3D position;
+    QMatrix3x3 rotation;
+};
+
+/*!
+ * \brief The PosePropagator class transfers poses between images of the same scene using
+ * the camera extrinsics of the images. A scene is a set of images with the same scene ID
+ * whose extrinsics refer to the same world coordinate system (like a T-LESS scene). Since
+ * the objects are static in the world, a pose annotated in one image determines the poses
+ * in all other images of the scene. Images without scene ID are never propagated to,
+ * the loaders only assign one if the dataset states it.
+ */
+class PosePropagator {
+
+public:
+    PosePropagator();
+
+    /*!
+     * \brief propagatePoses transforms the given poses into all other images of their scene
+     * in parallel. A pose is not added to a target image that already has a pose of the same
+     * object model at the same position, e.g. because it was propagated before. Other
+     * instances of the object model are still added.
+     * \param poses the poses to propagate, all of the same image which needs extrinsics
+     * \param images the candidate target images, the ones not in the scene are ignored
+     * \param existingPoses the poses that already exist, to not duplicate them
+     * \return a future with one list of propagated poses per target image, it reports
+     * progress per image
+     */
+    QFuture<QList<PropagatedPose>> propagatePoses(const QList<PosePtr> &poses,
+                                                  const QList<ImagePtr> &images,
+                                                  const QList<PosePtr> &existingPoses) const;
+
+    /*!
+     * \brief sceneImages returns the images of the scene of the given image (excluding the
+     * image itself) that have camera extrinsics.
+     */
+    static QList<ImagePtr> sceneImages(const Image &image, const QList<ImagePtr> &images);
+
+    //! Both images need camera extrinsics and the same, non-empty scene ID
+    static bool belongToSameScene(const Image &image, const Image &otherImage);
+
+    /*!
+     * \brief transformPose transforms the pose with the given values from the camera frame
+     * of the source image to the one of the target image.
+     * \return false if one of the images has no extrinsics or they are not in the same scene
+     */
+    static bool transformPose(const QVector3D &position, const QMatrix3x3 &rotation,
+                              const Image &sourceImage, const Image &targetImage,
+                              QVector3D &targetPosition, QMatrix3x3 &targetRotation);
+};
+
+#endif // POSEPROPAGATOR_H
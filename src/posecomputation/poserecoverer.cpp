@@ -0,0 +1,184 @@
+#include "poserecoverer.hpp"
+
+#include <QSharedPointer>
+#include <QtConcurrent>
+#include <QtMath>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/calib3d/calib3d.hpp>
+
+namespace {
+
+// The RANSAC variants of the iterative and EPnP solvers estimate their models from 5
+// points, with fewer correspondences they fail or (depending on the OpenCV version) fall
+// back to P3P, which AP3P covers already
+const int MINIMUM_POINTS_ITERATIVE_EPNP = 5;
+
+// The inputs shared by all solvers, converted only once
+struct Correspondences {
+    std::vector<cv::Point2d> imagePoints;
+    std::vector<cv::Point3d> objectPoints;
+    cv::Mat cameraMatrix;
+    float reprojectionThreshold;
+    int ransacIterations;
+};
+
+struct SolverTask {
+    int flag;
+    QString name;
+    QSharedPointer<const Correspondences> correspondences;
+};
+
+PoseRecoveringResult failedResult(const QString &solverName, const QString &message) {
+    PoseRecoveringResult result;
+    result.solverName = solverName;
+    result.errorMessage = message;
+    return result;
+}
+
+PoseRecoveringResult runSolver(const SolverTask &task) {
+    const Correspondences &c = *task.correspondences;
+    cv::Mat rvec;
+    cv::Mat tvec;
+    std::vector<int> inlierIndices;
+
+    try {
+        bool found = cv::solvePnPRansac(c.objectPoints, c.imagePoints, c.cameraMatrix, cv::noArray(),
+                                        rvec, tvec, false, c.ransacIterations,
+                                        c.reprojectionThreshold, 0.99, inlierIndices, task.flag);
+        if (!found || inlierIndices.size() < 4) {
+            return failedResult(task.name, "Not enough inliers.");
+        }
+
+        // Levenberg-Marquardt refinement on the inliers only, starting from the RANSAC pose
+        std::vector<cv::Point2d> inlierImagePoints;
+        std::vector<cv::Point3d> inlierObjectPoints;
+        for (int index : inlierIndices) {
+            inlierImagePoints.push_back(c.imagePoints[index]);
+            inlierObjectPoints.push_back(c.objectPoints[index]);
+        }
+        cv::solvePnP(inlierObjectPoints, inlierImagePoints, c.cameraMatrix, cv::noArray(),
+                     rvec, tvec, true, cv::SOLVEPNP_ITERATIVE);
+    } catch (const cv::Exception &e) {
+        return failedResult(task.name, QString::fromStdString(e.msg));
+    }
+
+    PoseRecoveringResult result;
+    result.success = true;
+    result.solverName = task.name;
+
+    std::vector<cv::Point2d> projectedPoints;
+    cv::projectPoints(c.objectPoints, rvec, tvec, c.cameraMatrix, cv::noArray(), projectedPoints);
+    double squaredErrorSum = 0;
+    for (size_t i = 0; i < projectedPoints.size(); i++) {
+        float residual = (float) cv::norm(projectedPoints[i] - c.imagePoints[i]);
+        bool inlier = residual <= c.reprojectionThreshold;
+        result.residuals.append(residual);
+        result.inliers.append(inlier);
+        if (inlier) {
+            result.numberOfInliers++;
+            squaredErrorSum += residual * residual;
+        }
+    }
+    if (result.numberOfInliers > 0) {
+        result.inlierRMS = (float) qSqrt(squaredErrorSum / result.numberOfInliers);
+    }
+
+    cv::Mat rotationMatrix;
+    cv::Rodrigues(rvec, rotationMatrix);
+    float rotationValues[9];
+    for (int i = 0; i < 9; i++) {
+        rotationValues[i] = (float) rotationMatrix.at<double>(i / 3, i % 3);
+    }
+    result.rotation = QMatrix3x3(rotationValues);
+    result.position = QVector3D(tvec.at<double>(0, 0),
+                                tvec.at<double>(1, 0),
+                                tvec.at<double>(2, 0));
+    return result;
+}
+
+bool isBetterResult(const PoseRecoveringResult &candidate, const PoseRecoveringResult &best) {
+    if (!candidate.success) {
+        return false;
+    }
+    if (!best.success) {
+        return true;
+    }
+    if (candidate.numberOfInliers != best.numberOfInliers) {
+        return candidate.numberOfInliers > best.numberOfInliers;
+    }
+    return candidate.inlierRMS < best.inlierRMS;
+}
+
+}
+
+PoseRecoverer::PoseRecoverer() {
+}
+
+QFuture<PoseRecoveringResult> PoseRecoverer::recoverPose(const QList<QPoint> &points2D,
+                                                         const QList<QVector3D> &points3D,
+                                                         const QMatrix3x3 &cameraMatrix) const {
+    // Copy the recoverer so that the settings don't change while the recovery is running
+    PoseRecoverer recoverer = *this;
+    return QtConcurrent::run([recoverer, points2D, points3D, cameraMatrix]() {
+        return recoverer.recoverPoseBlocking(points2D, points3D, cameraMatrix);
+    });
+}
+
+PoseRecoveringResult PoseRecoverer::recoverPoseBlocking(const QList<QPoint> &points2D,
+                                                        const QList<QVector3D> &points3D,
+                                                        const QMatrix3x3 &cameraMatrix) const {
+    if (points2D.size() != points3D.size() || points2D.size() < 4) {
+        return failedResult("", "At least 4 complete correspondences are required.");
+    }
+
+    QSharedPointer<Correspondences> correspondences(new Correspondences);
+    for (int i = 0; i < points2D.size(); i++) {
+        correspondences->imagePoints.push_back(cv::Point2d(points2D[i].x(), points2D[i].y()));
+        correspondences->objectPoints.push_back(cv::Point3d(points3D[i].x(),
+                                                            points3D[i].y(),
+                                                            points3D[i].z()));
+    }
+    correspondences->cameraMatrix = (cv::Mat_<double>(3, 3) <<
+                                     cameraMatrix(0, 0), 0, cameraMatrix(0, 2),
+                                     0, cameraMatrix(1, 1), cameraMatrix(1, 2),
+                                     0, 0, 1);
+    correspondences->reprojectionThreshold = m_reprojectionThreshold;
+    correspondences->ransacIterations = m_ransacIterations;
+
+    QList<SolverTask> tasks;
+    if (points2D.size() >= MINIMUM_POINTS_ITERATIVE_EPNP) {
+        tasks << SolverTask{cv::SOLVEPNP_ITERATIVE, "Iterative", correspondences}
+              << SolverTask{cv::SOLVEPNP_EPNP, "EPnP", correspondences};
+    }
+    tasks << SolverTask{cv::SOLVEPNP_AP3P, "AP3P", correspondences};
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 5)
+    tasks << SolverTask{cv::SOLVEPNP_SQPNP, "SQPnP", correspondences};
+#endif
+
+    QList<PoseRecoveringResult> results = QtConcurrent::blockingMapped(tasks, runSolver);
+
+    PoseRecoveringResult best = failedResult("", "None of the PnP solvers found a pose.");
+    for (const PoseRecoveringResult &result : results) {
+        if (isBetterResult(result, best)) {
+            best = result;
+        }
+    }
+    return best;
+}
+
+void PoseRecoverer::setReprojectionThreshold(float threshold) {
+    m_reprojectionThreshold = threshold;
+}
+
+float PoseRecoverer::reprojectionThreshold() const {
+    return m_reprojectionThreshold;
+}
+
+void PoseRecoverer::setRansacIterations(int iterations) {
+    m_ransacIterations = iterations;
+}
+
+int PoseRecoverer::ransacIterations() const {
+    return m_ransacIterations;
+}
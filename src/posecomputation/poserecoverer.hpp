@@ -0,0 +1,80 @@
+#ifndef POSERECOVERER_H
+#define POSERECOVERER_H
+
+#include <QFuture>
+#include <QList>
+#include <QMatrix3x3>
+#include <QPoint>
+#include <QString>
+#include <QVector3D>
+
+/*!
+ * \brief The PoseRecoveringResult struct is the outcome of recovering a pose from
+ * a set of 2D-3D correspondences.
+ */
+struct PoseRecoveringResult {
+    bool success = false;
+    // The name of the PnP solver whose result was selected as the best one
+    QString solverName;
+    QString errorMessage;
+    QVector3D position;
+    QMatrix3x3 rotation;
+    // Reprojection error in pixels of each correspondence, in the order in
+    // which the correspondences were added
+    QList<float> residuals;
+    // Whether the respective correspondence lies within the reprojection
+    // threshold of the recovered pose
+    QList<bool> inliers;
+    int numberOfInliers = 0;
+    // Root mean square reprojection error of the inliers in pixels
+    float inlierRMS = 0.f;
+};
+
+/*!
+ * \brief The PoseRecoverer class recovers a pose from clicked correspondences without
+ * blocking the caller. Several PnP solvers are run in parallel, each inside a RANSAC
+ * loop so that single mis-clicked correspondences get rejected, and their inliers are
+ * refined with Levenberg-Marquardt afterwards. The result with the most inliers (and
+ * the lowest reprojection error amongst equal inlier counts) is selected. The iterative
+ * and EPnP solvers only run with at least 5 correspondences.
+ */
+class PoseRecoverer {
+
+public:
+    PoseRecoverer();
+
+    /*!
+     * \brief recoverPose starts recovering the pose on the global thread pool.
+     * \param points2D the clicked image points
+     * \param points3D the clicked object model points, same size as points2D
+     * \param cameraMatrix the intrinsic camera matrix of the image
+     * \return a future that holds the result once the recovery has finished
+     */
+    QFuture<PoseRecoveringResult> recoverPose(const QList<QPoint> &points2D,
+                                              const QList<QVector3D> &points3D,
+                                              const QMatrix3x3 &cameraMatrix) const;
+
+    /*!
+     * \brief recoverPoseBlocking does the same as recoverPose but in the calling thread.
+     * The solvers are still evaluated in parallel.
+     */
+    PoseRecoveringResult recoverPoseBlocking(const QList<QPoint> &points2D,
+                                             const QList<QVector3D> &points3D,
+                                             const QMatrix3x3 &cameraMatrix) const;
+
+    /*!
+     * \brief setReprojectionThreshold sets the maximum reprojection error in pixels
+     * for a correspondence to be counted as inlier.
+     */
+    void setReprojectionThreshold(float threshold);
+    float reprojectionThreshold() const;
+
+    void setRansacIterations(int iterations);
+    int ransacIterations() const;
+
+private:
+    float m_reprojectionThreshold = 8.f;
+    int m_ransacIterations = 500;
+};
+
+#endif // POSERECOVERER_H
@@ -0,0 +1,94 @@
+#ifndef POSEREFINEMENT_H
+#define POSEREFINEMENT_H
+
+#include "model/pose.hpp"
+
+#include <QColor>
+#include <QMatrix3x3>
+#include <QString>
+#include <QVector3D>
+
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \brief The PoseRefinementTask struct holds everything a refinement algorithm needs
+ * to know about a pose. The values are copied from the pose on the calling thread
+ * so that the algorithms never touch the (GUI-owned) Pose objects.
+ */
+struct PoseRefinementTask {
+    QString poseId;
+    QVector3D position;
+    QMatrix3x3 rotation;
+    QMatrix3x3 cameraMatrix;
+    QString absoluteObjectModelPath;
+    QString absoluteSegmentationImagePath;
+    QColor segmentationColor;
+    QString absoluteDepthImagePath;
+    float depthScale = 1.f;
+};
+
+/*!
+ * \brief The PoseRefinementResult struct is the outcome of refining a single pose.
+ * The scores are algorithm specific but higher is always better.
+ */
+struct PoseRefinementResult {
+    QString poseId;
+    bool success = false;
+    QString errorMessage;
+    QVector3D position;
+    QMatrix3x3 rotation;
+    float initialScore = 0.f;
+    float finalScore = 0.f;
+};
+
+namespace PoseRefinement {
+
+inline PoseRefinementTask taskFromPose(const Pose &pose) {
+    PoseRefinementTask task;
+    task.poseId = pose.id();
+    task.position = pose.position();
+    task.rotation = pose.rotation().toRotationMatrix();
+    task.cameraMatrix = pose.image()->getCameraMatrix();
+    task.absoluteObjectModelPath = pose.objectModel()->absolutePath();
+    task.absoluteSegmentationImagePath = pose.image()->absoluteSegmentationImagePath();
+    if (pose.image()->hasDepthImage()) {
+        task.absoluteDepthImagePath = pose.image()->depthImagePath();
+        task.depthScale = pose.image()->depthScale();
+    }
+    return task;
+}
+
+inline PoseRefinementResult failedResult(const PoseRefinementTask &task, const QString &message) {
+    PoseRefinementResult result;
+    result.poseId = task.poseId;
+    result.errorMessage = message;
+    result.position = task.position;
+    result.rotation = task.rotation;
+    return result;
+}
+
+inline cv::Matx33d toMatx(const QMatrix3x3 &matrix) {
+    return cv::Matx33d(matrix(0, 0), matrix(0, 1), matrix(0, 2),
+                       matrix(1, 0), matrix(1, 1), matrix(1, 2),
+                       matrix(2, 0), matrix(2, 1), matrix(2, 2));
+}
+
+inline cv::Vec3d toVec(const QVector3D &vector) {
+    return cv::Vec3d(vector.x(), vector.y(), vector.z());
+}
+
+inline QMatrix3x3 toQMatrix(const cv::Matx33d &matrix) {
+    float values[9];
+    for (int i = 0; i < 9; i++) {
+        values[i] = (float) matrix.val[i];
+    }
+    return QMatrix3x3(values);
+}
+
+inline QVector3D toQVector(const cv::Vec3d &vector) {
+    return QVector3D(vector[0], vector[1], vector[2]);
+}
+
+}
+
+#endif // POSEREFINEMENT_H
@@ -0,0 +1,70 @@
+#include "poserefiner.hpp"
+#include "misc/generalhelper.hpp"
+#include "misc/global.hpp"
+
+#include <QtConcurrent>
+
+namespace {
+
+// Functor for QtConcurrent::mapped which requires result_type in Qt 5
+struct RefineFunctor {
+    typedef PoseRefinementResult result_type;
+
+    PoseRefiner refiner;
+
+    PoseRefinementResult operator()(const PoseRefinementTask &task) const {
+        return refiner.refinePoseBlocking(task);
+    }
+};
+
+}
+
+PoseRefiner::PoseRefiner() {
+}
+
+QFuture<PoseRefinementResult> PoseRefiner::refinePose(const PoseRefinementTask &task) const {
+    PoseRefiner refiner = *this;
+    return QtConcurrent::run([refiner, task]() {
+        return refiner.refinePoseBlocking(task);
+    });
+}
+
+QFuture<PoseRefinementResult> PoseRefiner::refinePoses(const QList<PoseRefinementTask> &tasks) const {
+    return QtConcurrent::mapped(tasks, RefineFunctor{*this});
+}
+
+PoseRefinementResult PoseRefiner::refinePoseBlocking(const PoseRefinementTask &task) const {
+    if (!task.absoluteDepthImagePath.isEmpty()) {
+        return m_icpRefiner.refinePoseBlocking(task);
+    }
+    return m_silhouetteRefiner.refinePoseBlocking(task);
+}
+
+QList<PoseRefinementTask> PoseRefiner::tasksForPoses(const QList<PosePtr> &poses,
+                                                     const QMap<QString, QString> &segmentationCodes) {
+    QList<PoseRefinementTask> tasks;
+    for (const PosePtr &pose : poses) {
+        const QString segmentationImagePath = pose->image()->segmentationImagePath();
+        const bool hasSegmentation = !segmentationImagePath.isEmpty()
+                && segmentationImagePath != Global::NO_PATH
+                && segmentationCodes.contains(pose->objectModel()->path());
+        if (!pose->image()->hasDepthImage() && !hasSegmentation) {
+            continue;
+        }
+        PoseRefinementTask task = PoseRefinement::taskFromPose(*pose);
+        if (hasSegmentation) {
+            task.segmentationColor = GeneralHelper::colorFromSegmentationCode(
+                        segmentationCodes[pose->objectModel()->path()]);
+        }
+        tasks.append(task);
+    }
+    return tasks;
+}
+
+IcpRefiner &PoseRefiner::icpRefiner() {
+    return m_icpRefiner;
+}
+
+SilhouetteRefiner &PoseRefiner::silhouetteRefiner() {
+    return m_silhouetteRefiner;
+}
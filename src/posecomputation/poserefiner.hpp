@@ -0,0 +1,58 @@
+#ifndef POSEREFINER_H
+#define POSEREFINER_H
+
+#include "icprefiner.hpp"
+#include "poserefinement.hpp"
+#include "silhouetterefiner.hpp"
+
+#include <QFuture>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+/*!
+ * \brief The PoseRefiner class refines poses with the best algorithm that the data of
+ * the pose allows: poses on images with a depth image are aligned to the depth with ICP,
+ * otherwise their silhouette is aligned to the segmentation image.
+ */
+class PoseRefiner {
+
+public:
+    PoseRefiner();
+
+    /*!
+     * \brief refinePose refines a single pose on the thread pool.
+     * \param task the pose values, camera, paths and segmentation color
+     */
+    QFuture<PoseRefinementResult> refinePose(const PoseRefinementTask &task) const;
+
+    /*!
+     * \brief refinePoses refines all given poses in parallel. The future holds one result
+     * per task in the order of the tasks and reports progress as tasks finish.
+     */
+    QFuture<PoseRefinementResult> refinePoses(const QList<PoseRefinementTask> &tasks) const;
+
+    /*!
+     * \brief refinePoseBlocking refines the pose in the calling thread.
+     */
+    PoseRefinementResult refinePoseBlocking(const PoseRefinementTask &task) const;
+
+    /*!
+     * \brief tasksForPoses creates refinement tasks for all poses that can be refined, i.e.
+     * whose image has a depth image or whose image has a segmentation image and whose object
+     * model has a segmentation code.
+     * \param poses the poses to create the tasks for
+     * \param segmentationCodes the segmentation codes of the settings (object model path -> code)
+     */
+    static QList<PoseRefinementTask> tasksForPoses(const QList<PosePtr> &poses,
+                                                   const QMap<QString, QString> &segmentationCodes);
+
+    IcpRefiner &icpRefiner();
+    SilhouetteRefiner &silhouetteRefiner();
+
+private:
+    IcpRefiner m_icpRefiner;
+    SilhouetteRefiner m_silhouetteRefiner;
+};
+
+#endif // POSEREFINER_H
@@ -0,0 +1,170 @@
+#include "silhouetterefiner.hpp"
+#include "mesh.hpp"
+#include "silhouetterenderer.hpp"
+
+#include <QtMath>
+
+#include <opencv2/calib3d/calib3d.hpp>
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace {
+
+// Initial step sizes of the pattern search
+const double INITIAL_TRANSLATION_STEP_IN_PIXELS = 4.0;
+const double INITIAL_DEPTH_STEP_RELATIVE = 0.02;
+const double INITIAL_ROTATION_STEP = qDegreesToRadians(2.0);
+// The search stops when the lateral step falls below this fraction of a pixel
+const double MINIMUM_TRANSLATION_STEP_IN_PIXELS = 0.25;
+
+}
+
+SilhouetteRefiner::SilhouetteRefiner() {
+}
+
+PoseRefinementResult SilhouetteRefiner::refinePoseBlocking(const PoseRefinementTask &task) const {
+    using namespace PoseRefinement;
+
+    if (task.absoluteSegmentationImagePath.isEmpty()) {
+        return failedResult(task, "The image has no segmentation image.");
+    }
+    if (!task.segmentationColor.isValid()) {
+        return failedResult(task, "The object model has no segmentation code.");
+    }
+
+    QString meshError;
+    MeshPtr mesh = MeshLoader::loadCached(task.absoluteObjectModelPath, &meshError);
+    if (mesh.isNull()) {
+        return failedResult(task, meshError);
+    }
+
+    cv::Mat segmentationImage = cv::imread(task.absoluteSegmentationImagePath.toStdString(),
+                                           cv::IMREAD_COLOR);
+    if (segmentationImage.empty()) {
+        return failedResult(task, "Could not read the segmentation image.");
+    }
+
+    const cv::Matx33d cameraMatrix = toMatx(task.cameraMatrix);
+    const cv::Matx33d initialRotation = toMatx(task.rotation);
+    const cv::Vec3d initialTranslation = toVec(task.position);
+
+    cv::Rect projected = SilhouetteRenderer::projectedBoundingRect(*mesh, cameraMatrix,
+                                                                   initialRotation,
+                                                                   initialTranslation);
+    if (projected.area() == 0) {
+        return failedResult(task, "The object is behind the camera.");
+    }
+    // Search region is the projection enlarged by half its size on every side,
+    // the mask is only evaluated there to not mistake other instances of the same
+    // object for the one to refine
+    cv::Rect regionOfInterest(projected.x - projected.width / 2,
+                              projected.y - projected.height / 2,
+                              projected.width * 2,
+                              projected.height * 2);
+    regionOfInterest &= cv::Rect(0, 0, segmentationImage.cols, segmentationImage.rows);
+    if (regionOfInterest.area() == 0) {
+        return failedResult(task, "The object is outside of the image.");
+    }
+
+    const QColor &color = task.segmentationColor;
+    cv::Mat1b mask;
+    cv::inRange(segmentationImage(regionOfInterest),
+                cv::Scalar(color.blue(), color.green(), color.red()),
+                cv::Scalar(color.blue(), color.green(), color.red()),
+                mask);
+
+    double scale = qMax(1.0, qMax(regionOfInterest.width, regionOfInterest.height)
+                             / (double) m_maximumRenderSize);
+    SilhouetteRenderer renderer(cameraMatrix, regionOfInterest, scale);
+    if (mask.size() != renderer.targetSize()) {
+        cv::resize(mask, mask, renderer.targetSize(), 0, 0, cv::INTER_NEAREST);
+    }
+    const int maskArea = cv::countNonZero(mask);
+    if (maskArea == 0) {
+        return failedResult(task, "The segmentation color of the object does not occur near the pose.");
+    }
+
+    cv::Mat1b silhouette;
+    cv::Mat1b overlap;
+    auto evaluate = [&](const double *parameters) {
+        // Parameters 0 - 2 are a translation offset, 3 - 5 a rotation vector that
+        // rotates the object around its origin in camera space
+        cv::Matx33d deltaRotation;
+        cv::Rodrigues(cv::Vec3d(parameters[3], parameters[4], parameters[5]), deltaRotation);
+        renderer.render(*mesh,
+                        deltaRotation * initialRotation,
+                        initialTranslation + cv::Vec3d(parameters[0], parameters[1], parameters[2]),
+                        silhouette);
+        cv::bitwise_and(silhouette, mask, overlap);
+        int intersection = cv::countNonZero(overlap);
+        int unionArea = cv::countNonZero(silhouette) + maskArea - intersection;
+        return unionArea > 0 ? (float) intersection / unionArea : 0.f;
+    };
+
+    // Size of a full resolution pixel at the depth of the object
+    const double pixelSize = qAbs(initialTranslation[2]) / cameraMatrix(0, 0);
+    double steps[6] = {INITIAL_TRANSLATION_STEP_IN_PIXELS * scale * pixelSize,
+                       INITIAL_TRANSLATION_STEP_IN_PIXELS * scale * pixelSize,
+                       INITIAL_DEPTH_STEP_RELATIVE * qAbs(initialTranslation[2]),
+                       INITIAL_ROTATION_STEP,
+                       INITIAL_ROTATION_STEP,
+                       INITIAL_ROTATION_STEP};
+    const double minimumStep = MINIMUM_TRANSLATION_STEP_IN_PIXELS * pixelSize;
+
+    double parameters[6] = {0, 0, 0, 0, 0, 0};
+    double candidate[6];
+    float bestScore = evaluate(parameters);
+    const float initialScore = bestScore;
+    int evaluations = 1;
+
+    while (evaluations < m_maximumEvaluations && steps[0] > minimumStep) {
+        bool improved = false;
+        for (int i = 0; i < 6 && !improved; i++) {
+            for (int sign = -1; sign <= 1 && !improved; sign += 2) {
+                std::copy(parameters, parameters + 6, candidate);
+                candidate[i] += sign * steps[i];
+                float score = evaluate(candidate);
+                evaluations++;
+                if (score > bestScore) {
+                    bestScore = score;
+                    std::copy(candidate, candidate + 6, parameters);
+                    improved = true;
+                }
+            }
+        }
+        if (!improved) {
+            for (double &step : steps) {
+                step *= 0.5;
+            }
+        }
+    }
+
+    cv::Matx33d deltaRotation;
+    cv::Rodrigues(cv::Vec3d(parameters[3], parameters[4], parameters[5]), deltaRotation);
+
+    PoseRefinementResult result;
+    result.poseId = task.poseId;
+    result.success = true;
+    result.rotation = toQMatrix(deltaRotation * initialRotation);
+    result.position = toQVector(initialTranslation
+                                + cv::Vec3d(parameters[0], parameters[1], parameters[2]));
+    result.initialScore = initialScore;
+    result.finalScore = bestScore;
+    return result;
+}
+
+void SilhouetteRefiner::setMaximumEvaluations(int maximumEvaluations) {
+    m_maximumEvaluations = maximumEvaluations;
+}
+
+int SilhouetteRefiner::maximumEvaluations() const {
+    return m_maximumEvaluations;
+}
+
+void SilhouetteRefiner::setMaximumRenderSize(int maximumRenderSize) {
+    m_maximumRenderSize = maximumRenderSize;
+}
+
+int SilhouetteRefiner::maximumRenderSize() const {
+    return m_maximumRenderSize;
+}
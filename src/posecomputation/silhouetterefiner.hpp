@@ -0,0 +1,42 @@
+#ifndef SILHOUETTEREFINER_H
+#define SILHOUETTEREFINER_H
+
+#include "poserefinement.hpp"
+
+/*!
+ * \brief The SilhouetteRefiner class refines poses by rendering the silhouette of the
+ * object model and comparing it to the region of the object's color in the segmentation
+ * image. Translation and rotation are optimized with a pattern search that maximizes the
+ * intersection over union of both. Rendering happens on the CPU, i.e. refining can run
+ * on as many threads as there are cores and does not need a GPU.
+ *
+ * Use PoseRefiner to refine poses asynchronously.
+ */
+class SilhouetteRefiner {
+
+public:
+    SilhouetteRefiner();
+
+    /*!
+     * \brief refinePoseBlocking refines the pose in the calling thread. The task needs
+     * a segmentation image path and a segmentation color.
+     */
+    PoseRefinementResult refinePoseBlocking(const PoseRefinementTask &task) const;
+
+    void setMaximumEvaluations(int maximumEvaluations);
+    int maximumEvaluations() const;
+
+    /*!
+     * \brief setMaximumRenderSize sets the size in pixels that the longer side of the region
+     * around the object is downscaled to before comparing silhouettes. Larger values
+     * are more precise but slower.
+     */
+    void setMaximumRenderSize(int maximumRenderSize);
+    int maximumRenderSize() const;
+
+private:
+    int m_maximumEvaluations = 400;
+    int m_maximumRenderSize = 200;
+};
+
+#endif // SILHOUETTEREFINER_H
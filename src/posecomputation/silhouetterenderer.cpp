@@ -0,0 +1,94 @@
+#include "silhouetterenderer.hpp"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Number of fractional bits used for the subpixel accurate polygon filling
+const int SUBPIXEL_SHIFT = 4;
+const double SUBPIXEL_FACTOR = 1 << SUBPIXEL_SHIFT;
+const double MINIMUM_DEPTH = 1e-6;
+
+}
+
+SilhouetteRenderer::SilhouetteRenderer(const cv::Matx33d &cameraMatrix,
+                                       const cv::Rect &regionOfInterest,
+                                       double scale)
+    : m_cameraMatrix(cameraMatrix)
+    , m_regionOfInterest(regionOfInterest)
+    , m_scale(std::max(1.0, scale)) {
+}
+
+cv::Size SilhouetteRenderer::targetSize() const {
+    return cv::Size(std::max(1, (int) std::ceil(m_regionOfInterest.width / m_scale)),
+                    std::max(1, (int) std::ceil(m_regionOfInterest.height / m_scale)));
+}
+
+void SilhouetteRenderer::render(const Mesh &mesh,
+                                const cv::Matx33d &rotation,
+                                const cv::Vec3d &translation,
+                                cv::Mat1b &target) const {
+    target.create(targetSize());
+    target.setTo(0);
+
+    const double fx = m_cameraMatrix(0, 0) / m_scale;
+    const double fy = m_cameraMatrix(1, 1) / m_scale;
+    const double cx = (m_cameraMatrix(0, 2) - m_regionOfInterest.x) / m_scale;
+    const double cy = (m_cameraMatrix(1, 2) - m_regionOfInterest.y) / m_scale;
+
+    const size_t vertexCount = mesh.vertices.size();
+    m_projectedVertices.resize(vertexCount);
+    m_validVertices.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+        const cv::Point3f &v = mesh.vertices[i];
+        cv::Vec3d p = rotation * cv::Vec3d(v.x, v.y, v.z) + translation;
+        m_validVertices[i] = p[2] > MINIMUM_DEPTH;
+        if (m_validVertices[i]) {
+            m_projectedVertices[i] = cv::Point(cvRound((fx * p[0] / p[2] + cx) * SUBPIXEL_FACTOR),
+                                               cvRound((fy * p[1] / p[2] + cy) * SUBPIXEL_FACTOR));
+        }
+    }
+
+    cv::Point triangle[3];
+    for (const cv::Vec3i &face : mesh.triangles) {
+        if (!m_validVertices[face[0]] || !m_validVertices[face[1]] || !m_validVertices[face[2]]) {
+            // Near plane clipping is not worth it for silhouettes, such poses are broken anyways
+            continue;
+        }
+        triangle[0] = m_projectedVertices[face[0]];
+        triangle[1] = m_projectedVertices[face[1]];
+        triangle[2] = m_projectedVertices[face[2]];
+        cv::fillConvexPoly(target, triangle, 3, cv::Scalar(255), cv::LINE_8, SUBPIXEL_SHIFT);
+    }
+}
+
+cv::Rect SilhouetteRenderer::projectedBoundingRect(const Mesh &mesh,
+                                                   const cv::Matx33d &cameraMatrix,
+                                                   const cv::Matx33d &rotation,
+                                                   const cv::Vec3d &translation) {
+    double minX = std::numeric_limits<double>::max();
+    double minY = std::numeric_limits<double>::max();
+    double maxX = std::numeric_limits<double>::lowest();
+    double maxY = std::numeric_limits<double>::lowest();
+    for (const cv::Point3f &v : mesh.vertices) {
+        cv::Vec3d p = rotation * cv::Vec3d(v.x, v.y, v.z) + translation;
+        if (p[2] <= MINIMUM_DEPTH) {
+            return cv::Rect();
+        }
+        double x = cameraMatrix(0, 0) * p[0] / p[2] + cameraMatrix(0, 2);
+        double y = cameraMatrix(1, 1) * p[1] / p[2] + cameraMatrix(1, 2);
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+    if (mesh.vertices.empty()) {
+        return cv::Rect();
+    }
+    return cv::Rect(cv::Point((int) std::floor(minX), (int) std::floor(minY)),
+                    cv::Point((int) std::ceil(maxX) + 1, (int) std::ceil(maxY) + 1));
+}
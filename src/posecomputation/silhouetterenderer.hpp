@@ -0,0 +1,56 @@
+#ifndef SILHOUETTERENDERER_H
+#define SILHOUETTERENDERER_H
+
+#include "mesh.hpp"
+
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \brief The SilhouetteRenderer class is a small software rasterizer that renders the
+ * binary silhouette of a mesh as seen through a pinhole camera. It does not need an
+ * OpenGL context and can thus be used from any thread.
+ */
+class SilhouetteRenderer {
+
+public:
+    /*!
+     * \brief SilhouetteRenderer creates a renderer that renders into the given region
+     * of interest of the image, optionally downscaled.
+     * \param cameraMatrix the intrinsic camera matrix of the full resolution image
+     * \param regionOfInterest the part of the image to render, in full resolution pixels
+     * \param scale the factor the region of interest is shrunk by, >= 1
+     */
+    SilhouetteRenderer(const cv::Matx33d &cameraMatrix,
+                       const cv::Rect &regionOfInterest,
+                       double scale = 1.0);
+
+    /*!
+     * \brief render renders the silhouette of the mesh transformed by rotation and
+     * translation into target, which gets (re)allocated to the scaled region size.
+     */
+    void render(const Mesh &mesh,
+                const cv::Matx33d &rotation,
+                const cv::Vec3d &translation,
+                cv::Mat1b &target) const;
+
+    cv::Size targetSize() const;
+
+    /*!
+     * \brief projectedBoundingRect computes the bounding rectangle of the projected mesh
+     * in full resolution pixels. Returns an empty rectangle if the mesh is behind the camera.
+     */
+    static cv::Rect projectedBoundingRect(const Mesh &mesh,
+                                          const cv::Matx33d &cameraMatrix,
+                                          const cv::Matx33d &rotation,
+                                          const cv::Vec3d &translation);
+
+private:
+    cv::Matx33d m_cameraMatrix;
+    cv::Rect m_regionOfInterest;
+    double m_scale;
+    // Reused between renderings to avoid allocations
+    mutable std::vector<cv::Point> m_projectedVertices;
+    mutable std::vector<bool> m_validVertices;
+};
+
+#endif // SILHOUETTERENDERER_H
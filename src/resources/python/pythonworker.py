@@ -0,0 +1,189 @@
+"""Worker process that runs the functions of a load and store script for 6D-PAT.
+
+The program starts a few of these workers with the path of the script as the only
+argument. Requests and responses are exchanged over stdin and stdout as frames, i.e.
+a big-endian uint32 with the payload length followed by one encoded value (see encode).
+
+Requests are lists [operation, function name, arguments], operation is either 'call'
+or 'has'. Responses are lists [success, result or error message]. Right after starting
+the worker sends a response that tells whether the script could be imported.
+"""
+import importlib.util
+import os
+import struct
+import sys
+import traceback
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+NONE, BOOL, INT, FLOAT, STRING, LIST, DICT, FLOAT_ARRAY, STRUCTURED_ARRAY = range(9)
+
+
+def encode_structured_array(value, out):
+    # Sent column by column, numeric columns as one block of int64 or doubles with the
+    # number of values per record (e.g. 9 for ('R', 'f8', (3, 3))). The program turns
+    # the columns into one dict per record.
+    records = value.ravel()
+    names = records.dtype.names
+    out.append(struct.pack('>BII', STRUCTURED_ARRAY, records.size, len(names)))
+    for name in names:
+        encode(name, out)
+        column = records[name]
+        width = int(numpy.prod(column.shape[1:], dtype=numpy.int64))
+        kind = column.dtype.kind
+        if kind == 'i' or (kind == 'u' and column.dtype.itemsize < 8):
+            out.append(struct.pack('>BI', INT, width))
+            out.append(numpy.ascontiguousarray(column, dtype='>i8').tobytes())
+        elif kind == 'f':
+            out.append(struct.pack('>BI', FLOAT, width))
+            out.append(numpy.ascontiguousarray(column, dtype='>f8').tobytes())
+        else:
+            # E.g. strings, one value per record
+            encode(column.tolist(), out)
+
+
+def encode(value, out):
+    if value is None:
+        out.append(struct.pack('>B', NONE))
+    elif isinstance(value, bool):
+        out.append(struct.pack('>BB', BOOL, value))
+    elif isinstance(value, int):
+        out.append(struct.pack('>Bq', INT, value))
+    elif isinstance(value, float):
+        out.append(struct.pack('>Bd', FLOAT, value))
+    elif isinstance(value, str):
+        data = value.encode('utf-8')
+        out.append(struct.pack('>BI', STRING, len(data)))
+        out.append(data)
+    elif isinstance(value, bytes):
+        encode(value.decode('utf-8', 'replace'), out)
+    elif isinstance(value, dict):
+        out.append(struct.pack('>BI', DICT, len(value)))
+        for key, item in value.items():
+            encode(str(key), out)
+            encode(item, out)
+    elif numpy is not None and isinstance(value, numpy.ndarray):
+        if value.dtype.names:
+            encode_structured_array(value, out)
+        elif value.dtype.kind in 'biuf':
+            # Numeric arrays (matrices, vectors) are sent flattened as one block of doubles
+            data = numpy.ascontiguousarray(value, dtype='>f8').ravel()
+            out.append(struct.pack('>BI', FLOAT_ARRAY, data.size))
+            out.append(data.tobytes())
+        else:
+            encode(value.tolist(), out)
+    elif numpy is not None and isinstance(value, numpy.generic):
+        encode(value.item(), out)
+    elif isinstance(value, (list, tuple)):
+        out.append(struct.pack('>BI', LIST, len(value)))
+        for item in value:
+            encode(item, out)
+    else:
+        encode(str(value), out)
+
+
+def decode(data, offset=0):
+    (tag,) = struct.unpack_from('>B', data, offset)
+    offset += 1
+    if tag == NONE:
+        return None, offset
+    if tag == BOOL:
+        return data[offset] != 0, offset + 1
+    if tag == INT:
+        return struct.unpack_from('>q', data, offset)[0], offset + 8
+    if tag == FLOAT:
+        return struct.unpack_from('>d', data, offset)[0], offset + 8
+    (count,) = struct.unpack_from('>I', data, offset)
+    offset += 4
+    if tag == STRING:
+        return data[offset:offset + count].decode('utf-8'), offset + count
+    if tag == LIST:
+        values = []
+        for _ in range(count):
+            value, offset = decode(data, offset)
+            values.append(value)
+        return values, offset
+    if tag == DICT:
+        values = {}
+        for _ in range(count):
+            key, offset = decode(data, offset)
+            values[key], offset = decode(data, offset)
+        return values, offset
+    if tag == FLOAT_ARRAY:
+        return list(struct.unpack_from('>%dd' % count, data, offset)), offset + 8 * count
+    raise ValueError('Unknown tag %d' % tag)
+
+
+def read_exactly(stream, size):
+    data = b''
+    while len(data) < size:
+        chunk = stream.read(size - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return data
+
+
+def write_frame(channel, value):
+    out = []
+    encode(value, out)
+    payload = b''.join(out)
+    channel.write(struct.pack('>I', len(payload)))
+    channel.write(payload)
+    channel.flush()
+
+
+def load_script(path):
+    sys.path.insert(0, os.path.dirname(os.path.abspath(path)))
+    name = os.path.splitext(os.path.basename(path))[0]
+    spec = importlib.util.spec_from_file_location(name, path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def main():
+    requests = sys.stdin.buffer
+    # Keep stdout for the responses and send everything the script prints to stderr
+    channel = os.fdopen(os.dup(sys.stdout.fileno()), 'wb')
+    os.dup2(sys.stderr.fileno(), sys.stdout.fileno())
+    sys.stdout = sys.stderr
+
+    try:
+        script = load_script(sys.argv[1])
+        write_frame(channel, [True, None])
+    except BaseException:
+        write_frame(channel, [False, traceback.format_exc()])
+        return 1
+
+    while True:
+        header = read_exactly(requests, 4)
+        if header is None:
+            return 0
+        payload = read_exactly(requests, struct.unpack('>I', header)[0])
+        if payload is None:
+            return 0
+        operation, name, arguments = decode(payload)[0]
+        try:
+            function = getattr(script, name, None)
+            if operation == 'has':
+                response = [True, callable(function)]
+            elif function is None:
+                response = [False, 'The script has no function %s.' % name]
+            else:
+                response = [True, function(*arguments)]
+        except Exception:
+            response = [False, traceback.format_exc()]
+        try:
+            write_frame(channel, response)
+        except (struct.error, RecursionError):
+            # E.g. integers that do not fit into 64 bit, the frame is only written
+            # after encoding succeeded
+            write_frame(channel, [False, traceback.format_exc()])
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -13,6 +13,8 @@ def convert_tless_cam_info(cam_info_path, images_path, image_extension, output_p
 
         yaml_info = inout.load_info(cam_info_path)
         converted = {}
+        # T-LESS keeps the images of a scene in a subfolder of the scene folder
+        scene = os.path.basename(os.path.dirname(os.path.abspath(images_path)))
 
         image_filenames = util.get_files_at_path_of_extensions(images_path, [image_extension])
         util.sort_list_by_num_in_string_entries(image_filenames)
@@ -26,6 +28,10 @@ def convert_tless_cam_info(cam_info_path, images_path, image_extension, output_p
                 # In this case we also have the rotation of the camera, which is provided for test images
                 converted_single['R'] = info['cam_R_w2c'].flatten().tolist()
                 converted_single['t'] = info['cam_t_w2c'].flatten().tolist()
+                # Under their original names 6D-PAT reads them as camera extrinsics
+                converted_single['cam_R_w2c'] = converted_single['R']
+                converted_single['cam_t_w2c'] = converted_single['t']
+                converted_single['scene'] = scene
             converted[filename] = converted_single
             index += 1
 
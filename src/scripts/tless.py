@@ -22,6 +22,7 @@ def load_images(images_path, segmentation_images_path):
         cam_info = yaml.safe_load(cam_info_file)
 
         converted = []
+        scene_id = os.path.basename(os.path.dirname(os.path.abspath(images_path)))
 
         image_filenames = get_files_at_path_of_extensions(images_path, image_extensions)
         sort_list_by_num_in_string_entries(image_filenames)
@@ -51,10 +52,21 @@ def load_images(images_path, segmentation_images_path):
                 segmentation_filename = os.path.basename(
                     segmentation_image_filenames[index])
                 converted_single['segmentation_image_path'] = segmentation_filename
+            # T-LESS ships aligned depth images next to the RGB images, the path is
+            # relative to the base path like the image path
+            depth_image_path = os.path.join('..', 'depth', filename)
+            if os.path.exists(os.path.join(images_path, depth_image_path)):
+                converted_single['depth_image_path'] = depth_image_path
+                # T-LESS stores depth in units of 0.1 mm, older versions of info.yml
+                # don't state it
+                converted_single['depth_scale'] = info.get('depth_scale', 0.1)
             if 'cam_R_w2c' in info:
-                # In this case we also have the rotation of the camera, which is provided for test images
-                converted_single['R'] = info['cam_R_w2c']
-                converted_single['t'] = info['cam_t_w2c']
+                # In this case we also have the extrinsics of the camera, which are provided for test
+                # images and allow to transfer poses between the images of a scene
+                converted_single['cam_R_w2c'] = info['cam_R_w2c']
+                converted_single['cam_t_w2c'] = info['cam_t_w2c']
+                # The extrinsics refer to the scene, i.e. the folder that contains the images folder
+                converted_single['scene_id'] = scene_id
             converted.append(converted_single)
         return converted
 
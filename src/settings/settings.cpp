@@ -24,6 +24,8 @@ Settings::Settings(const Settings &settings) {
     this->m_selectPoseRenderableMouseButton = settings.m_selectPoseRenderableMouseButton;
     this->m_translatePoseRenderableMouseButton = settings.m_translatePoseRenderableMouseButton;
     this->m_rotatePoseRenderableMouseButton = settings.m_rotatePoseRenderableMouseButton;
+    this->m_fileSystemEventsQuietPeriod = settings.m_fileSystemEventsQuietPeriod;
+    this->m_fileSystemEventsMaximumLatency = settings.m_fileSystemEventsMaximumLatency;
 }
 
 Settings::~Settings() {
@@ -188,3 +190,19 @@ bool Settings::showFPSLabel() const {
 void Settings::setShowFPSLabel(bool newShowFPSLabel) {
     m_showFPSLabel = newShowFPSLabel;
 }
+
+int Settings::fileSystemEventsQuietPeriod() const {
+    return m_fileSystemEventsQuietPeriod;
+}
+
+void Settings::setFileSystemEventsQuietPeriod(int fileSystemEventsQuietPeriod) {
+    m_fileSystemEventsQuietPeriod = fileSystemEventsQuietPeriod;
+}
+
+int Settings::fileSystemEventsMaximumLatency() const {
+    return m_fileSystemEventsMaximumLatency;
+}
+
+void Settings::setFileSystemEventsMaximumLatency(int fileSystemEventsMaximumLatency) {
+    m_fileSystemEventsMaximumLatency = fileSystemEventsMaximumLatency;
+}
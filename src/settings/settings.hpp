@@ -18,7 +18,9 @@ public:
 
     enum UsedLoadAndStoreStrategy {
         Default,
-        Python
+        Python,
+        //! Runs the Python script in separate worker processes
+        PythonProcesses
     };
 
     Settings(const QString &identifier);
@@ -88,6 +90,14 @@ public:
     bool showFPSLabel() const;
     void setShowFPSLabel(bool newShowFPSLabel);
 
+    //! Milliseconds without file system events before changes on disk are processed
+    int fileSystemEventsQuietPeriod() const;
+    void setFileSystemEventsQuietPeriod(int fileSystemEventsQuietPeriod);
+
+    //! Maximum milliseconds changes on disk are postponed while events keep coming in
+    int fileSystemEventsMaximumLatency() const;
+    void setFileSystemEventsMaximumLatency(int fileSystemEventsMaximumLatency);
+
 private:
     QString m_identifier;
 
@@ -108,6 +118,8 @@ private:
     Theme m_theme;
     int m_multisampleSamples = 2;
     bool m_showFPSLabel = true;
+    int m_fileSystemEventsQuietPeriod = 500;
+    int m_fileSystemEventsMaximumLatency = 5000;
 };
 
 typedef QSharedPointer<Settings> SettingsPtr;
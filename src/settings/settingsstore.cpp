@@ -37,6 +37,10 @@ void SettingsStore::saveCurrentSettings() {
     settings.setValue(CLICK_3D_SIZE, m_currentSettings->click3DSize());
     settings.setValue(MULTISAMPLING_SAMLPES, m_currentSettings->multisampleSamples());
     settings.setValue(SHOW_FPS_LABEL, m_currentSettings->showFPSLabel());
+    settings.setValue(FILE_SYSTEM_EVENTS_QUIET_PERIOD,
+                      m_currentSettings->fileSystemEventsQuietPeriod());
+    settings.setValue(FILE_SYSTEM_EVENTS_MAXIMUM_LATENCY,
+                      m_currentSettings->fileSystemEventsMaximumLatency());
     settings.endGroup();
 
     //! Persist the object color codes so that the user does not have to enter them at each program start
@@ -100,6 +104,10 @@ void SettingsStore::setCurrentSettings(const QString &identifier) {
     settingsPointer->setClick3DSize(settings.value(CLICK_3D_SIZE, 0.01).toFloat());
     settingsPointer->setMultisampleSamples(settings.value(MULTISAMPLING_SAMLPES, 2).toInt());
     settingsPointer->setShowFPSLabel(settings.value(SHOW_FPS_LABEL, true).toBool());
+    settingsPointer->setFileSystemEventsQuietPeriod(
+                settings.value(FILE_SYSTEM_EVENTS_QUIET_PERIOD, 500).toInt());
+    settingsPointer->setFileSystemEventsMaximumLatency(
+                settings.value(FILE_SYSTEM_EVENTS_MAXIMUM_LATENCY, 5000).toInt());
     // TODO read mouse buttons
     settings.endGroup();
 
@@ -142,3 +150,5 @@ const QString SettingsStore::TRANSLATE_POSE_RENDERABLE_MOUSE_BUTTON =
 const QString SettingsStore::CLICK_3D_SIZE = "click3dsize";
 const QString SettingsStore::MULTISAMPLING_SAMLPES = "multisampleSamples";
 const QString SettingsStore::SHOW_FPS_LABEL = "showFPSLabel";
+const QString SettingsStore::FILE_SYSTEM_EVENTS_QUIET_PERIOD = "fileSystemEventsQuietPeriod";
+const QString SettingsStore::FILE_SYSTEM_EVENTS_MAXIMUM_LATENCY = "fileSystemEventsMaximumLatency";
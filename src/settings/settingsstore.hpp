@@ -81,6 +81,8 @@ private:
     static const QString CLICK_3D_SIZE;
     static const QString MULTISAMPLING_SAMLPES;
     static const QString SHOW_FPS_LABEL;
+    static const QString FILE_SYSTEM_EVENTS_QUIET_PERIOD;
+    static const QString FILE_SYSTEM_EVENTS_MAXIMUM_LATENCY;
 };
 
 typedef QSharedPointer<SettingsStore> SettingsStorePtr;
@@ -12,7 +12,7 @@ lessThan(QT_MINOR_VERSION, 14) {
     }
 }
 
-QT     += core gui widgets 3dcore 3dextras 3drender 3dinput
+QT     += core gui widgets concurrent 3dcore 3dextras 3drender 3dinput
 CONFIG += c++11 no_keywords
 
 unix: QT_CONFIG -= no-pkg-config
@@ -39,6 +39,7 @@ include(../defaults.pri)
 include(controller/controller.pri)
 include(misc/misc.pri)
 include(model/model.pri)
+include(posecomputation/posecomputation.pri)
 include(settings/settings.pri)
 include(view/view.pri)
 include(3dparty/QtAwesome/QtAwesome.pri)
@@ -46,4 +47,5 @@ include(3dparty/QtAwesome/QtAwesome.pri)
 RESOURCES += resources/shaders/shaders.qrc \
              resources/images/images.qrc \
              resources/fonts/fonts.qrc \
-             resources/stylesheets/stylesheets.qrc
+             resources/stylesheets/stylesheets.qrc \
+             resources/python/python.qrc
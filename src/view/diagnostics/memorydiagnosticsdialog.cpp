@@ -0,0 +1,83 @@
+#include "memorydiagnosticsdialog.hpp"
+#include "misc/memoryaccounting.hpp"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+static const int REFRESH_INTERVAL = 1000;
+static const qint64 MB = 1024 * 1024;
+
+MemoryDiagnosticsDialog::MemoryDiagnosticsDialog(QWidget *parent)
+    : QDialog(parent)
+    , m_processMemoryLabel(new QLabel(this))
+    , m_table(new QTableWidget(0, 4, this)) {
+    setWindowTitle(tr("Memory Diagnostics"));
+    setAttribute(Qt::WA_DeleteOnClose);
+    resize(600, 300);
+
+    m_table->setHorizontalHeaderLabels({tr("Subsystem"), tr("Usage"),
+                                        tr("Budget (MB)"), tr("Evictions")});
+    m_table->horizontalHeader()->setSectionResizeMode(Subsystem, QHeaderView::Stretch);
+    m_table->verticalHeader()->hide();
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    connect(m_table, &QTableWidget::itemChanged, this, &MemoryDiagnosticsDialog::onItemChanged);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton *logButton = buttonBox->addButton(tr("Write to Log"), QDialogButtonBox::ActionRole);
+    connect(logButton, &QPushButton::clicked, [](){
+        MemoryAccounting::instance()->logUsage();
+    });
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::close);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_processMemoryLabel);
+    layout->addWidget(m_table);
+    layout->addWidget(buttonBox);
+
+    connect(&m_refreshTimer, &QTimer::timeout, this, &MemoryDiagnosticsDialog::refresh);
+    m_refreshTimer.start(REFRESH_INTERVAL);
+    refresh();
+}
+
+void MemoryDiagnosticsDialog::refresh() {
+    m_refreshing = true;
+    const QList<MemoryAccounting::Account> accounts = MemoryAccounting::instance()->accounts();
+    m_processMemoryLabel->setText(tr("Memory of the process: %1, accounted for: %2")
+                                  .arg(MemoryAccounting::formatBytes(MemoryAccounting::processMemory()))
+                                  .arg(MemoryAccounting::formatBytes(
+                                           MemoryAccounting::instance()->totalUsage())));
+    m_table->setRowCount(accounts.size());
+    for (int row = 0; row < accounts.size(); row++) {
+        const MemoryAccounting::Account &account = accounts[row];
+        if (m_table->item(row, Subsystem) == Q_NULLPTR) {
+            for (int column = Subsystem; column <= Evictions; column++) {
+                QTableWidgetItem *item = new QTableWidgetItem;
+                if (column != Budget) {
+                    item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+                }
+                m_table->setItem(row, column, item);
+            }
+        }
+        m_table->item(row, Subsystem)->setText(account.subsystem);
+        m_table->item(row, Usage)->setText(MemoryAccounting::formatBytes(account.usage));
+        // Setting the same text doesn't touch the editor, i.e. what the user is typing
+        m_table->item(row, Budget)->setText(QString::number(account.budget / MB));
+        m_table->item(row, Evictions)->setText(QString::number(account.evictions));
+    }
+    m_refreshing = false;
+}
+
+void MemoryDiagnosticsDialog::onItemChanged(QTableWidgetItem *item) {
+    if (m_refreshing || item->column() != Budget) {
+        return;
+    }
+    bool ok;
+    const qint64 budget = item->text().toLongLong(&ok);
+    const QString subsystem = m_table->item(item->row(), Subsystem)->text();
+    if (ok && budget >= 0) {
+        MemoryAccounting::instance()->setBudget(subsystem, budget * MB);
+    }
+    refresh();
+}
@@ -0,0 +1,42 @@
+#ifndef MEMORYDIAGNOSTICSDIALOG_H
+#define MEMORYDIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QTimer>
+
+/*!
+ * \brief The MemoryDiagnosticsDialog class shows the usage, budget and number of evictions
+ * of every subsystem of the MemoryAccounting and the memory of the whole process. The
+ * budgets can be edited in MB, 0 means unlimited.
+ */
+class MemoryDiagnosticsDialog : public QDialog {
+
+    Q_OBJECT
+
+public:
+    explicit MemoryDiagnosticsDialog(QWidget *parent = Q_NULLPTR);
+
+private Q_SLOTS:
+    void refresh();
+    void onItemChanged(QTableWidgetItem *item);
+
+private:
+    enum Column {
+        Subsystem,
+        Usage,
+        Budget,
+        Evictions
+    };
+
+private:
+    QLabel *m_processMemoryLabel;
+    QTableWidget *m_table;
+    QTimer m_refreshTimer;
+    // Set while the table is filled to ignore the resulting itemChanged signals
+    bool m_refreshing = false;
+};
+
+#endif // MEMORYDIAGNOSTICSDIALOG_H
@@ -1,20 +1,33 @@
 #include "galleryimagemodel.hpp"
+#include "misc/memoryaccounting.hpp"
 #include <QDebug>
 #include <QIcon>
 #include <QPainter>
 
-GalleryImageModel::GalleryImageModel(ModelManager* modelManager) {
+GalleryImageModel::GalleryImageModel(AsyncModelManager* modelManager)
+    : m_resizedImagesCache(MemoryAccounting::GALLERY_THUMBNAILS) {
     Q_ASSERT(modelManager != Q_NULLPTR);
     this->m_modelManager = modelManager;
-    m_imagesCache = modelManager->images();
+    const ModelSnapshotPtr snapshot = modelManager->snapshot();
+    m_imagesCache = snapshot->images();
+    m_imagesVersion = snapshot->imagesVersion();
     resizeImages();
-    connect(modelManager, &ModelManager::dataChanged,
+    connect(modelManager, &AsyncModelManager::dataChanged,
             this, &GalleryImageModel::onDataChanged);
+    connect(modelManager, &AsyncModelManager::imagesChanged,
+            this, &GalleryImageModel::onImagesChanged);
+    connect(MemoryAccounting::instance(), &MemoryAccounting::budgetExceeded,
+            this, &GalleryImageModel::onMemoryBudgetExceeded);
 }
 
 GalleryImageModel::~GalleryImageModel() {
     m_resizeImagesThreadpool.killTimer(0);
     m_resizeImagesRunnable->stop();
+    for (const QPointer<ResizeImagesRunnable> &runnable : m_resizeChangedImagesRunnables) {
+        if (!runnable.isNull()) {
+            runnable->stop();
+        }
+    }
     m_resizeImagesThreadpool.waitForDone();
     delete m_resizeImagesRunnable;
 }
@@ -28,8 +41,16 @@ QVariant GalleryImageModel::data(const QModelIndex &index, int role) const {
     QString imagePath = m_imagesCache[index.row()]->imagePath();
     if (role == Qt::DecorationRole) {
         if (m_resizedImagesCache.contains(imagePath)) {
-            return QIcon(QPixmap::fromImage(m_resizedImagesCache[imagePath]));
+            return QIcon(QPixmap::fromImage(m_resizedImagesCache.value(imagePath)));
         } else {
+            if (m_resizedImagesCache.isEvicted(imagePath)) {
+                if (m_imagesToRestore.isEmpty()) {
+                    // Collects the evicted images that are shown during this paint
+                    QMetaObject::invokeMethod(const_cast<GalleryImageModel*>(this),
+                                              "restoreEvictedImages", Qt::QueuedConnection);
+                }
+                m_imagesToRestore.insert(imagePath);
+            }
             return QIcon(m_currentLoadingAnimationFrame);
         }
     } else if (role == Qt::ToolTipRole) {
@@ -42,12 +63,22 @@ int GalleryImageModel::rowCount(const QModelIndex &/* parent */) const {
     return m_imagesCache.size();
 }
 
-void GalleryImageModel::resizeImages() {
+void GalleryImageModel::stopResizingImages() {
     if (!m_resizeImagesRunnable.isNull()) {
         m_resizeImagesRunnable->stop();
-        m_resizeImagesThreadpool.clear();
-        m_resizeImagesThreadpool.waitForDone();
     }
+    for (const QPointer<ResizeImagesRunnable> &runnable : m_resizeChangedImagesRunnables) {
+        if (!runnable.isNull()) {
+            runnable->stop();
+        }
+    }
+    m_resizeChangedImagesRunnables.clear();
+    m_resizeImagesThreadpool.clear();
+    m_resizeImagesThreadpool.waitForDone();
+}
+
+void GalleryImageModel::resizeImages() {
+    stopResizingImages();
     m_resizedImagesCache.clear();
     m_resizeImagesRunnable = new ResizeImagesRunnable(m_imagesCache);
     connect(m_resizeImagesRunnable, &ResizeImagesRunnable::imageResized,
@@ -55,21 +86,94 @@ void GalleryImageModel::resizeImages() {
     m_resizeImagesThreadpool.start(m_resizeImagesRunnable);
 }
 
+void GalleryImageModel::resizeImages(const QList<ImagePtr> &images) {
+    // Finished runnables delete themselves
+    m_resizeChangedImagesRunnables.removeAll(QPointer<ResizeImagesRunnable>());
+    m_loadingIconUpdateTimer.start();
+    ResizeImagesRunnable *runnable = new ResizeImagesRunnable(images);
+    connect(runnable, &ResizeImagesRunnable::imageResized,
+            this, &GalleryImageModel::onImageResized);
+    m_resizeChangedImagesRunnables.append(runnable);
+    m_resizeImagesThreadpool.start(runnable);
+}
+
 void GalleryImageModel::onImageResized(int imageIndex, const QString &imagePath, const QImage &resizedImage) {
-    m_resizedImagesCache[imagePath] = resizedImage;
-    if (imageIndex == m_imagesCache.size()) {
+    Q_UNUSED(imageIndex)
+    m_resizedImagesCache.insert(imagePath, resizedImage);
+    // Evicted images are only resized again when they are shown
+    if (m_resizedImagesCache.size() + m_resizedImagesCache.evictedCount() >= m_imagesCache.size()) {
         m_loadingIconUpdateTimer.stop();
     }
 }
 
+void GalleryImageModel::onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree) {
+    if (subsystem == MemoryAccounting::GALLERY_THUMBNAILS) {
+        m_resizedImagesCache.evict(bytesToFree);
+    }
+}
+
+void GalleryImageModel::restoreEvictedImages() {
+    QList<ImagePtr> imagesToResize;
+    for (const ImagePtr &image : m_imagesCache) {
+        if (m_imagesToRestore.contains(image->imagePath())
+                && m_resizedImagesCache.takeEvicted(image->imagePath())) {
+            imagesToResize.append(image);
+        }
+    }
+    m_imagesToRestore.clear();
+    if (!imagesToResize.isEmpty()) {
+        resizeImages(imagesToResize);
+    }
+}
+
 void GalleryImageModel::onDataChanged(int data) {
     // Check if images were changed
     if (data & Data::Images) {
+        const ModelSnapshotPtr snapshot = m_modelManager->snapshot();
+        if (snapshot->imagesVersion() == m_imagesVersion) {
+            // E.g. the same folder was loaded again, no need to resize all images again
+            return;
+        }
         m_loadingIconUpdateTimer.start();
-        m_imagesCache = m_modelManager->images();
+        m_imagesCache = snapshot->images();
+        m_imagesVersion = snapshot->imagesVersion();
         resizeImages();
         QModelIndex top = index(0, 0);
         QModelIndex bottom = index(m_imagesCache.size() - 1, 0);
         Q_EMIT dataChanged(top, bottom);
     }
 }
+
+void GalleryImageModel::onImagesChanged(const QList<ImagePtr> &images, const DataDelta &delta) {
+    // Descending to keep the rows of the remaining removals valid
+    for (int i = delta.removedRows.size() - 1; i >= 0; i--) {
+        int row = delta.removedRows[i];
+        beginRemoveRows(QModelIndex(), row, row);
+        m_resizedImagesCache.remove(m_imagesCache[row]->imagePath());
+        m_imagesCache.removeAt(row);
+        endRemoveRows();
+    }
+    QList<ImagePtr> imagesToResize;
+    // Ascending, every row is the final row of the image
+    for (int row : delta.insertedRows) {
+        beginInsertRows(QModelIndex(), row, row);
+        m_imagesCache.insert(row, images[row]);
+        endInsertRows();
+        imagesToResize.append(images[row]);
+    }
+    for (int row : delta.changedRows) {
+        m_resizedImagesCache.remove(m_imagesCache[row]->imagePath());
+        m_imagesCache[row] = images[row];
+        imagesToResize.append(images[row]);
+        Q_EMIT dataChanged(index(row, 0), index(row, 0));
+    }
+    m_imagesCache = images;
+    // The snapshot might already be newer than the delta, the next full change has to
+    // refresh no matter what
+    m_imagesVersion = 0;
+
+    if (!imagesToResize.isEmpty()) {
+        // Only resize what actually changed, the other images keep their previews
+        resizeImages(imagesToResize);
+    }
+}
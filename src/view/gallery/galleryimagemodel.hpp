@@ -1,9 +1,10 @@
 #ifndef GALLERYIMAGEMODEL_H
 #define GALLERYIMAGEMODEL_H
 
-#include "model/modelmanager.hpp"
+#include "model/asyncmodelmanager.hpp"
 #include "loadingiconmodel.hpp"
 #include "resizeimagesrunnable.hpp"
+#include "thumbnailcache.hpp"
 
 #include <QAbstractListModel>
 #include <QImage>
@@ -11,6 +12,7 @@
 #include <QPointer>
 #include <QMovie>
 #include <QIcon>
+#include <QSet>
 
 /*!
  * \brief The GalleryImageModel class provides the image data for a listview that is supposed to
@@ -24,7 +26,7 @@ public:
      * \brief GalleryImageModel constructor.
      * \param modelManager the model manager that is supposed to be used for image retrieval
      */
-    explicit GalleryImageModel(ModelManager* modelManager);
+    explicit GalleryImageModel(AsyncModelManager* modelManager);
     ~GalleryImageModel();
 
     //! Implementations of QAbstractListModel
@@ -34,17 +36,30 @@ public:
 private Q_SLOTS:
     void onImageResized(int imageIndex, const QString &imagePath, const QImage &resizedImage);
     void onDataChanged(int data);
+    void onImagesChanged(const QList<ImagePtr> &images, const DataDelta &delta);
+    void onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree);
+    //! Resizes the evicted images that were shown again
+    void restoreEvictedImages();
 
 private:
     void threadedResizeImages();
     void resizeImages();
+    void stopResizingImages();
+    //! Resizes only the given images, the other images keep their previews
+    void resizeImages(const QList<ImagePtr> &images);
 
 private:
-    ModelManager *m_modelManager;
+    AsyncModelManager *m_modelManager;
     QList<ImagePtr> m_imagesCache;
+    //! The version of the snapshot the images were taken from, 0 if unknown
+    quint64 m_imagesVersion = 0;
     QPointer<ResizeImagesRunnable> m_resizeImagesRunnable;
+    //! Runnables that resize only the images which changed on the filesystem
+    QList<QPointer<ResizeImagesRunnable>> m_resizeChangedImagesRunnables;
     QThreadPool m_resizeImagesThreadpool;
-    QMap<QString, QImage> m_resizedImagesCache;
+    ThumbnailCache m_resizedImagesCache;
+    //! Evicted images that were shown and have to be resized again
+    mutable QSet<QString> m_imagesToRestore;
     bool m_abortResize = false;
 };
 
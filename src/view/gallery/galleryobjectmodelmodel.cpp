@@ -1,5 +1,7 @@
 #include "galleryobjectmodelmodel.hpp"
 #include "misc/generalhelper.hpp"
+#include "misc/memoryaccounting.hpp"
+#include "misc/tracing.hpp"
 #include <QIcon>
 #include <QPainter>
 #include <QDir>
@@ -10,17 +12,32 @@
 #include <QThread>
 #include <QApplication>
 
-GalleryObjectModelModel::GalleryObjectModelModel(ModelManager* modelManager)
-    : m_modelManager(modelManager) {
+#include <algorithm>
+
+GalleryObjectModelModel::GalleryObjectModelModel(AsyncModelManager* modelManager)
+    : m_modelManager(modelManager)
+    , m_renderedObjectsModels(MemoryAccounting::OBJECT_MODEL_PREVIEWS) {
     Q_ASSERT(modelManager != Q_NULLPTR);
-    m_objectModels = modelManager->objectModels();
+    const ModelSnapshotPtr snapshot = modelManager->snapshot();
+    m_objectModels = snapshot->objectModels();
+    m_objectModelsVersion = snapshot->objectModelsVersion();
     renderObjectModels();
-    m_images = modelManager->images();
+    m_images = snapshot->images();
+    m_segmentationColorIndex.setImages(m_images);
+    compileSegmentationCodes();
     // Create default index mapping
     createIndexMapping();
-    connect(modelManager, &ModelManager::dataChanged,
+    connect(modelManager, &AsyncModelManager::dataChanged,
             this, &GalleryObjectModelModel::onDataChanged);
+    connect(modelManager, &AsyncModelManager::imagesChanged,
+            this, &GalleryObjectModelModel::onImagesChanged);
+    connect(modelManager, &AsyncModelManager::objectModelsChanged,
+            this, &GalleryObjectModelModel::onObjectModelsChanged);
     connect(&m_offscreenEngine, &OffscreenEngine::imageReady, this, &GalleryObjectModelModel::onObjectModelRendered);
+    connect(&m_segmentationColorIndex, &SegmentationColorIndex::imageIndexed,
+            this, &GalleryObjectModelModel::onSegmentationImageIndexed);
+    connect(MemoryAccounting::instance(), &MemoryAccounting::budgetExceeded,
+            this, &GalleryObjectModelModel::onMemoryBudgetExceeded);
 }
 
 GalleryObjectModelModel::~GalleryObjectModelModel() {
@@ -33,6 +50,13 @@ QVariant GalleryObjectModelModel::dataForObjectModel(const ObjectModel& objectMo
         if (m_renderedObjectsModels.contains(objectModel.path())) {
             return QIcon(QPixmap::fromImage(m_renderedObjectsModels.value(objectModel.path())));
         } else {
+            if (m_renderedObjectsModels.isEvicted(objectModel.path())) {
+                if (m_previewsToRestore.isEmpty()) {
+                    QMetaObject::invokeMethod(const_cast<GalleryObjectModelModel*>(this),
+                                              "restoreEvictedPreviews", Qt::QueuedConnection);
+                }
+                m_previewsToRestore.insert(objectModel.path());
+            }
             return m_currentLoadingAnimationFrame;
         }
     }
@@ -41,30 +65,62 @@ QVariant GalleryObjectModelModel::dataForObjectModel(const ObjectModel& objectMo
 }
 
 void GalleryObjectModelModel::renderObjectModels() {
-    if (m_objectModels.count() > 0) {
-        m_renderedObjectsModels.clear();
-        m_currentlyRenderedImageIndex = 0;
-        m_renderingObjectModels = true;
-        m_offscreenEngine.setObjectModel(*m_objectModels[0]);
-        // Next object model rendering will be requested when
-        // receiving the rendering
-        m_offscreenEngine.requestImage();
+    m_renderedObjectsModels.clear();
+    m_objectModelsToRender = m_objectModels;
+    if (m_objectModelBeingRendered) {
+        // Rendered with the old settings, the next rendering is requested
+        // when receiving this one
+        m_renderingOutdated = true;
+    } else {
+        renderNextObjectModel();
     }
 }
 
-void GalleryObjectModelModel::onObjectModelRendered(QImage image) {
-    QString objectModel = m_objectModels[m_currentlyRenderedImageIndex]->path();
-    qDebug() << "Preview rendering finished for " + objectModel;
-    m_renderedObjectsModels.insert(objectModel, image);
-    m_currentlyRenderedImageIndex++;
-    if (m_currentlyRenderedImageIndex < m_objectModels.size()) {
-        m_offscreenEngine.setObjectModel(*m_objectModels[m_currentlyRenderedImageIndex]);
-        m_offscreenEngine.requestImage();
-    } else {
-        m_currentlyRenderedImageIndex = 0;
-        m_renderingObjectModels = false;
+void GalleryObjectModelModel::renderNextObjectModel() {
+    m_renderingOutdated = false;
+    if (m_objectModelsToRender.isEmpty()) {
+        m_objectModelBeingRendered.reset();
         m_loadingIconUpdateTimer.stop();
+        return;
+    }
+    m_objectModelBeingRendered = m_objectModelsToRender.takeFirst();
+    TRACE_ASYNC_BEGIN("gallery", "render object model preview", this);
+    m_offscreenEngine.setObjectModel(*m_objectModelBeingRendered);
+    // Next object model rendering will be requested when
+    // receiving the rendering
+    m_offscreenEngine.requestImage();
+}
+
+void GalleryObjectModelModel::onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree) {
+    if (subsystem == MemoryAccounting::OBJECT_MODEL_PREVIEWS) {
+        m_renderedObjectsModels.evict(bytesToFree);
+    }
+}
+
+void GalleryObjectModelModel::restoreEvictedPreviews() {
+    for (const ObjectModelPtr &objectModel : m_objectModels) {
+        if (m_previewsToRestore.contains(objectModel->path())
+                && m_renderedObjectsModels.takeEvicted(objectModel->path())) {
+            m_objectModelsToRender.append(objectModel);
+        }
+    }
+    m_previewsToRestore.clear();
+    if (!m_objectModelsToRender.isEmpty()) {
+        m_loadingIconUpdateTimer.start();
+        if (!m_objectModelBeingRendered) {
+            renderNextObjectModel();
+        }
+    }
+}
+
+void GalleryObjectModelModel::onObjectModelRendered(QImage image) {
+    TRACE_ASYNC_END("gallery", "render object model preview", this);
+    if (m_objectModelBeingRendered && !m_renderingOutdated) {
+        QString objectModel = m_objectModelBeingRendered->path();
+        qDebug() << "Preview rendering finished for " + objectModel;
+        m_renderedObjectsModels.insert(objectModel, image);
     }
+    renderNextObjectModel();
 }
 
 //! Implementations of QAbstractListModel
@@ -76,62 +132,42 @@ QVariant GalleryObjectModelModel::data(const QModelIndex &index, int role) const
         return QVariant();
     }
 
-    ObjectModelPtr objectModel = m_objectModels.at(m_indexMapping.value(index.row()));
-
-    if (m_currentSelectedImageIndex == -1) {
-        return dataForObjectModel(*objectModel, role);
-    }
-
-    ImagePtr currentlySelectedImage = m_images.at(m_currentSelectedImageIndex);
-    if (m_codes.size() == 0
-            || currentlySelectedImage->segmentationImagePath().isEmpty()
-            || !isNumberOfToolsCorrect()) {
-        //! If no codes at all were set or if the currently selected image does not provide segmentation images
-        //! simply display all available object models
-        return dataForObjectModel(*objectModel, role);
-    } else if (m_codes.contains(objectModel->path())) {
-        //! If any codes are set only display the appropriate object models
-        QString code = m_codes[objectModel->path()];
-        if (code.compare("") != 0) {
-            QColor color = GeneralHelper::colorFromSegmentationCode(code);
-            if (m_colorsOfCurrentImage.contains(color)) {
-                return dataForObjectModel(*objectModel, role);
-            }
-        }
+    if (index.row() < 0 || index.row() >= m_indexMapping.size()) {
+        return QVariant();
     }
 
-    return QVariant();
+    //! The mapping only contains the object models that pass the segmentation filter
+    return dataForObjectModel(*m_objectModels.at(m_indexMapping[index.row()]), role);
 }
 
 int GalleryObjectModelModel::rowCount(const QModelIndex &/* parent */) const {
-    bool noCodes = m_codes.size() == 0;
-    bool noSegmentationImages = (m_currentSelectedImageIndex != -1
-                                    && m_images.at(m_currentSelectedImageIndex)
-                                        ->segmentationImagePath().isEmpty());
-    if (noCodes || noSegmentationImages || !isNumberOfToolsCorrect()) {
-        // Not only renderedObjectModels.size() because we show loading icons
-        return m_objectModels.size();
-    }
-
-    if (m_currentSelectedImageIndex == -1) {
-        return m_objectModels.size();
-    }
-
-    int count = 0;
-    for (const ObjectModelPtr &model : m_objectModels) {
-        QString code = m_codes[model->path()];
-        if (code != "") {
-            QColor color = GeneralHelper::colorFromSegmentationCode(code);
-            if (m_colorsOfCurrentImage.contains(color)) {
-                count++;
-            }
-        }
-    }
-    return count;
+    // Not only renderedObjectModels.size() because we show loading icons
+    return m_indexMapping.size();
 }
 
 void GalleryObjectModelModel::setSegmentationCodesForObjectModels(QMap<QString, QString> codes) {
+    beginResetModel();
     this->m_codes = std::move(codes);
+    compileSegmentationCodes();
+    createIndexMapping();
+    endResetModel();
+}
+
+void GalleryObjectModelModel::compileSegmentationCodes() {
+    // Parsing the codes once keeps them out of filtering the object models
+    m_codeColors.clear();
+    for (auto it = m_codes.constBegin(); it != m_codes.constEnd(); it++) {
+        if (!it.value().isEmpty()) {
+            m_codeColors.append(GeneralHelper::colorFromSegmentationCode(it.value()).rgb());
+        }
+    }
+    m_segmentationColorOfObjectModel.fill(NoSegmentationColor, m_objectModels.size());
+    for (int i = 0; i < m_objectModels.size(); i++) {
+        const QString code = m_codes.value(m_objectModels[i]->path());
+        if (!code.isEmpty()) {
+            m_segmentationColorOfObjectModel[i] = GeneralHelper::colorFromSegmentationCode(code).rgb();
+        }
+    }
 }
 
 void GalleryObjectModelModel::setPreviewRenderingSize(QSize size) {
@@ -158,86 +194,156 @@ bool GalleryObjectModelModel::isNumberOfToolsCorrect() const {
     //! If there are no color keys for object models defined and the total number of object models is less
     //! than different colors in the segmentation image we definitely have too few object models
     //!
-    //! Minus 2 because black and white are always in the segmentation images
-    if (m_codes.keys().size() == 0 && m_objectModels.size() < m_colorsOfCurrentImage.size() - 2)
+    //! Black and white are no object colors, palettized segmentation images always contain both
+    //! but masks without a palette might not
+    int numberOfObjectColors = m_colorsOfCurrentImage.size();
+    numberOfObjectColors -= m_colorsOfCurrentImage.contains(qRgb(0, 0, 0)) ? 1 : 0;
+    numberOfObjectColors -= m_colorsOfCurrentImage.contains(qRgb(255, 255, 255)) ? 1 : 0;
+    if (m_codes.keys().size() == 0 && m_objectModels.size() < numberOfObjectColors)
         return false;
 
     int numberOfMatches = 0;
-    for (QMap<QString, QString>::ConstIterator it = m_codes.begin(); it != m_codes.end(); it++) {
-        QString code = it.value();
-        if (code.compare("") != 0) {
-            QColor color = GeneralHelper::colorFromSegmentationCode(code);
-            if (m_colorsOfCurrentImage.contains(color)) {
-                numberOfMatches++;
-            }
+    for (QRgb color : m_codeColors) {
+        if (m_colorsOfCurrentImage.contains(color)) {
+            numberOfMatches++;
         }
     }
-    return numberOfMatches == m_colorsOfCurrentImage.size() - 2;
+    return numberOfMatches == numberOfObjectColors;
 }
 
 void GalleryObjectModelModel::onDataChanged(int data) {
+    const ModelSnapshotPtr snapshot = m_modelManager->snapshot();
     if (data & Data::Images) {
         // When the images change, the last selected image gets deselected
         // This means we have to reset the index
-        m_images = m_modelManager->images();
+        m_images = snapshot->images();
+        m_segmentationColorIndex.setImages(m_images);
         m_currentSelectedImageIndex = -1;
         m_colorsOfCurrentImage.clear();
-        m_indexMapping.clear();
         createIndexMapping();
     }
-    if (data & Data::ObjectModels) {
-        if (m_modelManager) {
-            // When the object models change we need to re-render them
-            m_objectModels = m_modelManager->objectModels();
-            renderObjectModels();
-            m_loadingIconUpdateTimer.start();
-        } else {
-            m_objectModels.clear();
-            m_indexMapping.clear();
-        }
+    // Rendering the previews is expensive, the ones we have stay valid as long as the
+    // object models are the same, e.g. when the same folder is loaded again
+    if ((data & Data::ObjectModels)
+            && snapshot->objectModelsVersion() != m_objectModelsVersion) {
+        // When the object models change we need to re-render them
+        m_objectModels = snapshot->objectModels();
+        m_objectModelsVersion = snapshot->objectModelsVersion();
+        renderObjectModels();
+        m_loadingIconUpdateTimer.start();
+        compileSegmentationCodes();
         createIndexMapping();
     }
 }
 
+void GalleryObjectModelModel::onImagesChanged(const QList<ImagePtr> &images,
+                                              const DataDelta &delta) {
+    m_images = images;
+    QList<ImagePtr> reloadedImages;
+    for (int row : delta.insertedRows + delta.changedRows) {
+        reloadedImages.append(images[row]);
+    }
+    m_segmentationColorIndex.reindexImages(reloadedImages);
+    int selectedImageIndex = delta.mapRow(m_currentSelectedImageIndex);
+    if (selectedImageIndex == -1 || delta.changedRows.contains(selectedImageIndex)) {
+        // The selected image is gone or its segmentation image might have changed
+        beginResetModel();
+        m_currentSelectedImageIndex = -1;
+        m_colorsOfCurrentImage.clear();
+        createIndexMapping();
+        endResetModel();
+    } else {
+        m_currentSelectedImageIndex = selectedImageIndex;
+    }
+}
+
+void GalleryObjectModelModel::onObjectModelsChanged(const QList<ObjectModelPtr> &objectModels,
+                                                    const DataDelta &delta) {
+    beginResetModel();
+    // Only the previews of changed object models have to be rendered again
+    for (int row : delta.removedRows) {
+        m_renderedObjectsModels.remove(m_objectModels[row]->path());
+    }
+    for (int row : delta.changedRows) {
+        m_renderedObjectsModels.remove(objectModels[row]->path());
+    }
+    m_objectModels = objectModels;
+    // The snapshot might already be newer than the delta, the next full change has to
+    // render the previews no matter what
+    m_objectModelsVersion = 0;
+    m_objectModelsToRender.erase(
+                std::remove_if(m_objectModelsToRender.begin(), m_objectModelsToRender.end(),
+                               [&objectModels](const ObjectModelPtr &objectModel) {
+                                   return !objectModels.contains(objectModel);
+                               }),
+                m_objectModelsToRender.end());
+    for (int row : delta.insertedRows + delta.changedRows) {
+        m_objectModelsToRender.append(objectModels[row]);
+    }
+    if (m_objectModelBeingRendered && !objectModels.contains(m_objectModelBeingRendered)) {
+        m_renderingOutdated = true;
+    }
+    compileSegmentationCodes();
+    createIndexMapping();
+    endResetModel();
+
+    if (!m_objectModelsToRender.isEmpty()) {
+        m_loadingIconUpdateTimer.start();
+        if (!m_objectModelBeingRendered) {
+            renderNextObjectModel();
+        }
+    }
+}
+
 void GalleryObjectModelModel::onSelectedImageChanged(int index) {
+    TRACE_SCOPE("gallery", "GalleryObjectModelModel::onSelectedImageChanged");
     if (index != m_currentSelectedImageIndex) {
         m_currentSelectedImageIndex = index;
-        const ImagePtr& image = m_images.at(m_currentSelectedImageIndex);
+        const bool validIndex = index >= 0 && index < m_images.size();
 
         //! If we find an segmentation image update the colors that are used to filter tools
-        if (image->segmentationImagePath().compare("") != 0) {
+        if (validIndex && m_segmentationColorIndex.isIndexed(*m_images.at(index))) {
+            updateColorsOfCurrentImage();
+        } else {
+            // All object models are shown until the colors are known
             m_colorsOfCurrentImage.clear();
-            m_indexMapping.clear();
-            QImage loadedImage(image->absoluteSegmentationImagePath());
-            for (QColor color : loadedImage.colorTable()) {
-                m_colorsOfCurrentImage.push_back(color);
-            }
             createIndexMapping();
             Q_EMIT displayedObjectModelsChanged();
+            if (validIndex) {
+                m_segmentationColorIndex.requestImage(*m_images.at(index));
+            }
         }
     }
 }
 
+void GalleryObjectModelModel::onSegmentationImageIndexed(const QString &absoluteSegmentationImagePath) {
+    if (m_currentSelectedImageIndex >= 0 && m_currentSelectedImageIndex < m_images.size()
+            && m_images[m_currentSelectedImageIndex]->absoluteSegmentationImagePath()
+                == absoluteSegmentationImagePath) {
+        updateColorsOfCurrentImage();
+    }
+}
+
+void GalleryObjectModelModel::updateColorsOfCurrentImage() {
+    m_colorsOfCurrentImage = m_segmentationColorIndex.colors(*m_images[m_currentSelectedImageIndex]);
+    createIndexMapping();
+    Q_EMIT displayedObjectModelsChanged();
+}
+
 void GalleryObjectModelModel::createIndexMapping() {
     m_indexMapping.clear();
-    if (m_currentSelectedImageIndex != -1) {
+    if (m_currentSelectedImageIndex >= 0 && m_currentSelectedImageIndex < m_images.size()
+            && !m_codes.isEmpty()) {
         const ImagePtr& image = m_images.at(m_currentSelectedImageIndex);
         if (image->segmentationImagePath().compare("") != 0 &&
                 isNumberOfToolsCorrect()) {
             // This is the case when the number of colors in the segmentation image equals
             // the number of tools and the an image has been selected for display
-            int count = 0;
-            int realIndex = 0;
-            for (const ObjectModelPtr &model : m_objectModels) {
-                QString code = m_codes[model->path()];
-                if (code != "") {
-                    QColor color = GeneralHelper::colorFromSegmentationCode(code);
-                    if (m_colorsOfCurrentImage.contains(color)) {
-                        m_indexMapping[count] = realIndex;
-                        count++;
-                    }
+            for (int i = 0; i < m_objectModels.size(); i++) {
+                const QRgb color = m_segmentationColorOfObjectModel[i];
+                if (color != NoSegmentationColor && m_colorsOfCurrentImage.contains(color)) {
+                    m_indexMapping.append(i);
                 }
-                realIndex++;
             }
             // Return here because we created the index mapping
             return;
@@ -246,7 +352,8 @@ void GalleryObjectModelModel::createIndexMapping() {
 
     // This is the mapping for when the number of colors in the segmentation image doesn't
     // match the number of tools or when the user hasn't selected an object model to display yet
+    m_indexMapping.reserve(m_objectModels.size());
     for (int i = 0; i < m_objectModels.size(); i++) {
-        m_indexMapping[i] = i;
+        m_indexMapping.append(i);
     }
 }
@@ -2,14 +2,18 @@
 #define GALLERYOBJECTMODELMODEL_H
 
 #include "loadingiconmodel.hpp"
-#include "model/modelmanager.hpp"
+#include "model/asyncmodelmanager.hpp"
 #include "view/rendering/offscreenengine.hpp"
+#include "segmentationcolorindex.hpp"
+#include "thumbnailcache.hpp"
 
 #include <QAbstractListModel>
 #include <QColor>
 #include <QMap>
 #include <QList>
+#include <QSet>
 #include <QSize>
+#include <QVector>
 
 /*!
  * \brief The GalleryObjectModelModel class provides object model images to the Gallery.
@@ -21,7 +25,7 @@ class GalleryObjectModelModel : public LoadingIconModel {
     Q_PROPERTY(QSize previewRenderingSize READ previewRenderingSize WRITE setPreviewRenderingSize)
 
 public:
-    explicit GalleryObjectModelModel(ModelManager* modelManager);
+    explicit GalleryObjectModelModel(AsyncModelManager* modelManager);
     ~GalleryObjectModelModel();
 
     //! Implementations of QAbstractListModel
@@ -51,30 +55,57 @@ Q_SIGNALS:
 private Q_SLOTS:
     bool isNumberOfToolsCorrect() const;
     void onDataChanged(int data);
+    void onImagesChanged(const QList<ImagePtr> &images, const DataDelta &delta);
+    void onObjectModelsChanged(const QList<ObjectModelPtr> &objectModels, const DataDelta &delta);
     void onObjectModelRendered(QImage image);
+    void onSegmentationImageIndexed(const QString &absoluteSegmentationImagePath);
+    void onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree);
+    //! Renders the evicted previews that were shown again
+    void restoreEvictedPreviews();
 
 private:
     QVariant dataForObjectModel(const ObjectModel& objectModel, int role) const;
     void renderObjectModels();
+    void renderNextObjectModel();
     void createIndexMapping();
+    //! Parses the segmentation codes, has to be called when the codes or object models change
+    void compileSegmentationCodes();
+    //! Takes the colors of the selected image from the index and filters the object models
+    void updateColorsOfCurrentImage();
 
 private:
-    ModelManager* m_modelManager;
+    AsyncModelManager* m_modelManager;
     QList<ObjectModelPtr> m_objectModels;
-    QMap<QString,QImage> m_renderedObjectsModels;
+    //! The version of the snapshot the object models were taken from, 0 if unknown
+    quint64 m_objectModelsVersion = 0;
+    ThumbnailCache m_renderedObjectsModels;
+    //! Evicted previews that were shown and have to be rendered again
+    mutable QSet<QString> m_previewsToRestore;
     OffscreenEngine m_offscreenEngine{QSize(300, 300)};
     QList<ImagePtr> m_images;
     // Color codes
     QMap<QString, QString> m_codes;
-    //! We need this in case that an object model will not be displayed due to its color
-    //! which then "tears" a hole into the indices
-    QMap<int, int> m_indexMapping;
-    QList<QColor> m_colorsOfCurrentImage;
+    //! The colors of all codes that are set
+    QVector<QRgb> m_codeColors;
+    //! The color of the code of every object model, by object model index
+    QVector<QRgb> m_segmentationColorOfObjectModel;
+    //! Transparent, the colors of codes are always opaque
+    static const QRgb NoSegmentationColor = 0;
+    //! Maps the rows to the object models that pass the filter, we need this in case that an
+    //! object model will not be displayed due to its color which then "tears" a hole into the
+    //! indices
+    QVector<int> m_indexMapping;
+    QSet<QRgb> m_colorsOfCurrentImage;
+    SegmentationColorIndex m_segmentationColorIndex;
     int m_currentSelectedImageIndex = -1;
-    //! Store the index of the currently rendered image to be able to set the correct image
+    //! The object models whose previews still have to be rendered
+    QList<ObjectModelPtr> m_objectModelsToRender;
+    //! Store the currently rendered object model to be able to set the correct image
     //! when the renderer returns
-    int m_currentlyRenderedImageIndex = 0;
-    bool m_renderingObjectModels = false;
+    ObjectModelPtr m_objectModelBeingRendered;
+    //! Set when the object model being rendered changed in the meantime, its preview is
+    //! discarded then
+    bool m_renderingOutdated = false;
 };
 
 #endif // GALLERYOBJECTMODELMODEL_H
@@ -1,4 +1,5 @@
 #include "resizeimagesrunnable.hpp"
+#include "misc/tracing.hpp"
 
 #include <QUrl>
 #include <QImageReader>
@@ -11,11 +12,13 @@ ResizeImagesRunnable::ResizeImagesRunnable(const QList<ImagePtr> &images) {
 }
 
 void ResizeImagesRunnable::run() {
+    TRACE_SCOPE("gallery", "ResizeImagesRunnable::run");
     int i = 0;
     for (Image &image : m_images) {
         if (m_stopProcess) {
             break;
         }
+        TRACE_SCOPE_DETAIL("gallery", "resize image", image.imagePath());
         QElapsedTimer timer;
         timer.start();
         QImageReader imageReader(QUrl::fromLocalFile(image.absoluteImagePath()).path());
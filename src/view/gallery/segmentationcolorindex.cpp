@@ -0,0 +1,133 @@
+#include "segmentationcolorindex.hpp"
+
+#include <QImage>
+#include <QtConcurrent>
+
+#include <cstring>
+
+SegmentationColorIndex::SegmentationColorIndex(QObject *parent)
+    : QObject(parent) {
+    m_requestThreadPool.setMaxThreadCount(1);
+    connect(&m_backgroundWatcher, &QFutureWatcherBase::resultReadyAt,
+            this, &SegmentationColorIndex::onBackgroundResultReady);
+    connect(&m_requestWatcher, &QFutureWatcherBase::finished,
+            this, &SegmentationColorIndex::onRequestedImageIndexed);
+}
+
+SegmentationColorIndex::~SegmentationColorIndex() {
+    m_backgroundWatcher.cancel();
+    m_backgroundWatcher.waitForFinished();
+    m_requestWatcher.waitForFinished();
+}
+
+void SegmentationColorIndex::setImages(const QList<ImagePtr> &images) {
+    m_colorsForPath.clear();
+    m_pendingPaths.clear();
+    reindexImages(images);
+}
+
+void SegmentationColorIndex::reindexImages(const QList<ImagePtr> &images) {
+    for (const ImagePtr &image : images) {
+        if (!image->segmentationImagePath().isEmpty()) {
+            const QString path = image->absoluteSegmentationImagePath();
+            m_colorsForPath.remove(path);
+            m_pendingPaths.insert(path);
+        }
+    }
+    startIndexing();
+}
+
+void SegmentationColorIndex::requestImage(const Image &image) {
+    if (image.segmentationImagePath().isEmpty() || isIndexed(image)) {
+        return;
+    }
+    m_pendingPaths.insert(image.absoluteSegmentationImagePath());
+    m_requestWatcher.setFuture(QtConcurrent::run(&m_requestThreadPool,
+                                                 &SegmentationColorIndex::indexSegmentationImage,
+                                                 image.absoluteSegmentationImagePath()));
+}
+
+bool SegmentationColorIndex::isIndexed(const Image &image) const {
+    return m_colorsForPath.contains(image.absoluteSegmentationImagePath());
+}
+
+QSet<QRgb> SegmentationColorIndex::colors(const Image &image) const {
+    return m_colorsForPath.value(image.absoluteSegmentationImagePath());
+}
+
+QSet<QRgb> SegmentationColorIndex::colorsOfSegmentationImage(const QString &absolutePath) {
+    QSet<QRgb> colors;
+    QImage image(absolutePath);
+    if (image.isNull()) {
+        return colors;
+    }
+
+    const QVector<QRgb> colorTable = image.colorTable();
+    if (!colorTable.isEmpty()) {
+        for (QRgb color : colorTable) {
+            colors.insert(color | 0xff000000);
+        }
+        return colors;
+    }
+
+    // Masks consist of large areas of one color, i.e. rows that equal the previous one and
+    // long runs within a row. memcmp compares whole rows with vector instructions and only
+    // the first pixel of every run has to be looked up in the set.
+    if (image.format() != QImage::Format_RGB32) {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    }
+    const int width = image.width();
+    const size_t rowSize = size_t(width) * sizeof(QRgb);
+    const QRgb *previousRow = Q_NULLPTR;
+    for (int y = 0; y < image.height(); y++) {
+        const QRgb *row = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        if (previousRow != Q_NULLPTR && std::memcmp(row, previousRow, rowSize) == 0) {
+            continue;
+        }
+        previousRow = row;
+        int x = 0;
+        while (x < width) {
+            const QRgb color = row[x];
+            colors.insert(color);
+            do {
+                x++;
+            } while (x < width && row[x] == color);
+        }
+    }
+    return colors;
+}
+
+SegmentationColors SegmentationColorIndex::indexSegmentationImage(const QString &absolutePath) {
+    return qMakePair(absolutePath, colorsOfSegmentationImage(absolutePath));
+}
+
+void SegmentationColorIndex::onBackgroundResultReady(int index) {
+    addColors(m_backgroundWatcher.resultAt(index));
+}
+
+void SegmentationColorIndex::onRequestedImageIndexed() {
+    if (!m_requestWatcher.isCanceled()) {
+        addColors(m_requestWatcher.result());
+    }
+}
+
+void SegmentationColorIndex::addColors(const SegmentationColors &colors) {
+    // The images might have been set again in the meantime, results of images that are no
+    // longer part of the index are dropped
+    if (!m_pendingPaths.remove(colors.first)) {
+        return;
+    }
+    m_colorsForPath.insert(colors.first, colors.second);
+    Q_EMIT imageIndexed(colors.first);
+}
+
+void SegmentationColorIndex::startIndexing() {
+    // Setting a new future drops the results of the running one, its remaining images are
+    // still pending and part of the new one
+    m_backgroundWatcher.cancel();
+    if (m_pendingPaths.isEmpty()) {
+        return;
+    }
+    m_backgroundWatcher.setFuture(QtConcurrent::mapped(m_pendingPaths.values(),
+                                                       &SegmentationColorIndex::indexSegmentationImage));
+}
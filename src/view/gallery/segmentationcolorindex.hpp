@@ -0,0 +1,77 @@
+#ifndef SEGMENTATIONCOLORINDEX_H
+#define SEGMENTATIONCOLORINDEX_H
+
+#include "model/image.hpp"
+
+#include <QColor>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+typedef QPair<QString, QSet<QRgb>> SegmentationColors;
+
+/*!
+ * \brief The SegmentationColorIndex class knows which colors the segmentation images of the
+ * images contain, so that the object model gallery can show only the object models visible
+ * on the selected image without loading its segmentation image on the GUI thread.
+ *
+ * The segmentation images are read in the background once the images are set. If the user
+ * selects an image that hasn't been indexed yet, it can be requested to be indexed before
+ * all others. imageIndexed is emitted for every indexed segmentation image.
+ */
+class SegmentationColorIndex : public QObject {
+
+    Q_OBJECT
+
+public:
+    explicit SegmentationColorIndex(QObject *parent = Q_NULLPTR);
+    ~SegmentationColorIndex();
+
+    /*!
+     * \brief setImages starts indexing the segmentation images of the given images, all
+     * previously indexed colors are dropped since the files might have changed.
+     */
+    void setImages(const QList<ImagePtr> &images);
+    //! Indexes the segmentation images of the given images again, e.g. because they changed
+    void reindexImages(const QList<ImagePtr> &images);
+    //! Indexes the segmentation image of the image before all others
+    void requestImage(const Image &image);
+
+    bool isIndexed(const Image &image) const;
+    //! The colors of the segmentation image, alpha is always opaque
+    QSet<QRgb> colors(const Image &image) const;
+
+    /*!
+     * \brief colorsOfSegmentationImage reads the colors of the segmentation image. Palettized
+     * images provide them in their color table, all others are scanned pixel by pixel.
+     */
+    static QSet<QRgb> colorsOfSegmentationImage(const QString &absolutePath);
+
+Q_SIGNALS:
+    void imageIndexed(const QString &absoluteSegmentationImagePath);
+
+private Q_SLOTS:
+    void onBackgroundResultReady(int index);
+    void onRequestedImageIndexed();
+
+private:
+    static SegmentationColors indexSegmentationImage(const QString &absolutePath);
+    void addColors(const SegmentationColors &colors);
+    void startIndexing();
+
+private:
+    QHash<QString, QSet<QRgb>> m_colorsForPath;
+    //! Segmentation images that still have to be indexed
+    QSet<QString> m_pendingPaths;
+    QFutureWatcher<SegmentationColors> m_backgroundWatcher;
+    //! Requested images don't queue up behind the background indexing in the global pool
+    QThreadPool m_requestThreadPool;
+    QFutureWatcher<SegmentationColors> m_requestWatcher;
+};
+
+#endif // SEGMENTATIONCOLORINDEX_H
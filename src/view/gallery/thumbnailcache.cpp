@@ -0,0 +1,108 @@
+#include "thumbnailcache.hpp"
+#include "misc/memoryaccounting.hpp"
+
+#include <QPair>
+#include <QVector>
+
+#include <algorithm>
+
+ThumbnailCache::ThumbnailCache(const QString &subsystem)
+    : m_subsystem(subsystem) {
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    MemoryAccounting::instance()->reportUsage(m_subsystem, 0);
+}
+
+bool ThumbnailCache::contains(const QString &path) const {
+    return m_entries.contains(path);
+}
+
+QImage ThumbnailCache::value(const QString &path) const {
+    auto entry = m_entries.constFind(path);
+    if (entry == m_entries.constEnd()) {
+        return QImage();
+    }
+    entry->lastUsed = ++m_useCounter;
+    return entry->image;
+}
+
+void ThumbnailCache::insert(const QString &path, const QImage &image) {
+    auto entry = m_entries.find(path);
+    if (entry != m_entries.end()) {
+        m_bytes -= entry->image.sizeInBytes();
+        entry->image = image;
+        entry->lastUsed = ++m_useCounter;
+    } else {
+        m_entries.insert(path, {image, ++m_useCounter});
+    }
+    m_bytes += image.sizeInBytes();
+    m_evicted.remove(path);
+    reportUsage();
+}
+
+void ThumbnailCache::remove(const QString &path) {
+    auto entry = m_entries.find(path);
+    if (entry != m_entries.end()) {
+        m_bytes -= entry->image.sizeInBytes();
+        m_entries.erase(entry);
+        reportUsage();
+    }
+    m_evicted.remove(path);
+}
+
+void ThumbnailCache::clear() {
+    m_entries.clear();
+    m_evicted.clear();
+    m_bytes = 0;
+    reportUsage();
+}
+
+int ThumbnailCache::size() const {
+    return m_entries.size();
+}
+
+qint64 ThumbnailCache::bytes() const {
+    return m_bytes;
+}
+
+QStringList ThumbnailCache::evict(qint64 bytesToFree) {
+    QVector<QPair<quint64, QString>> entriesByLastUse;
+    entriesByLastUse.reserve(m_entries.size());
+    for (auto entry = m_entries.constBegin(); entry != m_entries.constEnd(); entry++) {
+        entriesByLastUse.append(qMakePair(entry->lastUsed, entry.key()));
+    }
+    std::sort(entriesByLastUse.begin(), entriesByLastUse.end());
+
+    QStringList evicted;
+    qint64 freed = 0;
+    for (const auto &entry : entriesByLastUse) {
+        if (freed >= bytesToFree) {
+            break;
+        }
+        const qint64 bytes = m_entries.value(entry.second).image.sizeInBytes();
+        m_entries.remove(entry.second);
+        m_evicted.insert(entry.second);
+        m_bytes -= bytes;
+        freed += bytes;
+        evicted.append(entry.second);
+    }
+    reportUsage();
+    return evicted;
+}
+
+bool ThumbnailCache::isEvicted(const QString &path) const {
+    return m_evicted.contains(path);
+}
+
+bool ThumbnailCache::takeEvicted(const QString &path) {
+    return m_evicted.remove(path);
+}
+
+int ThumbnailCache::evictedCount() const {
+    return m_evicted.size();
+}
+
+void ThumbnailCache::reportUsage() const {
+    MemoryAccounting::instance()->reportUsage(m_subsystem, m_bytes);
+}
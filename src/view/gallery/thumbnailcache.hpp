@@ -0,0 +1,67 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+/*!
+ * \brief The ThumbnailCache class stores the previews of a gallery by path and reports
+ * their size to the MemoryAccounting under the given subsystem. When the subsystem is over
+ * its budget the gallery calls evict, which drops the least recently shown previews. The
+ * cache remembers which previews it evicted so that the gallery can create them again when
+ * they are shown the next time.
+ *
+ * Only used from the GUI thread.
+ */
+class ThumbnailCache {
+
+public:
+    explicit ThumbnailCache(const QString &subsystem);
+    ~ThumbnailCache();
+
+    bool contains(const QString &path) const;
+    //! Returns the preview and marks it as recently shown
+    QImage value(const QString &path) const;
+    void insert(const QString &path, const QImage &image);
+    void remove(const QString &path);
+    void clear();
+    int size() const;
+    qint64 bytes() const;
+
+    /*!
+     * \brief evict removes the least recently shown previews until at least the given
+     * number of bytes are free.
+     * \return the paths of the evicted previews
+     */
+    QStringList evict(qint64 bytesToFree);
+    //! True if the preview was evicted and has not been inserted again since
+    bool isEvicted(const QString &path) const;
+    /*!
+     * \brief takeEvicted forgets that the preview was evicted, e.g. because it is being
+     * created again.
+     * \return false if the preview wasn't evicted
+     */
+    bool takeEvicted(const QString &path);
+    int evictedCount() const;
+
+private:
+    struct Entry {
+        QImage image;
+        //! The value of m_useCounter when the preview was shown the last time
+        mutable quint64 lastUsed;
+    };
+
+    void reportUsage() const;
+
+private:
+    QString m_subsystem;
+    QHash<QString, Entry> m_entries;
+    QSet<QString> m_evicted;
+    qint64 m_bytes = 0;
+    mutable quint64 m_useCounter = 0;
+};
+
+#endif // THUMBNAILCACHE_H
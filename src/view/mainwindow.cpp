@@ -2,6 +2,7 @@
 #include "ui_mainwindow.h"
 #include "view/misc/displayhelper.hpp"
 #include "view/settings/settingsdialog.hpp"
+#include "view/diagnostics/memorydiagnosticsdialog.hpp"
 
 #include <QSettings>
 #include <QCloseEvent>
@@ -12,10 +13,11 @@
 #include <QStandardPaths>
 #include <QFileDialog>
 #include <QCheckBox>
+#include <QStringList>
 
 //! The main window of the application that holds the individual components.<
 MainWindow::MainWindow(QWidget *parent,
-                       ModelManager *modelManager,
+                       AsyncModelManager *modelManager,
                        SettingsStore *settingsStore) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
@@ -36,7 +38,7 @@ MainWindow::MainWindow(QWidget *parent,
 
     statusBar()->addPermanentWidget(m_statusBarLabel, 1);
     setStatusBarText(QString("Loading..."));
-    connect(modelManager, &ModelManager::stateChanged,
+    connect(modelManager, &AsyncModelManager::stateChanged,
             this, &MainWindow::onModelManagerStateChanged);
 
     connect(settingsStore, &SettingsStore::currentSettingsChanged,
@@ -179,6 +181,86 @@ void MainWindow::setStatusBarTextReadyForPoseCreation(int numberOfCorrespondence
                      " correspondences complete).");
 }
 
+void MainWindow::setStatusBarTextRecoveringPose() {
+    setStatusBarText("Recovering pose...");
+}
+
+void MainWindow::setStatusBarTextPoseRecoveringFailed(const QString &reason) {
+    setStatusBarText("Recovering the pose failed (" + reason + "). Add or correct correspondences.");
+}
+
+void MainWindow::setStatusBarTextPoseRecovered(const QList<float> &residuals,
+                                               const QList<bool> &inliers,
+                                               float inlierRMS) {
+    QStringList residualStrings;
+    int numberOfInliers = 0;
+    for (int i = 0; i < residuals.size(); i++) {
+        QString residual = QString::number(residuals[i], 'f', 1);
+        if (i < inliers.size() && inliers[i]) {
+            numberOfInliers++;
+        } else {
+            residual += "*";
+        }
+        residualStrings << residual;
+    }
+    setStatusBarText("Pose recovered (" +
+                     QString::number(numberOfInliers) +
+                     "/" +
+                     QString::number(residuals.size()) +
+                     " inliers, RMS " +
+                     QString::number(inlierRMS, 'f', 2) +
+                     " px). Residuals in px (* = outlier): " +
+                     residualStrings.join(", "));
+}
+
+void MainWindow::setStatusBarTextRefiningPoses(int numberOfRefinedPoses, int numberOfPoses) {
+    setStatusBarText("Refining poses (" +
+                     QString::number(numberOfRefinedPoses) +
+                     "/" +
+                     QString::number(numberOfPoses) +
+                     ")...");
+}
+
+void MainWindow::setStatusBarTextPoseRefined(float initialScore, float finalScore) {
+    setStatusBarText("Pose refined (fit " +
+                     QString::number(initialScore * 100, 'f', 1) +
+                     "% -> " +
+                     QString::number(finalScore * 100, 'f', 1) +
+                     "%).");
+}
+
+void MainWindow::setStatusBarTextPosesRefined(int numberOfRefinedPoses, int numberOfPoses) {
+    setStatusBarText("Refined " +
+                     QString::number(numberOfRefinedPoses) +
+                     " of " +
+                     QString::number(numberOfPoses) +
+                     " poses.");
+}
+
+void MainWindow::setStatusBarTextPoseRefiningFailed(const QString &reason) {
+    setStatusBarText("Refining failed (" + reason + ").");
+}
+
+void MainWindow::setStatusBarTextPropagatingPoses(int numberOfProcessedImages, int numberOfImages) {
+    setStatusBarText("Propagating poses (" +
+                     QString::number(numberOfProcessedImages) +
+                     "/" +
+                     QString::number(numberOfImages) +
+                     " images)...");
+}
+
+void MainWindow::setStatusBarTextPosesPropagated(int numberOfPoses, int numberOfImages) {
+    setStatusBarText("Added " +
+                     QString::number(numberOfPoses) +
+                     " poses to " +
+                     QString::number(numberOfImages) +
+                     " images.");
+}
+
+void MainWindow::setStatusBarTextPosePropagationFailed(const QString &reason) {
+    setStatusBarText("Propagating poses failed (" + reason + ").");
+}
+
 void MainWindow::showEvent(QShowEvent *e) {
     if (!m_showInitialized) {
         readSettings();
@@ -241,6 +323,14 @@ void MainWindow::clearGallerySelections() {
     ui->galleryRight->clearSelection(false);
 }
 
+void MainWindow::setEnabledActionUndo(bool enabled) {
+    ui->actionUndo->setEnabled(enabled);
+}
+
+void MainWindow::setEnabledActionRedo(bool enabled) {
+    ui->actionRedo->setEnabled(enabled);
+}
+
 void MainWindow::onImagesPathChangedByNavigation(const QString &path) {
     SettingsPtr settings = m_settingsStore->currentSettings();
     settings->setImagesPath(path);
@@ -316,7 +406,7 @@ void MainWindow::onActionExitTriggered() {
 void MainWindow::onActionSettingsTriggered() {
     SettingsDialog* settingsDialog = new SettingsDialog(this);
     settingsDialog->setSettingsStoreAndObjectModels(m_settingsStore,
-                                                    m_modelManager->objectModels());
+                                                    m_modelManager->snapshot()->objectModels());
     settingsDialog->show();
 }
 
@@ -330,6 +420,22 @@ void MainWindow::onActionResetTriggered() {
     Q_EMIT resetRequested();
 }
 
+void MainWindow::onActionUndoTriggered() {
+    Q_EMIT undoRequested();
+}
+
+void MainWindow::onActionRedoTriggered() {
+    Q_EMIT redoRequested();
+}
+
+void MainWindow::onActionRefineAllPosesTriggered() {
+    Q_EMIT refineAllPosesRequested();
+}
+
+void MainWindow::onActionPropagatePosesToSceneTriggered() {
+    Q_EMIT propagatePosesToSceneRequested();
+}
+
 void MainWindow::onActionReloadViewsTriggered() {
     Q_EMIT reloadViewsRequested();
     setStatusBarTextStartAddingCorrespondences();
@@ -367,6 +473,11 @@ void MainWindow::onActionTakeSnapshotTriggered() {
     }
 }
 
+void MainWindow::onActionMemoryDiagnosticsTriggered() {
+    MemoryDiagnosticsDialog *memoryDiagnosticsDialog = new MemoryDiagnosticsDialog(this);
+    memoryDiagnosticsDialog->show();
+}
+
 void MainWindow::onSnapshotSaved() {
     QSettings settings("Floretti Konfetti Inc.", "6D-PAT");
     bool showSnapshotSavedMessageBox = settings.value("showSnapshotSavedMessageBox", true).toBool();
@@ -28,7 +28,7 @@ class MainWindow : public QMainWindow {
 
 public:
 
-    explicit MainWindow(QWidget *parent, ModelManager *modelManager,
+    explicit MainWindow(QWidget *parent, AsyncModelManager *modelManager,
                         SettingsStore *settingsStore);
     ~MainWindow();
 
@@ -46,6 +46,22 @@ public:
     void setStatusBarText3DPointMissing(int numberOfCorrespondences, int minNumberOfCorrespondences);
     void setStatusBarTextNotEnoughCorrespondences(int numberOfCorrespondences, int minNumberOfCorrespondences);
     void setStatusBarTextReadyForPoseCreation(int numberOfCorrespondences, int minNumberOfCorrespondences);
+    void setStatusBarTextRecoveringPose();
+    void setStatusBarTextPoseRecoveringFailed(const QString &reason);
+    /*!
+     * \brief setStatusBarTextPoseRecovered displays the reprojection residuals of the
+     * correspondences of a recovered pose, outliers are marked with an asterisk.
+     */
+    void setStatusBarTextPoseRecovered(const QList<float> &residuals,
+                                       const QList<bool> &inliers,
+                                       float inlierRMS);
+    void setStatusBarTextRefiningPoses(int numberOfRefinedPoses, int numberOfPoses);
+    void setStatusBarTextPoseRefined(float initialScore, float finalScore);
+    void setStatusBarTextPosesRefined(int numberOfRefinedPoses, int numberOfPoses);
+    void setStatusBarTextPoseRefiningFailed(const QString &reason);
+    void setStatusBarTextPropagatingPoses(int numberOfProcessedImages, int numberOfImages);
+    void setStatusBarTextPosesPropagated(int numberOfPoses, int numberOfImages);
+    void setStatusBarTextPosePropagationFailed(const QString &reason);
 
     PoseViewer *poseViewer();
     PoseEditor *poseEditor();
@@ -56,6 +72,8 @@ public:
 
     // This is needed to clear the selections when e.g. relaoding the views
     void clearGallerySelections();
+    void setEnabledActionUndo(bool enabled);
+    void setEnabledActionRedo(bool enabled);
 
 public Q_SLOTS:
 
@@ -117,6 +135,10 @@ Q_SIGNALS:
 
     void reloadViewsRequested();
     void closingProgram();
+    void refineAllPosesRequested();
+    void propagatePosesToSceneRequested();
+    void undoRequested();
+    void redoRequested();
 
 private Q_SLOTS:
     void onSettingsChanged(SettingsPtr settings);
@@ -125,8 +147,13 @@ private Q_SLOTS:
     void onActionSettingsTriggered();
     void onActionAbortCreationTriggered();
     void onActionResetTriggered();
+    void onActionUndoTriggered();
+    void onActionRedoTriggered();
+    void onActionRefineAllPosesTriggered();
+    void onActionPropagatePosesToSceneTriggered();
     void onActionReloadViewsTriggered();
     void onActionTakeSnapshotTriggered();
+    void onActionMemoryDiagnosticsTriggered();
     void onSnapshotSaved();
     void onActionTutorialScreenTriggered();
     void onModelManagerStateChanged(ModelManager::State state,
@@ -166,7 +193,7 @@ private:
     QLabel *m_statusBarLabel = new QLabel();
 
     SettingsStore *m_settingsStore = Q_NULLPTR;
-    ModelManager *m_modelManager;
+    AsyncModelManager *m_modelManager;
 
     QProgressDialog *m_progressDialog;
 
@@ -137,6 +137,7 @@ void PoseEditor::setEnabledPoseEditorControls(bool enabled) {
     // The next line is the difference to setEnabledAllControls
     ui->buttonRemove->setEnabled(enabled);
     ui->buttonDuplicate->setEnabled(enabled);
+    ui->buttonRefine->setEnabled(enabled);
 }
 
 void PoseEditor::setEnabledAllControls(bool enabled) {
@@ -151,6 +152,7 @@ void PoseEditor::setEnabledAllControls(bool enabled) {
     ui->listViewPoses->setEnabled(enabled);
     ui->buttonSave->setEnabled(enabled);
     ui->buttonDuplicate->setEnabled(enabled);
+    ui->buttonRefine->setEnabled(enabled);
     ui->buttonCopy->setEnabled(enabled);
     ui->listViewImages->setEnabled(enabled);
 }
@@ -290,6 +292,10 @@ void PoseEditor::onButtonDuplicateClicked() {
     Q_EMIT buttonDuplicateClicked();
 }
 
+void PoseEditor::onButtonRefineClicked() {
+    Q_EMIT buttonRefineClicked();
+}
+
 // Callback to the ListViewPoses list view
 void PoseEditor::onListViewPosesSelectionChanged(const QItemSelection &selected, const QItemSelection &/*deselected*/) {
     // Reacts to selecting a different pose from the poses list view and loads the corresponding
@@ -69,6 +69,7 @@ Q_SIGNALS:
     void buttonSaveClicked();
     void buttonCopyClicked(ImagePtr imageToCopyFrom);
     void buttonDuplicateClicked();
+    void buttonRefineClicked();
     void buttonRemoveClicked();
 
 private Q_SLOTS:
@@ -88,6 +89,7 @@ private Q_SLOTS:
     void onButtonCreateClicked();
     void onButtonSaveClicked();
     void onButtonDuplicateClicked();
+    void onButtonRefineClicked();
     void onButtonRemoveClicked();
     void onButtonCopyClicked();
 
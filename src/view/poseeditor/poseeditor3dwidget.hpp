@@ -22,6 +22,8 @@
 #include <Qt3DRender/QDepthTest>
 #include <Qt3DRender/QMultiSampleAntiAliasing>
 
+// Runs its own Qt3D engine, unlike the pose viewer it needs picking and mouse input while
+// the viewer has them too, which the one input event source of an engine doesn't allow.
 class PoseEditor3DWindow : public Qt3DExtras::Qt3DWindow {
     Q_OBJECT
 
@@ -142,6 +142,10 @@ void PoseViewer::reset() {
     m_currentlyDisplayedImage.reset();
 }
 
+void PoseViewer::releaseUnusedObjectModels() {
+    m_poseViewer3DWidget->releaseUnusedPoseRenderables();
+}
+
 void PoseViewer::onPoseCreationAborted() {
     m_poseViewer3DWidget->setClicks({});
 }
@@ -51,6 +51,8 @@ public Q_SLOTS:
     void selectPose(PosePtr selected, PosePtr deselected);
 
     void reset();
+    //! Frees the meshes of object models that are not displayed, e.g. after reloading them
+    void releaseUnusedObjectModels();
     void onPoseCreationAborted();
     void takeSnapshot(const QString &path);
 
@@ -2,6 +2,9 @@
 #include "mousecoordinatesmodificationeventfilter.hpp"
 #include "misc/global.hpp"
 #include "view/misc/displayhelper.hpp"
+#include "view/rendering/sharedrenderengine.hpp"
+#include "misc/tracing.hpp"
+#include "misc/memoryaccounting.hpp"
 
 #include <math.h>
 #include <QtMath>
@@ -9,28 +12,22 @@
 #include <QTimer>
 
 #include <QApplication>
+#include <QFileInfo>
 #include <QFrame>
 #include <QImage>
 #include <QMouseEvent>
+#include <QSet>
 
 #include <QOpenGLFunctions>
 
 #include <Qt3DRender/QCameraLens>
-#include <Qt3DRender/QPickingSettings>
 #include <Qt3DRender/QFilterKey>
 #include <Qt3DRender/QParameter>
 
 PoseViewer3DWidget::PoseViewer3DWidget(QWidget *parent)
     : QOpenGLWidget(parent)
       // Qt3D core stuff
-      , m_aspectEngine(new Qt3DCore::QAspectEngine)
-      , m_renderAspect(new Qt3DRender::QRenderAspect(Qt3DRender::QRenderAspect::Threaded))
-      , m_inputAspect(new Qt3DInput::QInputAspect)
-      , m_logicAspect(new Qt3DLogic::QLogicAspect)
-      , m_renderSettings(new Qt3DRender::QRenderSettings)
-      , m_inputSettings(new Qt3DInput::QInputSettings)
       , m_frameAction(new Qt3DLogic::QFrameAction)
-      , m_root(new Qt3DCore::QEntity)
       , m_offscreenSurface(new QOffscreenSurface)
       , m_renderStateSet(new Qt3DRender::QRenderStateSet)
       , m_depthTest(new Qt3DRender::QDepthTest)
@@ -64,6 +61,7 @@ PoseViewer3DWidget::PoseViewer3DWidget(QWidget *parent)
       , m_posesFrustumCulling(new Qt3DRender::QFrustumCulling)
       , m_snapshotRenderPassFilter(new Qt3DRender::QRenderPassFilter)
       , m_removeHighlightParameter(new Qt3DRender::QParameter)
+      , m_opacityParameter(new Qt3DRender::QParameter)
       // Rest of poses branch
       , m_posesCamera(new Qt3DRender::QCamera)
       , m_posesCameraSelector(new Qt3DRender::QCameraSelector)
@@ -86,14 +84,25 @@ PoseViewer3DWidget::PoseViewer3DWidget(QWidget *parent)
     });
     m_updateFPSLabelTimer.setInterval(150);
     m_updateFPSLabelTimer.start();
+    connect(MemoryAccounting::instance(), &MemoryAccounting::budgetExceeded,
+            this, &PoseViewer3DWidget::onMemoryBudgetExceeded);
 }
 
 PoseViewer3DWidget::~PoseViewer3DWidget() {
+    SharedRenderEngine *engine = SharedRenderEngine::instance();
+    engine->removeView(m_renderStateSet);
+    if (engine->inputSettings() != Q_NULLPTR && engine->inputSettings()->eventSource() == this) {
+        engine->inputSettings()->setEventSource(Q_NULLPTR);
+    }
+    // Deletes all renderables and the rest of the framegraph as well
+    delete m_sceneRoot;
+    delete m_renderStateSet;
     makeCurrent();
     delete m_shaderProgram;
     m_vao.destroy();
     m_vbo.destroy();
     doneCurrent();
+    MemoryAccounting::instance()->reportUsage(MemoryAccounting::RENDERING_RESOURCES, 0);
 }
 
 const char *vertexShaderSource =
@@ -213,11 +222,6 @@ void PoseViewer3DWidget::initQt3D() {
     m_offscreenSurface->setFormat(QSurfaceFormat::defaultFormat());
     m_offscreenSurface->create();
 
-    //m_aspectEngine->registerAspect(new Qt3DCore::QCoreAspect);
-    m_aspectEngine->registerAspect(m_renderAspect);
-    m_aspectEngine->registerAspect(m_inputAspect);
-    m_aspectEngine->registerAspect(m_logicAspect);
-
     // Setup color
     m_colorOutput->setAttachmentPoint(Qt3DRender::QRenderTargetOutput::Color0);
 
@@ -263,8 +267,6 @@ void PoseViewer3DWidget::initQt3D() {
      * background image, the poses and the clicks
      */
 
-    m_sceneRoot->setParent(m_root);
-
     m_viewport->setParent(m_renderSurfaceSelector);
 
     // Viewport will be set as active framegraph at the end of initialization
@@ -309,8 +311,12 @@ void PoseViewer3DWidget::initQt3D() {
     m_posesBlendEquation->setBlendFunction(Qt3DRender::QBlendEquation::Add);
     m_posesFrustumCulling->setParent(m_posesRenderStateSet);
     m_snapshotRenderPassFilter->setParent(m_posesFrustumCulling);
-    m_removeHighlightParameter->setName("selected");
+    // Parameters of the framegraph override the ones of the materials
+    m_removeHighlightParameter->setName("highlightedOrSelectedColor");
     m_removeHighlightParameter->setValue(QVector4D(0.f, 0.f, 0.f, 0.f));
+    m_opacityParameter->setName("opacity");
+    m_opacityParameter->setValue(m_opacity);
+    m_snapshotRenderPassFilter->addParameter(m_opacityParameter);
     // Will be added when a snapshot is requested
     //snapshotRenderPassFilter->addParameter(removeHighlightParameter);
     m_posesCameraSelector->setParent(m_snapshotRenderPassFilter);
@@ -342,17 +348,16 @@ void PoseViewer3DWidget::initQt3D() {
     m_clickVisualizationRenderable->addComponent(m_clickVisualizationLayer);
     m_clickVisualizationRenderable->setSize(this->size());
 
-    // Global rendering config
-    m_renderSettings->pickingSettings()->setPickMethod(
-                Qt3DRender::QPickingSettings::TrianglePicking);
-    // RenderStateSet is the first node of the overall framegraph
-    m_renderSettings->setActiveFrameGraph(m_renderStateSet);
-    m_inputSettings->setEventSource(this);
+    // The picking method is set by the SharedRenderEngine for all views.
+    // RenderStateSet is the first node of our branch, it gets added to the engine when
+    // the widget is shown
 }
 
 void PoseViewer3DWidget::paintGL() {
+    TRACE_SCOPE("render", "PoseViewer3DWidget::paintGL");
     // In here we only take the offscreen texture from Qt3D to draw it on a quad
     m_elapsed = m_elapsedTimer.elapsed();
+    TRACE_COUNTER("render", "frame interval (ms)", m_elapsed);
     // Restart the timer
     m_elapsedTimer.start();
     glClearColor(1.0, 1.0, 1.0, 1.0);
@@ -398,6 +403,7 @@ void PoseViewer3DWidget::setClicks(const QList<QPoint> &clicks) {
 
 void PoseViewer3DWidget::setBackgroundImage(const QString& image, const QMatrix3x3 &cameraMatrix,
                                             float nearPlane, float farPlane) {
+    TRACE_SCOPE_DETAIL("viewer", "PoseViewer3DWidget::setBackgroundImage", image);
     QImage loadedImage(image);
     m_imageSize = loadedImage.size();
     setRenderingSize(loadedImage.width(), loadedImage.height());
@@ -430,14 +436,14 @@ void PoseViewer3DWidget::setBackgroundImage(const QString& image, const QMatrix3
     m_poseRotationHandler.setProjectionMatrix(m_projectionMatrix);
     m_poseTranslationHandler.setProjectionMatrix(m_projectionMatrix);
     m_backgroundImageRenderable->setEnabled(true);
+    reportMemoryUsage();
 }
 
 void PoseViewer3DWidget::setPoses(const QList<PosePtr> &poses) {
-    // Remove old poses
-    for (int index = 0; index < m_poseRenderables.size(); index++) {
-        PoseRenderable *renderable = m_poseRenderables[index];
-        // This also deletes the renderable
-        renderable->setParent((Qt3DCore::QNode *) 0);
+    TRACE_SCOPE("viewer", "PoseViewer3DWidget::setPoses");
+    // Hide the old poses, their renderables get reused for the new ones
+    for (PoseRenderable *renderable : m_poseRenderables) {
+        releasePoseRenderable(renderable);
     }
 
     // Important because for the next clicks this is relevant
@@ -448,14 +454,64 @@ void PoseViewer3DWidget::setPoses(const QList<PosePtr> &poses) {
     for (const PosePtr &pose : poses) {
         addPose(pose);
     }
+    reportMemoryUsage();
 }
 
 void PoseViewer3DWidget::addPose(PosePtr pose) {
     // TODO need to add functionality to select the pose if it is a pose
     // that has been added by creating a new pose
-    PoseRenderable *poseRenderable = new PoseRenderable(m_sceneRoot, pose);
+    PoseRenderable *poseRenderable = acquirePoseRenderable(pose);
     m_poseRenderables.append(poseRenderable);
     m_poseRenderableForId[pose->id()] = poseRenderable;
+    reportMemoryUsage();
+}
+
+void PoseViewer3DWidget::reportMemoryUsage() {
+    // Background image with 4 bytes per pixel
+    qint64 bytes = (qint64) m_imageSize.width() * m_imageSize.height() * 4;
+    // Color and depth texture of the render target, both 4 bytes per sample
+    const QSize scaledSize = m_imageSize * m_renderingScale;
+    bytes += (qint64) scaledSize.width() * scaledSize.height() * 8 * qMax(1, m_samples);
+
+    // Qt3D shares the geometry of meshes with the same source
+    QList<PoseRenderable*> poseRenderables = m_poseRenderables;
+    for (const QList<PoseRenderable*> &unusedPoseRenderables : m_unusedPoseRenderables) {
+        poseRenderables.append(unusedPoseRenderables);
+    }
+    QSet<QString> countedPaths;
+    for (PoseRenderable *poseRenderable : poseRenderables) {
+        const QString path = poseRenderable->objectModel()->absolutePath();
+        if (countedPaths.contains(path)) {
+            continue;
+        }
+        countedPaths.insert(path);
+        auto meshSize = m_meshSizes.constFind(path);
+        if (meshSize == m_meshSizes.constEnd()) {
+            meshSize = m_meshSizes.insert(path, QFileInfo(path).size());
+        }
+        bytes += meshSize.value();
+    }
+    MemoryAccounting::instance()->reportUsage(MemoryAccounting::RENDERING_RESOURCES, bytes);
+}
+
+PoseRenderable *PoseViewer3DWidget::acquirePoseRenderable(PosePtr pose) {
+    QList<PoseRenderable*> &unusedPoseRenderables = m_unusedPoseRenderables[pose->objectModel()->path()];
+    while (!unusedPoseRenderables.isEmpty()) {
+        PoseRenderable *poseRenderable = unusedPoseRenderables.takeLast();
+        // A reload replaces the object models, the file might have changed since the
+        // renderable loaded it
+        if (poseRenderable->objectModel() != pose->objectModel()) {
+            // This also deletes the renderable
+            poseRenderable->setParent((Qt3DCore::QNode *) 0);
+            continue;
+        }
+        poseRenderable->setPose(pose);
+        poseRenderable->setEnabled(true);
+        return poseRenderable;
+    }
+
+    PoseRenderable *poseRenderable = new PoseRenderable(m_sceneRoot, pose);
+    // The connections use the renderable's current pose, they stay valid when it gets reused
     connect(poseRenderable, &PoseRenderable::clicked,
             [poseRenderable, this](Qt3DRender::QPickEvent *e){
         if (e->button() == m_settings->selectPoseRenderableMouseButton()
@@ -501,6 +557,30 @@ void PoseViewer3DWidget::addPose(PosePtr pose) {
             [this](){
         m_poseRenderablePressed = false;
     });
+    return poseRenderable;
+}
+
+void PoseViewer3DWidget::releasePoseRenderable(PoseRenderable *poseRenderable) {
+    if (poseRenderable == m_selectedPoseRenderable) {
+        m_selectedPoseRenderable = Q_NULLPTR;
+    }
+    if (poseRenderable == m_hoveredPose) {
+        m_hoveredPose = Q_NULLPTR;
+        m_mouseOverPoseRenderable = false;
+    }
+    QList<PoseRenderable*> &unusedPoseRenderables =
+            m_unusedPoseRenderables[poseRenderable->objectModel()->path()];
+    if (unusedPoseRenderables.size() >= MAX_UNUSED_POSE_RENDERABLES_PER_OBJECT_MODEL) {
+        // This also deletes the renderable
+        poseRenderable->setParent((Qt3DCore::QNode *) 0);
+        return;
+    }
+    poseRenderable->setSelected(false);
+    poseRenderable->setHovered(false);
+    poseRenderable->setEnabled(false);
+    // Don't keep the pose alive while the renderable is unused
+    poseRenderable->setPose(PosePtr());
+    unusedPoseRenderables.append(poseRenderable);
 }
 
 void PoseViewer3DWidget::removePose(PosePtr pose) {
@@ -510,8 +590,8 @@ void PoseViewer3DWidget::removePose(PosePtr pose) {
             // Remove related framegraph
             m_poseRenderables.removeAt(index);
             m_poseRenderableForId.remove(pose->id());
-            // This also deletes the renderable
-            renderable->setParent((Qt3DCore::QNode *) 0);
+            releasePoseRenderable(renderable);
+            reportMemoryUsage();
             break;
         }
     }
@@ -537,6 +617,7 @@ void PoseViewer3DWidget::setSamples(int samples) {
     m_samples = DisplayHelper::indexToMultisampleSamlpes(samples);
     m_colorTexture->setSamples(m_samples);
     m_depthTexture->setSamples(m_samples);
+    reportMemoryUsage();
     if (m_initialized) {
         makeCurrent();
         m_shaderProgram->bind();
@@ -555,6 +636,7 @@ void PoseViewer3DWidget::setRenderingSize(int w, int h) {
     m_clickVisualizationCamera->lens()->setOrthographicProjection(-w / 2.f, w / 2.f,
                                                                 -h / 2.f, h / 2.f,
                                                                   0.1f, 1000.f);
+    reportMemoryUsage();
 }
 
 QPoint PoseViewer3DWidget::renderingPosition() {
@@ -649,6 +731,27 @@ int PoseViewer3DWidget::zoom() {
     return m_zoom;
 }
 
+void PoseViewer3DWidget::onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree) {
+    Q_UNUSED(bytesToFree)
+    if (subsystem != MemoryAccounting::RENDERING_RESOURCES) {
+        return;
+    }
+    // The displayed poses need their meshes, only the unused renderables can go
+    releaseUnusedPoseRenderables();
+}
+
+void PoseViewer3DWidget::releaseUnusedPoseRenderables() {
+    for (QList<PoseRenderable*> &unusedPoseRenderables : m_unusedPoseRenderables) {
+        for (PoseRenderable *poseRenderable : unusedPoseRenderables) {
+            // This also deletes the renderable
+            poseRenderable->setParent((Qt3DCore::QNode *) 0);
+        }
+    }
+    m_unusedPoseRenderables.clear();
+    m_meshSizes.clear();
+    reportMemoryUsage();
+}
+
 void PoseViewer3DWidget::onSnapshotReady() {
     m_snapshotRenderPassFilter->removeParameter(m_removeHighlightParameter);
     m_snapshotRenderCaptureReply->saveImage(m_snapshotPath);
@@ -666,9 +769,8 @@ void PoseViewer3DWidget::takeSnapshot(const QString &path) {
 
 void PoseViewer3DWidget::setObjectsOpacity(float opacity) {
     this->m_opacity = opacity;
-    for (PoseRenderable *poseRenderable : m_poseRenderables) {
-        poseRenderable->setOpacity(opacity);
-    }
+    // One parameter for all poses, no matter how many there are
+    m_opacityParameter->setValue(opacity);
 }
 
 void PoseViewer3DWidget::setAnimatedObjectsOpacity(float opacity) {
@@ -780,14 +882,15 @@ void PoseViewer3DWidget::wheelEvent(QWheelEvent *event) {
 
 void PoseViewer3DWidget::showEvent(QShowEvent *event) {
     if (!m_initialized) {
-        m_root->addComponent(m_renderSettings);
-        m_root->addComponent(m_inputSettings);
-        m_root->addComponent(m_frameAction);
+        m_sceneRoot->addComponent(m_frameAction);
         connect(m_frameAction, &Qt3DLogic::QFrameAction::triggered,
                 [this](){
             this->update();
         });
-        m_aspectEngine->setRootEntity(Qt3DCore::QEntityPtr(m_root));
+        SharedRenderEngine *engine = SharedRenderEngine::instance();
+        engine->addView(m_renderStateSet, m_sceneRoot);
+        // We are the only view that handles mouse input
+        engine->inputSettings()->setEventSource(this);
 
         m_initialized = true;
     }
@@ -823,6 +926,8 @@ QSize PoseViewer3DWidget::imageSize() const {
     return m_imageSize;
 }
 
+const int PoseViewer3DWidget::MAX_UNUSED_POSE_RENDERABLES_PER_OBJECT_MODEL = 32;
+
 const QMap<Qt::MouseButton, Qt3DRender::QPickEvent::Buttons>
                     PoseViewer3DWidget::MOUSE_BUTTON_MAPPING = {{Qt::LeftButton,   Qt3DRender::QPickEvent::LeftButton},
                                                                 {Qt::RightButton,  Qt3DRender::QPickEvent::RightButton},
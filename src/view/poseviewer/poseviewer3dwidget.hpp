@@ -15,6 +15,7 @@
 #include <QLabel>
 #include <QList>
 #include <QMap>
+#include <QHash>
 #include <QSharedPointer>
 #include <QList>
 #include <QMatrix4x4>
@@ -33,13 +34,7 @@
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLBuffer>
 
-#include <Qt3DCore/QAspectEngine>
-#include <Qt3DLogic/QLogicAspect>
 #include <Qt3DLogic/QFrameAction>
-#include <Qt3DInput/QInputAspect>
-#include <Qt3DInput/QInputSettings>
-#include <Qt3DRender/QRenderAspect>
-#include <Qt3DRender/QRenderSettings>
 #include <Qt3DRender/QRenderSurfaceSelector>
 #include <Qt3DRender/QRenderTargetSelector>
 #include <Qt3DRender/QRenderTarget>
@@ -76,6 +71,11 @@ public:
     ~PoseViewer3DWidget();
 
     void reset();
+    /*!
+     * \brief releaseUnusedPoseRenderables deletes the hidden renderables that are kept for
+     * reuse, e.g. because the object models have been reloaded and their meshes are outdated.
+     */
+    void releaseUnusedPoseRenderables();
 
     void initializeGL() override;
     //void resizeGL(int w, int h) override;
@@ -131,6 +131,7 @@ Q_SIGNALS:
 private Q_SLOTS:
     // Called by Qt3D when the snapshot is ready
     void onSnapshotReady();
+    void onMemoryBudgetExceeded(const QString &subsystem, qint64 bytesToFree);
 
 private:
     void init();
@@ -140,6 +141,21 @@ private:
     void setupZoomAnimation(int zoom);
     void setupRenderingPositionAnimation(int x, int y);
     void setupRenderingPositionAnimation(QPoint reinderingPosition);
+    /*!
+     * \brief acquirePoseRenderable returns a hidden renderable of the pose's object model
+     * bound to the pose, or creates a new one if there is none.
+     */
+    PoseRenderable *acquirePoseRenderable(PosePtr pose);
+    /*!
+     * \brief releasePoseRenderable hides the renderable and keeps it for the next pose of
+     * the same object model.
+     */
+    void releasePoseRenderable(PoseRenderable *poseRenderable);
+    /*!
+     * \brief reportMemoryUsage estimates the size of the background image, the render
+     * target textures and the meshes of the active and unused renderables.
+     */
+    void reportMemoryUsage();
 
 private:
     PosePtr m_selectedPose;
@@ -159,32 +175,16 @@ private:
      *
      * Offscreen rendering framegraph. The widget renders everything using
      * Qt3D into an offscreen texture which is then used to draw the texture
-     * of a quad in the paintGL() function.
+     * of a quad in the paintGL() function. The framegraph is one branch of the
+     * SharedRenderEngine, which renders all our 3D views on one render thread.
      *
      */
 
     int m_samples = 1;
 
-    Qt3DCore::QAspectEngine *m_aspectEngine;
-
-    // Aspects
-    Qt3DRender::QRenderAspect *m_renderAspect;
-    Qt3DInput::QInputAspect *m_inputAspect;
-    Qt3DLogic::QLogicAspect *m_logicAspect;
-
-    // Renderer configuration
-    Qt3DRender::QRenderSettings *m_renderSettings;
-
-    // Input configuration
-    Qt3DInput::QInputSettings *m_inputSettings;
-
     // To get notified when a frame is ready
     Qt3DLogic::QFrameAction *m_frameAction;
 
-    // Scene
-    // Scene root will be added as a child
-    Qt3DCore::QEntity *m_root;
-
     // Offscreen framegraph
     QOffscreenSurface *m_offscreenSurface;
     Qt3DRender::QRenderStateSet *m_renderStateSet;
@@ -230,7 +230,7 @@ private:
      *
      */
 
-    // Root entity
+    // Root entity of our scene, a child of the shared engine's root
     Qt3DCore::QEntity *m_sceneRoot;
 
     // Base framegraph
@@ -260,6 +260,8 @@ private:
     // Must be before the rest which draws the objects
     Qt3DRender::QRenderPassFilter *m_snapshotRenderPassFilter;
     Qt3DRender::QParameter *m_removeHighlightParameter;
+    // Opacity of all poses
+    Qt3DRender::QParameter *m_opacityParameter;
     // The main part of the poses branch
     Qt3DRender::QCamera *m_posesCamera;
     Qt3DRender::QCameraSelector *m_posesCameraSelector;
@@ -282,6 +284,12 @@ private:
 
     QList<PoseRenderable *> m_poseRenderables;
     QMap<QString, PoseRenderable*> m_poseRenderableForId;
+    // Hidden renderables by object model path, switching images rebinds them instead of
+    // creating and destroying entities in the Qt3D backend
+    QHash<QString, QList<PoseRenderable*>> m_unusedPoseRenderables;
+    static const int MAX_UNUSED_POSE_RENDERABLES_PER_OBJECT_MODEL;
+    // File sizes of the object models as estimate of their meshes, by path
+    QHash<QString, qint64> m_meshSizes;
     QMatrix4x4 m_projectionMatrix;
     float m_opacity = 1.0;
     // To animate opacity changes
@@ -1,5 +1,6 @@
 ﻿#include "objectmodelrenderable.hpp"
 #include "view/misc/displayhelper.hpp"
+#include "view/rendering/shaderprogramcache.hpp"
 
 #include <QColor>
 #include <QUrl>
@@ -35,6 +36,31 @@ ObjectModelRenderable::ObjectModelRenderable(Qt3DCore::QEntity *parent, const Ob
 }
 
 void ObjectModelRenderable::initialize() {
+    m_opacityParameter = new Qt3DRender::QParameter(this);
+    m_opacityParameter->setName("opacity");
+    // Fully opaque unless the framegraph overrides it
+    m_opacityParameter->setValue(1.0);
+
+    m_highlightedOrSelectedParameter = new Qt3DRender::QParameter(this);
+    m_highlightedOrSelectedParameter->setName("highlightedOrSelectedColor");
+    m_highlightedOrSelectedParameter->setValue(QVector4D(0.f, 0.f, 0.f, 0.f));
+
+    m_clicksParameter = new Qt3DRender::QParameter(this);
+    m_clicksParameter->setName("clicks[0]");
+    m_clicksParameter->setValue(QVariantList());
+
+    m_clickCountParameter = new Qt3DRender::QParameter(this);
+    m_clickCountParameter->setName("clickCount");
+    m_clickCountParameter->setValue(QVariantList());
+
+    m_colorsParameter = new Qt3DRender::QParameter(this);
+    m_colorsParameter->setName("clickColors[0]");
+    m_colorsParameter->setValue(QVariantList());
+
+    m_clickDiameterParameter = new Qt3DRender::QParameter(this);
+    m_clickDiameterParameter->setName("clickDiameter");
+    m_clickDiameterParameter->setValue(0.5);
+
     m_sceneLoader = new Qt3DRender::QSceneLoader(this);
     this->addComponent(m_sceneLoader);
     connect(m_sceneLoader, &Qt3DRender::QSceneLoader::statusChanged, this, &ObjectModelRenderable::onSceneLoaderStatusChanged);
@@ -58,11 +84,12 @@ bool ObjectModelRenderable::isHovered() const {
 
 void ObjectModelRenderable::setObjectModel(const ObjectModel &objectModel) {
     m_selected = false;
-    m_clicksParameters.clear();
-    m_clickDiameterParameters.clear();
-    m_colorsParameters.clear();
-    m_opacityParameters.clear();
-    m_highlightedOrSelectedParameters.clear();
+    m_hovered = false;
+    // The new model starts without highlight and clicks, like its freshly loaded materials did
+    m_highlightedOrSelectedParameter->setValue(QVector4D(0.0, 0.0, 0.0, 0.0));
+    m_clicksParameter->setValue(QVariantList());
+    m_colorsParameter->setValue(QVariantList());
+    m_clickCountParameter->setValue(QVariantList());
     m_sceneLoader->setEnabled(false);
     m_sceneLoader->setSource(QUrl::fromLocalFile(objectModel.absolutePath()));
 }
@@ -76,14 +103,9 @@ void ObjectModelRenderable::setClicks(QList<QVector3D> clicks) {
         QColor c = DisplayHelper::colorForPosePointIndex(i);
         convertedColors << QVector3D(c.red() / 255.f, c.green() / 255.f, c.blue() / 255.f);
     }
-    for (int i = 0; i < m_clicksParameters.size(); i++) {
-        Qt3DRender::QParameter *clicksParameter = m_clicksParameters[i];
-        Qt3DRender::QParameter *colorsParameter = m_colorsParameters[i];
-        Qt3DRender::QParameter *clickCountParameter = m_clickCountParameters[i];
-        clicksParameter->setValue(convertedClicks);
-        colorsParameter->setValue(convertedColors);
-        clickCountParameter->setValue(clicks.count());
-    }
+    m_clicksParameter->setValue(convertedClicks);
+    m_colorsParameter->setValue(convertedColors);
+    m_clickCountParameter->setValue(clicks.count());
     Q_EMIT clicksChanged();
 }
 
@@ -94,9 +116,7 @@ void ObjectModelRenderable::setSelected(bool selected) {
     } else {
         color = QVector4D(0.0, 0.0, 0.0, 0.0);
     }
-    for (Qt3DRender::QParameter *parameter : m_highlightedOrSelectedParameters) {
-        parameter->setValue(color);
-    }
+    m_highlightedOrSelectedParameter->setValue(color);
     m_selected = selected;
     Q_EMIT selectedChanged(selected);
 }
@@ -111,63 +131,24 @@ void ObjectModelRenderable::setHovered(bool hovered) {
     } else {
         color = m_selectedColor;
     }
-    for (Qt3DRender::QParameter *parameter : m_highlightedOrSelectedParameters) {
-        parameter->setValue(color);
-    }
+    m_highlightedOrSelectedParameter->setValue(color);
     m_hovered = hovered;
 }
 
-void ObjectModelRenderable::setOpacity(float opacity) {
-    for (Qt3DRender::QParameter *parameter : m_opacityParameters) {
-        parameter->setValue(opacity);
-    }
-}
-
 void ObjectModelRenderable::setClickDiameter(float clickDiameter) {
     m_clickDiameter = clickDiameter;
-    for (Qt3DRender::QParameter *parameter : m_clickDiameterParameters) {
-        parameter->setValue((m_minMeshExtent - m_maxMeshExtent).length() * clickDiameter);
-    }
+    m_clickDiameterParameter->setValue((m_minMeshExtent - m_maxMeshExtent).length() * clickDiameter);
 }
 
 void ObjectModelRenderable::traverseNodes(Qt3DCore::QNode *currentNode) {
     for (Qt3DCore::QNode *node : currentNode->childNodes()) {
         if (Qt3DRender::QMaterial* material = dynamic_cast<Qt3DRender::QMaterial *>(node)) {
-            Qt3DRender::QParameter *opacityParameter = new Qt3DRender::QParameter();
-            opacityParameter->setName("opacity");
-            opacityParameter->setValue(1.0);
-            material->addParameter(opacityParameter);
-            m_opacityParameters.append(opacityParameter);
-
-            Qt3DRender::QParameter *highlightedOrSelectedParameter = new Qt3DRender::QParameter();
-            highlightedOrSelectedParameter->setName("highlightedOrSelectedColor");
-            highlightedOrSelectedParameter->setValue(QVector4D(0.f, 0.f, 0.f, 0.f));
-            material->addParameter(highlightedOrSelectedParameter);
-            m_highlightedOrSelectedParameters.append(highlightedOrSelectedParameter);
-
-            Qt3DRender::QParameter *clicksParameter = new Qt3DRender::QParameter();
-            clicksParameter->setName("clicks[0]");
-            clicksParameter->setValue(QVariantList());
-            material->addParameter(clicksParameter);
-            m_clicksParameters.append(clicksParameter);
-
-            Qt3DRender::QParameter *clickCountParameter = new Qt3DRender::QParameter();
-            clickCountParameter->setName("clickCount");
-            clickCountParameter->setValue(QVariantList());
-            material->addParameter(clickCountParameter);
-            m_clickCountParameters.append(clickCountParameter);
-
-            Qt3DRender::QParameter *colorsParameter = new Qt3DRender::QParameter();
-            colorsParameter->setName("clickColors[0]");
-            colorsParameter->setValue(QVariantList());
-            material->addParameter(colorsParameter);
-            m_colorsParameters.append(colorsParameter);
-
-            Qt3DRender::QParameter *clickDiameterParameter = new Qt3DRender::QParameter();
-            clickDiameterParameter->setName("clickDiameter");
-            clickDiameterParameter->setValue(0.5);
-            material->addParameter(clickDiameterParameter);
-            m_clickDiameterParameters.append(clickDiameterParameter);
+            material->addParameter(m_opacityParameter);
+            material->addParameter(m_highlightedOrSelectedParameter);
+            material->addParameter(m_clicksParameter);
+            material->addParameter(m_clickCountParameter);
+            material->addParameter(m_colorsParameter);
+            material->addParameter(m_clickDiameterParameter);
 
             // Check if the material has a shininess property which we can set to 0
             // to remove annoying sparkling effects
@@ -182,8 +163,7 @@ void ObjectModelRenderable::traverseNodes(Qt3DCore::QNode *currentNode) {
         }
         if (Qt3DRender::QShaderProgramBuilder *shaderProgramBuilder =
                 dynamic_cast<Qt3DRender::QShaderProgramBuilder*>(node)) {
-            shaderProgramBuilder->setFragmentShaderGraph(QUrl(QStringLiteral("qrc:/shaders/object.frag.json")));
-            shaderProgramBuilder->setVertexShaderGraph(QUrl(QStringLiteral("qrc:/shaders/object.vert.json")));
+            ShaderProgramCache::setupShaderProgramBuilder(shaderProgramBuilder);
         }
         if (Qt3DRender::QGeometryRenderer *geometryRenderer = dynamic_cast<Qt3DRender::QGeometryRenderer*>(node)) {
             Qt3DRender::QGeometry *geometry = geometryRenderer->geometry();
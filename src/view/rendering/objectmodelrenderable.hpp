@@ -42,7 +42,6 @@ public Q_SLOTS:
     void setClicks(QList<QVector3D> clicks);
     void setSelected(bool selected);
     void setHovered(bool hovered);
-    void setOpacity(float opacity);
     void setClickDiameter(float circumference);
 
 private Q_SLOTS:
@@ -57,12 +56,16 @@ private:
     bool m_hovered = false;
 
     QPointer<Qt3DRender::QSceneLoader> m_sceneLoader;
-    QList<Qt3DRender::QParameter*> m_opacityParameters;
-    QList<Qt3DRender::QParameter*> m_highlightedOrSelectedParameters;
-    QList<Qt3DRender::QParameter*> m_clicksParameters;
-    QList<Qt3DRender::QParameter*> m_colorsParameters;
-    QList<Qt3DRender::QParameter*> m_clickCountParameters;
-    QList<Qt3DRender::QParameter*> m_clickDiameterParameters;
+    // The parameters are shared by all materials of the loaded model, changing the state
+    // of the renderable only updates one parameter no matter how many materials it has.
+    // The opacity isn't part of the renderable's state, the views set it for all objects
+    // at once in their framegraph.
+    Qt3DRender::QParameter *m_opacityParameter;
+    Qt3DRender::QParameter *m_highlightedOrSelectedParameter;
+    Qt3DRender::QParameter *m_clicksParameter;
+    Qt3DRender::QParameter *m_colorsParameter;
+    Qt3DRender::QParameter *m_clickCountParameter;
+    Qt3DRender::QParameter *m_clickDiameterParameter;
     Qt3DRender::QObjectPicker *m_picker;
 
     QList<QVector3D> m_clicks;
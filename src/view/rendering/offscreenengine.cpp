@@ -1,33 +1,21 @@
 #include "offscreenengine.hpp"
+#include "view/rendering/sharedrenderengine.hpp"
+#include "misc/tracing.hpp"
+
 #include <Qt3DExtras/QPhongMaterial>
 #include <Qt3DCore/QTransform>
 
 OffscreenEngine::OffscreenEngine(const QSize &size) {
-    // Set up the engine and the aspects that we want to use.
-    m_aspectEngine = new Qt3DCore::QAspectEngine();
-    m_renderAspect = new Qt3DRender::QRenderAspect(Qt3DRender::QRenderAspect::Threaded); // Only threaded mode seems to work right now.
-    m_logicAspect = new Qt3DLogic::QLogicAspect();
-
-    m_aspectEngine->registerAspect(m_renderAspect);
-    m_aspectEngine->registerAspect(m_logicAspect);
-
-    // Create the root entity of the engine.
-    // This is not the same as the 3D scene root: the QRenderSettings
-    // component must be held by the root of the QEntity tree,
-    // so it is added to this one. The 3D scene is added as a subtree later,
-    // in setSceneRoot().
-    Qt3DCore::QEntityPtr root(new Qt3DCore::QEntity());
-    m_renderSettings = new Qt3DRender::QRenderSettings(root.data());
-    m_renderSettings->setRenderPolicy(Qt3DRender::QRenderSettings::OnDemand);
-    root->addComponent(m_renderSettings);
-
     // Firstly, create the offscreen surface. This will take the place
     // of a QWindow, allowing us to render our scene without one.
     m_offscreenSurface = new QOffscreenSurface();
     m_offscreenSurface->setFormat(QSurfaceFormat::defaultFormat());
     m_offscreenSurface->create();
 
-    m_renderSurfaceSelector = new Qt3DRender::QRenderSurfaceSelector();
+    // Our branch of the framegraph of the shared engine, disabled until an image is requested
+    m_subtreeEnabler = new Qt3DRender::QSubtreeEnabler();
+    m_noPicking = new Qt3DRender::QNoPicking(m_subtreeEnabler);
+    m_renderSurfaceSelector = new Qt3DRender::QRenderSurfaceSelector(m_noPicking);
 
     // Hook it up to the frame graph.
     m_renderSurfaceSelector->setSurface(m_offscreenSurface);
@@ -54,10 +42,7 @@ OffscreenEngine::OffscreenEngine(const QSize &size) {
 
     m_renderCapture = new Qt3DRender::QRenderCapture(m_cameraSelector);
 
-    m_renderSettings->setActiveFrameGraph(m_renderSurfaceSelector);
-    m_aspectEngine->setRootEntity(root);
-
-    m_sceneRoot = new Qt3DCore::QEntity(root.get());
+    m_sceneRoot = new Qt3DCore::QEntity();
     m_objectModelRenderable = new ObjectModelRenderable(m_sceneRoot);
     connect(m_objectModelRenderable, &ObjectModelRenderable::statusChanged, this, &OffscreenEngine::onSceneLoaderStatusChanged);
 
@@ -69,16 +54,17 @@ OffscreenEngine::OffscreenEngine(const QSize &size) {
     m_lightEntity->addComponent(m_light);
     m_lightEntity->addComponent(lightTransform);
     connect(m_camera, &Qt3DRender::QCamera::positionChanged, [this, lightTransform](){lightTransform->setTranslation(this->m_camera->position());});
+
+    setRenderingEnabled(false);
+    SharedRenderEngine::instance()->addView(m_subtreeEnabler, m_sceneRoot);
 }
 
 OffscreenEngine::~OffscreenEngine() {
-    // Not sure if the following is strictly required, as it may
-    // happen automatically when the engine is destroyed.
-    m_objectModelRenderable->setParent((Qt3DCore::QNode *) 0);
-    connect(m_objectModelRenderable, &QObject::destroyed, this, &OffscreenEngine::shutdown);
-    m_objectModelRenderable->deleteLater();
-    m_aspectEngine->unregisterAspect(m_logicAspect);
-    m_aspectEngine->unregisterAspect(m_renderAspect);
+    SharedRenderEngine::instance()->removeView(m_subtreeEnabler);
+    // Deletes the object model and the light as well
+    delete m_sceneRoot;
+    delete m_subtreeEnabler;
+    delete m_offscreenSurface;
 }
 
 void OffscreenEngine::setObjectModel(const ObjectModel &objectModel) {
@@ -98,8 +84,10 @@ void OffscreenEngine::onRenderCaptureReady() {
         requestImage();
     } else {
         m_initialized = false;
+        TRACE_SCOPE("render", "OffscreenEngine::onRenderCaptureReady");
         QImage image = m_reply->image();
         delete m_reply;
+        setRenderingEnabled(false);
         image.convertTo(QImage::Format_ARGB32);
         // Not very performant
         // TODO check if we can render the image directly using alpha
@@ -114,14 +102,9 @@ void OffscreenEngine::onRenderCaptureReady() {
     }
 }
 
-void OffscreenEngine::shutdown() {
-    // Setting a null root entity shuts down the engine.
-    m_aspectEngine->setRootEntity(Qt3DCore::QEntityPtr());
-
-    delete m_aspectEngine;
-
-    delete m_logicAspect;
-    delete m_renderAspect;
+void OffscreenEngine::setRenderingEnabled(bool enabled) {
+    m_subtreeEnabler->setEnabled(enabled);
+    m_sceneRoot->setEnabled(enabled);
 }
 
 void OffscreenEngine::setSize(const QSize &size) {
@@ -139,6 +122,7 @@ void OffscreenEngine::setBackgroundColor(QColor color) {
 }
 
 void OffscreenEngine::requestImage() {
+    setRenderingEnabled(true);
     m_reply = m_renderCapture->requestCapture();
     connect(m_reply, &Qt3DRender::QRenderCaptureReply::completed, this, &OffscreenEngine::onRenderCaptureReady);
 }
@@ -12,14 +12,12 @@
 #include <Qt3DRender/QPointLight>
 #include <Qt3DCore/QNode>
 #include <Qt3DRender/QCamera>
-#include <Qt3DRender/QRenderSettings>
 #include <Qt3DRender/QRenderCapture>
 #include <Qt3DRender/QRenderCaptureReply>
-#include <Qt3DCore/QAspectEngine>
-#include <Qt3DRender/QRenderAspect>
-#include <Qt3DLogic/QLogicAspect>
 
 #include <QOffscreenSurface>
+#include <Qt3DRender/QSubtreeEnabler>
+#include <Qt3DRender/QNoPicking>
 #include <Qt3DRender/QRenderSurfaceSelector>
 #include <Qt3DRender/QRenderTargetSelector>
 #include <Qt3DRender/QViewport>
@@ -32,6 +30,7 @@
 // The OffscreenEngine brings together various Qt3D classes that are required in order to
 // perform basic scene rendering. Of these, the most important for this project is the OffscreenSurfaceFrameGraph.
 // Render captures can be requested, and the capture contents used within other widgets (see OffscreenEngineDelegate).
+// The scene is rendered by the SharedRenderEngine as one of its views and only while an image is requested.
 class OffscreenEngine : public QObject {
 
     Q_OBJECT
@@ -57,19 +56,19 @@ Q_SIGNALS:
 private Q_SLOTS:
     void onSceneLoaderStatusChanged(Qt3DRender::QSceneLoader::Status status);
     void onRenderCaptureReady();
-    void shutdown();
 
 private:
-    // We need all of the following in order to render a scene:
-    Qt3DCore::QAspectEngine *m_aspectEngine;              // The aspect engine, which holds the scene and related aspects.
-    Qt3DRender::QRenderAspect *m_renderAspect;            // The render aspect, which deals with rendering the scene.
-    Qt3DLogic::QLogicAspect *m_logicAspect;               // The logic aspect, which runs jobs to do with synchronising frames.
-    Qt3DRender::QRenderSettings *m_renderSettings;        // The render settings, which control the general rendering behaviour.
-    Qt3DRender::QRenderCapture *m_renderCapture;          // The render capture node, which is appended to the frame graph.
-    Qt3DCore::QEntity *m_sceneRoot;                         // The scene root, which becomes a child of the engine's root entity.
+    //! Only renders our branch and shows our scene (e.g. its light) while capturing
+    void setRenderingEnabled(bool enabled);
 
-    Qt3DCore::QEntityPtr m_root;
+private:
+    Qt3DRender::QRenderCapture *m_renderCapture;          // The render capture node, which is appended to the frame graph.
+    Qt3DCore::QEntity *m_sceneRoot;                       // The scene root, which becomes a child of the shared engine's root entity.
 
+    // Root of our branch of the shared framegraph
+    Qt3DRender::QSubtreeEnabler *m_subtreeEnabler;
+    // The gallery doesn't receive mouse events
+    Qt3DRender::QNoPicking *m_noPicking;
     OffscreenTextureRenderTarget *m_textureTarget;
     QOffscreenSurface *m_offscreenSurface;
     Qt3DRender::QRenderSurfaceSelector *m_renderSurfaceSelector;
@@ -3,11 +3,9 @@
 PoseRenderable::PoseRenderable(Qt3DCore::QEntity *parent,
                                PosePtr pose) :
         ObjectModelRenderable(parent, *pose->objectModel()),
-        m_pose(pose),
+        m_objectModel(pose->objectModel()),
         m_picker(new Qt3DRender::QObjectPicker),
         m_transform(new Qt3DCore::QTransform) {
-    m_transform->setRotation(pose->rotation());
-    m_transform->setTranslation(pose->position());
     addComponent(m_transform);
     addComponent(m_picker);
     m_picker->setHoverEnabled(true);
@@ -24,18 +22,15 @@ PoseRenderable::PoseRenderable(Qt3DCore::QEntity *parent,
             this, &PoseRenderable::entered);
     connect(m_picker, &Qt3DRender::QObjectPicker::exited,
             this, &PoseRenderable::exited);
-    connect(pose.get(), &Pose::positionChanged,
-            m_transform, &Qt3DCore::QTransform::setTranslation);
-    connect(pose.get(), &Pose::rotationChanged,
-            m_transform, &Qt3DCore::QTransform::setRotation);
+    setPose(pose);
 }
 
 ObjectModelPtr PoseRenderable::objectModel() {
-    return m_pose->objectModel();
+    return m_objectModel;
 }
 
 QString PoseRenderable::poseID() {
-    return m_pose->id();
+    return m_pose.isNull() ? QString() : m_pose->id();
 }
 
 bool PoseRenderable::operator==(const PoseRenderable &other) {
@@ -46,6 +41,22 @@ PosePtr PoseRenderable::pose() const {
     return m_pose;
 }
 
+void PoseRenderable::setPose(PosePtr pose) {
+    Q_ASSERT(pose.isNull() || pose->objectModel()->path() == m_objectModel->path());
+    disconnect(m_positionChangedConnection);
+    disconnect(m_rotationChangedConnection);
+    m_pose = pose;
+    if (pose.isNull()) {
+        return;
+    }
+    m_transform->setRotation(pose->rotation());
+    m_transform->setTranslation(pose->position());
+    m_positionChangedConnection = connect(pose.get(), &Pose::positionChanged,
+                                          m_transform, &Qt3DCore::QTransform::setTranslation);
+    m_rotationChangedConnection = connect(pose.get(), &Pose::rotationChanged,
+                                          m_transform, &Qt3DCore::QTransform::setRotation);
+}
+
 Qt3DCore::QTransform *PoseRenderable::transform() const {
     return m_transform;
 }
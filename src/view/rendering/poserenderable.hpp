@@ -19,6 +19,8 @@
 //! \brief The PoseRenderable class is only an object model renderable
 //! essentially (i.e. displays an object model) but takes in a pose
 //! to compute the position of the object according to the pose.
+//! The renderable can be bound to another pose of the same object model
+//! which is a lot cheaper than creating a new one.
 //!
 class PoseRenderable : public ObjectModelRenderable
 {
@@ -35,6 +37,12 @@ public:
     bool operator==(const PoseRenderable &other);
 
     PosePtr pose() const;
+    /*!
+     * \brief setPose binds the renderable to the given pose which must have the
+     * object model the renderable was created with. Passing a null pose unbinds
+     * it, e.g. while it is kept for later use.
+     */
+    void setPose(PosePtr pose);
 
 Q_SIGNALS:
     void clicked(Qt3DRender::QPickEvent *pickEvent);
@@ -46,6 +54,9 @@ Q_SIGNALS:
 
 private:
     PosePtr m_pose;
+    ObjectModelPtr m_objectModel;
+    QMetaObject::Connection m_positionChangedConnection;
+    QMetaObject::Connection m_rotationChangedConnection;
 
     Qt3DRender::QObjectPicker *m_picker;
     Qt3DCore::QTransform *m_transform;
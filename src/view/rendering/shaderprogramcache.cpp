@@ -0,0 +1,162 @@
+#include "shaderprogramcache.hpp"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QSurfaceFormat>
+#include <QUrl>
+
+#include <Qt3DRender/QShaderProgram>
+
+namespace {
+
+const QString VERTEX_SHADER_GRAPH = QStringLiteral("qrc:/shaders/object.vert.json");
+const QString FRAGMENT_SHADER_GRAPH = QStringLiteral("qrc:/shaders/object.frag.json");
+
+QMutex cacheMutex;
+// Vertex and fragment shader code by variant key
+QHash<QString, QPair<QByteArray, QByteArray>> cachedCode;
+QByteArray shaderSourcesHash;
+
+QByteArray hashShaderSources() {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    // The graphs and everything they include
+    for (const QString &file : {QStringLiteral(":/shaders/object.vert.json"),
+                                QStringLiteral(":/shaders/object.frag.json"),
+                                QStringLiteral(":/shaders/phong.inc.frag"),
+                                QStringLiteral(":/shaders/visualizeclicks.inc.frag")}) {
+        QFile source(file);
+        if (source.open(QFile::ReadOnly)) {
+            hash.addData(source.readAll());
+        }
+    }
+    return hash.result().toHex();
+}
+
+QByteArray readFile(const QString &path) {
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+bool writeFile(const QString &path, const QByteArray &data) {
+    // A crash never leaves half written code behind
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+    file.write(data);
+    return file.commit();
+}
+
+}
+
+void ShaderProgramCache::setupShaderProgramBuilder(Qt3DRender::QShaderProgramBuilder *builder) {
+    const QString key = variantKey(builder->enabledLayers());
+    Qt3DRender::QShaderProgram *shaderProgram = builder->shaderProgram();
+    QByteArray vertexShaderCode;
+    QByteArray fragmentShaderCode;
+    if (shaderProgram != Q_NULLPTR && lookup(key, &vertexShaderCode, &fragmentShaderCode)) {
+        // Detach the builder, otherwise it would generate the code again and overwrite ours
+        builder->setShaderProgram(Q_NULLPTR);
+        shaderProgram->setVertexShaderCode(vertexShaderCode);
+        shaderProgram->setFragmentShaderCode(fragmentShaderCode);
+        return;
+    }
+
+    builder->setFragmentShaderGraph(QUrl(FRAGMENT_SHADER_GRAPH));
+    builder->setVertexShaderGraph(QUrl(VERTEX_SHADER_GRAPH));
+    // The code is generated asynchronously in the backend and the two signals don't
+    // arrive in a defined order
+    auto storeWhenComplete = [builder, key]() {
+        if (!builder->vertexShaderCode().isEmpty() && !builder->fragmentShaderCode().isEmpty()) {
+            store(key, builder->vertexShaderCode(), builder->fragmentShaderCode());
+        }
+    };
+    QObject::connect(builder, &Qt3DRender::QShaderProgramBuilder::vertexShaderCodeChanged,
+                     builder, storeWhenComplete);
+    QObject::connect(builder, &Qt3DRender::QShaderProgramBuilder::fragmentShaderCodeChanged,
+                     builder, storeWhenComplete);
+}
+
+QString ShaderProgramCache::variantKey(const QStringList &enabledLayers) {
+    {
+        QMutexLocker locker(&cacheMutex);
+        if (shaderSourcesHash.isEmpty()) {
+            shaderSourcesHash = hashShaderSources();
+        }
+    }
+    QStringList layers = enabledLayers;
+    layers.sort();
+    // The generated code depends on the graphics API the renderer uses
+    const QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    return QStringList({QStringLiteral(QT_VERSION_STR),
+                        QString::number(format.renderableType()),
+                        QString::number(format.profile()),
+                        QString::number(format.majorVersion()),
+                        QString::number(format.minorVersion()),
+                        QString::fromLatin1(shaderSourcesHash),
+                        layers.join(',')}).join('|');
+}
+
+QString ShaderProgramCache::cacheDirectory() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("shaders");
+}
+
+bool ShaderProgramCache::lookup(const QString &key,
+                                QByteArray *vertexShaderCode,
+                                QByteArray *fragmentShaderCode) {
+    QMutexLocker locker(&cacheMutex);
+    auto it = cachedCode.constFind(key);
+    if (it != cachedCode.constEnd()) {
+        *vertexShaderCode = it->first;
+        *fragmentShaderCode = it->second;
+        return true;
+    }
+
+    const QString hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    const QDir directory(cacheDirectory());
+    // The key is stored as well to rule out collisions of the hashes
+    const QByteArray storedKey = readFile(directory.filePath(hash + ".key"));
+    if (storedKey != key.toUtf8()) {
+        return false;
+    }
+    const QByteArray vertexCode = readFile(directory.filePath(hash + ".vert"));
+    const QByteArray fragmentCode = readFile(directory.filePath(hash + ".frag"));
+    if (vertexCode.isEmpty() || fragmentCode.isEmpty()) {
+        return false;
+    }
+    cachedCode.insert(key, qMakePair(vertexCode, fragmentCode));
+    *vertexShaderCode = vertexCode;
+    *fragmentShaderCode = fragmentCode;
+    return true;
+}
+
+void ShaderProgramCache::store(const QString &key,
+                               const QByteArray &vertexShaderCode,
+                               const QByteArray &fragmentShaderCode) {
+    QMutexLocker locker(&cacheMutex);
+    if (cachedCode.contains(key)) {
+        return;
+    }
+    cachedCode.insert(key, qMakePair(vertexShaderCode, fragmentShaderCode));
+
+    const QString hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    QDir directory(cacheDirectory());
+    directory.mkpath(".");
+    // The key goes last, a variant only counts as cached once all files are there
+    if (!writeFile(directory.filePath(hash + ".vert"), vertexShaderCode)
+            || !writeFile(directory.filePath(hash + ".frag"), fragmentShaderCode)
+            || !writeFile(directory.filePath(hash + ".key"), key.toUtf8())) {
+        qDebug() << "Could not write shader cache to " + directory.absolutePath();
+    }
+}
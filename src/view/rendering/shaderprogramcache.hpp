@@ -0,0 +1,42 @@
+#ifndef SHADERPROGRAMCACHE_H
+#define SHADERPROGRAMCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <Qt3DRender/QShaderProgramBuilder>
+
+/*!
+ * \brief The ShaderProgramCache class stores the GLSL code that Qt3D generates from our
+ * object shader graphs, once for every combination of enabled layers (e.g. untextured
+ * Phong or diffuse map). The code is kept in memory and in the cache folder, so that
+ * materials only have to be generated the first time a variant is ever used.
+ *
+ * Since all materials of a variant end up with exactly the same code, Qt3D compiles every
+ * variant only once and Qt's shader disk cache can reuse the program binary of the last
+ * run instead of compiling it again.
+ */
+class ShaderProgramCache {
+
+public:
+    /*!
+     * \brief setupShaderProgramBuilder sets our object shader graphs on the builder of a
+     * loaded material. If the code of the builder's variant is cached already it is set on
+     * the shader program directly and the builder doesn't generate anything.
+     */
+    static void setupShaderProgramBuilder(Qt3DRender::QShaderProgramBuilder *builder);
+
+private:
+    /*!
+     * \brief variantKey identifies the code generated for the given layers. It includes
+     * the Qt version and a hash of our shader graphs, so that changing either of them
+     * doesn't lead to outdated code.
+     */
+    static QString variantKey(const QStringList &enabledLayers);
+    static QString cacheDirectory();
+    static bool lookup(const QString &key, QByteArray *vertexShaderCode, QByteArray *fragmentShaderCode);
+    static void store(const QString &key, const QByteArray &vertexShaderCode, const QByteArray &fragmentShaderCode);
+};
+
+#endif // SHADERPROGRAMCACHE_H
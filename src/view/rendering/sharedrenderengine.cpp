@@ -0,0 +1,111 @@
+#include "sharedrenderengine.hpp"
+
+#include <QCoreApplication>
+
+#include <Qt3DRender/QPickingSettings>
+
+SharedRenderEngine *SharedRenderEngine::instance() {
+    // Only used from the GUI thread
+    static SharedRenderEngine *engine = new SharedRenderEngine(qApp);
+    return engine;
+}
+
+SharedRenderEngine::SharedRenderEngine(QObject *parent)
+    : QObject(parent)
+    , m_aspectEngine(new Qt3DCore::QAspectEngine)
+    , m_renderAspect(new Qt3DRender::QRenderAspect(Qt3DRender::QRenderAspect::Threaded))
+    , m_inputAspect(new Qt3DInput::QInputAspect)
+    , m_logicAspect(new Qt3DLogic::QLogicAspect)
+    , m_renderSettings(new Qt3DRender::QRenderSettings)
+    , m_inputSettings(new Qt3DInput::QInputSettings)
+    , m_root(new Qt3DCore::QEntity)
+    , m_frameGraphRoot(new Qt3DRender::QFrameGraphNode) {
+    m_aspectEngine->registerAspect(m_renderAspect);
+    m_aspectEngine->registerAspect(m_inputAspect);
+    m_aspectEngine->registerAspect(m_logicAspect);
+
+    // Every child of the framegraph root is a branch of one view and gets rendered
+    // into the surface that the branch selects
+    m_renderSettings->setActiveFrameGraph(m_frameGraphRoot);
+    // Global for all views, the pose viewer needs to know the exact triangle that was clicked
+    m_renderSettings->pickingSettings()->setPickMethod(Qt3DRender::QPickingSettings::TrianglePicking);
+    m_root->addComponent(m_renderSettings);
+    m_root->addComponent(m_inputSettings);
+    m_aspectEngine->setRootEntity(Qt3DCore::QEntityPtr(m_root));
+
+    // The render thread has to be stopped while the application is still fully functional
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &SharedRenderEngine::shutdown);
+}
+
+SharedRenderEngine::~SharedRenderEngine() {
+    shutdown();
+}
+
+void SharedRenderEngine::addView(Qt3DRender::QFrameGraphNode *frameGraph,
+                                 Qt3DCore::QEntity *sceneRoot) {
+    if (m_aspectEngine == Q_NULLPTR || m_views.contains(frameGraph)) {
+        return;
+    }
+    View view;
+    view.sceneRoot = sceneRoot;
+    // The layer is recursive, i.e. it marks every entity below the scene root
+    view.layer = new Qt3DRender::QLayer(sceneRoot);
+    view.layer->setRecursive(true);
+    sceneRoot->addComponent(view.layer);
+    view.layerFilter = new Qt3DRender::QLayerFilter(m_frameGraphRoot);
+    view.layerFilter->addLayer(view.layer);
+    frameGraph->setParent(view.layerFilter);
+    sceneRoot->setParent(m_root);
+    m_views.insert(frameGraph, view);
+}
+
+void SharedRenderEngine::removeView(Qt3DRender::QFrameGraphNode *frameGraph) {
+    auto it = m_views.find(frameGraph);
+    if (it == m_views.end()) {
+        return;
+    }
+    detachView(frameGraph, *it);
+    m_views.erase(it);
+}
+
+void SharedRenderEngine::detachView(Qt3DRender::QFrameGraphNode *frameGraph, const View &view) {
+    frameGraph->setParent((Qt3DCore::QNode *) Q_NULLPTR);
+    view.sceneRoot->setParent((Qt3DCore::QNode *) Q_NULLPTR);
+    view.sceneRoot->removeComponent(view.layer);
+    delete view.layer;
+    delete view.layerFilter;
+}
+
+Qt3DRender::QRenderSettings *SharedRenderEngine::renderSettings() const {
+    return m_renderSettings;
+}
+
+Qt3DInput::QInputSettings *SharedRenderEngine::inputSettings() const {
+    return m_inputSettings;
+}
+
+void SharedRenderEngine::shutdown() {
+    if (m_aspectEngine == Q_NULLPTR) {
+        return;
+    }
+    // The views still own their nodes and delete them themselves
+    for (auto it = m_views.constBegin(); it != m_views.constEnd(); it++) {
+        detachView(it.key(), it.value());
+    }
+    m_views.clear();
+
+    // Setting a null root entity shuts down the engine and deletes the root
+    m_aspectEngine->setRootEntity(Qt3DCore::QEntityPtr());
+    m_aspectEngine->unregisterAspect(m_logicAspect);
+    m_aspectEngine->unregisterAspect(m_inputAspect);
+    m_aspectEngine->unregisterAspect(m_renderAspect);
+    delete m_aspectEngine;
+    m_aspectEngine = Q_NULLPTR;
+
+    delete m_logicAspect;
+    delete m_inputAspect;
+    delete m_renderAspect;
+    m_root = Q_NULLPTR;
+    m_renderSettings = Q_NULLPTR;
+    m_inputSettings = Q_NULLPTR;
+}
@@ -0,0 +1,83 @@
+#ifndef SHAREDRENDERENGINE_H
+#define SHAREDRENDERENGINE_H
+
+#include <QObject>
+#include <QHash>
+
+#include <Qt3DCore/QAspectEngine>
+#include <Qt3DCore/QEntity>
+#include <Qt3DRender/QRenderAspect>
+#include <Qt3DRender/QRenderSettings>
+#include <Qt3DRender/QFrameGraphNode>
+#include <Qt3DRender/QLayer>
+#include <Qt3DRender/QLayerFilter>
+#include <Qt3DInput/QInputAspect>
+#include <Qt3DInput/QInputSettings>
+#include <Qt3DLogic/QLogicAspect>
+
+/*!
+ * \brief The SharedRenderEngine class owns the one Qt3D aspect engine that the pose viewer
+ * and the offscreen renderer of the object model gallery render with. Instead of a render
+ * thread and an OpenGL context per view there is only one of each, and meshes, textures
+ * and shader programs are only uploaded once.
+ *
+ * Every view adds its own framegraph branch, which selects the view's surface, and its own
+ * scene root. The branch only draws the entities below the view's scene root.
+ *
+ * Qt3D has one set of render and input settings per engine, i.e. the picking method and
+ * the input event source are global. The engine uses triangle picking for all views (views
+ * without object pickers don't pay for it) and only one view can receive input.
+ *
+ * The pose editor is not rendered with this engine. It needs picking and mouse input at
+ * the same time as the pose viewer, so it keeps its own engine as a Qt3DWindow.
+ */
+class SharedRenderEngine : public QObject {
+
+    Q_OBJECT
+
+public:
+    static SharedRenderEngine *instance();
+
+    /*!
+     * \brief addView attaches the framegraph branch and the scene of a view to the engine.
+     * The view keeps the ownership of both and has to call removeView before deleting them.
+     */
+    void addView(Qt3DRender::QFrameGraphNode *frameGraph, Qt3DCore::QEntity *sceneRoot);
+    //! Detaches the view with the given framegraph branch from the engine
+    void removeView(Qt3DRender::QFrameGraphNode *frameGraph);
+
+    //! The render settings are shared by all views, changing them affects every view
+    Qt3DRender::QRenderSettings *renderSettings() const;
+    //! Only one view can receive input events at a time
+    Qt3DInput::QInputSettings *inputSettings() const;
+
+private Q_SLOTS:
+    void shutdown();
+
+private:
+    SharedRenderEngine(QObject *parent);
+    ~SharedRenderEngine();
+
+    struct View {
+        Qt3DCore::QEntity *sceneRoot;
+        Qt3DRender::QLayer *layer;
+        Qt3DRender::QLayerFilter *layerFilter;
+    };
+
+    void detachView(Qt3DRender::QFrameGraphNode *frameGraph, const View &view);
+
+private:
+    Qt3DCore::QAspectEngine *m_aspectEngine;
+    Qt3DRender::QRenderAspect *m_renderAspect;
+    Qt3DInput::QInputAspect *m_inputAspect;
+    Qt3DLogic::QLogicAspect *m_logicAspect;
+    Qt3DRender::QRenderSettings *m_renderSettings;
+    Qt3DInput::QInputSettings *m_inputSettings;
+    Qt3DCore::QEntity *m_root;
+    // The branches of the views are added as children
+    Qt3DRender::QFrameGraphNode *m_frameGraphRoot;
+
+    QHash<Qt3DRender::QFrameGraphNode*, View> m_views;
+};
+
+#endif // SHAREDRENDERENGINE_H
@@ -26,6 +26,8 @@ void SettingsLoadSavePage::setSettings(Settings *settings) {
                                        == Settings::UsedLoadAndStoreStrategy::Default);
     ui->radioButtonPythonScript->setChecked(settings->usedLoadAndStoreStrategy()
                                        == Settings::UsedLoadAndStoreStrategy::Python);
+    ui->radioButtonPythonProcesses->setChecked(settings->usedLoadAndStoreStrategy()
+                                       == Settings::UsedLoadAndStoreStrategy::PythonProcesses);
     QString scriptPath = (settings->loadSaveScriptPath() != Global::NO_PATH ?
                           settings->loadSaveScriptPath() : PLEASE_SELECT_A_PYTHON_SCRIPT);
     ui->editPythonScriptPath->setText(scriptPath);
@@ -39,6 +41,10 @@ void SettingsLoadSavePage::radioButtonPythonScriptClicked() {
     m_settings->setUsedLoadAndStoreStrategy(Settings::UsedLoadAndStoreStrategy::Python);
 }
 
+void SettingsLoadSavePage::radioButtonPythonProcessesClicked() {
+    m_settings->setUsedLoadAndStoreStrategy(Settings::UsedLoadAndStoreStrategy::PythonProcesses);
+}
+
 void SettingsLoadSavePage::buttonPythonScriptClicked() {
     QString newPath;
     if (m_settings->loadSaveScriptPath() != Global::NO_PATH) {
@@ -49,7 +55,9 @@ void SettingsLoadSavePage::buttonPythonScriptClicked() {
     if (newPath.compare("") != 0) {
         ui->editPythonScriptPath->setText(newPath);
         m_settings->setLoadSaveScriptPath(newPath);
-        ui->radioButtonPythonScript->setChecked(true);
+        if (!ui->radioButtonPythonProcesses->isChecked()) {
+            ui->radioButtonPythonScript->setChecked(true);
+        }
     }
 }
 
@@ -72,7 +80,11 @@ void SettingsLoadSavePage::buttonPythonScriptHelpClicked() {
                       "load_poses and persist_pose function with certain parameters ("
                       "checkout the GitHub page to see what parameters excatly and what"
                       "return types are expected from the script). This way, dynamic"
-                      "data loading is possible wihtout the need for conversion beforehand.";
+                      "data loading is possible wihtout the need for conversion beforehand. "
+                      "With the separate processes option the script runs in worker "
+                      "processes instead of inside the program, slow or crashing scripts "
+                      "then don't block or take down the program and scripts that define "
+                      "list_image_shards and load_images_shard load images in parallel.";
     std::unique_ptr<QMessageBox> messageBox = DisplayHelper::messageBox(
                 this, QMessageBox::Information, title, message, "OK", QMessageBox::AcceptRole);
     messageBox->exec();
@@ -21,6 +21,7 @@ public:
 private Q_SLOTS:
     void radioButtonDefaultClicked();
     void radioButtonPythonScriptClicked();
+    void radioButtonPythonProcessesClicked();
     void buttonPythonScriptClicked();
     void buttonDefaultJsonHelpClicked();
     void buttonPythonScriptHelpClicked();
@@ -15,6 +15,7 @@ HEADERS += \
     $$PWD/misc/displayhelper.hpp \
     $$PWD/mainwindow.hpp \
     $$PWD/breadcrumb/breadcrumbview.hpp \
+    $$PWD/diagnostics/memorydiagnosticsdialog.hpp \
     $$PWD/gallery/gallery.hpp \
     $$PWD/gallery/galleryimagemodel.hpp \
     $$PWD/gallery/galleryobjectmodelmodel.hpp \
@@ -28,9 +29,13 @@ HEADERS += \
     $$PWD/poseeditor/poseeditor.hpp \
     $$PWD/poseeditor/poseeditor3dwidget.hpp \
     $$PWD/gallery/resizeimagesrunnable.hpp \
+    $$PWD/gallery/segmentationcolorindex.hpp \
+    $$PWD/gallery/thumbnailcache.hpp \
     $$PWD/rendering/offscreenengine.hpp \
     $$PWD/rendering/poserenderable.hpp \
     $$PWD/rendering/objectmodelrenderable.hpp \
+    $$PWD/rendering/shaderprogramcache.hpp \
+    $$PWD/rendering/sharedrenderengine.hpp \
     $$PWD/rendering/texturerendertarget.hpp \
     $$PWD/rendering/clickvisualizationmaterial.hpp \
     $$PWD/rendering/clickvisualizationrenderable.hpp \
@@ -48,6 +53,7 @@ SOURCES += \
     $$PWD/settings/settingspathspage.cpp \
     $$PWD/mainwindow.cpp \
     $$PWD/breadcrumb/breadcrumbview.cpp \
+    $$PWD/diagnostics/memorydiagnosticsdialog.cpp \
     $$PWD/settings/settingsdialog.cpp \
     $$PWD/settings/settingssegmentationcodespage.cpp \
     $$PWD/settings/settingsinterfacepage.cpp \
@@ -63,11 +69,15 @@ SOURCES += \
     $$PWD/gallery/galleryobjectmodelmodel.cpp \
     $$PWD/gallery/iconexpandinglistview.cpp \
     $$PWD/gallery/resizeimagesrunnable.cpp \
+    $$PWD/gallery/segmentationcolorindex.cpp \
+    $$PWD/gallery/thumbnailcache.cpp \
     $$PWD/rendering/offscreenengine.cpp \
     $$PWD/rendering/texturerendertarget.cpp \
     $$PWD/rendering/backgroundimagerenderable.cpp \
     $$PWD/rendering/poserenderable.cpp \
     $$PWD/rendering/objectmodelrenderable.cpp \
+    $$PWD/rendering/shaderprogramcache.cpp \
+    $$PWD/rendering/sharedrenderengine.cpp \
     $$PWD/rendering/clickvisualizationmaterial.cpp \
     $$PWD/rendering/clickvisualizationrenderable.cpp \
     $$PWD/tutorialscreen/tutorialscreen.cpp
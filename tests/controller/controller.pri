@@ -1,7 +1,9 @@
 INCLUDEPATH += $$PWD
 
 HEADERS  += \
+    $$PWD/poseedithistorytest.hpp \
     $$PWD/poseeditingcontrollertest.hpp
 
 SOURCES += \
+    $$PWD/poseedithistorytest.cpp \
     $$PWD/poseeditingcontrollertest.cpp
@@ -0,0 +1,285 @@
+#include "poseedithistorytest.hpp"
+
+PosePtr PoseEditHistoryTest::createPose(const QString &id) {
+    return PosePtr(new Pose(id, QVector3D(), QQuaternion(), ImagePtr(), ObjectModelPtr()));
+}
+
+void PoseEditHistoryTest::recordMove(PoseEditHistory &history, const PosePtr &pose, float x) {
+    history.recordModified(pose, QVector3D(x, 0, 0), QQuaternion(),
+                           QVector3D(x + 1, 0, 0), QQuaternion());
+}
+
+int PoseEditHistoryTest::budgetForModifications(int count) {
+    return count * int(sizeof(PoseEdit));
+}
+
+int PoseEditHistoryTest::costOfAddedOrRemoved() {
+    return int(sizeof(PoseEdit)) + int(sizeof(Pose));
+}
+
+void PoseEditHistoryTest::undoRedoModification() {
+    PoseEditHistory history;
+    QVERIFY(!history.canUndo());
+    QVERIFY(!history.canRedo());
+    QVERIFY(history.undo().isEmpty());
+    const PosePtr pose = createPose("a");
+    const QQuaternion rotation = QQuaternion::fromAxisAndAngle(0, 1, 0, 45);
+    history.recordModified(pose, QVector3D(1, 2, 3), QQuaternion(), QVector3D(4, 5, 6), rotation);
+    QVERIFY(history.canUndo());
+    QVERIFY(!history.canRedo());
+    QCOMPARE(history.memoryUsage(), budgetForModifications(1));
+
+    QVector<PoseEdit> edits = history.undo();
+    QCOMPARE(edits.size(), 1);
+    QCOMPARE(edits[0].type, PoseEdit::Modified);
+    QCOMPARE(edits[0].pose, pose);
+    QCOMPARE(edits[0].positionBefore, QVector3D(1, 2, 3));
+    QCOMPARE(edits[0].positionAfter, QVector3D(4, 5, 6));
+    QCOMPARE(edits[0].rotationBefore, QQuaternion());
+    QCOMPARE(edits[0].rotationAfter, rotation);
+    QVERIFY(!history.canUndo());
+    QVERIFY(history.canRedo());
+
+    edits = history.redo();
+    QCOMPARE(edits.size(), 1);
+    QCOMPARE(edits[0].positionAfter, QVector3D(4, 5, 6));
+    QVERIFY(history.canUndo());
+    QVERIFY(!history.canRedo());
+}
+
+void PoseEditHistoryTest::unchangedModificationIsIgnored() {
+    PoseEditHistory history;
+    history.recordModified(createPose("a"), QVector3D(1, 0, 0), QQuaternion(),
+                           QVector3D(1, 0, 0), QQuaternion());
+    QVERIFY(!history.canUndo());
+    QCOMPARE(history.memoryUsage(), 0);
+}
+
+void PoseEditHistoryTest::recordingDropsRedoSteps() {
+    PoseEditHistory history(budgetForModifications(10), 0);
+    const PosePtr pose = createPose("a");
+    recordMove(history, pose, 0);
+    recordMove(history, pose, 1);
+    history.undo();
+    QVERIFY(history.canRedo());
+    recordMove(history, pose, 5);
+    QVERIFY(!history.canRedo());
+    QCOMPARE(history.memoryUsage(), budgetForModifications(2));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(5, 0, 0));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(0, 0, 0));
+    QVERIFY(!history.canUndo());
+}
+
+void PoseEditHistoryTest::coalesceWithinInterval() {
+    // Long enough to never run out during the test
+    PoseEditHistory history(budgetForModifications(10), 60000);
+    const PosePtr pose = createPose("a");
+    for (int i = 0; i < 5; i++) {
+        recordMove(history, pose, i);
+    }
+    QCOMPARE(history.memoryUsage(), budgetForModifications(1));
+    const QVector<PoseEdit> edits = history.undo();
+    QCOMPARE(edits.size(), 1);
+    // The whole drag
+    QCOMPARE(edits[0].positionBefore, QVector3D(0, 0, 0));
+    QCOMPARE(edits[0].positionAfter, QVector3D(5, 0, 0));
+    QVERIFY(!history.canUndo());
+
+    // Without interval nothing is merged
+    history.clear();
+    history.setCoalesceInterval(0);
+    for (int i = 0; i < 5; i++) {
+        recordMove(history, pose, i);
+    }
+    QCOMPARE(history.memoryUsage(), budgetForModifications(5));
+    for (int i = 4; i >= 0; i--) {
+        QCOMPARE(history.undo()[0].positionBefore, QVector3D(i, 0, 0));
+    }
+    QVERIFY(!history.canUndo());
+}
+
+void PoseEditHistoryTest::coalesceOnlySamePose() {
+    PoseEditHistory history(budgetForModifications(10), 60000);
+    const PosePtr first = createPose("a");
+    const PosePtr second = createPose("b");
+    recordMove(history, first, 0);
+    recordMove(history, second, 0);
+    recordMove(history, second, 1);
+    recordMove(history, first, 1);
+    QCOMPARE(history.memoryUsage(), budgetForModifications(3));
+    QCOMPARE(history.undo()[0].pose, first);
+    QVector<PoseEdit> edits = history.undo();
+    QCOMPARE(edits.size(), 1);
+    QCOMPARE(edits[0].pose, second);
+    QCOMPARE(edits[0].positionBefore, QVector3D(0, 0, 0));
+    QCOMPARE(edits[0].positionAfter, QVector3D(2, 0, 0));
+    QCOMPARE(history.undo()[0].pose, first);
+}
+
+void PoseEditHistoryTest::sealStartsNewStep() {
+    PoseEditHistory history(budgetForModifications(10), 60000);
+    const PosePtr pose = createPose("a");
+    recordMove(history, pose, 0);
+    history.seal();
+    recordMove(history, pose, 1);
+    QCOMPARE(history.memoryUsage(), budgetForModifications(2));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(1, 0, 0));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(0, 0, 0));
+
+    // Adding or removing poses in between seals, too
+    history.clear();
+    recordMove(history, pose, 0);
+    history.recordRemoved(createPose("b"));
+    recordMove(history, pose, 1);
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(1, 0, 0));
+    QCOMPARE(history.undo()[0].type, PoseEdit::Removed);
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(0, 0, 0));
+}
+
+void PoseEditHistoryTest::noCoalescingAfterUndo() {
+    PoseEditHistory history(budgetForModifications(10), 60000);
+    const PosePtr pose = createPose("a");
+    recordMove(history, pose, 0);
+    history.undo();
+    history.redo();
+    // The redone step must stay as it was
+    recordMove(history, pose, 1);
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(1, 0, 0));
+    const QVector<PoseEdit> edits = history.undo();
+    QCOMPARE(edits[0].positionBefore, QVector3D(0, 0, 0));
+    QCOMPARE(edits[0].positionAfter, QVector3D(1, 0, 0));
+}
+
+void PoseEditHistoryTest::addedPosesAreOneStep() {
+    PoseEditHistory history;
+    const QList<PosePtr> poses = {createPose("a"), createPose("b"), createPose("c")};
+    history.recordAdded(poses);
+    QCOMPARE(history.memoryUsage(), 3 * costOfAddedOrRemoved());
+
+    QVector<PoseEdit> edits = history.undo();
+    QCOMPARE(edits.size(), 3);
+    // The most recent one first
+    for (int i = 0; i < 3; i++) {
+        QCOMPARE(edits[i].type, PoseEdit::Added);
+        QCOMPARE(edits[i].pose, poses[2 - i]);
+    }
+    QVERIFY(!history.canUndo());
+
+    edits = history.redo();
+    QCOMPARE(edits.size(), 3);
+    for (int i = 0; i < 3; i++) {
+        QCOMPARE(edits[i].pose, poses[i]);
+    }
+    QVERIFY(!history.canRedo());
+
+    history.recordAdded({});
+    QCOMPARE(history.memoryUsage(), 3 * costOfAddedOrRemoved());
+}
+
+void PoseEditHistoryTest::addedStepLargerThanBudgetClears() {
+    PoseEditHistory history(2 * costOfAddedOrRemoved(), 0);
+    history.recordRemoved(createPose("a"));
+    QVERIFY(history.canUndo());
+    history.recordAdded({createPose("b"), createPose("c"), createPose("d")});
+    QVERIFY(!history.canUndo());
+    QVERIFY(!history.canRedo());
+    QCOMPARE(history.memoryUsage(), 0);
+}
+
+void PoseEditHistoryTest::wrapAroundDropsOldestSteps() {
+    const int capacity = 4;
+    PoseEditHistory history(budgetForModifications(capacity), 0);
+    const PosePtr pose = createPose("a");
+    // Goes around the ring more than twice
+    for (int i = 0; i < 2 * capacity + 3; i++) {
+        recordMove(history, pose, i);
+        QVERIFY(history.memoryUsage() <= history.memoryBudget());
+    }
+    QCOMPARE(history.memoryUsage(), budgetForModifications(capacity));
+    for (int i = 2 * capacity + 2; i > capacity + 2; i--) {
+        QVERIFY(history.canUndo());
+        QCOMPARE(history.undo()[0].positionBefore, QVector3D(i, 0, 0));
+    }
+    QVERIFY(!history.canUndo());
+}
+
+void PoseEditHistoryTest::wrapAroundDropsWholeSteps() {
+    PoseEditHistory history(3 * costOfAddedOrRemoved(), 0);
+    PosePtr first = createPose("a");
+    const QWeakPointer<Pose> firstReference = first;
+    const PosePtr third = createPose("c");
+    const PosePtr fourth = createPose("d");
+    history.recordAdded({first, createPose("b")});
+    first.reset();
+    history.recordRemoved(third);
+    QCOMPARE(history.memoryUsage(), 3 * costOfAddedOrRemoved());
+    // Doesn't fit anymore, both poses that were added together have to go
+    history.recordRemoved(fourth);
+    QCOMPARE(history.memoryUsage(), 2 * costOfAddedOrRemoved());
+    QCOMPARE(history.undo()[0].pose, fourth);
+    QCOMPARE(history.undo()[0].pose, third);
+    QVERIFY(!history.canUndo());
+    // The history doesn't hold on to the poses of dropped steps
+    QVERIFY(firstReference.isNull());
+}
+
+void PoseEditHistoryTest::undoRedoAfterWrapAround() {
+    const int capacity = 3;
+    PoseEditHistory history(budgetForModifications(capacity), 0);
+    const PosePtr pose = createPose("a");
+    for (int i = 0; i < capacity + 2; i++) {
+        recordMove(history, pose, i);
+    }
+    // The steps are spread over the end and the start of the ring now
+    for (int i = capacity + 1; i > 1; i--) {
+        QCOMPARE(history.undo()[0].positionBefore, QVector3D(i, 0, 0));
+    }
+    QVERIFY(!history.canUndo());
+    for (int i = 2; i < capacity + 2; i++) {
+        QVERIFY(history.canRedo());
+        QCOMPARE(history.redo()[0].positionBefore, QVector3D(i, 0, 0));
+    }
+    QVERIFY(!history.canRedo());
+
+    // Recording after undoing reuses the slots of the dropped steps
+    history.undo();
+    history.undo();
+    recordMove(history, pose, 10);
+    recordMove(history, pose, 11);
+    recordMove(history, pose, 12);
+    QCOMPARE(history.memoryUsage(), budgetForModifications(capacity));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(12, 0, 0));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(11, 0, 0));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(10, 0, 0));
+    QVERIFY(!history.canUndo());
+}
+
+void PoseEditHistoryTest::lowerMemoryBudget() {
+    PoseEditHistory history(budgetForModifications(5), 0);
+    const PosePtr pose = createPose("a");
+    for (int i = 0; i < 7; i++) {
+        recordMove(history, pose, i);
+    }
+    history.undo();
+    history.setMemoryBudget(budgetForModifications(2));
+    // The step that could have been redone goes first
+    QVERIFY(!history.canRedo());
+    QCOMPARE(history.memoryUsage(), budgetForModifications(2));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(5, 0, 0));
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(4, 0, 0));
+    QVERIFY(!history.canUndo());
+
+    // Raising it again allows more steps than the ring has slots
+    history.redo();
+    history.redo();
+    history.setMemoryBudget(budgetForModifications(4));
+    for (int i = 10; i < 13; i++) {
+        recordMove(history, pose, i);
+    }
+    QCOMPARE(history.memoryUsage(), budgetForModifications(4));
+    for (int i = 12; i >= 10; i--) {
+        QCOMPARE(history.undo()[0].positionBefore, QVector3D(i, 0, 0));
+    }
+    QCOMPARE(history.undo()[0].positionBefore, QVector3D(5, 0, 0));
+    QVERIFY(!history.canUndo());
+}
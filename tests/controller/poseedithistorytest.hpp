@@ -0,0 +1,39 @@
+#ifndef POSEEDITHISTORYTEST_H
+#define POSEEDITHISTORYTEST_H
+
+#include <controller/poseedithistory.hpp>
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class PoseEditHistoryTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void undoRedoModification();
+    void unchangedModificationIsIgnored();
+    void recordingDropsRedoSteps();
+
+    void coalesceWithinInterval();
+    void coalesceOnlySamePose();
+    void sealStartsNewStep();
+    void noCoalescingAfterUndo();
+
+    void addedPosesAreOneStep();
+    void addedStepLargerThanBudgetClears();
+
+    void wrapAroundDropsOldestSteps();
+    void wrapAroundDropsWholeSteps();
+    void undoRedoAfterWrapAround();
+    void lowerMemoryBudget();
+
+private:
+    static PosePtr createPose(const QString &id);
+    //! Records moving the pose from (x, 0, 0) to (x + 1, 0, 0)
+    static void recordMove(PoseEditHistory &history, const PosePtr &pose, float x);
+    //! The budget for exactly the given number of modifications
+    static int budgetForModifications(int count);
+    static int costOfAddedOrRemoved();
+};
+
+#endif // POSEEDITHISTORYTEST_H
@@ -0,0 +1,30 @@
+#include "controller/poseedithistorytest.hpp"
+#include "model/jsonloadandstorestrategytest.hpp"
+#include "model/poseidtest.hpp"
+#include "model/posestoretest.hpp"
+#include "model/pythonloadandstorestrategytest.hpp"
+
+#include <QCoreApplication>
+#include <QSharedPointer>
+#include <QtTest/QtTest>
+
+/*!
+ * Runs all tests, the arguments are the ones of QtTest.
+ */
+int main(int argc, char *argv[]) {
+    QCoreApplication application(argc, argv);
+
+    QList<QSharedPointer<QObject>> tests;
+    tests << QSharedPointer<QObject>(new JsonLoadAndStoreStrategyTest)
+          << QSharedPointer<QObject>(new PoseIdTest)
+          << QSharedPointer<QObject>(new PoseEditHistoryTest)
+          << QSharedPointer<QObject>(new PoseStoreTest)
+          << QSharedPointer<QObject>(new PythonLoadAndStoreStrategyTest);
+
+    int status = 0;
+    const QStringList arguments = application.arguments();
+    for (const QSharedPointer<QObject> &test : tests) {
+        status |= QTest::qExec(test.data(), arguments);
+    }
+    return status;
+}
@@ -145,5 +145,3 @@ void JsonLoadAndStoreStrategyTest::cleanupTestCase() {
     delete m_tmpDir;
     delete m_signalSpy;
 }
-
-QTEST_GUILESS_MAIN( JsonLoadAndStoreStrategyTest )
@@ -2,8 +2,12 @@ INCLUDEPATH += $$PWD
 
 HEADERS += \
     $$PWD/jsonloadandstorestrategytest.hpp \
+    $$PWD/poseidtest.hpp \
+    $$PWD/posestoretest.hpp \
     $$PWD/pythonloadandstorestrategytest.hpp
 
 SOURCES += \
     $$PWD/jsonloadandstorestrategytest.cpp \
+    $$PWD/poseidtest.cpp \
+    $$PWD/posestoretest.cpp \
     $$PWD/pythonloadandstorestrategytest.cpp
@@ -0,0 +1,102 @@
+#include "poseidtest.hpp"
+
+void PoseIdTest::generatedIdsAreIncreasing() {
+    PoseId previous = PoseId::generate();
+    // Many more than fit into one millisecond
+    for (int i = 0; i < 10000; i++) {
+        const PoseId id = PoseId::generate();
+        QVERIFY(previous < id);
+        QVERIFY(!id.isLegacy());
+        previous = id;
+    }
+}
+
+void PoseIdTest::generatedIdsRoundTrip() {
+    const PoseId id = PoseId::generate();
+    const QString text = id.toString();
+    QVERIFY(text.startsWith('p'));
+    QCOMPARE(PoseId::fromString(text), id);
+    QCOMPARE(PoseId::find(text), id);
+    QCOMPARE(PoseId::fromString(text).toString(), text);
+}
+
+void PoseIdTest::advancePast() {
+    // Like an id of a dataset created on a clock that is an hour ahead
+    const PoseId ahead = PoseId::fromString(
+                QLatin1Char('p') + QString::number(PoseId::generate().value() + (quint64(3600000) << 12), 36));
+    QVERIFY(ahead.isValid());
+    PoseId::advancePast(ahead);
+    QVERIFY(ahead < PoseId::generate());
+    // Legacy and invalid ids are ignored
+    PoseId::advancePast(PoseId::fromString("000001_obj_01"));
+    PoseId::advancePast(PoseId());
+    QVERIFY(ahead < PoseId::generate());
+}
+
+void PoseIdTest::parseCompact_data() {
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("compact");
+
+    QTest::newRow("compact") << "pa" << true;
+    QTest::newRow("generated") << "p1ry3c5vk00" << true;
+    QTest::newRow("empty") << "" << false;
+    QTest::newRow("only prefix") << "p" << false;
+    QTest::newRow("leading zero") << "p0a" << false;
+    QTest::newRow("upper case") << "pA" << false;
+    QTest::newRow("zero") << "p0" << false;
+    QTest::newRow("no prefix") << "1ry3c5vk00" << false;
+    QTest::newRow("invalid digit") << "p1ry3c5vk0_" << false;
+    QTest::newRow("too long") << "p1ry3c5vk001ry3c5" << false;
+    // Doesn't fit into the 63 bits that aren't reserved for legacy ids
+    QTest::newRow("legacy range") << "p" + QString::number(quint64(1) << 63, 36) << false;
+    QTest::newRow("legacy") << "000001_obj_01_1.3.19_12:00:00" << false;
+}
+
+void PoseIdTest::parseCompact() {
+    QFETCH(QString, text);
+    QFETCH(bool, compact);
+
+    const PoseId id = PoseId::fromString(text);
+    if (text.isEmpty()) {
+        QVERIFY(!id.isValid());
+        return;
+    }
+    QVERIFY(id.isValid());
+    QCOMPARE(id.isLegacy(), !compact);
+    // Either way the text is written back unchanged
+    QCOMPARE(id.toString(), text);
+}
+
+void PoseIdTest::legacyIdsRoundTrip() {
+    const QString text = "000002_obj_03_1.3.19_12:00:00";
+    const PoseId id = PoseId::fromString(text);
+    QVERIFY(id.isValid());
+    QVERIFY(id.isLegacy());
+    QCOMPARE(id.toString(), text);
+    // Registered once
+    QCOMPARE(PoseId::fromString(text), id);
+    QCOMPARE(PoseId::find(text), id);
+    QVERIFY(PoseId::fromString("000002_obj_03_1.3.19_12:00:01") != id);
+}
+
+void PoseIdTest::findDoesNotRegister() {
+    const QString text = "never_registered";
+    const int count = PoseId::legacyIdCount();
+    QVERIFY(!PoseId::find(text).isValid());
+    QCOMPARE(PoseId::legacyIdCount(), count);
+}
+
+void PoseIdTest::releaseLegacyIds() {
+    const PoseId kept = PoseId::fromString("kept_legacy_id");
+    const PoseId released = PoseId::fromString("released_legacy_id");
+    PoseId::releaseLegacyIds({kept});
+    QCOMPARE(PoseId::legacyIdCount(), 1);
+    QCOMPARE(kept.toString(), QString("kept_legacy_id"));
+    QCOMPARE(PoseId::find("kept_legacy_id"), kept);
+    QVERIFY(released.toString().isEmpty());
+    QVERIFY(!PoseId::find("released_legacy_id").isValid());
+    // Registering the text again doesn't bring back the released key
+    const PoseId registeredAgain = PoseId::fromString("released_legacy_id");
+    QVERIFY(registeredAgain != released);
+    QCOMPARE(registeredAgain.toString(), QString("released_legacy_id"));
+}
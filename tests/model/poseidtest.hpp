@@ -0,0 +1,25 @@
+#ifndef POSEIDTEST_H
+#define POSEIDTEST_H
+
+#include <model/poseid.hpp>
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class PoseIdTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void generatedIdsAreIncreasing();
+    void generatedIdsRoundTrip();
+    void advancePast();
+
+    void parseCompact_data();
+    void parseCompact();
+
+    void legacyIdsRoundTrip();
+    void findDoesNotRegister();
+    void releaseLegacyIds();
+};
+
+#endif // POSEIDTEST_H
@@ -0,0 +1,146 @@
+#include "posestoretest.hpp"
+
+#include <model/data.hpp>
+
+PoseId PoseStoreTest::appendPose(PoseStore &store, float x, int imageIndex, int objectModelIndex) {
+    const PoseId id = PoseId::generate();
+    store.append(id, QVector3D(x, 0, 0), QQuaternion(), imageIndex, objectModelIndex);
+    return id;
+}
+
+void PoseStoreTest::appendReturnsRows() {
+    PoseStore store;
+    QVERIFY(store.isEmpty());
+    const PoseId id = PoseId::generate();
+    const QQuaternion rotation = QQuaternion::fromAxisAndAngle(0, 0, 1, 90);
+    QCOMPARE(store.append(id, QVector3D(1, 2, 3), rotation, 4, 5), 0);
+    QCOMPARE(store.append(PoseId::generate(), QVector3D(), QQuaternion(), 0, 0), 1);
+    QCOMPARE(store.size(), 2);
+    QCOMPARE(store.id(0), id);
+    QCOMPARE(store.position(0), QVector3D(1, 2, 3));
+    QCOMPARE(store.rotation(0), rotation);
+    QCOMPARE(store.imageIndex(0), 4);
+    QCOMPARE(store.objectModelIndex(0), 5);
+}
+
+void PoseStoreTest::appendStore() {
+    PoseStore store;
+    appendPose(store, 0, 0, 0);
+    PoseStore other;
+    const PoseId first = appendPose(other, 1, 1, 0);
+    const PoseId second = appendPose(other, 2, 2, 1);
+    store.append(other);
+    QCOMPARE(store.size(), 3);
+    QCOMPARE(store.id(1), first);
+    QCOMPARE(store.id(2), second);
+    QCOMPARE(store.imageIndex(2), 2);
+    QCOMPARE(store.objectModelIndex(2), 1);
+    QCOMPARE(other.size(), 2);
+}
+
+void PoseStoreTest::removeAtMovesFollowingRows() {
+    PoseStore store;
+    const PoseId first = appendPose(store, 0, 0, 0);
+    appendPose(store, 1, 1, 0);
+    const PoseId third = appendPose(store, 2, 2, 0);
+    store.removeAt(1);
+    QCOMPARE(store.size(), 2);
+    QCOMPARE(store.id(0), first);
+    QCOMPARE(store.id(1), third);
+    QCOMPARE(store.position(1), QVector3D(2, 0, 0));
+    QCOMPARE(store.imageIndex(1), 2);
+    store.removeAt(0);
+    store.removeAt(0);
+    QVERIFY(store.isEmpty());
+}
+
+void PoseStoreTest::removeRowsOfImages() {
+    PoseStore store;
+    appendPose(store, 0, 0, 0);
+    const PoseId kept = appendPose(store, 1, 1, 0);
+    appendPose(store, 2, 2, 0);
+    appendPose(store, 3, 0, 1);
+    store.removeRowsOfImages({0, 2});
+    QCOMPARE(store.size(), 1);
+    QCOMPARE(store.id(0), kept);
+    QCOMPARE(store.position(0), QVector3D(1, 0, 0));
+    // Nothing to remove
+    store.removeRowsOfImages(QSet<int>());
+    QCOMPARE(store.size(), 1);
+}
+
+void PoseStoreTest::remapImageIndicesRemovesUnmappedPoses() {
+    PoseStore store;
+    appendPose(store, 0, 0, 0);
+    const PoseId moved = appendPose(store, 1, 1, 0);
+    appendPose(store, 2, 2, 0);
+    // Image 0 was removed and image 1 moved to the front, image 2 is beyond the mapping
+    store.remapImageIndices({-1, 0});
+    QCOMPARE(store.size(), 1);
+    QCOMPARE(store.id(0), moved);
+    QCOMPARE(store.imageIndex(0), 0);
+
+    store.remapObjectModelIndices({3});
+    QCOMPARE(store.objectModelIndex(0), 3);
+    store.remapObjectModelIndices({-1, -1, -1, -1});
+    QVERIFY(store.isEmpty());
+}
+
+void PoseStoreTest::setPoseKeepsIndices() {
+    PoseStore store;
+    const PoseId id = appendPose(store, 0, 3, 4);
+    const QQuaternion rotation = QQuaternion::fromAxisAndAngle(1, 0, 0, 45);
+    store.setPose(0, QVector3D(5, 6, 7), rotation);
+    QCOMPARE(store.id(0), id);
+    QCOMPARE(store.position(0), QVector3D(5, 6, 7));
+    QCOMPARE(store.rotation(0), rotation);
+    QCOMPARE(store.imageIndex(0), 3);
+    QCOMPARE(store.objectModelIndex(0), 4);
+}
+
+void PoseStoreTest::rowMapping_data() {
+    QTest::addColumn<int>("oldRowCount");
+    QTest::addColumn<QList<int>>("removedRows");
+    QTest::addColumn<QList<int>>("insertedRows");
+    QTest::addColumn<QVector<int>>("expectedMapping");
+
+    QTest::newRow("unchanged") << 3 << QList<int>() << QList<int>()
+                               << QVector<int>({0, 1, 2});
+    QTest::newRow("empty") << 0 << QList<int>() << QList<int>({0})
+                           << QVector<int>();
+    QTest::newRow("removed first") << 3 << QList<int>({0}) << QList<int>()
+                                   << QVector<int>({-1, 0, 1});
+    QTest::newRow("removed last") << 3 << QList<int>({2}) << QList<int>()
+                                  << QVector<int>({0, 1, -1});
+    QTest::newRow("removed all") << 2 << QList<int>({0, 1}) << QList<int>()
+                                 << QVector<int>({-1, -1});
+    QTest::newRow("inserted first") << 2 << QList<int>() << QList<int>({0})
+                                    << QVector<int>({1, 2});
+    QTest::newRow("inserted last") << 2 << QList<int>() << QList<int>({2})
+                                   << QVector<int>({0, 1});
+    QTest::newRow("inserted consecutive") << 2 << QList<int>() << QList<int>({1, 2})
+                                          << QVector<int>({0, 3});
+    // New list: inserted, 0, 2, inserted, 3
+    QTest::newRow("removed and inserted") << 4 << QList<int>({1}) << QList<int>({0, 3})
+                                          << QVector<int>({1, -1, 2, 4});
+    // Like renaming the second image, it is removed and inserted at another row
+    QTest::newRow("moved") << 3 << QList<int>({1}) << QList<int>({2})
+                           << QVector<int>({0, -1, 1});
+}
+
+void PoseStoreTest::rowMapping() {
+    QFETCH(int, oldRowCount);
+    QFETCH(QList<int>, removedRows);
+    QFETCH(QList<int>, insertedRows);
+    QFETCH(QVector<int>, expectedMapping);
+
+    DataDelta delta;
+    delta.removedRows = removedRows;
+    delta.insertedRows = insertedRows;
+    const QVector<int> mapping = delta.rowMapping(oldRowCount);
+    QCOMPARE(mapping, expectedMapping);
+    // Both have to agree, views use mapRow for single rows
+    for (int oldRow = 0; oldRow < oldRowCount; oldRow++) {
+        QCOMPARE(delta.mapRow(oldRow), mapping[oldRow]);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef POSESTORETEST_H
+#define POSESTORETEST_H
+
+#include <model/posestore.hpp>
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class PoseStoreTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void appendReturnsRows();
+    void appendStore();
+    void removeAtMovesFollowingRows();
+    void removeRowsOfImages();
+    void remapImageIndicesRemovesUnmappedPoses();
+    void setPoseKeepsIndices();
+
+    void rowMapping_data();
+    void rowMapping();
+
+private:
+    //! Appends a pose whose position is (x, 0, 0) to tell the rows apart
+    static PoseId appendPose(PoseStore &store, float x, int imageIndex, int objectModelIndex);
+};
+
+#endif // POSESTORETEST_H
@@ -1,5 +1,52 @@
 #include "pythonloadandstorestrategytest.hpp"
 
-PythonLoadAndStoreStrategyTest::PythonLoadAndStoreStrategyTest() {
+#include <settings/settings.hpp>
 
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+
+void PythonLoadAndStoreStrategyTest::initTestCase() {
+    m_tmpDir = new QTemporaryDir;
+    QDir tmpDir = m_tmpDir->path();
+    tmpDir.mkdir("images");
+    tmpDir.mkdir("models");
+    // Python can't import the script from the resources
+    const QString scriptPath = tmpDir.filePath("numpy_scalars_loader.py");
+    QVERIFY(QFile::copy(":/python/numpy_scalars_loader.py", scriptPath));
+
+    SettingsPtr settings(new Settings("test"));
+    settings->setImagesPath(tmpDir.filePath("images"));
+    settings->setObjectModelsPath(tmpDir.filePath("models"));
+    settings->setLoadSaveScriptPath(scriptPath);
+    m_strategy = new PythonLoadAndStoreStrategy;
+    m_strategy->applySettings(settings);
+
+    m_signalSpy = new QSignalSpy(m_strategy, &LoadAndStoreStrategy::error);
+}
+
+void PythonLoadAndStoreStrategyTest::loadImagesWithNumpyScalars() {
+    QList<ImagePtr> images = m_strategy->loadImages();
+    QCOMPARE(m_signalSpy->count(), 0);
+    QCOMPARE(images.size(), 1);
+    const ImagePtr &image = images.first();
+    QCOMPARE(image->id(), QString("7"));
+    QCOMPARE(image->getCameraMatrix()(0, 0), 500.f);
+    QCOMPARE(image->getCameraMatrix()(1, 2), 240.f);
+    QVERIFY(image->hasDepthImage());
+    QCOMPARE(image->depthScale(), 0.5f);
+    QCOMPARE(image->sceneId(), QString("3"));
+}
+
+void PythonLoadAndStoreStrategyTest::loadObjectModelsWithNumpyScalars() {
+    QList<ObjectModelPtr> objectModels = m_strategy->loadObjectModels();
+    QCOMPARE(m_signalSpy->count(), 0);
+    QCOMPARE(objectModels.size(), 1);
+    QCOMPARE(objectModels.first()->id(), QString("2"));
+}
+
+void PythonLoadAndStoreStrategyTest::cleanupTestCase() {
+    delete m_signalSpy;
+    delete m_strategy;
+    delete m_tmpDir;
 }
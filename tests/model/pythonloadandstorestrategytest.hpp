@@ -3,10 +3,27 @@
 
 #include <model/pythonloadandstorestrategy.hpp>
 
-class PythonLoadAndStoreStrategyTest {
+#include <QObject>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
 
-public:
-    PythonLoadAndStoreStrategyTest();
+class PythonLoadAndStoreStrategyTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    // The script returns NumPy scalars instead of Python ints and floats
+    void loadImagesWithNumpyScalars();
+    void loadObjectModelsWithNumpyScalars();
+
+    void cleanupTestCase();
+
+private:
+    // The interpreter can only be initialized once, all tests share the strategy
+    PythonLoadAndStoreStrategy *m_strategy;
+    QTemporaryDir *m_tmpDir;
+    QSignalSpy *m_signalSpy;
 };
 
 #endif // PYTHONLOADANDSTORESTRATEGYTEST_H
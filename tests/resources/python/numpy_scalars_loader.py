@@ -0,0 +1,17 @@
+import numpy as np
+
+# Returns all values as NumPy scalars like scripts that read them from arrays do
+
+def load_images(images_path, segmentation_images_path):
+    return [{'img_id' : np.int64(7),
+             'img_path' : 'image.png',
+             'base_path' : images_path,
+             'K' : [np.float32(value) for value in (500, 0, 320, 0, 500, 240, 0, 0, 1)],
+             'depth_image_path' : 'depth.png',
+             'depth_scale' : np.float32(0.5),
+             'scene_id' : np.int32(3)}]
+
+def load_object_models(object_models_path):
+    return [{'obj_id' : np.int64(2),
+             'obj_model_path' : 'model.ply',
+             'base_path' : object_models_path}]
@@ -10,6 +10,11 @@ include(integration/integration.pri)
 
 LIBS += -L../src -l6dpat
 
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/main.cpp
+
 RESOURCES += \
     resources.qrc
 
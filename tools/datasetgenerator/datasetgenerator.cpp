@@ -0,0 +1,456 @@
+#include "datasetgenerator.hpp"
+
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QPainter>
+#include <QQuaternion>
+#include <QRadialGradient>
+#include <QVector2D>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// Generated ids look like the ones the program creates (see PoseId), as if they were
+// all created at the same point in time which lies in the past
+const quint64 POSE_ID_BASE = quint64(1500000000000) << 12;
+
+QByteArray number(double value) {
+    return QByteArray::number(value, 'g', 9);
+}
+
+QByteArray jsonString(const QString &text) {
+    // File names and ids don't contain characters that need to be escaped
+    return '"' + text.toUtf8() + '"';
+}
+
+//! Collects the output and writes it in large chunks
+class ChunkedWriter {
+
+public:
+    explicit ChunkedWriter(QFile &file) : m_file(file) {
+    }
+
+    ChunkedWriter &operator<<(const QByteArray &data) {
+        m_buffer += data;
+        if (m_buffer.size() > 1 << 20) {
+            flush();
+        }
+        return *this;
+    }
+
+    bool flush() {
+        m_ok &= m_file.write(m_buffer) == m_buffer.size();
+        m_buffer.clear();
+        return m_ok;
+    }
+
+private:
+    QFile &m_file;
+    QByteArray m_buffer;
+    bool m_ok = true;
+};
+
+}
+
+DatasetGenerator::DatasetGenerator(const Parameters &parameters)
+    : m_parameters(parameters)
+    // Roughly the field of view of common cameras
+    , m_focalLength(parameters.imageSize.width()) {
+    for (int i = 0; i < m_parameters.numberOfObjectModels; i++) {
+        ObjectModelShape shape = objectModelShape(i);
+        switch (shape.type) {
+        case ObjectModelShape::Box:
+            m_objectModelRadii.append(shape.size.length());
+            break;
+        case ObjectModelShape::Cylinder:
+            m_objectModelRadii.append(QVector2D(shape.size.x(), shape.size.z()).length());
+            break;
+        case ObjectModelShape::Sphere:
+            m_objectModelRadii.append(shape.size.x());
+            break;
+        }
+    }
+}
+
+bool DatasetGenerator::generate(const QString &path) {
+    m_errorString.clear();
+    if (m_parameters.numberOfPoses > 0 && m_parameters.numberOfObjectModels == 0) {
+        m_errorString = "Poses can't be generated without object models.";
+        return false;
+    }
+    if (m_parameters.numberOfPoses > 0 && m_parameters.numberOfImages == 0) {
+        m_errorString = "Poses can't be generated without images.";
+        return false;
+    }
+    QDir dir(path);
+    if (!dir.mkpath("images") || !dir.mkpath("models")
+            || (m_parameters.segmentationImages && !dir.mkpath("segmentation_images"))) {
+        m_errorString = "Failed to create the folders of the dataset at " + path + ".";
+        return false;
+    }
+    return writeImages(dir.filePath("images"),
+                       m_parameters.segmentationImages ? dir.filePath("segmentation_images") : "")
+            && writeCameraInfo(dir.filePath("images"))
+            && writeObjectModels(dir.filePath("models"))
+            && writePoses(dir.filePath("poses.json"))
+            && writeSegmentationCodes(dir.filePath("segmentation_codes.json"));
+}
+
+QString DatasetGenerator::errorString() const {
+    return m_errorString;
+}
+
+QString DatasetGenerator::imageFileName(int index) {
+    return QString("%1.png").arg(index, 6, 10, QChar('0'));
+}
+
+QString DatasetGenerator::objectModelFileName(int index) const {
+    const int digits = QString::number(qMax(0, m_parameters.numberOfObjectModels - 1)).size();
+    return QString("obj_%1.obj").arg(index, qMax(3, digits), 10, QChar('0'));
+}
+
+QColor DatasetGenerator::segmentationColor(int objectModelIndex) {
+    // A lattice of 15 values per channel that leaves out black and white
+    const int index = objectModelIndex % (15 * 15 * 15);
+    return QColor(16 + 16 * (index % 15),
+                  16 + 16 * (index / 15 % 15),
+                  16 + 16 * (index / 225));
+}
+
+QRandomGenerator DatasetGenerator::randomGenerator(Stream stream, int index) const {
+    const quint32 seed[3] = {m_parameters.seed, quint32(stream), quint32(index)};
+    return QRandomGenerator(seed, 3);
+}
+
+int DatasetGenerator::firstPoseOfImage(int imageIndex) const {
+    const int posesPerImage = m_parameters.numberOfPoses / m_parameters.numberOfImages;
+    const int remainder = m_parameters.numberOfPoses % m_parameters.numberOfImages;
+    return imageIndex * posesPerImage + qMin(imageIndex, remainder);
+}
+
+QVector<DatasetGenerator::GeneratedPose> DatasetGenerator::posesOfImage(int imageIndex) const {
+    QVector<GeneratedPose> poses;
+    if (m_parameters.numberOfPoses == 0) {
+        return poses;
+    }
+    const int numberOfPoses = firstPoseOfImage(imageIndex + 1) - firstPoseOfImage(imageIndex);
+    const QSize &imageSize = m_parameters.imageSize;
+    QRandomGenerator random = randomGenerator(PoseStream, imageIndex);
+    for (int i = 0; i < numberOfPoses; i++) {
+        GeneratedPose pose;
+        pose.objectModel = random.bounded(m_parameters.numberOfObjectModels);
+        // Somewhere in the image between 40 cm and 1.5 m in front of the camera
+        const double z = 400 + random.bounded(1100.0);
+        const double u = imageSize.width() * (0.1 + 0.8 * random.generateDouble());
+        const double v = imageSize.height() * (0.1 + 0.8 * random.generateDouble());
+        pose.position = QVector3D((u - imageSize.width() / 2.0) * z / m_focalLength,
+                                  (v - imageSize.height() / 2.0) * z / m_focalLength,
+                                  z);
+        // Uniformly distributed rotations (Shoemake)
+        const double u1 = random.generateDouble();
+        const double u2 = 2 * M_PI * random.generateDouble();
+        const double u3 = 2 * M_PI * random.generateDouble();
+        QQuaternion rotation(std::sqrt(u1) * std::cos(u3),
+                             std::sqrt(1 - u1) * std::sin(u2),
+                             std::sqrt(1 - u1) * std::cos(u2),
+                             std::sqrt(u1) * std::sin(u3));
+        pose.rotation = rotation.toRotationMatrix();
+        poses.append(pose);
+    }
+    return poses;
+}
+
+DatasetGenerator::ObjectModelShape DatasetGenerator::objectModelShape(int index) const {
+    QRandomGenerator random = randomGenerator(ObjectModelStream, index);
+    ObjectModelShape shape;
+    shape.type = ObjectModelShape::Type(random.bounded(3));
+    // Between 4 and 16 cm like the objects of common datasets
+    shape.size = QVector3D(20 + random.bounded(60.0),
+                           20 + random.bounded(60.0),
+                           20 + random.bounded(60.0));
+    if (shape.type == ObjectModelShape::Sphere) {
+        shape.size = QVector3D(shape.size.x(), shape.size.x(), shape.size.x());
+    } else if (shape.type == ObjectModelShape::Cylinder) {
+        shape.size.setY(shape.size.x());
+    }
+    shape.segments = 8 + random.bounded(17);
+    return shape;
+}
+
+QPointF DatasetGenerator::project(const QVector3D &point) const {
+    return QPointF(m_focalLength * point.x() / point.z() + m_parameters.imageSize.width() / 2.0,
+                   m_focalLength * point.y() / point.z() + m_parameters.imageSize.height() / 2.0);
+}
+
+bool DatasetGenerator::writeImages(const QString &imagesPath, const QString &segmentationImagesPath) {
+    QByteArray sharedImage;
+    if (m_parameters.sharedImage) {
+        QBuffer buffer(&sharedImage);
+        buffer.open(QBuffer::WriteOnly);
+        drawImage(0, QVector<GeneratedPose>()).save(&buffer, "PNG");
+    }
+    QVector<int> indices(m_parameters.numberOfImages);
+    std::iota(indices.begin(), indices.end(), 0);
+    QAtomicInt failures;
+    QtConcurrent::blockingMap(indices, [&](int index) {
+        if (!writeImage(index, imagesPath, segmentationImagesPath, sharedImage)) {
+            failures.ref();
+        }
+    });
+    if (failures.loadAcquire() > 0) {
+        m_errorString = QString("Failed to write %1 images.").arg(failures.loadAcquire());
+        return false;
+    }
+    return true;
+}
+
+bool DatasetGenerator::writeImage(int index, const QString &imagesPath,
+                                  const QString &segmentationImagesPath,
+                                  const QByteArray &sharedImage) const {
+    const QString fileName = imageFileName(index);
+    const QVector<GeneratedPose> poses = posesOfImage(index);
+    if (sharedImage.isEmpty()) {
+        if (!drawImage(index, poses).save(QDir(imagesPath).filePath(fileName), "PNG")) {
+            return false;
+        }
+    } else {
+        QFile file(QDir(imagesPath).filePath(fileName));
+        if (!file.open(QFile::WriteOnly) || file.write(sharedImage) != sharedImage.size()) {
+            return false;
+        }
+    }
+    if (!segmentationImagesPath.isEmpty()) {
+        return drawSegmentationImage(poses).save(QDir(segmentationImagesPath).filePath(fileName), "PNG");
+    }
+    return true;
+}
+
+//! The poses from back to front, in the order they have to be drawn
+static QVector<int> drawingOrder(const QVector<QVector3D> &positions) {
+    QVector<int> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&positions](int i, int j) {
+        return positions[i].z() > positions[j].z();
+    });
+    return order;
+}
+
+QImage DatasetGenerator::drawImage(int index, const QVector<GeneratedPose> &poses) const {
+    QRandomGenerator random = randomGenerator(ImageStream, index);
+    QImage image(m_parameters.imageSize, QImage::Format_RGB32);
+    QPainter painter(&image);
+    QLinearGradient background(0, 0, 0, image.height());
+    background.setColorAt(0, QColor::fromHsv(random.bounded(360), 40, 200));
+    background.setColorAt(1, QColor::fromHsv(random.bounded(360), 40, 90));
+    painter.fillRect(image.rect(), background);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+
+    QVector<QVector3D> positions;
+    for (const GeneratedPose &pose : poses) {
+        positions.append(pose.position);
+    }
+    for (int i : drawingOrder(positions)) {
+        const GeneratedPose &pose = poses[i];
+        const QPointF center = project(pose.position);
+        const double radius = m_focalLength * m_objectModelRadii[pose.objectModel] / pose.position.z();
+        // Something that looks like a lit object, the images are only there to be displayed
+        QRadialGradient shading(center - QPointF(radius, radius) / 3, radius * 1.5);
+        const QColor color = segmentationColor(pose.objectModel);
+        shading.setColorAt(0, color.lighter(150));
+        shading.setColorAt(1, color.darker(250));
+        painter.setBrush(shading);
+        painter.drawEllipse(center, radius, radius);
+    }
+    return image;
+}
+
+QImage DatasetGenerator::drawSegmentationImage(const QVector<GeneratedPose> &poses) const {
+    QImage mask(m_parameters.imageSize, QImage::Format_RGB32);
+    mask.fill(Qt::black);
+    // No antialiasing, a mask must only contain the colors of the palette
+    QPainter painter(&mask);
+    painter.setPen(QPen(Qt::white, 2));
+    QVector<QRgb> colorTable = {qRgb(0, 0, 0), qRgb(255, 255, 255)};
+    QVector<QVector3D> positions;
+    for (const GeneratedPose &pose : poses) {
+        positions.append(pose.position);
+    }
+    for (int i : drawingOrder(positions)) {
+        const GeneratedPose &pose = poses[i];
+        const QPointF center = project(pose.position);
+        const double radius = m_focalLength * m_objectModelRadii[pose.objectModel] / pose.position.z();
+        const QColor color = segmentationColor(pose.objectModel);
+        painter.setBrush(color);
+        painter.drawEllipse(center, radius, radius);
+        if (!colorTable.contains(color.rgb())) {
+            colorTable.append(color.rgb());
+        }
+    }
+    painter.end();
+    // Palettized like the masks of common datasets, the gallery reads the colors of the palette
+    return mask.convertToFormat(QImage::Format_Indexed8, colorTable,
+                                Qt::ThresholdDither | Qt::AvoidDither);
+}
+
+bool DatasetGenerator::writeCameraInfo(const QString &imagesPath) {
+    QFile file(QDir(imagesPath).filePath("info.json"));
+    if (!file.open(QFile::WriteOnly)) {
+        m_errorString = "Failed to write the camera info file " + file.fileName() + ".";
+        return false;
+    }
+    const QSize &imageSize = m_parameters.imageSize;
+    const QByteArray cameraMatrix = "{\"K\": [" + number(m_focalLength) + ", 0, "
+            + number(imageSize.width() / 2.0) + ", 0, " + number(m_focalLength) + ", "
+            + number(imageSize.height() / 2.0) + ", 0, 0, 1]}";
+    ChunkedWriter writer(file);
+    writer << "{\n";
+    for (int i = 0; i < m_parameters.numberOfImages; i++) {
+        writer << "    " << jsonString(imageFileName(i)) << ": " << cameraMatrix
+               << (i + 1 < m_parameters.numberOfImages ? ",\n" : "\n");
+    }
+    writer << "}\n";
+    if (!writer.flush()) {
+        m_errorString = "Failed to write the camera info file " + file.fileName() + ".";
+        return false;
+    }
+    return true;
+}
+
+bool DatasetGenerator::writeObjectModels(const QString &objectModelsPath) {
+    for (int i = 0; i < m_parameters.numberOfObjectModels; i++) {
+        const ObjectModelShape shape = objectModelShape(i);
+        QVector<QVector3D> vertices;
+        // Triangles with counter-clockwise vertices seen from outside, indices start at 1
+        QVector<int> faces;
+        const int segments = shape.segments;
+        if (shape.type == ObjectModelShape::Box) {
+            for (int j = 0; j < 8; j++) {
+                vertices.append(QVector3D(j & 1 ? 1 : -1, j & 2 ? 1 : -1, j & 4 ? 1 : -1) * shape.size);
+            }
+            faces = {1, 3, 4, 1, 4, 2,  5, 6, 8, 5, 8, 7,
+                     1, 2, 6, 1, 6, 5,  3, 7, 8, 3, 8, 4,
+                     1, 5, 7, 1, 7, 3,  2, 4, 8, 2, 8, 6};
+        } else if (shape.type == ObjectModelShape::Cylinder) {
+            for (int j = 0; j < segments; j++) {
+                const double angle = 2 * M_PI * j / segments;
+                const float x = shape.size.x() * std::cos(angle);
+                const float y = shape.size.y() * std::sin(angle);
+                vertices.append(QVector3D(x, y, -shape.size.z()));
+                vertices.append(QVector3D(x, y, shape.size.z()));
+            }
+            vertices.append(QVector3D(0, 0, -shape.size.z()));
+            vertices.append(QVector3D(0, 0, shape.size.z()));
+            const int bottom = 2 * segments + 1;
+            const int top = bottom + 1;
+            for (int j = 0; j < segments; j++) {
+                const int lower = 2 * j + 1;
+                const int nextLower = 2 * ((j + 1) % segments) + 1;
+                faces << lower << nextLower << nextLower + 1
+                      << lower << nextLower + 1 << lower + 1
+                      << bottom << nextLower << lower
+                      << top << lower + 1 << nextLower + 1;
+            }
+        } else {
+            const int rings = qMax(2, segments / 2);
+            for (int ring = 0; ring <= rings; ring++) {
+                const double polar = M_PI * ring / rings;
+                for (int j = 0; j < segments; j++) {
+                    const double azimuth = 2 * M_PI * j / segments;
+                    vertices.append(shape.size.x() * QVector3D(std::sin(polar) * std::cos(azimuth),
+                                                               std::sin(polar) * std::sin(azimuth),
+                                                               std::cos(polar)));
+                }
+            }
+            for (int ring = 0; ring < rings; ring++) {
+                for (int j = 0; j < segments; j++) {
+                    const int current = ring * segments + j + 1;
+                    const int next = ring * segments + (j + 1) % segments + 1;
+                    faces << current << current + segments << next + segments
+                          << current << next + segments << next;
+                }
+            }
+        }
+
+        QByteArray obj;
+        for (const QVector3D &vertex : vertices) {
+            obj += "v " + number(vertex.x()) + ' ' + number(vertex.y()) + ' ' + number(vertex.z()) + '\n';
+        }
+        for (int j = 0; j < faces.size(); j += 3) {
+            obj += "f " + QByteArray::number(faces[j]) + ' ' + QByteArray::number(faces[j + 1])
+                    + ' ' + QByteArray::number(faces[j + 2]) + '\n';
+        }
+        QFile file(QDir(objectModelsPath).filePath(objectModelFileName(i)));
+        if (!file.open(QFile::WriteOnly) || file.write(obj) != obj.size()) {
+            m_errorString = "Failed to write the object model " + file.fileName() + ".";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DatasetGenerator::writePoses(const QString &posesFilePath) {
+    QFile file(posesFilePath);
+    if (!file.open(QFile::WriteOnly)) {
+        m_errorString = "Failed to write the poses file " + posesFilePath + ".";
+        return false;
+    }
+    ChunkedWriter writer(file);
+    writer << "{\n";
+    for (int i = 0; i < m_parameters.numberOfImages; i++) {
+        const QVector<GeneratedPose> poses = posesOfImage(i);
+        writer << "    " << jsonString(imageFileName(i)) << ": [";
+        for (int j = 0; j < poses.size(); j++) {
+            const GeneratedPose &pose = poses[j];
+            writer << (j > 0 ? ",\n        {" : "\n        {");
+            if (m_parameters.poseIds) {
+                const quint64 id = POSE_ID_BASE + firstPoseOfImage(i) + j;
+                writer << "\"id\": " << jsonString("p" + QString::number(id, 36)) << ", ";
+            }
+            writer << "\"obj\": " << jsonString(objectModelFileName(pose.objectModel)) << ", \"R\": [";
+            for (int k = 0; k < 9; k++) {
+                writer << (k > 0 ? ", " : "") << number(pose.rotation(k / 3, k % 3));
+            }
+            writer << "], \"t\": [" << number(pose.position.x()) << ", "
+                   << number(pose.position.y()) << ", " << number(pose.position.z()) << "]}";
+        }
+        writer << (poses.isEmpty() ? "]" : "\n    ]")
+               << (i + 1 < m_parameters.numberOfImages ? ",\n" : "\n");
+    }
+    writer << "}\n";
+    if (!writer.flush()) {
+        m_errorString = "Failed to write the poses file " + posesFilePath + ".";
+        return false;
+    }
+    return true;
+}
+
+bool DatasetGenerator::writeSegmentationCodes(const QString &segmentationCodesFilePath) {
+    QFile file(segmentationCodesFilePath);
+    if (!file.open(QFile::WriteOnly)) {
+        m_errorString = "Failed to write the segmentation codes " + segmentationCodesFilePath + ".";
+        return false;
+    }
+    ChunkedWriter writer(file);
+    writer << "{\n";
+    for (int i = 0; i < m_parameters.numberOfObjectModels; i++) {
+        // The format of the codes in the settings, red.green.blue
+        const QColor color = segmentationColor(i);
+        const QString code = QString("%1.%2.%3").arg(color.red()).arg(color.green()).arg(color.blue());
+        writer << "    " << jsonString(objectModelFileName(i)) << ": " << jsonString(code)
+               << (i + 1 < m_parameters.numberOfObjectModels ? ",\n" : "\n");
+    }
+    writer << "}\n";
+    if (!writer.flush()) {
+        m_errorString = "Failed to write the segmentation codes " + segmentationCodesFilePath + ".";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef DATASETGENERATOR_H
+#define DATASETGENERATOR_H
+
+#include <QColor>
+#include <QMatrix3x3>
+#include <QRandomGenerator>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <QVector3D>
+
+/*!
+ * \brief The DatasetGenerator class writes a synthetic dataset in the formats the
+ * JsonLoadAndStoreStrategy reads, e.g. to test and benchmark the program at the scale of
+ * production datasets without their images:
+ *
+ *     images/                 the images and their camera info file info.json
+ *     segmentation_images/    palettized masks with one color per object model
+ *     models/                 boxes, cylinders and spheres as OBJ files
+ *     poses.json              the poses, with or without ids
+ *     segmentation_codes.json the segmentation code of every object model
+ *
+ * Everything is derived from the seed, i.e. the same parameters always produce the same
+ * files. Images and masks are drawn in parallel, each with its own random generator, and
+ * the JSON files are written as they are generated to support millions of poses.
+ */
+class DatasetGenerator {
+
+public:
+    struct Parameters {
+        int numberOfImages = 100;
+        int numberOfObjectModels = 10;
+        //! Spread evenly over the images
+        int numberOfPoses = 1000;
+        QSize imageSize = QSize(640, 480);
+        quint32 seed = 0;
+        //! Without ids the poses look like external ground truth, e.g. of T-LESS
+        bool poseIds = true;
+        bool segmentationImages = false;
+        //! Writes the same pixels for all images, a lot faster for large datasets
+        bool sharedImage = false;
+    };
+
+    explicit DatasetGenerator(const Parameters &parameters);
+
+    /*!
+     * \brief generate writes the dataset into the folder, which is created if necessary.
+     * \return false if a file could not be written, see errorString
+     */
+    bool generate(const QString &path);
+    QString errorString() const;
+
+    static QString imageFileName(int index);
+    QString objectModelFileName(int index) const;
+    /*!
+     * \brief segmentationColor returns the color of the object model in the masks. The
+     * colors are distinct for the first 3375 object models, black and white are never used.
+     */
+    static QColor segmentationColor(int objectModelIndex);
+
+private:
+    enum Stream : quint32 {
+        ImageStream,
+        PoseStream,
+        ObjectModelStream
+    };
+
+    struct ObjectModelShape {
+        enum Type {
+            Box,
+            Cylinder,
+            Sphere
+        };
+        Type type;
+        //! Half the extents
+        QVector3D size;
+        int segments;
+    };
+
+    struct GeneratedPose {
+        int objectModel;
+        QMatrix3x3 rotation;
+        QVector3D position;
+    };
+
+    //! Every image, object model etc. gets its own generator to be independent of the order
+    QRandomGenerator randomGenerator(Stream stream, int index) const;
+    int firstPoseOfImage(int imageIndex) const;
+    QVector<GeneratedPose> posesOfImage(int imageIndex) const;
+    ObjectModelShape objectModelShape(int index) const;
+    //! The position of the point in the image
+    QPointF project(const QVector3D &point) const;
+
+    bool writeImages(const QString &imagesPath, const QString &segmentationImagesPath);
+    bool writeImage(int index, const QString &imagesPath,
+                    const QString &segmentationImagesPath, const QByteArray &sharedImage) const;
+    QImage drawImage(int index, const QVector<GeneratedPose> &poses) const;
+    QImage drawSegmentationImage(const QVector<GeneratedPose> &poses) const;
+    bool writeCameraInfo(const QString &imagesPath);
+    bool writeObjectModels(const QString &objectModelsPath);
+    bool writePoses(const QString &posesFilePath);
+    bool writeSegmentationCodes(const QString &segmentationCodesFilePath);
+
+private:
+    Parameters m_parameters;
+    float m_focalLength;
+    //! The radius of the bounding sphere of every object model, for drawing the masks
+    QVector<float> m_objectModelRadii;
+    QString m_errorString;
+};
+
+#endif // DATASETGENERATOR_H
@@ -0,0 +1,7 @@
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/datasetgenerator.hpp
+
+SOURCES += \
+    $$PWD/datasetgenerator.cpp
@@ -0,0 +1,11 @@
+TEMPLATE = app
+TARGET = datasetgenerator
+QT += core gui concurrent
+QT -= widgets
+CONFIG += c++11 console no_keywords
+CONFIG -= app_bundle
+
+include(datasetgenerator.pri)
+
+SOURCES += \
+    main.cpp
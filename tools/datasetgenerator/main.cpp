@@ -0,0 +1,83 @@
+#include "datasetgenerator.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QTextStream>
+
+static bool parseNumber(const QCommandLineParser &parser, const QString &option, int &value) {
+    bool ok = false;
+    value = parser.value(option).toInt(&ok);
+    return ok && value >= 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Images are only drawn with the raster engine, no window system is needed
+    QCoreApplication application(argc, argv);
+    QCoreApplication::setApplicationName("datasetgenerator");
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "Writes a synthetic dataset in the format of the JSON strategy of 6D-PAT. "
+                "The same arguments always produce the same dataset.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("folder", "The folder to write the dataset to, it must be empty.");
+    parser.addOptions({
+        {"images", "The number of images.", "count", "100"},
+        {"object-models", "The number of object models.", "count", "10"},
+        {"poses", "The number of poses, spread evenly over the images.", "count", "1000"},
+        {"image-size", "The size of the images.", "WIDTHxHEIGHT", "640x480"},
+        {"seed", "The seed all contents are derived from.", "seed", "0"},
+        {"no-pose-ids", "Writes the poses without ids, like external ground truth."},
+        {"segmentation-images", "Writes a palettized mask for every image."},
+        {"shared-image", "Writes the same pixels for all images, much faster for large datasets."}
+    });
+    parser.process(application);
+
+    const QStringList positionalArguments = parser.positionalArguments();
+    if (positionalArguments.size() != 1) {
+        parser.showHelp(1);
+    }
+    const QString path = positionalArguments.first();
+    QDir dir(path);
+    if (dir.exists() && !dir.isEmpty()) {
+        err << "The folder " << path << " is not empty." << endl;
+        return 1;
+    }
+
+    DatasetGenerator::Parameters parameters;
+    bool ok = parseNumber(parser, "images", parameters.numberOfImages)
+            && parseNumber(parser, "object-models", parameters.numberOfObjectModels)
+            && parseNumber(parser, "poses", parameters.numberOfPoses);
+    QRegularExpressionMatch sizeMatch = QRegularExpression("^(\\d+)x(\\d+)$").match(parser.value("image-size"));
+    if (sizeMatch.hasMatch()) {
+        parameters.imageSize = QSize(sizeMatch.captured(1).toInt(), sizeMatch.captured(2).toInt());
+    }
+    bool seedOk = false;
+    parameters.seed = parser.value("seed").toUInt(&seedOk);
+    ok = ok && seedOk && sizeMatch.hasMatch() && !parameters.imageSize.isEmpty();
+    if (!ok) {
+        err << "Invalid arguments, see --help." << endl;
+        return 1;
+    }
+    parameters.poseIds = !parser.isSet("no-pose-ids");
+    parameters.segmentationImages = parser.isSet("segmentation-images");
+    parameters.sharedImage = parser.isSet("shared-image");
+
+    QElapsedTimer timer;
+    timer.start();
+    DatasetGenerator generator(parameters);
+    if (!generator.generate(path)) {
+        err << generator.errorString() << endl;
+        return 1;
+    }
+    out << "Wrote " << parameters.numberOfImages << " images, "
+        << parameters.numberOfObjectModels << " object models and "
+        << parameters.numberOfPoses << " poses to " << path
+        << " in " << timer.elapsed() << " ms." << endl;
+    return 0;
+}